@@ -0,0 +1,180 @@
+/**
+ * @file aprsSession.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief One verified APRS-IS connection shared by every station.
+ * @details Reconnects back off from 1 s doubling to 1 min, reset by a verified logon.
+ */
+
+#include "aprsSession.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#define QUEUE_MAX 10000		 // packets held while disconnected
+#define BACKOFF_MAX 60000	 // longest reconnect delay (ms)
+#define SOFTWARE "wxgateway 1.0" // vers field of the logon
+
+AprsSession::AprsSession(EventLoop &eventLoop, const Endpoint &to, std::string user, std::string code)
+	: loop(eventLoop), server(to), login(std::move(user)), passcode(std::move(code))
+{
+}
+
+void AprsSession::send(const std::string &packet)
+{
+	if (state == VERIFIED)
+	{
+		out += packet;
+		out += "\r\n";
+		sentCount++;
+		flush();
+		return;
+	}
+	if (queue.size() >= QUEUE_MAX)
+	{
+		queue.pop_front();
+		droppedCount++;
+	}
+	queue.push_back(packet);
+	if (state == DISCONNECTED && !retryPending)
+	{
+		connect();
+	}
+} // send()
+
+void AprsSession::connect()
+{
+	fd = connectNonBlocking(server);
+	if (fd < 0)
+	{
+		fail();
+		return;
+	}
+	state = CONNECTING;
+	in.clear();
+	out.clear();
+	watch = loop.add(fd, EPOLLIN | EPOLLRDHUP, [this](uint32_t events) { onEvent(events); });
+} // connect()
+
+void AprsSession::fail()
+{
+	if (fd >= 0)
+	{
+		loop.remove(watch);
+		close(fd);
+		fd = -1;
+	}
+	state = DISCONNECTED;
+	retryPending = true;
+	uint64_t delay = backoffMs;
+	backoffMs = std::min<uint64_t>(backoffMs * 2, BACKOFF_MAX);
+	loop.after(delay, [this] {
+		retryPending = false;
+		if (state == DISCONNECTED && !queue.empty())
+		{
+			connect();
+		}
+	});
+} // fail()
+
+void AprsSession::flush()
+{
+	while (!out.empty())
+	{
+		ssize_t written = ::send(fd, out.data(), out.size(), MSG_NOSIGNAL);
+		if (written < 0)
+		{
+			if (errno == EAGAIN)
+			{
+				loop.modify(watch, EPOLLIN | EPOLLOUT | EPOLLRDHUP);
+				return;
+			}
+			fail();
+			return;
+		}
+		out.erase(0, written);
+	}
+	loop.modify(watch, EPOLLIN | EPOLLRDHUP);
+} // flush()
+
+void AprsSession::onLine(const std::string &line)
+{
+	if (state == CONNECTING)
+	{
+		// banner, or "# port full" from a busy server
+		if (line.find("full") != std::string::npos)
+		{
+			fail();
+			return;
+		}
+		state = LOGGING_ON;
+		out = "user " + login + " pass " + passcode + " vers " SOFTWARE "\r\n";
+		flush();
+	}
+	else if (state == LOGGING_ON && line.find("logresp") != std::string::npos)
+	{
+		if (line.find(" verified") == std::string::npos)
+		{
+			fail(); // unverified logins may not send packets
+			return;
+		}
+		state = VERIFIED;
+		backoffMs = 1000;
+		while (!queue.empty())
+		{
+			out += queue.front();
+			out += "\r\n";
+			queue.pop_front();
+			sentCount++;
+		}
+		flush();
+	}
+	// server comments and keep-alives are ignored
+} // onLine()
+
+void AprsSession::onEvent(uint32_t events)
+{
+	if (events & EPOLLOUT)
+	{
+		flush();
+		if (fd < 0)
+		{
+			return;
+		}
+	}
+	if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+	{
+		char buffer[2048];
+		for (;;)
+		{
+			ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+			if (got > 0)
+			{
+				in.append(buffer, got);
+				size_t end;
+				while ((end = in.find('\n')) != std::string::npos)
+				{
+					std::string line = in.substr(0, end);
+					in.erase(0, end + 1);
+					onLine(line);
+					if (fd < 0)
+					{
+						return;
+					}
+				}
+				continue;
+			}
+			if (got < 0 && errno == EAGAIN)
+			{
+				return;
+			}
+			fail(); // closed or error
+			return;
+		}
+	}
+} // onEvent()
+
+// End of file
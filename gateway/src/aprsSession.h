@@ -0,0 +1,68 @@
+/**
+ * @file aprsSession.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief One verified APRS-IS connection shared by every station.
+ *
+ * APRS-IS accepts packets for any source callsign from a verified login, so
+ * the gateway logs on once and writes all stations' reports to the same
+ * socket. Packets queued while the session is down are sent after the next
+ * logon; the queue drops the oldest packet when it is full.
+ *
+ * Functions:
+ * - send(packet): Queue one packet, without line ending.
+ * - sent(): Packets written to the server.
+ * - dropped(): Packets lost to a full queue.
+ */
+#ifndef APRS_SESSION_H
+#define APRS_SESSION_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include "eventLoop.h"
+#include "net.h"
+
+class AprsSession
+{
+public:
+	AprsSession(EventLoop &loop, const Endpoint &server, std::string login, std::string passcode);
+
+	void send(const std::string &packet); ///< queue one packet
+	uint64_t sent() const { return sentCount; }
+	uint64_t dropped() const { return droppedCount; }
+
+private:
+	enum State
+	{
+		DISCONNECTED,
+		CONNECTING, // waiting for the banner
+		LOGGING_ON, // logon sent, waiting for "verified"
+		VERIFIED
+	};
+
+	EventLoop &loop;
+	Endpoint server;
+	std::string login;
+	std::string passcode;
+	State state = DISCONNECTED;
+	int fd = -1;
+	uint64_t watch = 0;
+	std::string out;				// bytes not yet written
+	std::string in;					// partial server line
+	std::deque<std::string> queue; // packets waiting for a verified session
+	bool retryPending = false; // a reconnect timer is running
+	uint64_t backoffMs = 1000;
+	uint64_t sentCount = 0;
+	uint64_t droppedCount = 0;
+
+	void connect();
+	void fail();
+	void onEvent(uint32_t events);
+	void onLine(const std::string &line);
+	void flush();
+};
+
+#endif // APRS_SESSION_H
+// End of file
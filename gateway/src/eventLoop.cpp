@@ -0,0 +1,172 @@
+/**
+ * @file eventLoop.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Single threaded epoll event loop with timers.
+ * @details epoll carries a watch id rather than the descriptor, so an event
+ *          still queued for a descriptor that was closed and reused in the same
+ *          batch finds no watch and is dropped instead of reaching the new owner.
+ */
+
+#include "eventLoop.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_EVENTS 256 // events taken per epoll_wait()
+#define WAKE_ID 0	   // watch id of the eventfd
+
+EventLoop::EventLoop()
+{
+	epollFd = epoll_create1(EPOLL_CLOEXEC);
+	wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (epollFd < 0 || wakeFd < 0)
+	{
+		throw std::runtime_error("event loop: epoll or eventfd failed");
+	}
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.u64 = WAKE_ID;
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+} // EventLoop()
+
+EventLoop::~EventLoop()
+{
+	close(wakeFd);
+	close(epollFd);
+}
+
+uint64_t EventLoop::nowMs()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+uint64_t EventLoop::add(int fd, uint32_t events, Handler handler)
+{
+	uint64_t id = nextId++;
+	epoll_event event{};
+	event.events = events;
+	event.data.u64 = id;
+	if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+	{
+		return 0;
+	}
+	watches[id] = Watch{fd, std::make_shared<Handler>(std::move(handler))};
+	return id;
+} // add()
+
+void EventLoop::modify(uint64_t id, uint32_t events)
+{
+	auto watch = watches.find(id);
+	if (watch == watches.end())
+	{
+		return;
+	}
+	epoll_event event{};
+	event.events = events;
+	event.data.u64 = id;
+	epoll_ctl(epollFd, EPOLL_CTL_MOD, watch->second.fd, &event);
+} // modify()
+
+void EventLoop::remove(uint64_t id)
+{
+	auto watch = watches.find(id);
+	if (watch == watches.end())
+	{
+		return;
+	}
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, watch->second.fd, nullptr);
+	watches.erase(watch);
+} // remove()
+
+void EventLoop::after(uint64_t ms, Task fn)
+{
+	timers.push(Timer{nowMs() + ms, timerOrder++, std::move(fn)});
+}
+
+void EventLoop::post(Task fn)
+{
+	{
+		std::lock_guard<std::mutex> lock(postMutex);
+		posted.push_back(std::move(fn));
+	}
+	uint64_t one = 1;
+	ssize_t ignored = write(wakeFd, &one, sizeof(one));
+	(void)ignored;
+} // post()
+
+void EventLoop::stop()
+{
+	running = false;
+	post([] {}); // wake epoll_wait()
+}
+
+void EventLoop::runPosted()
+{
+	uint64_t count;
+	ssize_t ignored = read(wakeFd, &count, sizeof(count));
+	(void)ignored;
+	std::vector<Task> batch;
+	{
+		std::lock_guard<std::mutex> lock(postMutex);
+		batch.swap(posted);
+	}
+	for (Task &fn : batch)
+	{
+		fn();
+	}
+} // runPosted()
+
+// milliseconds until the next timer, -1 if none
+int EventLoop::nextTimeout()
+{
+	if (timers.empty())
+	{
+		return -1;
+	}
+	uint64_t now = nowMs();
+	uint64_t due = timers.top().due;
+	return due <= now ? 0 : (int)std::min<uint64_t>(due - now, 60000);
+} // nextTimeout()
+
+void EventLoop::run()
+{
+	running = true;
+	epoll_event events[MAX_EVENTS];
+	while (running)
+	{
+		int count = epoll_wait(epollFd, events, MAX_EVENTS, nextTimeout());
+		for (int i = 0; i < count; i++)
+		{
+			uint64_t id = events[i].data.u64;
+			if (id == WAKE_ID)
+			{
+				runPosted();
+				continue;
+			}
+			auto watch = watches.find(id);
+			if (watch == watches.end())
+			{
+				continue; // removed earlier in this batch
+			}
+			std::shared_ptr<Handler> handler = watch->second.handler;
+			(*handler)(events[i].events);
+		}
+
+		uint64_t now = nowMs();
+		while (!timers.empty() && timers.top().due <= now)
+		{
+			Task fn = timers.top().fn;
+			timers.pop();
+			fn();
+		}
+	}
+} // run()
+
+// End of file
@@ -0,0 +1,84 @@
+/**
+ * @file eventLoop.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Single threaded epoll event loop with timers.
+ *
+ * Every socket of the gateway belongs to one loop and its handlers run on the
+ * loop thread, so they need no locking. Other threads hand work to the loop
+ * with post(), which wakes it through an eventfd.
+ *
+ * Functions:
+ * - add(fd, events, handler): Watch a descriptor, returns a watch id.
+ * - modify(id, events): Change the events of a watch.
+ * - remove(id): Stop watching; safe from inside the handler.
+ * - after(ms, fn): Run fn once on the loop after ms milliseconds.
+ * - post(fn): Run fn on the loop soon, callable from any thread.
+ * - run() / stop(): Dispatch until stopped.
+ */
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+class EventLoop
+{
+public:
+	using Handler = std::function<void(uint32_t events)>;
+	using Task = std::function<void()>;
+
+	EventLoop();
+	~EventLoop();
+	EventLoop(const EventLoop &) = delete;
+	EventLoop &operator=(const EventLoop &) = delete;
+
+	uint64_t add(int fd, uint32_t events, Handler handler); ///< watch fd, returns a watch id
+	void modify(uint64_t id, uint32_t events);				///< change watched events
+	void remove(uint64_t id);								///< stop watching, does not close fd
+	void after(uint64_t ms, Task fn);						///< one shot timer
+	void post(Task fn);										///< run on the loop thread
+	void run();												///< dispatch until stop()
+	void stop();											///< make run() return, any thread
+
+	static uint64_t nowMs(); ///< monotonic milliseconds
+
+private:
+	struct Watch
+	{
+		int fd;
+		std::shared_ptr<Handler> handler; // kept alive while it runs
+	};
+	struct Timer
+	{
+		uint64_t due;
+		uint64_t order; // FIFO among equal due times
+		Task fn;
+		bool operator>(const Timer &other) const
+		{
+			return due != other.due ? due > other.due : order > other.order;
+		}
+	};
+
+	int epollFd;
+	int wakeFd;
+	uint64_t nextId = 1;
+	uint64_t timerOrder = 0;
+	std::unordered_map<uint64_t, Watch> watches;
+	std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> timers;
+	std::mutex postMutex;
+	std::vector<Task> posted;
+	std::atomic<bool> running{false};
+
+	void runPosted();
+	int nextTimeout();
+};
+
+#endif // EVENT_LOOP_H
+// End of file
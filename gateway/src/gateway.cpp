@@ -0,0 +1,138 @@
+/**
+ * @file gateway.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Runs the weather cycle for many stations on one event loop.
+ * @details Only the parse and format step runs on a worker. It touches no
+ *          gateway state: it gets the response body and returns two strings
+ *          through EventLoop::post(), so the loop thread stays the sole owner
+ *          of sockets, schedule and counters.
+ */
+
+#include "gateway.h"
+
+#include <aprsFormat.h>
+#include <cmath>
+#include <tsPayload.h>
+#include <wxParse.h>
+
+Gateway::Gateway(EventLoop &eventLoop, WorkerPool &pool, const GatewayConfig &settings, std::vector<Station> list)
+	: loop(eventLoop), workers(pool), config(settings), stations(std::move(list)),
+	  aprsSession(eventLoop, settings.aprs, settings.aprsLogin, settings.aprsPasscode)
+{
+}
+
+void Gateway::start()
+{
+	uint64_t now = EventLoop::nowMs();
+	for (size_t i = 0; i < stations.size(); i++)
+	{
+		schedule.push(Due{now + config.intervalMs * i / stations.size(), i});
+	}
+	pump();
+} // start()
+
+// start every due station that fits, then sleep until the next one is due
+void Gateway::pump()
+{
+	uint64_t now = EventLoop::nowMs();
+	while (inFlight < config.maxInFlight && !schedule.empty() && schedule.top().at <= now)
+	{
+		size_t station = schedule.top().station;
+		schedule.pop();
+		inFlight++;
+		fetch(station, now);
+	}
+	if (inFlight < config.maxInFlight && !schedule.empty() && (wakeAt == 0 || schedule.top().at < wakeAt))
+	{
+		wakeAt = schedule.top().at;
+		loop.after(wakeAt - now, [this] {
+			wakeAt = 0;
+			pump();
+		});
+	}
+} // pump()
+
+void Gateway::fetch(size_t index, uint64_t started)
+{
+	const Station &station = stations[index];
+	std::string request = "GET /v2/pws/observations/current?stationId=" + station.id +
+						  "&format=json&units=m&numericPrecision=decimal&apiKey=" + station.apiKey +
+						  " HTTP/1.0\r\nHost: " + config.api.host + "\r\nAccept: application/json\r\n\r\n";
+
+	httpExchange(loop, config.api, std::move(request), config.timeoutMs,
+				 [this, index, started](int status, const std::string &body) {
+					 if (status != 200)
+					 {
+						 counters.fetchFailed++;
+						 finish(index, started);
+						 return;
+					 }
+					 // parse and format off the loop thread
+					 const Station &station = stations[index];
+					 workers.submit([this, index, started, body, callsign = station.callsign, tsKey = station.tsKey] {
+						 wxObservation obs;
+						 bool valid = wxParseCurrent(body.c_str(), body.size(), obs);
+						 std::string packet, row;
+						 if (valid && !callsign.empty())
+						 {
+							 char buffer[APRS_PACKET_MAX];
+							 aprsFormatWeather(buffer, sizeof(buffer), callsign.c_str(), obs, NAN, config.comment.c_str());
+							 packet = buffer;
+						 }
+						 if (valid && !tsKey.empty())
+						 {
+							 char buffer[TS_UPDATE_MAX];
+							 tsFormatUpdate(buffer, sizeof(buffer), tsKey.c_str(), obs, "");
+							 row = buffer;
+						 }
+						 loop.post([this, index, started, valid, packet, row] {
+							 if (!valid)
+							 {
+								 counters.parseFailed++;
+								 finish(index, started);
+								 return;
+							 }
+							 publish(index, started, packet, row);
+						 });
+					 });
+				 });
+} // fetch()
+
+void Gateway::publish(size_t index, uint64_t started, const std::string &packet, const std::string &row)
+{
+	if (!packet.empty())
+	{
+		aprsSession.send(packet);
+	}
+	if (row.empty())
+	{
+		finish(index, started);
+		return;
+	}
+	std::string request = "POST /update.json HTTP/1.0\r\nHost: " + config.thingspeak.host +
+						  "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(row.size()) +
+						  "\r\n\r\n" + row;
+	httpExchange(loop, config.thingspeak, std::move(request), config.timeoutMs,
+				 [this, index, started](int status, const std::string &) {
+					 if (status == 200)
+					 {
+						 counters.tsOk++;
+					 }
+					 else
+					 {
+						 counters.tsFailed++;
+					 }
+					 finish(index, started);
+				 });
+} // publish()
+
+void Gateway::finish(size_t index, uint64_t started)
+{
+	counters.cycles++;
+	inFlight--;
+	schedule.push(Due{started + config.intervalMs, index});
+	pump();
+} // finish()
+
+// End of file
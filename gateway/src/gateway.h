@@ -0,0 +1,93 @@
+/**
+ * @file gateway.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Runs the weather cycle for many stations on one event loop.
+ *
+ * Each cycle fetches the station's current observation, parses it and formats
+ * the APRS report and ThingSpeak row on a worker, then sends the report on the
+ * shared APRS-IS session and posts the row. At most `maxInFlight` cycles run at
+ * once; stations start spread across the interval so the API sees a steady rate.
+ *
+ * Functions:
+ * - start(): Schedule every station.
+ * - stats(): Counters so far.
+ */
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <cstdint>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include "aprsSession.h"
+#include "eventLoop.h"
+#include "net.h"
+#include "workerPool.h"
+
+struct Station
+{
+	std::string id;		  ///< Weather Underground station id
+	std::string apiKey;	  ///< Weather Underground API key
+	std::string callsign; ///< APRS call-SSID, empty to skip APRS
+	std::string tsKey;	  ///< ThingSpeak write key, empty to skip ThingSpeak
+};
+
+struct GatewayConfig
+{
+	Endpoint api;				   ///< Weather Underground API or a TLS proxy in front of it
+	Endpoint aprs;				   ///< APRS-IS server
+	Endpoint thingspeak;		   ///< ThingSpeak API
+	std::string aprsLogin;		   ///< gateway call-SSID for the APRS-IS logon
+	std::string aprsPasscode;	   ///< passcode of aprsLogin
+	std::string comment;		   ///< text after each APRS weather report
+	uint64_t intervalMs = 420000;  ///< time between cycles of one station, 0 to repeat at once
+	uint64_t timeoutMs = 10000;	   ///< longest HTTP exchange
+	unsigned maxInFlight = 64;	   ///< cycles running at once
+};
+
+struct GatewayStats
+{
+	uint64_t cycles = 0;	  ///< completed cycles
+	uint64_t fetchFailed = 0; ///< API errors and timeouts
+	uint64_t parseFailed = 0; ///< responses without an observation
+	uint64_t tsOk = 0;		  ///< ThingSpeak rows accepted
+	uint64_t tsFailed = 0;	  ///< ThingSpeak errors and timeouts
+};
+
+class Gateway
+{
+public:
+	Gateway(EventLoop &loop, WorkerPool &workers, const GatewayConfig &config, std::vector<Station> stations);
+
+	void start();							  ///< schedule every station
+	const GatewayStats &stats() const { return counters; }
+	const AprsSession &aprs() const { return aprsSession; }
+
+private:
+	struct Due
+	{
+		uint64_t at;
+		size_t station;
+		bool operator>(const Due &other) const { return at > other.at; }
+	};
+
+	EventLoop &loop;
+	WorkerPool &workers;
+	GatewayConfig config;
+	std::vector<Station> stations;
+	AprsSession aprsSession;
+	std::priority_queue<Due, std::vector<Due>, std::greater<Due>> schedule;
+	unsigned inFlight = 0;
+	uint64_t wakeAt = 0; // due time of the pending pump timer, 0 if none
+	GatewayStats counters;
+
+	void pump();
+	void fetch(size_t station, uint64_t started);
+	void publish(size_t station, uint64_t started, const std::string &packet, const std::string &row);
+	void finish(size_t station, uint64_t started);
+};
+
+#endif // GATEWAY_H
+// End of file
@@ -0,0 +1,118 @@
+/**
+ * @file historyBench.cpp
+ * @author Karl Berger
+ * @date 2025-07-05
+ * @brief Host benchmark of the firmware's packed observation history.
+ * @details The made-up records are kept in a vector as well, so the scan can
+ *          check every record it decodes against the one appended.
+ */
+
+#include "historyBench.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "packedHistory.h"
+
+#define BENCH_INTERVAL 420 // seconds, the firmware's current weather interval
+#define BENCH_START 1750000000UL
+
+static packedStore store; // the size the firmware keeps, too large for the stack
+
+static double elapsedNs(std::chrono::steady_clock::time_point start)
+{
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// the channels of wxHistory.cpp: high, spread, humidity, pressure, wind, gust, rain, solar, indoor
+static std::vector<packedRecord> makeRecords(unsigned days)
+{
+	std::mt19937 random(42);
+	std::normal_distribution<double> noise(0, 1);
+	std::vector<packedRecord> records;
+	double pressure = 10150, wind = 10, rain = 0, indoor = 215;
+	uint32_t epoch = BENCH_START;
+	for (uint32_t n = 0; n < days * 86400UL / BENCH_INTERVAL; n++)
+	{
+		epoch += BENCH_INTERVAL + ((random() % 3 == 0) ? (int)(random() % 61) - 30 : 0); // upload jitter
+		double day = (epoch % 86400) / 86400.0;
+		double sun = sin(2 * M_PI * (day - 0.3));
+		pressure += noise(random) * 0.7;
+		wind = std::max(0.0, wind + noise(random) * 2.5);
+		rain = (day < 0.005) ? 0 : rain + ((random() % 50 == 0) ? random() % 20 : 0);
+		indoor += noise(random) * 0.7;
+		double solar = (day > 0.25 && day < 0.75) ? std::max(0.0, 900 * sin(M_PI * (day - 0.25) * 2) + 40 * noise(random)) : 0;
+		packedRecord record;
+		record.epoch = epoch;
+		record.value[0] = lround(150 + 80 * sun + 1.5 * noise(random));
+		record.value[1] = 0;
+		record.value[2] = std::min(100L, std::max(0L, lround(70 - 30 * sun + noise(random))));
+		record.value[3] = lround(pressure);
+		record.value[4] = lround(wind);
+		record.value[5] = lround(wind + fabs(3 + 2 * noise(random)));
+		record.value[6] = lround(rain);
+		record.value[7] = lround(solar);
+		record.value[8] = lround(indoor);
+		records.push_back(record);
+	}
+	return records;
+} // makeRecords()
+
+int runHistoryBench(unsigned days)
+{
+	std::vector<packedRecord> records = makeRecords(days);
+	packedClear(store);
+
+	auto start = std::chrono::steady_clock::now();
+	for (const packedRecord &record : records)
+	{
+		packedAppend(store, record);
+	}
+	double appendNs = elapsedNs(start) / records.size();
+
+	// whole store, checked against what went in
+	int errors = 0;
+	size_t next = records.size() - store.count;
+	packedCursor cursor;
+	packedRecord record;
+	start = std::chrono::steady_clock::now();
+	packedBegin(store, cursor, 0);
+	while (packedNext(cursor, record))
+	{
+		const packedRecord &expected = records[next++];
+		errors += (record.epoch != expected.epoch);
+		for (int i = 0; i < PACKED_CHANNELS; i++)
+		{
+			errors += (record.value[i] != expected.value[i]);
+		}
+	}
+	double scanNs = elapsedNs(start);
+	errors += (next != records.size());
+
+	// the 24 hour window the rolling values read
+	uint32_t from = records.back().epoch - 86400;
+	int windowCount = 0;
+	start = std::chrono::steady_clock::now();
+	packedBegin(store, cursor, from);
+	while (packedNext(cursor, record))
+	{
+		windowCount++;
+	}
+	double windowNs = elapsedNs(start);
+
+	uint32_t bits = packedBits(store);
+	const packedRecord &oldest = records[records.size() - store.count];
+	printf("history bench: %zu records appended at %d s, %.0f ns each\n", records.size(), BENCH_INTERVAL, appendNs);
+	printf("history bench: store of %d bytes holds %u records, %.2f days, %.1f bits/record (%zu raw)\n",
+		   PACKED_BLOCKS * PACKED_BLOCK_BYTES, store.count, (records.back().epoch - oldest.epoch) / 86400.0,
+		   (double)bits / store.count, 8 * sizeof(packedRecord));
+	printf("history bench: scan all %u in %.1f us (%.0f ns each), last 24 h %d in %.1f us\n", store.count,
+		   scanNs / 1000, scanNs / store.count, windowCount, windowNs / 1000);
+	printf("history bench: %d mismatches\n", errors);
+	return errors ? 1 : 0;
+} // runHistoryBench()
+
+// End of file
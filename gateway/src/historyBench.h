@@ -0,0 +1,23 @@
+/**
+ * @file historyBench.h
+ * @author Karl Berger
+ * @date 2025-07-05
+ * @brief Host benchmark of the firmware's packed observation history.
+ *
+ * Used by --history-bench. Appends made-up observations at the 7 minute fetch
+ * interval to one packedStore, the size the firmware keeps, and reports the
+ * append cost, the cost of scanning the whole store and a 24 hour window, the
+ * bits per sample and the span of time the store holds. The values follow a
+ * daily cycle with noise in the firmware's scaling (0.1 °C, %, 0.1 hPa, km/h,
+ * 0.1 mm, W/m²), so the bit counts are close to a real station's.
+ *
+ * Functions:
+ * - runHistoryBench(days): Run the benchmark over a number of days, print the results.
+ */
+#ifndef HISTORY_BENCH_H
+#define HISTORY_BENCH_H
+
+int runHistoryBench(unsigned days); ///< 0 when every record read back intact
+
+#endif // HISTORY_BENCH_H
+// End of file
@@ -0,0 +1,269 @@
+/**
+ * @file main.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Linux gateway: the firmware's weather cycle for many stations.
+ * @details
+ *   wxgateway --stations FILE --aprs-login CALL --aprs-pass CODE [options]
+ *   wxgateway --bench [--count N] [--seconds S] [options]
+ *   wxgateway --history-bench [--days N]
+ *
+ *   Options:
+ *     --api HOST[:PORT]         weather API over plain HTTP (default api.weather.com:80)
+ *     --aprs HOST[:PORT]        APRS-IS server (default noam.aprs2.net:14580)
+ *     --thingspeak HOST[:PORT]  ThingSpeak API (default api.thingspeak.com:80)
+ *     --interval SECONDS        time between cycles of one station (default 420)
+ *     --workers N               parse and format threads (default: CPU count)
+ *     --inflight N              cycles running at once (default 64)
+ *
+ *   The stations file has one station per line, blank lines and # comments ignored:
+ *     STATION_ID API_KEY CALLSIGN THINGSPEAK_WRITE_KEY
+ *   Use "-" for CALLSIGN or the write key to skip that service.
+ *
+ *   --bench runs N made up stations against in-process stand-ins with no
+ *   interval and reports completed cycles per second and per CPU second of the
+ *   gateway threads (event loop plus workers; stand-in CPU is reported apart).
+ *
+ *   --history-bench fills the firmware's packed observation history with N days
+ *   (default 10) of made-up 7 minute records and reports append and scan cost
+ *   and bits per record.
+ */
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+#include "eventLoop.h"
+#include "gateway.h"
+#include "historyBench.h"
+#include "standIns.h"
+#include "workerPool.h"
+
+#define STATS_INTERVAL 60000 // ms between status lines in service
+
+volatile sig_atomic_t stopRequested = 0;
+
+static void onSignal(int)
+{
+	stopRequested = 1;
+}
+
+static double threadCpuSeconds()
+{
+	timespec used{};
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &used);
+	return used.tv_sec + used.tv_nsec / 1e9;
+}
+
+static bool loadStations(const std::string &path, std::vector<Station> &stations)
+{
+	std::ifstream file(path);
+	if (!file)
+	{
+		return false;
+	}
+	std::string line;
+	while (std::getline(file, line))
+	{
+		std::istringstream fields(line);
+		Station station;
+		if (!(fields >> station.id) || station.id[0] == '#')
+		{
+			continue;
+		}
+		fields >> station.apiKey >> station.callsign >> station.tsKey;
+		station.callsign = (station.callsign == "-") ? "" : station.callsign;
+		station.tsKey = (station.tsKey == "-") ? "" : station.tsKey;
+		stations.push_back(station);
+	}
+	return true;
+} // loadStations()
+
+static void usage()
+{
+	fprintf(stderr, "usage: wxgateway --stations FILE --aprs-login CALL --aprs-pass CODE [options]\n"
+					"       wxgateway --bench [--count N] [--seconds S] [options]\n"
+					"       wxgateway --history-bench [--days N]\n"
+					"options: --api H[:P] --aprs H[:P] --thingspeak H[:P] --interval S --workers N --inflight N\n");
+}
+
+static void printStats(const Gateway &gateway)
+{
+	const GatewayStats &stats = gateway.stats();
+	printf("cycles %llu, fetch failed %llu, parse failed %llu, thingspeak ok %llu failed %llu, "
+		   "aprs sent %llu dropped %llu\n",
+		   (unsigned long long)stats.cycles, (unsigned long long)stats.fetchFailed,
+		   (unsigned long long)stats.parseFailed, (unsigned long long)stats.tsOk, (unsigned long long)stats.tsFailed,
+		   (unsigned long long)gateway.aprs().sent(), (unsigned long long)gateway.aprs().dropped());
+	fflush(stdout);
+} // printStats()
+
+int main(int argc, char **argv)
+{
+	bool bench = false;
+	std::string stationsPath, apiText = "api.weather.com", aprsText = "noam.aprs2.net",
+							  thingspeakText = "api.thingspeak.com";
+	GatewayConfig config;
+	config.comment = "wxgateway";
+	unsigned workerCount = std::thread::hardware_concurrency();
+	unsigned benchCount = 1000;
+	unsigned benchSeconds = 10;
+	bool historyBench = false;
+	unsigned historyDays = 10;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::string arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+		if (arg == "--bench")
+		{
+			bench = true;
+			continue;
+		}
+		if (arg == "--history-bench")
+		{
+			historyBench = true;
+			continue;
+		}
+		if (value == nullptr)
+		{
+			usage();
+			return 2;
+		}
+		i++;
+		if (arg == "--stations")
+			stationsPath = value;
+		else if (arg == "--api")
+			apiText = value;
+		else if (arg == "--aprs")
+			aprsText = value;
+		else if (arg == "--thingspeak")
+			thingspeakText = value;
+		else if (arg == "--aprs-login")
+			config.aprsLogin = value;
+		else if (arg == "--aprs-pass")
+			config.aprsPasscode = value;
+		else if (arg == "--interval")
+			config.intervalMs = strtoull(value, nullptr, 10) * 1000;
+		else if (arg == "--workers")
+			workerCount = atoi(value);
+		else if (arg == "--inflight")
+			config.maxInFlight = atoi(value);
+		else if (arg == "--count")
+			benchCount = atoi(value);
+		else if (arg == "--seconds")
+			benchSeconds = atoi(value);
+		else if (arg == "--days")
+			historyDays = atoi(value);
+		else
+		{
+			usage();
+			return 2;
+		}
+	}
+
+	if (historyBench)
+	{
+		return runHistoryBench(historyDays);
+	}
+
+	std::vector<Station> stations;
+	StandIns standIns;
+	if (bench)
+	{
+		if (!standIns.start())
+		{
+			fprintf(stderr, "bench: cannot open stand-in listeners\n");
+			return 1;
+		}
+		apiText = "127.0.0.1:" + std::to_string(standIns.apiPort);
+		aprsText = "127.0.0.1:" + std::to_string(standIns.aprsPort);
+		thingspeakText = "127.0.0.1:" + std::to_string(standIns.thingspeakPort);
+		config.aprsLogin = "N0CALL-10";
+		config.aprsPasscode = "13023";
+		config.intervalMs = 0;
+		for (unsigned i = 0; i < benchCount; i++)
+		{
+			std::string number = std::to_string(i);
+			stations.push_back(Station{"KBENCH" + number, "benchkey", "BN" + number + "-13", "TSKEY" + number});
+		}
+	}
+	else
+	{
+		if (stationsPath.empty() || config.aprsLogin.empty() || config.aprsPasscode.empty())
+		{
+			usage();
+			return 2;
+		}
+		if (!loadStations(stationsPath, stations) || stations.empty())
+		{
+			fprintf(stderr, "no stations in %s\n", stationsPath.c_str());
+			return 1;
+		}
+	}
+
+	if (!resolveEndpoint(apiText, 80, config.api) || !resolveEndpoint(aprsText, 14580, config.aprs) ||
+		!resolveEndpoint(thingspeakText, 80, config.thingspeak))
+	{
+		fprintf(stderr, "cannot resolve a service host\n");
+		return 1;
+	}
+
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	signal(SIGPIPE, SIG_IGN);
+
+	EventLoop loop;
+	WorkerPool workers(workerCount);
+	Gateway gateway(loop, workers, config, stations);
+
+	// poll the signal flag; also ends the benchmark
+	uint64_t benchEnd = EventLoop::nowMs() + benchSeconds * 1000ULL;
+	uint64_t nextStats = EventLoop::nowMs() + STATS_INTERVAL;
+	std::function<void()> watchdog = [&] {
+		uint64_t now = EventLoop::nowMs();
+		if (stopRequested || (bench && now >= benchEnd))
+		{
+			loop.stop();
+			return;
+		}
+		if (!bench && now >= nextStats)
+		{
+			printStats(gateway);
+			nextStats += STATS_INTERVAL;
+		}
+		loop.after(100, watchdog);
+	};
+	loop.after(100, watchdog);
+
+	printf("wxgateway: %zu stations, %u workers, %u in flight\n", stations.size(), workerCount ? workerCount : 1,
+		   config.maxInFlight);
+	uint64_t started = EventLoop::nowMs();
+	gateway.start();
+	loop.run();
+
+	double wall = (EventLoop::nowMs() - started) / 1000.0;
+	double loopCpu = threadCpuSeconds();
+	double workerCpu = workers.cpuSeconds();
+	printStats(gateway);
+	if (bench)
+	{
+		const GatewayStats &stats = gateway.stats();
+		double gatewayCpu = loopCpu + workerCpu;
+		printf("bench: %.1f s, %.0f stations/s\n", wall, stats.cycles / wall);
+		printf("bench: gateway CPU %.2f s (loop %.2f, workers %.2f), %.0f stations/s per core\n", gatewayCpu,
+			   loopCpu, workerCpu, gatewayCpu > 0 ? stats.cycles / gatewayCpu : 0.0);
+		printf("bench: stand-in CPU %.2f s, not counted; %llu APRS packets and %llu ThingSpeak rows received\n",
+			   standIns.cpuSeconds(), (unsigned long long)standIns.aprsPackets.load(),
+			   (unsigned long long)standIns.thingspeakUpdates.load());
+	}
+	return 0;
+} // main()
+
+// End of file
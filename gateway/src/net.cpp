@@ -0,0 +1,181 @@
+/**
+ * @file net.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Endpoints and one shot HTTP exchanges on the event loop.
+ * @details Each exchange is a small state object owned by its epoll handler.
+ *          The timeout holds only a weak reference, so a finished exchange is
+ *          freed at once instead of when its timer fires.
+ */
+
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <netdb.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+bool resolveEndpoint(const std::string &text, uint16_t defaultPort, Endpoint &endpoint)
+{
+	size_t colon = text.rfind(':');
+	endpoint.host = text.substr(0, colon);
+	endpoint.port = (colon == std::string::npos) ? defaultPort : (uint16_t)std::stoi(text.substr(colon + 1));
+
+	addrinfo hints{};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	addrinfo *result = nullptr;
+	if (getaddrinfo(endpoint.host.c_str(), nullptr, &hints, &result) != 0 || result == nullptr)
+	{
+		return false;
+	}
+	endpoint.address = *(sockaddr_in *)result->ai_addr;
+	endpoint.address.sin_port = htons(endpoint.port);
+	freeaddrinfo(result);
+	return true;
+} // resolveEndpoint()
+
+int connectNonBlocking(const Endpoint &endpoint)
+{
+	int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	if (connect(fd, (const sockaddr *)&endpoint.address, sizeof(endpoint.address)) < 0 && errno != EINPROGRESS)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+} // connectNonBlocking()
+
+namespace
+{
+struct Exchange
+{
+	EventLoop &loop;
+	int fd = -1;
+	uint64_t watch = 0;
+	std::string out;
+	size_t written = 0;
+	std::string in;
+	HttpDone done;
+	bool finished = false;
+
+	explicit Exchange(EventLoop &eventLoop) : loop(eventLoop) {}
+
+	void finish(bool received)
+	{
+		if (finished)
+		{
+			return;
+		}
+		finished = true;
+		loop.remove(watch);
+		close(fd);
+		int status = 0;
+		std::string body;
+		if (received && in.compare(0, 5, "HTTP/") == 0)
+		{
+			size_t space = in.find(' ');
+			status = (space == std::string::npos) ? 0 : atoi(in.c_str() + space + 1);
+			size_t headerEnd = in.find("\r\n\r\n");
+			if (headerEnd != std::string::npos)
+			{
+				body = in.substr(headerEnd + 4);
+			}
+		}
+		HttpDone callback = std::move(done);
+		out.clear();
+		in.clear();
+		callback(status, body);
+	} // finish()
+
+	void onEvent(uint32_t events)
+	{
+		if (events & EPOLLOUT)
+		{
+			int error = 0;
+			socklen_t length = sizeof(error);
+			getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length);
+			if (error != 0)
+			{
+				finish(false);
+				return;
+			}
+			while (written < out.size())
+			{
+				ssize_t sent = send(fd, out.data() + written, out.size() - written, MSG_NOSIGNAL);
+				if (sent < 0)
+				{
+					if (errno == EAGAIN)
+					{
+						return;
+					}
+					finish(false);
+					return;
+				}
+				written += sent;
+			}
+			loop.modify(watch, EPOLLIN | EPOLLRDHUP);
+		}
+		if (events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+		{
+			char buffer[4096];
+			for (;;)
+			{
+				ssize_t got = recv(fd, buffer, sizeof(buffer), 0);
+				if (got > 0)
+				{
+					in.append(buffer, got);
+					continue;
+				}
+				if (got < 0 && errno == EAGAIN)
+				{
+					return;
+				}
+				finish(got == 0); // orderly close ends the response
+				return;
+			}
+		}
+	} // onEvent()
+};
+} // namespace
+
+void httpExchange(EventLoop &loop, const Endpoint &endpoint, std::string request, uint64_t timeoutMs, HttpDone done)
+{
+	int fd = connectNonBlocking(endpoint);
+	if (fd < 0)
+	{
+		done(0, std::string());
+		return;
+	}
+	auto exchange = std::make_shared<Exchange>(loop);
+	exchange->fd = fd;
+	exchange->out = std::move(request);
+	exchange->done = std::move(done);
+	exchange->watch = loop.add(fd, EPOLLOUT, [exchange](uint32_t events) { exchange->onEvent(events); });
+	if (exchange->watch == 0)
+	{
+		exchange->finish(false);
+		return;
+	}
+	std::weak_ptr<Exchange> pending = exchange;
+	loop.after(timeoutMs, [pending] {
+		if (auto late = pending.lock())
+		{
+			late->finish(false);
+		}
+	});
+} // httpExchange()
+
+// End of file
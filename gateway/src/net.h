@@ -0,0 +1,40 @@
+/**
+ * @file net.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Endpoints and one shot HTTP exchanges on the event loop.
+ *
+ * Requests are sent as HTTP/1.0 with "Connection: close", so a response is
+ * complete when the server closes and is never chunked. TLS is not spoken
+ * here; an HTTPS service is reached through a local TLS proxy.
+ *
+ * Functions:
+ * - resolveEndpoint(text, defaultPort, endpoint): Parse "host[:port]" and resolve it.
+ * - connectNonBlocking(endpoint): Start a TCP connect, returns the socket or -1.
+ * - httpExchange(loop, endpoint, request, timeoutMs, done): Send a request, deliver status and body.
+ */
+#ifndef NET_H
+#define NET_H
+
+#include <cstdint>
+#include <functional>
+#include <netinet/in.h>
+#include <string>
+
+#include "eventLoop.h"
+
+struct Endpoint
+{
+	std::string host;
+	uint16_t port = 0;
+	sockaddr_in address{};
+};
+
+using HttpDone = std::function<void(int status, const std::string &body)>; ///< status 0 on network error
+
+bool resolveEndpoint(const std::string &text, uint16_t defaultPort, Endpoint &endpoint);
+int connectNonBlocking(const Endpoint &endpoint);
+void httpExchange(EventLoop &loop, const Endpoint &endpoint, std::string request, uint64_t timeoutMs, HttpDone done);
+
+#endif // NET_H
+// End of file
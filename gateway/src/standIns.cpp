@@ -0,0 +1,555 @@
+/**
+ * @file standIns.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Local stand-ins for the weather API, APRS-IS, ThingSpeak, an MQTT broker and a DNS server.
+ * @details The API body copies the layout of a real v2/pws/observations/current
+ *          response so the parser does the same work as in service. The broker
+ *          reads and writes packets with mqttPacket.h, and the DNS stub
+ *          its messages with dnsMessage.h, as the firmware does.
+ */
+
+#include "standIns.h"
+
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dnsMessage.h"
+#include "mqttPacket.h"
+
+enum
+{
+	KIND_API,
+	KIND_APRS,
+	KIND_THINGSPEAK,
+	KIND_MQTT,
+	KINDS
+};
+
+namespace
+{
+struct Connection
+{
+	int fd;
+	uint64_t watch = 0;
+	std::string in;
+	std::string out;
+	bool closeAfterWrite = false;
+	bool connected = false; // MQTT CONNECT accepted
+	bool hasWill = false;	// MQTT will to publish if the client drops
+	bool willRetain = false;
+	std::string willTopic;
+	std::string willMessage;
+};
+
+std::string observationBody(const std::string &stationId)
+{
+	unsigned hash = std::hash<std::string>()(stationId);
+	char body[1024];
+	snprintf(body, sizeof(body),
+			 "{\"observations\":[{\"stationID\":\"%s\",\"obsTimeUtc\":\"2025-06-21T12:00:00Z\","
+			 "\"obsTimeLocal\":\"2025-06-21 08:00:00\",\"neighborhood\":\"Stand-in\",\"softwareType\":null,"
+			 "\"country\":\"US\",\"solarRadiation\":%u.4,\"lon\":-77.%05u,\"realtimeFrequency\":null,"
+			 "\"epoch\":1750507200,\"lat\":38.%05u,\"uv\":%u.0,\"winddir\":%u,\"humidity\":%u.0,\"qcStatus\":1,"
+			 "\"metric\":{\"temp\":%u.%u,\"heatIndex\":%u.%u,\"dewpt\":12.3,\"windChill\":%u.%u,\"windSpeed\":%u.2,"
+			 "\"windGust\":%u.9,\"pressure\":101%u.42,\"precipRate\":0.00,\"precipTotal\":%u.27,\"elev\":95.1}}]}",
+			 stationId.c_str(), hash % 900, hash % 100000, (hash >> 7) % 100000, hash % 11, hash % 360,
+			 30 + hash % 70, 10 + hash % 20, hash % 10, 10 + hash % 20, hash % 10, 10 + hash % 20, hash % 10,
+			 hash % 30, hash % 50, hash % 10, hash % 20);
+	return body;
+} // observationBody()
+
+std::string queryValue(const std::string &request, const char *key)
+{
+	size_t start = request.find(key);
+	if (start == std::string::npos)
+	{
+		return "";
+	}
+	start += strlen(key);
+	size_t end = request.find_first_of("& ", start);
+	return request.substr(start, end - start);
+} // queryValue()
+
+// the string value after "name": in text, false if there is none
+bool stringMember(const std::string &text, const char *name, std::string &value)
+{
+	size_t at = text.find(std::string("\"") + name + "\"");
+	at = (at == std::string::npos) ? at : text.find_first_not_of(" \t\r\n", at + strlen(name) + 2);
+	if (at == std::string::npos || text[at] != ':')
+	{
+		return false;
+	}
+	at = text.find_first_not_of(" \t\r\n", at + 1);
+	if (at == std::string::npos || text[at] != '"')
+	{
+		return false;
+	}
+	size_t end = text.find('"', at + 1);
+	value = text.substr(at + 1, end == std::string::npos ? 0 : end - at - 1);
+	return end != std::string::npos;
+} // stringMember()
+
+// check a bulk_update.json body the way ThingSpeak does, count its rows, return the HTTP status
+int bulkUpdate(const std::string &body, const std::string &requiredKey, uint64_t &rows)
+{
+	std::string key;
+	if (!stringMember(body, "write_api_key", key) || key.empty() || (!requiredKey.empty() && key != requiredKey))
+	{
+		return 401;
+	}
+	size_t at = body.find("\"updates\"");
+	at = (at == std::string::npos) ? at : body.find('[', at);
+	if (at == std::string::npos)
+	{
+		return 400;
+	}
+	rows = 0;
+	int depth = 0;
+	size_t rowStart = 0;
+	for (at++; at < body.size(); at++)
+	{
+		char c = body[at];
+		if (c == '"')
+		{
+			at = body.find('"', at + 1); // no escapes in the rows
+			if (at == std::string::npos)
+			{
+				return 400;
+			}
+		}
+		else if (c == '{' && depth++ == 0)
+		{
+			rowStart = at;
+		}
+		else if (c == '}' && --depth == 0)
+		{
+			std::string row = body.substr(rowStart, at - rowStart + 1);
+			size_t created = row.find("\"created_at\"");
+			created = (created == std::string::npos) ? created : row.find_first_not_of(" :", created + 12);
+			if (created == std::string::npos || !(isdigit((unsigned char)row[created]) || row[created] == '"'))
+			{
+				return 400; // every row needs its time
+			}
+			rows++;
+		}
+		else if (c == ']' && depth == 0)
+		{
+			return rows > 0 ? 202 : 400;
+		}
+	}
+	return 400; // array not closed
+} // bulkUpdate()
+
+std::string mqttPacket(uint8_t type, const std::string &body)
+{
+	uint8_t header[MQTT_HEADER_MAX];
+	size_t used = mqttHeader(header, type, body.size());
+	return std::string((const char *)header, used) + body;
+} // mqttPacket()
+
+std::string getString(const std::string &body, size_t &at, bool &ok)
+{
+	const char *text;
+	size_t length;
+	ok = ok && mqttGetString((const uint8_t *)body.data(), body.size(), at, text, length);
+	return ok ? std::string(text, length) : "";
+} // getString()
+
+bool topicMatches(const std::string &filter, const std::string &topic)
+{
+	if (!filter.empty() && filter.back() == '#')
+	{
+		return topic.compare(0, filter.size() - 1, filter, 0, filter.size() - 1) == 0;
+	}
+	return filter == topic;
+} // topicMatches()
+
+// answer one broker packet into c.out, false to drop the connection
+bool brokerPacket(Connection &c, uint8_t type, const std::string &body, std::map<std::string, std::string> &retained,
+				  std::set<std::string> &sessions)
+{
+	bool ok = true;
+	size_t at = 0;
+	if ((type & 0xF0) == MQTT_CONNECT && !c.connected)
+	{
+		std::string protocol = getString(body, at, ok);
+		if (!ok || at + 4 > body.size())
+		{
+			return false;
+		}
+		uint8_t level = body[at];
+		uint8_t flags = body[at + 1];
+		at += 4; // level, flags, keep alive
+		std::string clientId = getString(body, at, ok);
+		if (flags & MQTT_WILL)
+		{
+			c.willTopic = getString(body, at, ok);
+			c.willMessage = getString(body, at, ok);
+			c.willRetain = flags & MQTT_WILL_RETAIN;
+		}
+		if (!ok)
+		{
+			return false;
+		}
+		if (protocol != "MQTT" || level != 4)
+		{
+			c.out += mqttPacket(MQTT_CONNACK, std::string("\0\1", 2)); // unacceptable protocol version
+			c.closeAfterWrite = true;
+			return true;
+		}
+		bool present = false;
+		if (flags & MQTT_CLEAN_SESSION)
+		{
+			sessions.erase(clientId);
+		}
+		else
+		{
+			present = !sessions.insert(clientId).second;
+		}
+		c.connected = true;
+		c.hasWill = flags & MQTT_WILL;
+		c.out += mqttPacket(MQTT_CONNACK, std::string(present ? "\1\0" : "\0\0", 2));
+		return true;
+	}
+	if (!c.connected)
+	{
+		return false; // CONNECT must come first, and only once
+	}
+	switch (type & 0xF0)
+	{
+	case MQTT_PUBLISH:
+	{
+		uint8_t qos = (type >> 1) & 0x03;
+		std::string topic = getString(body, at, ok);
+		if (!ok || qos > 1 || at + (qos ? 2 : 0) > body.size())
+		{
+			return false; // QoS 2 is not supported
+		}
+		std::string id = body.substr(at, qos ? 2 : 0);
+		at += id.size();
+		if (type & MQTT_RETAIN)
+		{
+			if (at == body.size())
+			{
+				retained.erase(topic); // an empty retained message clears the topic
+			}
+			else
+			{
+				retained[topic] = body.substr(at);
+			}
+		}
+		if (qos == 1)
+		{
+			c.out += mqttPacket(MQTT_PUBACK, id);
+		}
+		return true;
+	}
+	case MQTT_SUBSCRIBE & 0xF0:
+	{
+		if (body.size() < 2)
+		{
+			return false;
+		}
+		std::string granted = body.substr(0, 2); // packet id
+		std::string deliver;
+		at = 2;
+		while (ok && at < body.size())
+		{
+			std::string filter = getString(body, at, ok);
+			ok = ok && at < body.size();
+			at++; // requested QoS, granted 0
+			granted += '\0';
+			for (const auto &message : retained)
+			{
+				if (ok && topicMatches(filter, message.first))
+				{
+					uint8_t out[1024];
+					size_t length = mqttPublishBody(out, sizeof(out), message.first.c_str(),
+													(const uint8_t *)message.second.data(), message.second.size(), 0, 0);
+					deliver += mqttPacket(mqttPublishType(0, false, true), std::string((const char *)out, length));
+				}
+			}
+		}
+		c.out += mqttPacket(MQTT_SUBACK, granted) + deliver;
+		return ok;
+	}
+	case MQTT_PINGREQ:
+		c.out += mqttPacket(MQTT_PINGRESP, "");
+		return true;
+	case MQTT_DISCONNECT:
+		c.hasWill = false; // a clean disconnect drops the will
+		c.closeAfterWrite = true;
+		return true;
+	default:
+		return false;
+	}
+} // brokerPacket()
+} // namespace
+
+StandIns::~StandIns()
+{
+	if (thread.joinable())
+	{
+		loop.stop();
+		thread.join();
+	}
+}
+
+int StandIns::listenOn(uint16_t &port, int type)
+{
+	int fd = socket(AF_INET, type | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	int one = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t length = sizeof(address);
+	if (fd < 0 || bind(fd, (sockaddr *)&address, length) < 0 || (type == SOCK_STREAM && listen(fd, 1024) < 0) ||
+		getsockname(fd, (sockaddr *)&address, &length) < 0)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return -1;
+	}
+	port = ntohs(address.sin_port);
+	return fd;
+} // listenOn()
+
+void StandIns::accept(int listener, int kind)
+{
+	for (;;)
+	{
+		int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if (fd < 0)
+		{
+			return;
+		}
+		auto connection = std::make_shared<Connection>();
+		connection->fd = fd;
+
+		auto flush = [this](Connection &c) {
+			while (!c.out.empty())
+			{
+				ssize_t written = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+				if (written <= 0)
+				{
+					if (written < 0 && errno == EAGAIN)
+					{
+						loop.modify(c.watch, EPOLLIN | EPOLLOUT);
+						return;
+					}
+					break;
+				}
+				c.out.erase(0, written);
+			}
+			if (c.closeAfterWrite || !c.out.empty())
+			{
+				loop.remove(c.watch);
+				close(c.fd);
+				return;
+			}
+			loop.modify(c.watch, EPOLLIN);
+		};
+
+		if (kind == KIND_APRS)
+		{
+			connection->out = "# aprsc 2.1.19 stand-in\r\n";
+		}
+		connection->watch = loop.add(fd, EPOLLIN | EPOLLOUT, [this, connection, kind, flush](uint32_t events) {
+			Connection &c = *connection;
+			if (events & EPOLLIN)
+			{
+				char buffer[4096];
+				ssize_t got;
+				while ((got = recv(c.fd, buffer, sizeof(buffer), 0)) > 0)
+				{
+					c.in.append(buffer, got);
+				}
+				if (got == 0 || (got < 0 && errno != EAGAIN))
+				{
+					if (c.hasWill && c.willRetain)
+					{
+						retained[c.willTopic] = c.willMessage; // the client dropped without DISCONNECT
+					}
+					loop.remove(c.watch);
+					close(c.fd);
+					return;
+				}
+			}
+
+			size_t headerEnd = c.in.find("\r\n\r\n");
+			if (kind == KIND_API && headerEnd != std::string::npos)
+			{
+				std::string body = observationBody(queryValue(c.in, "stationId="));
+				c.out = "HTTP/1.0 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+						std::to_string(body.size()) + "\r\n\r\n" + body;
+				c.in.clear();
+				c.closeAfterWrite = true;
+			}
+			else if (kind == KIND_THINGSPEAK && headerEnd != std::string::npos)
+			{
+				size_t length = atoi(queryValue(c.in, "Content-Length: ").c_str());
+				if (c.in.size() >= headerEnd + 4 + length)
+				{
+					std::string status = "200 OK";
+					std::string body;
+					if (c.in.compare(0, 15, "POST /channels/") == 0 &&
+						c.in.find("/bulk_update.json ") < c.in.find('\n'))
+					{
+						uint64_t rows = 0;
+						int code = bulkUpdate(c.in.substr(headerEnd + 4, length), thingspeakKey, rows);
+						status = code == 202 ? "202 Accepted" : code == 401 ? "401 Unauthorized" : "400 Bad Request";
+						body = code == 202 ? "{\"success\":true}" : "{\"success\":false}";
+						thingspeakUpdates += (code == 202) ? rows : 0;
+					}
+					else
+					{
+						body = "{\"entry_id\":" + std::to_string(++thingspeakUpdates) + "}";
+					}
+					c.out = "HTTP/1.0 " + status + "\r\nContent-Type: application/json\r\nContent-Length: " +
+							std::to_string(body.size()) + "\r\n\r\n" + body;
+					c.in.clear();
+					c.closeAfterWrite = true;
+				}
+			}
+			else if (kind == KIND_APRS)
+			{
+				size_t end;
+				while ((end = c.in.find('\n')) != std::string::npos)
+				{
+					std::string line = c.in.substr(0, end);
+					c.in.erase(0, end + 1);
+					if (line.compare(0, 5, "user ") == 0)
+					{
+						c.out += "# logresp " + line.substr(5, line.find(' ', 5) - 5) + " verified, server STANDIN\r\n";
+					}
+					else if (!line.empty() && line[0] != '#')
+					{
+						aprsPackets++;
+					}
+				}
+			}
+			else if (kind == KIND_MQTT)
+			{
+				size_t length;
+				int used;
+				while ((used = mqttParseHeader((const uint8_t *)c.in.data(), c.in.size(), length)) != 0)
+				{
+					if (used < 0 || c.closeAfterWrite)
+					{
+						c.closeAfterWrite = true;
+						break;
+					}
+					if (c.in.size() < used + length)
+					{
+						break; // rest of the body to come
+					}
+					uint8_t type = c.in[0];
+					std::string body = c.in.substr(used, length);
+					c.in.erase(0, used + length);
+					mqttPublishes += (type & 0xF0) == MQTT_PUBLISH;
+					if (!brokerPacket(c, type, body, retained, sessions))
+					{
+						c.closeAfterWrite = true; // protocol error
+						break;
+					}
+				}
+			}
+			flush(c);
+		});
+	}
+} // accept()
+
+void StandIns::dnsRecord(const std::string &name, uint32_t address, uint32_t ttl)
+{
+	std::lock_guard<std::mutex> lock(dnsMutex);
+	dnsRecords[name] = {address, ttl};
+}
+
+void StandIns::dnsRemove(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(dnsMutex);
+	dnsRecords.erase(name);
+}
+
+void StandIns::answerDns(int fd)
+{
+	uint8_t query[DNS_PACKET_SIZE];
+	sockaddr_in from{};
+	socklen_t fromLength = sizeof(from);
+	ssize_t got;
+	while ((got = recvfrom(fd, query, sizeof(query), 0, (sockaddr *)&from, &fromLength)) > 0)
+	{
+		dnsQueries++;
+		uint16_t id;
+		char name[DNS_NAME_MAX + 1];
+		int questionEnd = dnsQuestion(query, got, id, name, sizeof(name));
+		if (questionEnd < 0 || dnsSilent)
+		{
+			continue;
+		}
+		uint8_t rcode = DNS_RCODE_NXDOMAIN;
+		uint32_t address = 0;
+		uint32_t ttl = 0;
+		{
+			std::lock_guard<std::mutex> lock(dnsMutex);
+			auto record = dnsRecords.find(name);
+			if (record != dnsRecords.end())
+			{
+				rcode = DNS_RCODE_OK;
+				address = record->second.first;
+				ttl = record->second.second;
+			}
+		}
+		uint8_t reply[DNS_PACKET_SIZE];
+		size_t length = dnsReply(reply, sizeof(reply), query, questionEnd, rcode, address, ttl);
+		sendto(fd, reply, length, 0, (sockaddr *)&from, fromLength);
+		fromLength = sizeof(from);
+	}
+} // answerDns()
+
+bool StandIns::start()
+{
+	int listeners[KINDS] = {listenOn(apiPort), listenOn(aprsPort), listenOn(thingspeakPort), listenOn(mqttPort)};
+	for (int kind = 0; kind < KINDS; kind++)
+	{
+		if (listeners[kind] < 0)
+		{
+			return false;
+		}
+		int listener = listeners[kind];
+		loop.add(listener, EPOLLIN, [this, listener, kind](uint32_t) { accept(listener, kind); });
+	}
+	int dns = listenOn(dnsPort, SOCK_DGRAM);
+	if (dns < 0)
+	{
+		return false;
+	}
+	loop.add(dns, EPOLLIN, [this, dns](uint32_t) { answerDns(dns); });
+	thread = std::thread([this] { loop.run(); });
+	pthread_getcpuclockid(thread.native_handle(), &clock);
+	return true;
+} // start()
+
+double StandIns::cpuSeconds() const
+{
+	timespec used{};
+	clock_gettime(clock, &used);
+	return used.tv_sec + used.tv_nsec / 1e9;
+}
+
+// End of file
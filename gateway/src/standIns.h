@@ -0,0 +1,81 @@
+/**
+ * @file standIns.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Local stand-ins for the weather API, APRS-IS, ThingSpeak, an MQTT broker and a DNS server.
+ *
+ * Used by --bench so the gateway can be measured without the Internet or
+ * API quota, and by the unit tests. The servers run on their own thread and event loop and listen
+ * on loopback ports chosen by the kernel.
+ * - API: answers any current observation request with a fixed-size JSON body
+ *   whose values vary with the station id.
+ * - APRS-IS: sends a banner, verifies any logon and counts packets.
+ * - ThingSpeak: accepts any update.json and counts it. A bulk_update.json must
+ *   carry write_api_key (thingspeakKey if set, else any) and an updates array
+ *   whose rows all have created_at; it is answered 202 {"success":true}, a bad
+ *   key 401 and bad rows 400, as the service does. Rows are counted as updates.
+ * - MQTT: a 3.1.1 broker with QoS 0 and 1, retained messages, last wills and
+ *   kept sessions. SUBSCRIBE delivers the retained messages that match (exact
+ *   topic, or a filter ending in "#"); later publishes are not forwarded.
+ * - DNS: a UDP stub that answers A queries for the names given to dnsRecord()
+ *   with their address and TTL, and any other name NXDOMAIN. With dnsSilent
+ *   set it drops every query, as an unreachable server would.
+ *
+ * Functions:
+ * - start(): Open the listeners and start the thread.
+ * - cpuSeconds(): CPU time used by the stand-in thread.
+ * - dnsRecord(name, address, ttl) / dnsRemove(name): Change the DNS stub's records, any thread.
+ */
+#ifndef STAND_INS_H
+#define STAND_INS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+
+#include "eventLoop.h"
+
+class StandIns
+{
+public:
+	StandIns() = default;
+	~StandIns(); ///< stops the thread
+
+	bool start();				///< listen and run, false if a socket fails
+	double cpuSeconds() const;	///< CPU time of the stand-in thread
+	void dnsRecord(const std::string &name, uint32_t address, uint32_t ttl); ///< answer name, first octet high
+	void dnsRemove(const std::string &name);								 ///< answer name NXDOMAIN
+
+	uint16_t apiPort = 0;
+	uint16_t aprsPort = 0;
+	uint16_t thingspeakPort = 0;
+	uint16_t mqttPort = 0;
+	uint16_t dnsPort = 0; ///< UDP
+	std::string thingspeakKey; ///< bulk write key to require, empty for any; set before start()
+	std::atomic<uint64_t> aprsPackets{0};
+	std::atomic<uint64_t> thingspeakUpdates{0};
+	std::atomic<uint64_t> mqttPublishes{0};
+	std::atomic<uint64_t> dnsQueries{0};
+	std::atomic<bool> dnsSilent{false}; ///< drop queries unanswered
+
+private:
+	EventLoop loop;
+	std::thread thread;
+	clockid_t clock{};
+	std::map<std::string, std::string> retained; ///< broker topic to message, loop thread only
+	std::set<std::string> sessions;				 ///< broker client ids with a kept session
+	std::mutex dnsMutex;
+	std::map<std::string, std::pair<uint32_t, uint32_t>> dnsRecords; ///< name to address and TTL, under dnsMutex
+
+	int listenOn(uint16_t &port, int type = SOCK_STREAM);
+	void accept(int listener, int kind);
+	void answerDns(int fd);
+};
+
+#endif // STAND_INS_H
+// End of file
@@ -0,0 +1,79 @@
+/**
+ * @file workerPool.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Fixed pool of threads for parsing and formatting.
+ */
+
+#include "workerPool.h"
+
+#include <pthread.h>
+#include <time.h>
+
+WorkerPool::WorkerPool(unsigned count)
+{
+	count = count ? count : 1;
+	clocks.resize(count);
+	for (unsigned i = 0; i < count; i++)
+	{
+		threads.emplace_back(&WorkerPool::work, this);
+		pthread_getcpuclockid(threads.back().native_handle(), &clocks[i]);
+	}
+} // WorkerPool()
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	ready.notify_all();
+	for (std::thread &thread : threads)
+	{
+		thread.join();
+	}
+} // ~WorkerPool()
+
+void WorkerPool::submit(Job job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	ready.notify_one();
+} // submit()
+
+double WorkerPool::cpuSeconds() const
+{
+	uint64_t ns = 0;
+	for (clockid_t clock : clocks)
+	{
+		timespec used;
+		if (clock_gettime(clock, &used) == 0)
+		{
+			ns += (uint64_t)used.tv_sec * 1000000000ULL + used.tv_nsec;
+		}
+	}
+	return ns / 1e9;
+} // cpuSeconds()
+
+void WorkerPool::work()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (jobs.empty())
+			{
+				return; // stopping and drained
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+} // work()
+
+// End of file
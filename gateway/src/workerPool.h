@@ -0,0 +1,48 @@
+/**
+ * @file workerPool.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Fixed pool of threads for parsing and formatting.
+ *
+ * The event loop only moves bytes; each completed API response is handed to a
+ * worker, which parses it and formats the APRS and ThingSpeak payloads, then
+ * posts the result back to the loop.
+ *
+ * Functions:
+ * - submit(job): Queue a job for the next free worker.
+ * - cpuSeconds(): CPU time used by the workers so far, valid until destruction.
+ */
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+	using Job = std::function<void()>;
+
+	explicit WorkerPool(unsigned threads);
+	~WorkerPool(); ///< finishes queued jobs, then joins
+
+	void submit(Job job);	   ///< queue a job
+	double cpuSeconds() const; ///< CPU time of all workers
+
+private:
+	std::vector<std::thread> threads;
+	std::deque<Job> jobs;
+	std::mutex mutex;
+	std::condition_variable ready;
+	bool stopping = false;
+	std::vector<clockid_t> clocks; // per thread CPU clocks
+
+	void work();
+};
+
+#endif // WORKER_POOL_H
+// End of file
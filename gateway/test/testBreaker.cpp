@@ -0,0 +1,208 @@
+/**
+ * @file testBreaker.cpp
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Tests of the retry backoff and circuit breaker (circuitBreaker.h) under a fake clock.
+ * @details The jitter source is replaced by one the test sets, so each backoff
+ *          can be checked at both ends of its range.
+ */
+
+#include "unitTest.h"
+
+#include "circuitBreaker.h"
+
+static uint32_t jitterPick = 0; // 0 for the shortest backoff, 1 for the longest
+
+static uint32_t testRandom(uint32_t bound)
+{
+	return jitterPick ? bound - 1 : 0;
+}
+
+static int events = 0;
+
+static void countEvents(const endpointHealth &, const char *)
+{
+	events++;
+}
+
+// 1 s doubling to 8 s, open for 60 s after 4 failures
+const retryPolicy TEST_POLICY = {1000, 8000, 4, 60000};
+
+static bool waiting = true; // what the retried endpoints have pending
+
+static bool retryWaiting()
+{
+	return waiting;
+}
+
+static uint32_t retryIn(const endpointHealth &health)
+{
+	return health.retryAt - fakeClock();
+}
+
+// each failure doubles the wait up to maxDelay, half of it fixed
+static void testBackoff()
+{
+	static endpointHealth health = ENDPOINT_HEALTH_RETRIED("backoff", TEST_POLICY, retryWaiting);
+	setFakeClock(10000);
+	CHECK(policyAllow(health));
+	CHECK(!policyRetryDue(health)); // nothing failed
+	CHECK_EQUAL(policyNextRetry(), POLICY_NEVER);
+
+	jitterPick = 0;
+	policyFailure(health);
+	CHECK_EQUAL(retryIn(health), 500); // half of 1 s
+	CHECK(!policyAllow(health));
+	CHECK_EQUAL(health.refused, 1);
+	CHECK_EQUAL(policyNextRetry(), 500);
+	advanceClock(499);
+	CHECK(!policyRetryDue(health));
+	advanceClock(1);
+	CHECK(policyRetryDue(health));
+	CHECK(policyAllow(health));
+
+	jitterPick = 1;
+	policyFailure(health);
+	CHECK_EQUAL(retryIn(health), 2000); // all of 2 s
+	policyFailure(health);
+	CHECK_EQUAL(retryIn(health), 4000);
+	CHECK_EQUAL(health.state, BREAKER_CLOSED);
+
+	policySuccess(health); // success forgets the failures
+	CHECK_EQUAL(health.failures, 0);
+	CHECK(policyAllow(health));
+	CHECK_EQUAL(health.successes, 1);
+	CHECK_EQUAL(health.errors, 3);
+} // testBackoff()
+
+// the longest backoff is maxDelay, however high the shift
+static void testBackoffCap()
+{
+	static const retryPolicy patient = {1000, 8000, 200, 60000};
+	static endpointHealth health = ENDPOINT_HEALTH("cap", patient); // the policy keeps a pointer to it
+	setFakeClock(0);
+	jitterPick = 1;
+	for (int i = 0; i < 40; i++)
+	{
+		policyFailure(health);
+	}
+	CHECK_EQUAL(health.state, BREAKER_CLOSED);
+	CHECK_EQUAL(retryIn(health), 8000);
+	policySuccess(health);
+} // testBackoffCap()
+
+// closed, open at the threshold, half-open probe, then closed or open again
+static void testStates()
+{
+	static endpointHealth health = ENDPOINT_HEALTH("breaker", TEST_POLICY);
+	setFakeClock(50000);
+	jitterPick = 0;
+	events = 0;
+	for (int i = 0; i < 3; i++)
+	{
+		policyFailure(health);
+	}
+	CHECK_EQUAL(health.state, BREAKER_CLOSED);
+	policyFailure(health); // the fourth opens the circuit
+	CHECK_EQUAL(health.state, BREAKER_OPEN);
+	CHECK_EQUAL(retryIn(health), 30000); // half of the open time with the least jitter
+	CHECK_EQUAL(events, 4);
+
+	advanceClock(29999);
+	CHECK(!policyAllow(health)); // still open
+	advanceClock(1);
+	CHECK(policyAllow(health)); // one probe
+	CHECK_EQUAL(health.state, BREAKER_HALF_OPEN);
+	CHECK(!policyAllow(health)); // the probe is in flight
+	CHECK(!policyRetryDue(health));
+
+	policyFailure(health); // a failed probe opens it again at once
+	CHECK_EQUAL(health.state, BREAKER_OPEN);
+	advanceClock(30000);
+	CHECK(policyAllow(health));
+	CHECK_EQUAL(health.state, BREAKER_HALF_OPEN);
+
+	policySuccess(health); // recovery
+	CHECK_EQUAL(health.state, BREAKER_CLOSED);
+	CHECK_EQUAL(health.failures, 0);
+	CHECK(policyAllow(health));
+	CHECK_EQUAL(events, 8); // open, half-open, open, half-open, closed and three backoffs
+} // testStates()
+
+// a probe that never reports is allowed again after the open time
+static void testLostProbe()
+{
+	static endpointHealth health = ENDPOINT_HEALTH("probe", TEST_POLICY);
+	setFakeClock(0xFFFFA000UL); // and the deadlines cross the rollover
+	jitterPick = 1;
+	for (int i = 0; i < 4; i++)
+	{
+		policyFailure(health);
+	}
+	CHECK_EQUAL(retryIn(health), 60000);
+	advanceClock(60000);
+	CHECK(policyAllow(health));
+	CHECK(fakeClock() < 0xFFFFA000UL); // the clock rolled over
+	advanceClock(59999);
+	CHECK(!policyAllow(health));
+	advanceClock(1);
+	CHECK(policyAllow(health));
+	CHECK_EQUAL(health.state, BREAKER_HALF_OPEN);
+	policySuccess(health);
+} // testLostProbe()
+
+// after an outage every failed endpoint may try at once; only retries
+// something is waiting for count towards the next one
+static void testRetryAll()
+{
+	static endpointHealth first = ENDPOINT_HEALTH_RETRIED("first", TEST_POLICY, retryWaiting);
+	static endpointHealth second = ENDPOINT_HEALTH("second", TEST_POLICY); // retried by its next scheduled attempt
+	setFakeClock(1000000);
+	jitterPick = 1;
+	waiting = true;
+	policyFailure(second);
+	CHECK_EQUAL(policyNextRetry(), POLICY_NEVER);
+	policyFailure(first);
+	policyFailure(second);
+	CHECK_EQUAL(policyNextRetry(), 1000);
+	policyRetryAll();
+	CHECK_EQUAL(policyNextRetry(), 0); // overdue, its service runs it on the next pass
+	CHECK(policyRetryDue(first));
+	CHECK(policyRetryDue(second));
+
+	waiting = false; // the data went out another way: nothing will run the retry
+	CHECK_EQUAL(policyNextRetry(), POLICY_NEVER);
+	advanceClock(100000);
+	CHECK_EQUAL(policyNextRetry(), POLICY_NEVER);
+	policyFailure(first);
+	CHECK_EQUAL(policyNextRetry(), POLICY_NEVER);
+	waiting = true;
+	CHECK_EQUAL(policyNextRetry(), 2000);
+
+	policySuccess(first);
+	policySuccess(second);
+	CHECK_EQUAL(policyNextRetry(), POLICY_NEVER);
+
+	bool listed = false;
+	endpointHealth *health;
+	for (int i = 0; (health = policyEndpointAt(i)) != nullptr; i++)
+	{
+		listed = listed || health == &second;
+	}
+	CHECK(listed);
+} // testRetryAll()
+
+void testBreaker()
+{
+	setPolicyClock(fakeClock);
+	setPolicyRandom(testRandom);
+	setPolicyLog(countEvents);
+	testBackoff();
+	testBackoffCap();
+	testStates();
+	testLostProbe();
+	testRetryAll();
+	setPolicyLog(nullptr);
+} // testBreaker()
+
+// End of file
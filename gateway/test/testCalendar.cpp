@@ -0,0 +1,175 @@
+/**
+ * @file testCalendar.cpp
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Tests of the wall-clock calendar (calendarScheduler.h) across DST and under a simulated clock.
+ * @details Local offsets come from the America/New_York rule in tzRules.h, read
+ *          through the C library as testTzRules.cpp does. In 2026 its clocks go
+ *          forward at 2026-03-08 07:00 UTC and back at 2026-11-01 06:00 UTC.
+ */
+
+#include "unitTest.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+
+#include "calendarScheduler.h"
+#include "tzRules.h"
+
+#define SPRING_2026 1772953200UL // 2026-03-08 02:00 EST becomes 03:00 EDT
+#define FALL_2026 1793512800UL	 // 2026-11-01 02:00 EDT becomes 01:00 EST
+
+static uint32_t utcNow = 0;
+
+static uint32_t testClock()
+{
+	return utcNow;
+}
+
+static int32_t zoneOffset(uint32_t utc)
+{
+	time_t t = (time_t)utc;
+	tm local;
+	localtime_r(&t, &local);
+	return (int32_t)local.tm_gmtoff;
+}
+
+static int runs = 0;
+
+static void countRuns()
+{
+	runs++;
+}
+
+static uint32_t customTime = 0; // what nextAfter() answers, 0 for unknown
+
+static uint32_t customNext(uint32_t after)
+{
+	return customTime > after ? customTime : 0;
+}
+
+// local times keep their wall-clock time; a skipped or repeated time runs once
+static void testDaily()
+{
+	calendarEvent morning = CALENDAR_DAILY("morning", countRuns, 8, 0, 1800);
+	// 08:00 EST on the 7th, 08:00 EDT on the 8th: 23 hours apart
+	CHECK_EQUAL(calendarNext(morning, 1772888400 - 1), 1772888400);
+	CHECK_EQUAL(calendarNext(morning, 1772888400), 1772971200);
+	CHECK_EQUAL(calendarNext(morning, 1772971200), 1773057600);
+	// 08:00 EDT on 31 October, 08:00 EST on 1 November: 25 hours apart
+	CHECK_EQUAL(calendarNext(morning, 1793448000 - 1), 1793448000);
+	CHECK_EQUAL(calendarNext(morning, 1793448000), 1793538000);
+
+	// 02:30 does not exist on 8 March; it runs an hour early, at 01:30 EST
+	calendarEvent skipped = CALENDAR_DAILY("skipped", countRuns, 2, 30, 1800);
+	CHECK_EQUAL(calendarNext(skipped, SPRING_2026 - 86400 + 3600), SPRING_2026 - 1800);
+	CHECK_EQUAL(calendarNext(skipped, SPRING_2026 - 1800), SPRING_2026 + 86400 - 3600 + 1800); // 02:30 EDT on the 9th
+	// 01:30 happens twice on 1 November; only the first, in EDT, runs
+	calendarEvent repeated = CALENDAR_DAILY("repeated", countRuns, 1, 30, 1800);
+	CHECK_EQUAL(calendarNext(repeated, FALL_2026 - 86400), FALL_2026 - 1800);
+	CHECK_EQUAL(calendarNext(repeated, FALL_2026 - 1800), FALL_2026 + 86400 + 1800); // 01:30 EST on the 2nd
+} // testDaily()
+
+// steps keep their spacing through the change and their local alignment after it
+static void testEvery()
+{
+	calendarEvent tenMinutes = CALENDAR_EVERY("ten", countRuns, 10, 0, 600);
+	CHECK_EQUAL(calendarNext(tenMinutes, SPRING_2026 - 300), SPRING_2026); // 01:55 EST to 03:00 EDT
+	CHECK_EQUAL(calendarNext(tenMinutes, SPRING_2026), SPRING_2026 + 600);
+	CHECK_EQUAL(calendarNext(tenMinutes, FALL_2026 - 300), FALL_2026); // 01:55 EDT to 01:00 EST
+	CHECK_EQUAL(calendarNext(tenMinutes, FALL_2026), FALL_2026 + 600);
+	CHECK_EQUAL(calendarNext(tenMinutes, FALL_2026 + 1), FALL_2026 + 600);
+
+	// 25 minute steps from midnight at :07 start over at the next local midnight
+	calendarEvent odd = CALENDAR_EVERY("odd", countRuns, 25, 7, 600);
+	uint32_t midnight = FALL_2026 - 7200; // 00:00 EDT on 1 November
+	CHECK_EQUAL(calendarNext(odd, midnight), midnight + 7 * 60);
+	// 1 November lasts 25 hours; its last step is 23:52 EST, then 00:07 EST the next day
+	uint32_t lastStep = midnight + 3600 + (7 + 57 * 25) * 60;
+	CHECK_EQUAL(calendarNext(odd, lastStep - 1), lastStep);
+	CHECK_EQUAL(calendarNext(odd, lastStep), lastStep + 900);
+	// the seconds form keeps an offset within the minute
+	calendarEvent seconds = CALENDAR_EVERY_SECONDS("seconds", countRuns, 15, 30, 600);
+	CHECK_EQUAL(calendarNext(seconds, SPRING_2026 - 900), SPRING_2026 - 900 + 30);
+	CHECK_EQUAL(calendarNext(seconds, SPRING_2026 - 870), SPRING_2026 + 30);
+} // testEvery()
+
+// due events run once within their grace, later ones are counted missed
+static void testRun()
+{
+	calendarEvent every = CALENDAR_EVERY("every", countRuns, 10, 0, 900);
+	calendarAdd(every);
+	runs = 0;
+
+	utcNow = 1000; // unset clock: nothing is calculated or run
+	CHECK_EQUAL(calendarRun(), CAL_RETRY);
+	CHECK_EQUAL(every.next, 0);
+
+	utcNow = SPRING_2026 - 300;
+	CHECK_EQUAL(calendarRun(), 300); // first pass only calculates
+	CHECK_EQUAL(every.next, SPRING_2026);
+	CHECK_EQUAL(calendarDueIn(), 300);
+	utcNow = SPRING_2026;
+	CHECK_EQUAL(calendarDueIn(), 0);
+	CHECK_EQUAL(calendarRun(), 600);
+	CHECK_EQUAL(runs, 1);
+
+	// late within the grace: runs once, although the 03:20 occurrence went by meanwhile
+	utcNow = SPRING_2026 + 600 + 700;
+	CHECK_EQUAL(calendarRun(), 500);
+	CHECK_EQUAL(runs, 2);
+	CHECK_EQUAL(every.missed, 0);
+	CHECK_EQUAL(every.next, SPRING_2026 + 1800);
+
+	// asleep past the grace: counted, not run, and the next one comes from now
+	utcNow = SPRING_2026 + 1800 + 901;
+	CHECK_EQUAL(calendarRun(), 299);
+	CHECK_EQUAL(every.next, SPRING_2026 + 3000);
+	CHECK_EQUAL(runs, 2);
+	CHECK_EQUAL(every.missed, 1);
+	CHECK_EQUAL(every.runs, 2);
+
+	// a clock stepped back by days recalculates instead of waiting for the old time
+	utcNow = SPRING_2026 - 3 * 86400;
+	CHECK_EQUAL(calendarRun(), 600);
+	CHECK_EQUAL(every.next, SPRING_2026 - 3 * 86400 + 600);
+	CHECK_EQUAL(runs, 2);
+
+	// a custom rule that does not know its time yet is asked again every CAL_RETRY
+	calendarEvent custom = CALENDAR_CUSTOM("custom", countRuns, customNext, 60);
+	calendarAdd(custom);
+	customTime = 0;
+	CHECK_EQUAL(calendarRun(), CAL_RETRY);
+	CHECK_EQUAL(custom.next, CAL_NEVER);
+	customTime = utcNow + 120;
+	CHECK_EQUAL(calendarRun(), 120);
+	utcNow += 120 + 60;
+	calendarRun();
+	CHECK_EQUAL(custom.runs, 1);
+
+	calendarRemove(every);
+	calendarRemove(custom);
+	CHECK(calendarEventAt(0) == nullptr);
+} // testRun()
+
+void testCalendar()
+{
+	const char *saved = getenv("TZ");
+	char *restore = saved ? strdup(saved) : nullptr;
+	char posix[TZ_POSIX_SIZE];
+	if (CHECK(tzPosixRule("America/New_York", posix, sizeof(posix))))
+	{
+		setenv("TZ", posix, 1);
+		tzset();
+		setCalendarClock(testClock, zoneOffset);
+		testDaily();
+		testEvery();
+		testRun();
+	}
+	restore ? setenv("TZ", restore, 1) : unsetenv("TZ");
+	tzset();
+	free(restore);
+} // testCalendar()
+
+// End of file
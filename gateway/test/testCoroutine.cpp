@@ -0,0 +1,194 @@
+/**
+ * @file testCoroutine.cpp
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Tests of protothreads and coroutines (protothread.h, coroutine.h) under a fake clock.
+ * @details The coroutines are resumed by the scheduler task in coroutine.cpp,
+ *          as on the firmware, while the test moves the clock CO_POLL_MS at a time.
+ */
+
+#include "unitTest.h"
+
+#include "coroutine.h"
+#include "taskScheduler.h"
+
+extern scheduledTask taskCoroutines; // the resume task in coroutine.cpp
+
+// three naps, the time each one ended
+struct napperState
+{
+	int naps;
+	uint32_t wokeAt[3];
+};
+static napperState napper;
+
+static ptState napperBody(protothread *pt)
+{
+	PT_BEGIN(pt);
+	for (napper.naps = 0; napper.naps < 3; napper.naps++)
+	{
+		PT_SLEEP(pt, 30);
+		napper.wokeAt[napper.naps] = ptClock();
+	}
+	PT_END(pt);
+}
+
+// waits for a flag with a timeout, like a socket read
+struct waiterState
+{
+	bool flag;
+	bool timedOut;
+	uint32_t doneAt;
+};
+static waiterState waiter;
+
+static ptState waiterBody(protothread *pt)
+{
+	PT_BEGIN(pt);
+	PT_AWAIT(pt, waiter.flag, 100);
+	waiter.timedOut = PT_TIMED_OUT(pt);
+	waiter.doneAt = ptClock();
+	PT_END(pt);
+}
+
+// a parent that waits on a child protothread, like a fetch on readHttpResponse()
+static protothread child;
+static int childSteps = 0;
+static bool parentDone = false;
+
+static ptState childBody()
+{
+	protothread *pt = &child;
+	PT_BEGIN(pt);
+	while (childSteps < 4)
+	{
+		childSteps++;
+		PT_YIELD(pt);
+	}
+	PT_END(pt);
+}
+
+static ptState parentBody(protothread *pt)
+{
+	PT_BEGIN(pt);
+	PT_INIT(&child);
+	PT_AWAIT_THREAD(pt, childBody());
+	parentDone = true;
+	PT_END(pt);
+}
+
+static ptState idleBody(protothread *pt)
+{
+	PT_BEGIN(pt);
+	PT_SLEEP(pt, 1000);
+	PT_END(pt);
+}
+
+coroutine coNapper = COROUTINE("napper", napperBody);
+coroutine coWaiter = COROUTINE("waiter", waiterBody);
+coroutine coParent = COROUTINE("parent", parentBody);
+coroutine coIdle = COROUTINE("idle", idleBody);
+coroutine coExtra = COROUTINE("extra", idleBody);
+
+// run the scheduler for a time, one poll at a time
+static void runFor(uint32_t ms)
+{
+	for (uint32_t t = 0; t < ms; t += CO_POLL_MS)
+	{
+		schedulerRun();
+		advanceClock(CO_POLL_MS);
+	}
+	schedulerRun();
+}
+
+static void pollIdle()
+{
+	advanceClock(CO_POLL_MS);
+}
+
+// several coroutines interleave, each on its own timeline
+static void testInterleave()
+{
+	setFakeClock(5000);
+	waiter = {};
+	napper = {};
+	CHECK(coStart(coNapper));
+	CHECK(coStart(coWaiter));
+	CHECK(coStart(coParent));
+	CHECK(!coStart(coNapper)); // already running
+	CHECK_EQUAL(coRunning(), 3);
+	CHECK(taskScheduled(taskCoroutines));
+
+	runFor(40);
+	CHECK_EQUAL(childSteps, 4);
+	CHECK(parentDone);
+	CHECK(!coActive(coParent));
+	CHECK_EQUAL(napper.naps, 1);
+	CHECK_EQUAL(napper.wokeAt[0], 5030);
+
+	waiter.flag = true; // arrives before its timeout
+	runFor(20);
+	CHECK(!coActive(coWaiter));
+	CHECK(!waiter.timedOut);
+	CHECK(waiter.doneAt < 5100);
+
+	runFor(60);
+	CHECK(!coActive(coNapper));
+	CHECK_EQUAL(napper.wokeAt[1], 5060);
+	CHECK_EQUAL(napper.wokeAt[2], 5090);
+	CHECK_EQUAL(coRunning(), 0);
+	runFor(CO_POLL_MS);
+	CHECK(!taskScheduled(taskCoroutines)); // nothing left to poll
+} // testInterleave()
+
+// a wait that is never satisfied ends at its timeout
+static void testTimeout()
+{
+	setFakeClock(0xFFFFFFC0UL); // and the deadline lies past the rollover
+	waiter = {};
+	CHECK(coStart(coWaiter));
+	runFor(90);
+	CHECK(coActive(coWaiter));
+	runFor(20);
+	CHECK(!coActive(coWaiter));
+	CHECK(waiter.timedOut);
+	CHECK_EQUAL(waiter.doneAt, (uint32_t)(0xFFFFFFC0UL + 100));
+} // testTimeout()
+
+// only CO_MAX run at once; coFinish() runs one to the end in place
+static void testLimitAndFinish()
+{
+	setFakeClock(0);
+	napper = {};
+	CHECK(coStart(coIdle));
+	CHECK(coStart(coWaiter));
+	CHECK(coStart(coParent));
+	CHECK(coStart(coNapper));
+	CHECK(!coStart(coExtra)); // CO_MAX is 4
+	CHECK_EQUAL(coRunning(), CO_MAX);
+
+	coFinish(coNapper, pollIdle);
+	CHECK(!coActive(coNapper));
+	CHECK_EQUAL(napper.wokeAt[2], 90);
+	CHECK(coStart(coExtra)); // takes the slot coNapper finished in
+
+	coFinish(coIdle, pollIdle);
+	coFinish(coExtra, pollIdle);
+	waiter.flag = true;
+	coFinish(coWaiter, pollIdle);
+	coFinish(coParent, pollIdle);
+	CHECK_EQUAL(coRunning(), 0);
+	runFor(CO_POLL_MS);
+	CHECK(!taskScheduled(taskCoroutines));
+} // testLimitAndFinish()
+
+void testCoroutine()
+{
+	setSchedulerClock(fakeClock);
+	setProtothreadClock(fakeClock);
+	testInterleave();
+	testTimeout();
+	testLimitAndFinish();
+} // testCoroutine()
+
+// End of file
@@ -0,0 +1,269 @@
+/**
+ * @file testDns.cpp
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Tests of the DNS coding (dnsMessage.h) and the host cache (hostCache.h) against the stand-in.
+ * @details Lookups go to the stand-in's UDP stub the way the firmware's lookup
+ *          coroutine sends them, and their outcome is stored in the cache under
+ *          the fake clock, so TTL expiry, the stale window and negative entries
+ *          can be stepped through without waiting.
+ */
+
+#include "unitTest.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "dnsMessage.h"
+#include "hostCache.h"
+#include "standIns.h"
+
+#define ADDRESS(a, b, c, d) (((uint32_t)(a) << 24) | ((b) << 16) | ((c) << 8) | (d))
+
+static void testCoding()
+{
+	uint8_t query[DNS_PACKET_SIZE];
+	size_t length = dnsQuery(query, sizeof(query), 0x1234, "api.thingspeak.com");
+	CHECK_EQUAL(length, 12 + 20 + 4); // header, 3api9thingspeak3com0, type and class
+	uint16_t id = 0;
+	char name[DNS_NAME_MAX + 1];
+	int questionEnd = dnsQuestion(query, length, id, name, sizeof(name));
+	CHECK_EQUAL(questionEnd, length);
+	CHECK_EQUAL(id, 0x1234);
+	CHECK(std::string(name) == "api.thingspeak.com");
+	uint8_t bad[DNS_PACKET_SIZE];
+	CHECK_EQUAL(dnsQuery(bad, sizeof(bad), 1, ""), 0);
+	CHECK_EQUAL(dnsQuery(bad, sizeof(bad), 1, "a..b"), 0);
+	CHECK_EQUAL(dnsQuery(bad, sizeof(bad), 1, (std::string(64, 'x') + ".com").c_str()), 0);
+	CHECK_EQUAL(dnsQuery(bad, 20, 1, "api.thingspeak.com"), 0); // does not fit
+
+	uint8_t reply[DNS_PACKET_SIZE];
+	uint32_t address = 0;
+	uint32_t ttl = 0;
+	size_t replyLength = dnsReply(reply, sizeof(reply), query, questionEnd, DNS_RCODE_OK, ADDRESS(192, 0, 2, 7), 86400);
+	CHECK_EQUAL(replyLength, length + 16);
+	CHECK_EQUAL(dnsAnswer(reply, replyLength, 0x1234, address, ttl), DNS_FOUND);
+	CHECK_EQUAL(address, ADDRESS(192, 0, 2, 7));
+	CHECK_EQUAL(ttl, 86400);
+	CHECK_EQUAL(dnsAnswer(reply, replyLength, 0x1235, address, ttl), DNS_NOT_OURS);
+	CHECK_EQUAL(dnsAnswer(query, length, 0x1234, address, ttl), DNS_NOT_OURS); // the query itself
+	CHECK_EQUAL(dnsAnswer(reply, replyLength - 4, 0x1234, address, ttl), DNS_NO_HOST); // address cut off
+	CHECK_EQUAL(dnsAnswer(reply, length + 6, 0x1234, address, ttl), DNS_NO_ANSWER); // record cut off
+
+	replyLength = dnsReply(reply, sizeof(reply), query, questionEnd, DNS_RCODE_NXDOMAIN, 0, 0);
+	CHECK_EQUAL(replyLength, length);
+	CHECK_EQUAL(dnsAnswer(reply, replyLength, 0x1234, address, ttl), DNS_NO_HOST);
+	replyLength = dnsReply(reply, sizeof(reply), query, questionEnd, DNS_RCODE_SERVFAIL, 0, 0);
+	CHECK_EQUAL(dnsAnswer(reply, replyLength, 0x1234, address, ttl), DNS_NO_ANSWER);
+	replyLength = dnsReply(reply, sizeof(reply), query, questionEnd, DNS_RCODE_OK, 0, 0);
+	CHECK_EQUAL(dnsAnswer(reply, replyLength, 0x1234, address, ttl), DNS_NO_HOST); // no A record
+
+	// a CNAME ahead of the A record, as api.thingspeak.com is answered
+	static const uint8_t cname[] = {0xC0, 0x0C, 0, 5, 0, 1, 0, 0, 0, 60, 0, 6, 3, 'w', 'w', 'w', 0xC0, 0x0C};
+	static const uint8_t record[] = {0xC0, 0x2A, 0, 1, 0, 1, 0, 0, 1, 0, 0, 4, 203, 0, 113, 9};
+	replyLength = dnsReply(reply, sizeof(reply), query, questionEnd, DNS_RCODE_OK, 0, 0);
+	memcpy(reply + replyLength, cname, sizeof(cname));
+	memcpy(reply + replyLength + sizeof(cname), record, sizeof(record));
+	reply[7] = 2;
+	CHECK_EQUAL(dnsAnswer(reply, replyLength + sizeof(cname) + sizeof(record), 0x1234, address, ttl), DNS_FOUND);
+	CHECK_EQUAL(address, ADDRESS(203, 0, 113, 9));
+	CHECK_EQUAL(ttl, 256);
+} // testCoding()
+
+static int lookupSocket = -1;
+static uint16_t lookupId = 0;
+
+// one query to the stub and its outcome stored, as the lookup coroutine does
+static dnsResult lookup(uint16_t port, const char *host)
+{
+	hostEntry &entry = hostCacheClaim(host);
+	uint8_t packet[DNS_PACKET_SIZE];
+	size_t length = dnsQuery(packet, sizeof(packet), ++lookupId, host);
+	sockaddr_in server{};
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	sendto(lookupSocket, packet, length, 0, (sockaddr *)&server, sizeof(server));
+
+	dnsResult result = DNS_NOT_OURS;
+	uint32_t address = 0;
+	uint32_t ttl = 0;
+	while (result == DNS_NOT_OURS)
+	{
+		ssize_t got = recv(lookupSocket, packet, sizeof(packet), 0);
+		result = got > 0 ? dnsAnswer(packet, got, lookupId, address, ttl) : DNS_NO_ANSWER; // timeout
+	}
+	hostCacheStore(entry, result, address, ttl);
+	return result;
+} // lookup()
+
+static hostAnswer find(const char *host, uint32_t &address)
+{
+	address = 0;
+	return hostCacheFind(host, address);
+}
+
+// fresh for the TTL, then stale for DNS_STALE_WINDOW while a refresh is due
+static void testExpiry(StandIns &standIns)
+{
+	hostCacheFlush();
+	setFakeClock(5000);
+	uint32_t address;
+	standIns.dnsRecord("api.thingspeak.com", ADDRESS(192, 0, 2, 1), 120);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_MISS);
+	uint64_t queries = standIns.dnsQueries;
+	CHECK_EQUAL(lookup(standIns.dnsPort, "api.thingspeak.com"), DNS_FOUND);
+	CHECK_EQUAL(standIns.dnsQueries, queries + 1);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_FRESH);
+	CHECK_EQUAL(address, ADDRESS(192, 0, 2, 1));
+	advanceClock(120000 - 1);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_FRESH);
+	CHECK(hostCacheDue() != nullptr); // used, and past three quarters of its TTL
+	advanceClock(1);
+	standIns.dnsRecord("api.thingspeak.com", ADDRESS(192, 0, 2, 2), 120);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_STALE);
+	CHECK_EQUAL(address, ADDRESS(192, 0, 2, 1)); // the old address while revalidating
+	hostEntry *due = hostCacheDue();
+	CHECK(due != nullptr && strcmp(due->host, "api.thingspeak.com") == 0);
+	CHECK_EQUAL(lookup(standIns.dnsPort, due->host), DNS_FOUND);
+	CHECK(hostCacheDue() == nullptr);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_FRESH);
+	CHECK_EQUAL(address, ADDRESS(192, 0, 2, 2));
+
+	// nobody revalidated: the stale address runs out with the window
+	advanceClock(120000 + 1000 * DNS_STALE_WINDOW - 1);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_STALE);
+	advanceClock(1);
+	CHECK_EQUAL(find("api.thingspeak.com", address), HOST_MISS);
+
+	// TTLs are held to DNS_MIN_TTL and DNS_MAX_TTL
+	standIns.dnsRecord("short.example", ADDRESS(192, 0, 2, 3), 5);
+	standIns.dnsRecord("long.example", ADDRESS(192, 0, 2, 4), 86400);
+	lookup(standIns.dnsPort, "short.example");
+	lookup(standIns.dnsPort, "long.example");
+	advanceClock(1000 * DNS_MIN_TTL - 1);
+	CHECK_EQUAL(find("short.example", address), HOST_FRESH);
+	advanceClock(1);
+	CHECK_EQUAL(find("short.example", address), HOST_STALE);
+	advanceClock(1000 * (DNS_MAX_TTL - DNS_MIN_TTL));
+	CHECK_EQUAL(find("long.example", address), HOST_STALE);
+} // testExpiry()
+
+// NXDOMAIN is remembered for DNS_NEGATIVE_TTL without asking again
+static void testNegative(StandIns &standIns)
+{
+	hostCacheFlush();
+	setFakeClock(0xFFFF0000); // across the roll-over
+	uint32_t address;
+	standIns.dnsRemove("gone.example");
+	CHECK_EQUAL(lookup(standIns.dnsPort, "gone.example"), DNS_NO_HOST);
+	uint64_t queries = standIns.dnsQueries;
+	CHECK_EQUAL(find("gone.example", address), HOST_NEGATIVE);
+	CHECK(hostCacheDue() == nullptr); // negative entries are not refreshed in the background
+	advanceClock(1000 * DNS_NEGATIVE_TTL - 1);
+	CHECK_EQUAL(find("gone.example", address), HOST_NEGATIVE);
+	CHECK_EQUAL(standIns.dnsQueries, queries);
+	advanceClock(1);
+	CHECK_EQUAL(find("gone.example", address), HOST_MISS);
+
+	// a host that comes back is cached again
+	standIns.dnsRecord("gone.example", ADDRESS(192, 0, 2, 5), 300);
+	CHECK_EQUAL(lookup(standIns.dnsPort, "gone.example"), DNS_FOUND);
+	CHECK_EQUAL(find("gone.example", address), HOST_FRESH);
+	CHECK_EQUAL(address, ADDRESS(192, 0, 2, 5));
+	// and a host that goes away turns negative on its next lookup
+	standIns.dnsRemove("gone.example");
+	CHECK_EQUAL(lookup(standIns.dnsPort, "gone.example"), DNS_NO_HOST);
+	CHECK_EQUAL(find("gone.example", address), HOST_NEGATIVE);
+} // testNegative()
+
+// a silent server is not proof the host is gone
+static void testSilent(StandIns &standIns)
+{
+	hostCacheFlush();
+	setFakeClock(1000);
+	uint32_t address;
+	standIns.dnsRecord("api.weather.com", ADDRESS(192, 0, 2, 6), 60);
+	CHECK_EQUAL(lookup(standIns.dnsPort, "api.weather.com"), DNS_FOUND);
+	advanceClock(60000);
+	CHECK_EQUAL(find("api.weather.com", address), HOST_STALE);
+
+	standIns.dnsSilent = true;
+	CHECK_EQUAL(lookup(standIns.dnsPort, "api.weather.com"), DNS_NO_ANSWER);
+	advanceClock(1000 * DNS_STALE_WINDOW - 1); // a whole new window from the failed revalidation
+	CHECK_EQUAL(find("api.weather.com", address), HOST_STALE);
+	CHECK_EQUAL(address, ADDRESS(192, 0, 2, 6));
+	advanceClock(1);
+	CHECK_EQUAL(find("api.weather.com", address), HOST_MISS);
+
+	// with nothing to fall back on the failure is negative
+	CHECK_EQUAL(lookup(standIns.dnsPort, "new.example"), DNS_NO_ANSWER);
+	CHECK_EQUAL(find("new.example", address), HOST_NEGATIVE);
+	standIns.dnsSilent = false;
+} // testSilent()
+
+// only entries in use are fetched ahead; the slot fetched longest ago is reused
+static void testPrefetch(StandIns &standIns)
+{
+	hostCacheFlush();
+	setFakeClock(1000);
+	uint32_t address;
+	standIns.dnsRecord("used.example", ADDRESS(192, 0, 2, 8), 100);
+	standIns.dnsRecord("idle.example", ADDRESS(192, 0, 2, 9), 100);
+	lookup(standIns.dnsPort, "used.example");
+	lookup(standIns.dnsPort, "idle.example");
+	uint32_t prefetches = hostCacheCounters().prefetches;
+	find("used.example", address);
+	advanceClock(100000 / 100 * DNS_PREFETCH_PERCENT - 1);
+	CHECK(hostCacheDue() == nullptr);
+	advanceClock(1);
+	hostEntry *due = hostCacheDue();
+	CHECK(due != nullptr && strcmp(due->host, "used.example") == 0);
+	CHECK_EQUAL(hostCacheCounters().prefetches, prefetches + 1);
+	lookup(standIns.dnsPort, due->host);
+	CHECK(hostCacheDue() == nullptr); // not used since, and idle.example never was
+	CHECK_EQUAL(find("used.example", address), HOST_FRESH);
+
+	static const char *const HOSTS[] = {"h1.example", "h2.example", "h3.example", "h4.example", "h5.example"};
+	for (const char *host : HOSTS)
+	{
+		advanceClock(1);
+		standIns.dnsRecord(host, ADDRESS(192, 0, 2, 10), 3600);
+		lookup(standIns.dnsPort, host);
+	}
+	// six slots: idle.example was fetched longest ago
+	CHECK_EQUAL(find("idle.example", address), HOST_MISS);
+	CHECK_EQUAL(find("used.example", address), HOST_FRESH);
+	CHECK_EQUAL(find("h5.example", address), HOST_FRESH);
+	int used = 0;
+	for (int i = 0; hostCacheAt(i) != nullptr; i++)
+	{
+		used += hostCacheAt(i)->host != nullptr;
+	}
+	CHECK_EQUAL(used, DNS_CACHE_SLOTS);
+} // testPrefetch()
+
+void testDns()
+{
+	testCoding();
+	StandIns standIns;
+	lookupSocket = socket(AF_INET, SOCK_DGRAM, 0);
+	timeval timeout = {0, 200000}; // a silent server
+	setsockopt(lookupSocket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	if (CHECK(standIns.start()))
+	{
+		setHostCacheClock(fakeClock);
+		testExpiry(standIns);
+		testNegative(standIns);
+		testSilent(standIns);
+		testPrefetch(standIns);
+		hostCacheFlush();
+	}
+	close(lookupSocket);
+} // testDns()
+
+// End of file
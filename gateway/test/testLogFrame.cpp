@@ -0,0 +1,197 @@
+/**
+ * @file testLogFrame.cpp
+ * @author Karl Berger
+ * @date 2025-07-12
+ * @brief Tests of the CRC-framed log records (logFrame.h) and of recovery from damaged logs.
+ * @details scanLog() walks a log the way readRecord() in the firmware's obsLog.cpp
+ *          does, with the whole file in memory: a bad frame costs one byte and the
+ *          scan looks for the next magic byte, and a frame running past the end is
+ *          a torn write. Bytes skipped before a good frame count as corrupt; bytes
+ *          skipped at the end do not.
+ */
+
+#include "unitTest.h"
+
+#include <cstring>
+
+#include "logFrame.h"
+
+#define TEST_PAYLOAD 12 // bytes in each test record
+#define TEST_RECORDS 5
+
+struct scanResult
+{
+	int records;		  // good frames found
+	uint8_t first[8];	  // first payload byte of each
+	size_t corrupt;		  // bytes skipped before a good frame
+	size_t end;			  // just past the last good frame
+};
+
+static scanResult scanLog(const uint8_t *log, size_t size)
+{
+	scanResult scan;
+	memset(&scan, 0, sizeof(scan));
+	size_t position = 0;
+	size_t skipped = 0;
+	while (position < size)
+	{
+		const uint8_t *payload;
+		uint8_t length;
+		frameResult result = frameDecode(log + position, size - position, payload, length);
+		if (result != FRAME_OK)
+		{
+			position++; // FRAME_SHORT here is at the end of the file: not a frame
+			skipped++;
+			continue;
+		}
+		scan.corrupt += skipped;
+		skipped = 0;
+		if (scan.records < (int)sizeof(scan.first))
+		{
+			scan.first[scan.records] = payload[0];
+		}
+		scan.records++;
+		position += length + FRAME_OVERHEAD;
+		scan.end = position;
+	}
+	return scan;
+} // scanLog()
+
+// record n, with FRAME_MAGIC inside to tempt the resync into a false start
+static void testRecord(int n, uint8_t *payload)
+{
+	for (int i = 0; i < TEST_PAYLOAD; i++)
+	{
+		payload[i] = (uint8_t)(n * 16 + i);
+	}
+	payload[4] = FRAME_MAGIC;
+	payload[5] = TEST_PAYLOAD - 8; // a plausible length after it
+}
+
+// frame TEST_RECORDS records into log, return the size; offsets[n] is where record n starts
+static size_t buildLog(uint8_t *log, size_t *offsets)
+{
+	size_t size = 0;
+	uint8_t payload[TEST_PAYLOAD];
+	for (int n = 0; n < TEST_RECORDS; n++)
+	{
+		testRecord(n, payload);
+		offsets[n] = size;
+		size += frameEncode(payload, TEST_PAYLOAD, log + size);
+	}
+	return size;
+} // buildLog()
+
+// the CRC is the usual CRC-32 and frames decode back to their payload
+static void testFrame()
+{
+	CHECK_EQUAL(frameCrc((const uint8_t *)"123456789", 9), 0xCBF43926UL);
+
+	uint8_t payload[FRAME_MAX_PAYLOAD];
+	uint8_t frame[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+	for (int i = 0; i < FRAME_MAX_PAYLOAD; i++)
+	{
+		payload[i] = (uint8_t)(i * 7);
+	}
+	const uint8_t *decoded;
+	uint8_t length;
+	CHECK_EQUAL(frameEncode(payload, FRAME_MAX_PAYLOAD, frame), FRAME_MAX_PAYLOAD + FRAME_OVERHEAD);
+	CHECK_EQUAL(frameDecode(frame, sizeof(frame), decoded, length), FRAME_OK);
+	CHECK_EQUAL(length, FRAME_MAX_PAYLOAD);
+	CHECK(decoded == frame + 2 && memcmp(decoded, payload, FRAME_MAX_PAYLOAD) == 0);
+	CHECK_EQUAL(frameEncode(payload, 0, frame), FRAME_OVERHEAD);
+	CHECK_EQUAL(frameDecode(frame, FRAME_OVERHEAD, decoded, length), FRAME_OK);
+	CHECK_EQUAL(length, 0);
+
+	// short and bad frames
+	frameEncode(payload, 10, frame);
+	CHECK_EQUAL(frameDecode(frame, 0, decoded, length), FRAME_SHORT);
+	CHECK_EQUAL(frameDecode(frame, 1, decoded, length), FRAME_SHORT);
+	CHECK_EQUAL(frameDecode(frame, 10 + FRAME_OVERHEAD - 1, decoded, length), FRAME_SHORT);
+	CHECK_EQUAL(frameDecode(frame + 1, 1, decoded, length), FRAME_BAD); // not a magic byte
+	frame[7] ^= 0x01;
+	CHECK_EQUAL(frameDecode(frame, 10 + FRAME_OVERHEAD, decoded, length), FRAME_BAD);
+	frame[7] ^= 0x01;
+	frame[10 + FRAME_OVERHEAD - 1] ^= 0x80; // in the CRC itself
+	CHECK_EQUAL(frameDecode(frame, 10 + FRAME_OVERHEAD, decoded, length), FRAME_BAD);
+} // testFrame()
+
+// a corrupted record costs only itself, a torn last record is cut off
+static void testRecovery()
+{
+	uint8_t log[TEST_RECORDS * (TEST_PAYLOAD + FRAME_OVERHEAD) + 16];
+	size_t offsets[TEST_RECORDS];
+	size_t size = buildLog(log, offsets);
+	const size_t FRAME = TEST_PAYLOAD + FRAME_OVERHEAD;
+
+	scanResult scan = scanLog(log, size);
+	CHECK_EQUAL(scan.records, TEST_RECORDS);
+	CHECK_EQUAL(scan.corrupt, 0);
+	CHECK_EQUAL(scan.end, size);
+
+	// a flipped payload bit in record 2, and record 4 torn after 7 of its bytes
+	log[offsets[2] + 2 + 9] ^= 0x10;
+	size_t torn = offsets[4] + 7;
+	scan = scanLog(log, torn);
+	CHECK_EQUAL(scan.records, 3);
+	CHECK_EQUAL(scan.first[0], 0x00);
+	CHECK_EQUAL(scan.first[1], 0x10);
+	CHECK_EQUAL(scan.first[2], 0x30); // the scan found record 3 again
+	CHECK_EQUAL(scan.corrupt, FRAME); // all of record 2, not more
+	CHECK_EQUAL(scan.end, offsets[4]); // the torn bytes are not corruption
+
+	// the log is truncated at end and appended to: the next scan sees the new record
+	uint8_t payload[TEST_PAYLOAD];
+	testRecord(7, payload);
+	size = scan.end + frameEncode(payload, TEST_PAYLOAD, log + scan.end);
+	scan = scanLog(log, size);
+	CHECK_EQUAL(scan.records, 4);
+	CHECK_EQUAL(scan.first[3], 0x70);
+	CHECK_EQUAL(scan.corrupt, FRAME);
+	CHECK_EQUAL(scan.end, size);
+} // testRecovery()
+
+// damage to the magic or length byte, and garbage before the first frame
+static void testResync()
+{
+	uint8_t log[TEST_RECORDS * (TEST_PAYLOAD + FRAME_OVERHEAD) + 16];
+	size_t offsets[TEST_RECORDS];
+	size_t size = buildLog(log, offsets);
+	const size_t FRAME = TEST_PAYLOAD + FRAME_OVERHEAD;
+
+	log[offsets[1]] = 0x00; // magic byte gone
+	log[offsets[3] + 1] = TEST_PAYLOAD + 2; // length runs into the next frame
+	scanResult scan = scanLog(log, size);
+	CHECK_EQUAL(scan.records, 3);
+	CHECK_EQUAL(scan.first[0], 0x00);
+	CHECK_EQUAL(scan.first[1], 0x20);
+	CHECK_EQUAL(scan.first[2], 0x40);
+	CHECK_EQUAL(scan.corrupt, 2 * FRAME);
+	CHECK_EQUAL(scan.end, size);
+
+	// a length that runs past the end of the file looks like a torn write
+	size = buildLog(log, offsets);
+	log[offsets[4] + 1] = 200;
+	scan = scanLog(log, size);
+	CHECK_EQUAL(scan.records, 4);
+	CHECK_EQUAL(scan.corrupt, 0);
+	CHECK_EQUAL(scan.end, offsets[4]);
+
+	// stray bytes, one of them a magic byte, ahead of the log
+	const uint8_t junk[] = {0x13, FRAME_MAGIC, 0x02, 0x44, 0x00};
+	memmove(log + sizeof(junk), log, size);
+	memcpy(log, junk, sizeof(junk));
+	scan = scanLog(log, size + sizeof(junk));
+	CHECK_EQUAL(scan.records, 4);
+	CHECK_EQUAL(scan.first[0], 0x00);
+	CHECK_EQUAL(scan.corrupt, sizeof(junk));
+} // testResync()
+
+void testLogFrame()
+{
+	testFrame();
+	testRecovery();
+	testResync();
+} // testLogFrame()
+
+// End of file
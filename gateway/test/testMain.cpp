@@ -0,0 +1,109 @@
+/**
+ * @file testMain.cpp
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Runs the host unit test suites.
+ * @details
+ *   wxtest [SUITE...]
+ *
+ *   With no arguments every suite runs; otherwise only the suites named.
+ */
+
+#include "unitTest.h"
+
+#include <cstdio>
+#include <cstring>
+
+struct testSuite
+{
+	const char *name;
+	void (*run)();
+};
+
+static const testSuite SUITES[] = {
+	{"scheduler", testScheduler},
+	{"coroutine", testCoroutine},
+	{"tzrules", testTzRules},
+	{"breaker", testBreaker},
+	{"share", testShare},
+	{"mqtt", testMqtt},
+	{"thingspeak", testThingSpeak},
+	{"dns", testDns},
+	{"calendar", testCalendar},
+	{"logframe", testLogFrame},
+	{"packed", testPackedHistory},
+};
+
+static int checks = 0;
+static int failures = 0;
+static uint32_t clockMs = 0;
+
+bool checkThat(bool passed, const char *expression, const char *file, int line)
+{
+	checks++;
+	if (!passed)
+	{
+		failures++;
+		printf("  FAILED %s:%d: %s\n", file, line, expression);
+	}
+	return passed;
+} // checkThat()
+
+bool checkEqual(long long actual, long long expected, const char *expression, const char *file, int line)
+{
+	if (!checkThat(actual == expected, expression, file, line))
+	{
+		printf("         got %lld, expected %lld\n", actual, expected);
+		return false;
+	}
+	return true;
+} // checkEqual()
+
+uint32_t fakeClock()
+{
+	return clockMs;
+}
+
+void advanceClock(uint32_t ms)
+{
+	clockMs += ms;
+}
+
+void setFakeClock(uint32_t ms)
+{
+	clockMs = ms;
+}
+
+static bool wanted(const char *name, int argc, char **argv)
+{
+	if (argc < 2)
+	{
+		return true;
+	}
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], name) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+} // wanted()
+
+int main(int argc, char **argv)
+{
+	for (const testSuite &suite : SUITES)
+	{
+		if (!wanted(suite.name, argc, argv))
+		{
+			continue;
+		}
+		int before = failures;
+		suite.run();
+		printf("%-12s %s\n", suite.name, failures == before ? "ok" : "FAILED");
+	}
+	printf("%d checks, %d failed\n", checks, failures);
+	return failures > 0 ? 1 : 0;
+} // main()
+
+// End of file
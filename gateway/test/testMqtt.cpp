@@ -0,0 +1,243 @@
+/**
+ * @file testMqtt.cpp
+ * @author Karl Berger
+ * @date 2025-07-09
+ * @brief Tests of the MQTT packet coding (mqttPacket.h) against the broker stand-in.
+ * @details The publisher is a plain socket that sends the packets the firmware
+ *          builds: CONNECT with its will and kept session, retained PUBLISH at
+ *          QoS 1 and 0. A second client subscribes to read back what the broker
+ *          retained.
+ */
+
+#include "unitTest.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <map>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "mqttPacket.h"
+#include "standIns.h"
+
+struct mqttReply
+{
+	uint8_t type;	  ///< first byte, 0 if nothing arrived
+	std::string body; ///< after the fixed header
+};
+
+static int connectTo(uint16_t port)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	timeval timeout = {2, 0};
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	if (connect(fd, (sockaddr *)&address, sizeof(address)) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+} // connectTo()
+
+static void sendPacket(int fd, uint8_t type, const uint8_t *body, size_t length)
+{
+	uint8_t header[MQTT_HEADER_MAX];
+	size_t used = mqttHeader(header, type, length);
+	std::string packet((const char *)header, used);
+	packet.append((const char *)body, length);
+	CHECK(send(fd, packet.data(), packet.size(), MSG_NOSIGNAL) == (ssize_t)packet.size());
+} // sendPacket()
+
+// read one whole packet, or type 0 after the timeout or a close
+static mqttReply readPacket(int fd)
+{
+	std::string in;
+	char byte;
+	size_t length;
+	int used;
+	while ((used = mqttParseHeader((const uint8_t *)in.data(), in.size(), length)) == 0 ||
+		   (used > 0 && in.size() < used + length))
+	{
+		if (recv(fd, &byte, 1, 0) != 1)
+		{
+			return {0, ""};
+		}
+		in += byte;
+	}
+	if (used < 0)
+	{
+		return {0, ""};
+	}
+	return {(uint8_t)in[0], in.substr(used)};
+} // readPacket()
+
+static int connectClient(uint16_t port, const mqttConnectFields &fields, mqttReply &ack)
+{
+	int fd = connectTo(port);
+	uint8_t body[256];
+	size_t length = mqttConnectBody(body, sizeof(body), fields);
+	CHECK(length > 0);
+	sendPacket(fd, MQTT_CONNECT, body, length);
+	ack = readPacket(fd);
+	return fd;
+} // connectClient()
+
+static void publish(int fd, const char *topic, const char *payload, uint8_t qos, uint16_t id, bool dup = false)
+{
+	uint8_t body[256];
+	size_t length = mqttPublishBody(body, sizeof(body), topic, (const uint8_t *)payload, strlen(payload), qos, id);
+	CHECK(length > 0);
+	sendPacket(fd, mqttPublishType(qos, dup, true), body, length);
+} // publish()
+
+// subscribe a new clean session and collect the retained messages it is sent
+static std::map<std::string, std::string> readRetained(uint16_t port, const char *filter)
+{
+	mqttConnectFields reader = {"reader", nullptr, nullptr, 0, false, nullptr, nullptr, 30, true};
+	mqttReply reply;
+	int fd = connectClient(port, reader, reply);
+	uint8_t body[128] = {0x00, 0x03}; // packet id 3
+	size_t length = mqttPutString(body, sizeof(body), 2, filter, strlen(filter));
+	body[length++] = 0; // QoS 0
+	sendPacket(fd, MQTT_SUBSCRIBE, body, length);
+	reply = readPacket(fd);
+	CHECK_EQUAL(reply.type, MQTT_SUBACK);
+	CHECK(reply.body == std::string("\0\3\0", 3));
+
+	std::map<std::string, std::string> messages;
+	sendPacket(fd, MQTT_PINGREQ, nullptr, 0); // its answer follows the retained messages
+	while ((reply = readPacket(fd)).type != MQTT_PINGRESP && reply.type != 0)
+	{
+		CHECK_EQUAL(reply.type, MQTT_PUBLISH | MQTT_RETAIN);
+		const char *topic;
+		size_t topicLength;
+		size_t at = 0;
+		CHECK(mqttGetString((const uint8_t *)reply.body.data(), reply.body.size(), at, topic, topicLength));
+		messages[std::string(topic, topicLength)] = reply.body.substr(at);
+	}
+	CHECK_EQUAL(reply.type, MQTT_PINGRESP);
+	close(fd);
+	return messages;
+} // readRetained()
+
+static void testCoding()
+{
+	uint8_t header[MQTT_HEADER_MAX];
+	size_t length;
+	CHECK_EQUAL(mqttHeader(header, MQTT_PINGREQ, 0), 2);
+	CHECK_EQUAL(mqttHeader(header, MQTT_PUBLISH, 321), 3);
+	CHECK_EQUAL(header[1], 0xC1);
+	CHECK_EQUAL(header[2], 0x02);
+	CHECK_EQUAL(mqttParseHeader(header, 3, length), 3);
+	CHECK_EQUAL(length, 321);
+	CHECK_EQUAL(mqttParseHeader(header, 2, length), 0); // length continues
+	const uint8_t tooLong[] = {MQTT_PUBLISH, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+	CHECK_EQUAL(mqttParseHeader(tooLong, sizeof(tooLong), length), -1);
+
+	mqttConnectFields fields = {"wug-1a2b3c", "wx/status", "offline", 1, true, "user", "", 60, false};
+	uint8_t body[64];
+	length = mqttConnectBody(body, sizeof(body), fields);
+	CHECK_EQUAL(length, 10 + 12 + 11 + 9 + 6); // no password field when it is empty
+	CHECK_EQUAL(body[7], MQTT_USER_FLAG | MQTT_WILL_RETAIN | 0x08 | MQTT_WILL);
+	CHECK_EQUAL(mqttConnectBody(body, 40, fields), 0);
+	CHECK_EQUAL(mqttPublishBody(body, 16, "wx/wx", (const uint8_t *)"{\"t\":21.5}", 10, 1, 7), 0);
+	CHECK_EQUAL(mqttPublishBody(body, sizeof(body), "wx/wx", (const uint8_t *)"{\"t\":21.5}", 10, 1, 7), 19);
+	CHECK_EQUAL(mqttPublishType(1, true, true), 0x3B);
+} // testCoding()
+
+static void testBroker()
+{
+	StandIns standIns;
+	if (!CHECK(standIns.start()))
+	{
+		return;
+	}
+	uint16_t port = standIns.mqttPort;
+
+	// the firmware's CONNECT: will "offline" retained at QoS 1, session kept
+	mqttConnectFields station = {"wug-test", "wx/test/status", "offline", 1, true, nullptr, nullptr, 60, false};
+	mqttReply ack;
+	int fd = connectClient(port, station, ack);
+	CHECK_EQUAL(ack.type, MQTT_CONNACK);
+	CHECK(ack.body == std::string("\0\0", 2)); // new session, accepted
+
+	publish(fd, "wx/test/status", "online", 0, 0);
+	publish(fd, "wx/test/wx", "{\"t\":21.5}", 1, 7);
+	mqttReply reply = readPacket(fd);
+	CHECK_EQUAL(reply.type, MQTT_PUBACK);
+	CHECK(reply.body == std::string("\0\7", 2));
+	publish(fd, "wx/test/wx", "{\"t\":21.5}", 1, 7, true); // resent after a lost PUBACK
+	reply = readPacket(fd);
+	CHECK_EQUAL(reply.type, MQTT_PUBACK);
+	CHECK(reply.body == std::string("\0\7", 2));
+	publish(fd, "wx/test/wx", "{\"t\":22.0}", 1, 300);
+	reply = readPacket(fd);
+	CHECK_EQUAL(reply.type, MQTT_PUBACK);
+	CHECK(reply.body == std::string("\1\54", 2));
+	sendPacket(fd, MQTT_PINGREQ, nullptr, 0); // the QoS 0 publish had no answer to wait for
+	CHECK_EQUAL(readPacket(fd).type, MQTT_PINGRESP);
+	CHECK_EQUAL(standIns.mqttPublishes, 4);
+
+	std::map<std::string, std::string> retained = readRetained(port, "wx/test/wx");
+	CHECK_EQUAL(retained.size(), 1);
+	CHECK(retained["wx/test/wx"] == "{\"t\":22.0}"); // the newer message replaced the older
+	retained = readRetained(port, "wx/test/#");
+	CHECK_EQUAL(retained.size(), 2);
+	CHECK(retained["wx/test/status"] == "online");
+
+	// dropped without DISCONNECT: the broker publishes the will
+	close(fd);
+	for (int wait = 0; wait < 100 && readRetained(port, "wx/test/status")["wx/test/status"] != "offline"; wait++)
+	{
+		usleep(10000);
+	}
+	CHECK(readRetained(port, "wx/test/status")["wx/test/status"] == "offline");
+
+	fd = connectClient(port, station, ack);
+	CHECK(ack.body == std::string("\1\0", 2)); // session resumed
+	publish(fd, "wx/test/status", "online", 0, 0);
+	sendPacket(fd, MQTT_DISCONNECT, nullptr, 0);
+	CHECK_EQUAL(readPacket(fd).type, 0); // closed by the broker
+	close(fd);
+	CHECK(readRetained(port, "wx/test/status")["wx/test/status"] == "online"); // no will after DISCONNECT
+
+	// an empty retained message clears the topic
+	mqttConnectFields clean = {"wug-test", nullptr, nullptr, 0, false, nullptr, nullptr, 60, true};
+	fd = connectClient(port, clean, ack);
+	CHECK(ack.body == std::string("\0\0", 2)); // clean session drops the kept one
+	publish(fd, "wx/test/wx", "", 1, 8);
+	CHECK_EQUAL(readPacket(fd).type, MQTT_PUBACK);
+	close(fd);
+	CHECK_EQUAL(readRetained(port, "wx/test/wx").size(), 0);
+
+	// MQTT 3.1 is refused
+	fd = connectTo(port);
+	uint8_t old[64];
+	size_t length = mqttConnectBody(old, sizeof(old), clean);
+	old[6] = 3;
+	sendPacket(fd, MQTT_CONNECT, old, length);
+	reply = readPacket(fd);
+	CHECK_EQUAL(reply.type, MQTT_CONNACK);
+	CHECK(reply.body == std::string("\0\1", 2));
+	close(fd);
+
+	// a publish before CONNECT is a protocol error
+	fd = connectTo(port);
+	publish(fd, "wx/test/wx", "early", 0, 0);
+	CHECK_EQUAL(readPacket(fd).type, 0);
+	close(fd);
+} // testBroker()
+
+void testMqtt()
+{
+	testCoding();
+	testBroker();
+} // testMqtt()
+
+// End of file
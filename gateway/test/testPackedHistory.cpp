@@ -0,0 +1,225 @@
+/**
+ * @file testPackedHistory.cpp
+ * @author Karl Berger
+ * @date 2025-07-12
+ * @brief Round-trip tests of the bit-packed history store (packedHistory.h).
+ * @details Records come from sample(), so any record read back can be checked
+ *          against the one written from its time alone. The time step wobbles
+ *          and channel 8 jumps by more than 1024 now and then, so the delta of
+ *          delta codes and the 32 bit escape are both exercised.
+ */
+
+#include "unitTest.h"
+
+#include <cstring>
+
+#include "packedHistory.h"
+
+#define BASE_EPOCH 1780000000UL // first record time
+#define STEP 60					// usual seconds between records
+#define JUMP 100000				// channel 8 jump, far past the 10 bit code
+
+static packedStore store; // 8 kB, kept off the stack
+
+// epoch of record n; every 7th comes 13 s late
+static uint32_t sampleEpoch(int n)
+{
+	return BASE_EPOCH + n * STEP + (n % 7 == 3 ? 13 : 0);
+}
+
+static packedRecord sample(int n)
+{
+	packedRecord record;
+	record.epoch = sampleEpoch(n);
+	for (int i = 0; i < PACKED_CHANNELS; i++)
+	{
+		record.value[i] = (n / (i + 1)) % 40 - 20 + i * 100; // slow wander about a level
+	}
+	record.value[PACKED_CHANNELS - 1] = (n % 50 == 25) ? JUMP + n : (n % 50 == 26) ? -JUMP : n % 5;
+	return record;
+} // sample()
+
+// the record a time belongs to, -1 if none
+static int sampleAt(uint32_t epoch)
+{
+	int n = (int)((epoch - BASE_EPOCH) / STEP);
+	return sampleEpoch(n) == epoch ? n : -1;
+}
+
+static bool sameRecord(const packedRecord &a, const packedRecord &b)
+{
+	return a.epoch == b.epoch && memcmp(a.value, b.value, sizeof(a.value)) == 0;
+}
+
+// append records first to last - 1, true if every one was taken
+static bool appendSamples(int first, int last)
+{
+	bool taken = true;
+	for (int n = first; n < last; n++)
+	{
+		taken = packedAppend(store, sample(n)) && taken;
+	}
+	return taken;
+} // appendSamples()
+
+// read from a time to the newest: records expected, and all of them intact and in order
+static int readFrom(uint32_t from, uint32_t &firstEpoch, bool &intact)
+{
+	packedCursor cursor;
+	packedRecord record;
+	packedBegin(store, cursor, from);
+	int read = 0;
+	int last = -1;
+	intact = true;
+	firstEpoch = 0;
+	while (packedNext(cursor, record))
+	{
+		int n = sampleAt(record.epoch);
+		intact = intact && n > last && sameRecord(record, sample(n)) && record.epoch >= from;
+		if (read++ == 0)
+		{
+			firstEpoch = record.epoch;
+		}
+		last = n;
+	}
+	return read;
+} // readFrom()
+
+// the cost of each code, and the 32 bit escape both ways
+static void testCodes()
+{
+	packedClear(store);
+	packedRecord record;
+	memset(&record, 0, sizeof(record));
+	record.epoch = BASE_EPOCH;
+	CHECK(packedAppend(store, record));
+	CHECK_EQUAL(packedBits(store), PACKED_CHANNELS); // zeros against zero
+	record.epoch += STEP;
+	CHECK(packedAppend(store, record));
+	CHECK_EQUAL(packedBits(store), 2 * PACKED_CHANNELS + 4 + 10); // the first time step, 60, in the 10 bit code
+	record.epoch += STEP;
+	CHECK(packedAppend(store, record));
+	CHECK_EQUAL(packedBits(store), 3 * PACKED_CHANNELS + 4 + 10 + 1); // nothing changed: one bit each
+
+	uint32_t before = packedBits(store);
+	record.epoch += STEP;
+	record.value[0] = 3;		  // "10" + 3 bits
+	record.value[1] = -32;		  // "110" + 6 bits
+	record.value[2] = 511;		  // "1110" + 10 bits
+	record.value[3] = JUMP;		  // "1111" + 32 bits
+	record.value[4] = -2 * JUMP; // escape for a negative value
+	CHECK(packedAppend(store, record));
+	CHECK_EQUAL(packedBits(store) - before, 1 + 5 + 9 + 14 + 36 + 36 + (PACKED_CHANNELS - 5));
+	packedRecord back = record;
+	record.epoch += STEP;
+	record.value[3] = -JUMP; // a 2 * JUMP fall
+	record.value[4] = 0;
+	CHECK(packedAppend(store, record));
+
+	packedCursor cursor;
+	packedRecord read;
+	packedBegin(store, cursor, back.epoch);
+	CHECK(packedNext(cursor, read) && sameRecord(read, back));
+	CHECK(packedNext(cursor, read) && sameRecord(read, record));
+	CHECK(!packedNext(cursor, read));
+
+	// a record not newer than the last is refused and changes nothing
+	before = packedBits(store);
+	CHECK(!packedAppend(store, record));
+	record.epoch--;
+	CHECK(!packedAppend(store, record));
+	CHECK_EQUAL(store.count, 5);
+	CHECK_EQUAL(packedBits(store), before);
+} // testCodes()
+
+// a record that does not fit starts a new block, coded against zero
+static void testBlocks()
+{
+	packedClear(store);
+	int n = 0;
+	bool taken = true;
+	while (store.used < 2)
+	{
+		taken = packedAppend(store, sample(n++)) && taken;
+	}
+	CHECK(taken);
+	const packedBlock &first = store.block[store.head];
+	const packedBlock &second = store.block[(store.head + 1) % PACKED_BLOCKS];
+	CHECK_EQUAL(first.firstEpoch, sampleEpoch(0));
+	CHECK_EQUAL(second.firstEpoch, sampleEpoch(n - 1));
+	CHECK_EQUAL(first.count + second.count, n);
+	CHECK_EQUAL(second.count, 1);
+	CHECK(first.bits <= PACKED_BLOCK_BYTES * 8);
+	CHECK(first.bits + PACKED_MAX_BITS > PACKED_BLOCK_BYTES * 8); // it was close to full
+	CHECK(appendSamples(n, n + 10));
+
+	uint32_t firstEpoch;
+	bool intact;
+	CHECK_EQUAL(readFrom(0, firstEpoch, intact), n + 10);
+	CHECK(intact);
+	CHECK_EQUAL(firstEpoch, sampleEpoch(0));
+
+	// windows that open in the middle of each block, on a record or between two
+	int middle = first.count / 2;
+	CHECK_EQUAL(readFrom(sampleEpoch(middle), firstEpoch, intact), n + 10 - middle);
+	CHECK(intact);
+	CHECK_EQUAL(firstEpoch, sampleEpoch(middle));
+	CHECK_EQUAL(readFrom(sampleEpoch(n + 3) - 1, firstEpoch, intact), 7);
+	CHECK(intact);
+	CHECK_EQUAL(firstEpoch, sampleEpoch(n + 3));
+	// the last record of the first block, then the first of the second
+	CHECK_EQUAL(readFrom(sampleEpoch(n - 2), firstEpoch, intact), 12);
+	CHECK(intact);
+	CHECK_EQUAL(readFrom(sampleEpoch(n + 9) + 1, firstEpoch, intact), 0);
+} // testBlocks()
+
+// when the ring is full the oldest block goes whole and is counted
+static void testEviction()
+{
+	packedClear(store);
+	int n = 0;
+	bool taken = true;
+	while (store.dropped == 0)
+	{
+		taken = packedAppend(store, sample(n++)) && taken;
+	}
+	CHECK(taken);
+	CHECK_EQUAL(store.used, PACKED_BLOCKS);
+	CHECK_EQUAL(store.head, 1);
+	CHECK_EQUAL(store.block[store.head].firstEpoch, sampleEpoch(store.dropped));
+	CHECK_EQUAL(store.count + store.dropped, n);
+
+	// twice round the ring
+	int total = n + (int)store.count * 2;
+	CHECK(appendSamples(n, total));
+	CHECK_EQUAL(store.used, PACKED_BLOCKS);
+	CHECK_EQUAL(store.count + store.dropped, total);
+	int oldest = (int)store.dropped;
+	CHECK_EQUAL(store.block[store.head].firstEpoch, sampleEpoch(oldest));
+	packedRecord newest;
+	CHECK(packedNewest(store, newest) && sameRecord(newest, sample(total - 1)));
+
+	uint32_t firstEpoch;
+	bool intact;
+	CHECK_EQUAL(readFrom(0, firstEpoch, intact), store.count); // a window older than the store
+	CHECK(intact);
+	CHECK_EQUAL(firstEpoch, sampleEpoch(oldest));
+
+	// a window from the middle of a block well inside the ring
+	const packedBlock &block = store.block[(store.head + PACKED_BLOCKS / 2) % PACKED_BLOCKS];
+	int start = sampleAt(block.firstEpoch) + block.count / 2;
+	CHECK_EQUAL(readFrom(sampleEpoch(start), firstEpoch, intact), total - start);
+	CHECK(intact);
+	CHECK_EQUAL(firstEpoch, sampleEpoch(start));
+	CHECK(packedBits(store) <= PACKED_BLOCKS * PACKED_BLOCK_BYTES * 8);
+} // testEviction()
+
+void testPackedHistory()
+{
+	testCodes();
+	testBlocks();
+	testEviction();
+	packedClear(store);
+} // testPackedHistory()
+
+// End of file
@@ -0,0 +1,185 @@
+/**
+ * @file testScheduler.cpp
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Tests of the deadline scheduler (taskScheduler.h) under a fake clock.
+ */
+
+#include "unitTest.h"
+
+#include <cstring>
+
+#include "taskScheduler.h"
+
+static char order[32]; // names of the tasks run, in order
+static int orderLength = 0;
+
+static void record(char name)
+{
+	if (orderLength < (int)sizeof(order) - 1)
+	{
+		order[orderLength++] = name;
+		order[orderLength] = '\0';
+	}
+}
+
+static void clearOrder()
+{
+	orderLength = 0;
+	order[0] = '\0';
+}
+
+static void runA() { record('A'); }
+static void runB() { record('B'); }
+static void runC() { record('C'); }
+
+scheduledTask taskA = SCHEDULED_TASK("a", runA, 0);
+scheduledTask taskB = SCHEDULED_TASK("b", runB, 0);
+scheduledTask taskC = SCHEDULED_TASK("c", runC, 0);
+
+static void cancelAll()
+{
+	taskCancel(taskA);
+	taskCancel(taskB);
+	taskCancel(taskC);
+	taskA.period = taskB.period = taskC.period = 0;
+	taskA.runs = taskB.runs = taskC.runs = 0;
+	taskA.skipped = taskB.skipped = taskC.skipped = 0;
+	clearOrder();
+}
+
+// tasks run in deadline order, whatever order they were scheduled in
+static void testOrdering()
+{
+	setFakeClock(1000);
+	taskSchedule(taskA, 30);
+	taskSchedule(taskB, 10);
+	taskSchedule(taskC, 20);
+	CHECK_EQUAL(schedulerRun(), 10);
+	CHECK_EQUAL(orderLength, 0);
+	advanceClock(15);
+	CHECK_EQUAL(schedulerRun(), 5);
+	CHECK(strcmp(order, "B") == 0);
+	advanceClock(100); // both late: still in deadline order
+	CHECK_EQUAL(schedulerRun(), TASK_NEVER);
+	CHECK(strcmp(order, "BCA") == 0);
+	CHECK(!taskScheduled(taskA));
+	cancelAll();
+} // testOrdering()
+
+// a periodic task keeps its phase and counts the periods it missed
+static void testPeriod()
+{
+	setFakeClock(0);
+	taskA.period = 100;
+	taskSchedule(taskA, 100);
+	advanceClock(100);
+	CHECK_EQUAL(schedulerRun(), 100);
+	advanceClock(350); // due at 200, now 450: 200 and 300 and 400 are one late run
+	CHECK_EQUAL(schedulerRun(), 50);
+	CHECK_EQUAL(taskA.runs, 2);
+	CHECK_EQUAL(taskA.skipped, 2);
+	CHECK_EQUAL(taskDueIn(taskA), 50); // next at 500, the original phase
+	cancelAll();
+} // testPeriod()
+
+// deadlines on either side of the 32-bit rollover stay in order
+static void testWrapAround()
+{
+	setFakeClock(0xFFFFFF00UL);
+	taskSchedule(taskA, 0x200); // due 0x100, after the rollover
+	taskSchedule(taskB, 0x10);	// due 0xFFFFFF10
+	CHECK_EQUAL(taskDueIn(taskA), 0x200);
+	CHECK_EQUAL(schedulerRun(), 0x10);
+	advanceClock(0x80);
+	CHECK_EQUAL(schedulerRun(), 0x180);
+	CHECK(strcmp(order, "B") == 0);
+	advanceClock(0x100); // clock now 0x80
+	CHECK_EQUAL(fakeClock(), 0x80);
+	CHECK_EQUAL(schedulerRun(), 0x80);
+	advanceClock(0x80);
+	CHECK_EQUAL(schedulerRun(), TASK_NEVER);
+	CHECK(strcmp(order, "BA") == 0);
+
+	setFakeClock(0xFFFFFFF0UL); // a periodic task across the rollover
+	taskC.period = 0x20;
+	taskSchedule(taskC, 0x10); // due 0
+	advanceClock(0x10);
+	CHECK_EQUAL(schedulerRun(), 0x20);
+	CHECK_EQUAL(taskC.skipped, 0);
+	cancelAll();
+} // testWrapAround()
+
+static void runSelf();
+scheduledTask taskSelf = SCHEDULED_TASK("self", runSelf, 0);
+static int selfRuns = 0;
+
+static void runSelf()
+{
+	record('S');
+	if (++selfRuns < 3)
+	{
+		taskSchedule(taskSelf, 50); // one-shot that keeps itself going
+	}
+	taskCancel(taskC); // and may cancel another task
+}
+
+// a task may reschedule itself or cancel others from its own function
+static void testReschedule()
+{
+	setFakeClock(500);
+	taskSchedule(taskA, 10);
+	taskSchedule(taskA, 40); // moved, not added twice
+	taskSchedule(taskB, 20);
+	taskSchedule(taskB, 5); // moved earlier
+	CHECK_EQUAL(schedulerRun(), 5);
+	advanceClock(40);
+	schedulerRun();
+	CHECK(strcmp(order, "BA") == 0);
+	CHECK_EQUAL(taskA.runs, 1);
+	CHECK_EQUAL(taskB.runs, 1);
+
+	clearOrder();
+	taskSchedule(taskSelf, 0);
+	taskSchedule(taskC, 120);
+	for (int i = 0; i < 5; i++)
+	{
+		schedulerRun();
+		advanceClock(50);
+	}
+	CHECK(strcmp(order, "SSS") == 0); // C was cancelled before its time
+	CHECK(!taskScheduled(taskSelf));
+	CHECK(!taskScheduled(taskC));
+	cancelAll();
+} // testReschedule()
+
+// a full heap refuses a new task and keeps the ones it has
+static void testFull()
+{
+	static scheduledTask many[SCHED_MAX_TASKS];
+	setFakeClock(0);
+	for (int i = 0; i < SCHED_MAX_TASKS; i++)
+	{
+		many[i] = SCHEDULED_TASK("many", runC, 0);
+		CHECK(taskSchedule(many[i], SCHED_MAX_TASKS - i));
+	}
+	CHECK(!taskSchedule(taskA, 0));
+	CHECK(!taskScheduled(taskA));
+	CHECK_EQUAL(schedulerRun(), 1);
+	advanceClock(SCHED_MAX_TASKS);
+	CHECK_EQUAL(schedulerRun(), TASK_NEVER);
+	CHECK_EQUAL(orderLength, SCHED_MAX_TASKS);
+	cancelAll();
+} // testFull()
+
+void testScheduler()
+{
+	setSchedulerClock(fakeClock);
+	testOrdering();
+	testPeriod();
+	testWrapAround();
+	testReschedule();
+	testFull();
+} // testScheduler()
+
+// End of file
@@ -0,0 +1,280 @@
+/**
+ * @file testShare.cpp
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Tests of the shared weather snapshots (wxSnapshot.h), in one process and over multicast.
+ * @details The multicast test forks follower processes that join the group on
+ *          the loopback interface, as displays join it on the LAN. The parent
+ *          sends as the leader: a heartbeat carries the same content under a new
+ *          sequence, and damaged datagrams are mixed in. Each follower reports
+ *          what it made of them through a pipe. Where the host has no multicast
+ *          on loopback the multicast part is skipped, not failed.
+ */
+
+#include "unitTest.h"
+
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "wxSnapshot.h"
+
+#define TEST_GROUP "239.255.87.71" // the firmware's group
+#define FOLLOWERS 3
+
+static wxSnapshot observation(uint32_t epoch, uint32_t sequence)
+{
+	wxSnapshot snap;
+	memset(&snap, 0, sizeof(snap));
+	snap.obsEpoch = epoch;
+	snap.temp = 215;
+	snap.pressure = 10132;
+	strcpy(snap.neighborhood, "Centreville");
+	snap.flags = SNAPSHOT_FORECAST;
+	snap.tempMax = 27;
+	snap.tempMin = 14;
+	strcpy(snap.phraseShort, "Sunny");
+	snapshotSeal(snap, sequence);
+	return snap;
+} // observation()
+
+static snapshotKind receive(const wxSnapshot &snap, wxSnapshot &last)
+{
+	return snapshotReceive((const uint8_t *)&snap, sizeof(snap), last);
+}
+
+// the follower's checks in one process
+static void testClassify()
+{
+	wxSnapshot last;
+	memset(&last, 0, sizeof(last));
+	wxSnapshot first = observation(1750000000, 1);
+	CHECK_EQUAL(receive(first, last), SNAPSHOT_OBSERVATION);
+	CHECK_EQUAL(receive(observation(1750000000, 2), last), SNAPSHOT_HEARTBEAT); // only the sequence moved
+	CHECK_EQUAL(last.sequence, 2);
+
+	wxSnapshot forecast = observation(1750000000, 3);
+	forecast.tempMax = 29;
+	snapshotSeal(forecast, 3);
+	CHECK_EQUAL(receive(forecast, last), SNAPSHOT_FORECAST_UPDATE);
+	CHECK_EQUAL(receive(forecast, last), SNAPSHOT_HEARTBEAT); // the same datagram again
+	CHECK_EQUAL(receive(observation(1750000420, 4), last), SNAPSHOT_OBSERVATION);
+
+	wxSnapshot bad = observation(1750000840, 5);
+	bad.magic ^= 1;
+	CHECK_EQUAL(receive(bad, last), SNAPSHOT_REJECTED); // the CRC would pass, the magic does not
+	bad = observation(1750000840, 5);
+	bad.magic = 0x12345678;
+	snapshotSeal(bad, 5);
+	bad.magic = 0x12345678; // a good CRC over a foreign magic
+	CHECK_EQUAL(receive(bad, last), SNAPSHOT_REJECTED);
+	bad = observation(1750000840, 5);
+	bad.temp++; // CRC no longer matches
+	CHECK_EQUAL(receive(bad, last), SNAPSHOT_REJECTED);
+	bad = observation(1750000840, 5);
+	bad.version++;
+	CHECK_EQUAL(receive(bad, last), SNAPSHOT_REJECTED);
+	CHECK_EQUAL(snapshotReceive((const uint8_t *)&bad, sizeof(bad) - 1, last), SNAPSHOT_REJECTED);
+	CHECK_EQUAL(last.obsEpoch, 1750000420); // nothing rejected was kept
+
+	// a newer minor revision appends a field before the CRC
+	uint8_t longer[sizeof(wxSnapshot) + 4];
+	wxSnapshot newer = observation(1750000840, 6);
+	memcpy(longer, &newer, offsetof(wxSnapshot, crc));
+	memset(longer + offsetof(wxSnapshot, crc), 0x5A, 4);
+	wxSnapshot header = newer;
+	header.length = sizeof(longer);
+	memcpy(longer, &header, offsetof(wxSnapshot, sequence));
+	// CRC-16/CCITT over the longer body, as the newer leader would send it
+	uint16_t crc = 0xFFFF;
+	for (size_t i = 0; i < sizeof(longer) - 2; i++)
+	{
+		crc ^= (uint16_t)longer[i] << 8;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	longer[sizeof(longer) - 2] = crc & 0xFF;
+	longer[sizeof(longer) - 1] = crc >> 8;
+	CHECK_EQUAL(snapshotReceive(longer, sizeof(longer), last), SNAPSHOT_OBSERVATION);
+	CHECK_EQUAL(last.obsEpoch, 1750000840);
+} // testClassify()
+
+struct followerCounts
+{
+	int observations;
+	int forecasts;
+	int heartbeats;
+	int rejected;
+};
+
+// a follower process: count what arrives until the end marker, report through the pipe
+static void follower(uint16_t port, int ready, int report)
+{
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	int yes = 1;
+	setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	ip_mreq group{};
+	group.imr_multiaddr.s_addr = inet_addr(TEST_GROUP);
+	group.imr_interface.s_addr = htonl(INADDR_LOOPBACK);
+	timeval timeout = {3, 0};
+	setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	char joined = (bind(sock, (sockaddr *)&address, sizeof(address)) == 0 &&
+				   setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &group, sizeof(group)) == 0)
+					  ? 1
+					  : 0;
+	if (write(ready, &joined, 1) != 1 || !joined)
+	{
+		_exit(1);
+	}
+
+	followerCounts counts = {};
+	wxSnapshot last;
+	memset(&last, 0, sizeof(last));
+	uint8_t packet[256];
+	ssize_t length;
+	while ((length = recv(sock, packet, sizeof(packet), 0)) > 0)
+	{
+		uint32_t magic;
+		memcpy(&magic, packet, sizeof(magic));
+		if (length == sizeof(magic) && magic == QUERY_MAGIC)
+		{
+			break; // the leader is done
+		}
+		switch (snapshotReceive(packet, length, last))
+		{
+		case SNAPSHOT_OBSERVATION:
+			counts.observations++;
+			break;
+		case SNAPSHOT_FORECAST_UPDATE:
+			counts.forecasts++;
+			break;
+		case SNAPSHOT_HEARTBEAT:
+			counts.heartbeats++;
+			break;
+		case SNAPSHOT_REJECTED:
+			counts.rejected++;
+			break;
+		}
+	}
+	_exit(write(report, &counts, sizeof(counts)) == sizeof(counts) ? 0 : 1);
+} // follower()
+
+// one leader, FOLLOWERS followers, all over the loopback multicast group
+static void testMulticast()
+{
+	uint16_t port = 20000 + getpid() % 20000; // apart from a display on the same LAN
+	int ready[2], report[2];
+	if (pipe(ready) != 0 || pipe(report) != 0)
+	{
+		CHECK(!"pipe");
+		return;
+	}
+	pid_t children[FOLLOWERS];
+	for (int i = 0; i < FOLLOWERS; i++)
+	{
+		children[i] = fork();
+		if (children[i] == 0)
+		{
+			follower(port, ready[1], report[1]);
+		}
+	}
+	int joined = 0;
+	for (int i = 0; i < FOLLOWERS; i++)
+	{
+		char ok = 0;
+		joined += (read(ready[0], &ok, 1) == 1 && ok) ? 1 : 0;
+	}
+
+	int sock = socket(AF_INET, SOCK_DGRAM, 0);
+	in_addr loopback{};
+	loopback.s_addr = htonl(INADDR_LOOPBACK);
+	unsigned char loop = 1;
+	bool sending = setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, &loopback, sizeof(loopback)) == 0 &&
+				   setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) == 0;
+	sockaddr_in to{};
+	to.sin_family = AF_INET;
+	to.sin_port = htons(port);
+	to.sin_addr.s_addr = inet_addr(TEST_GROUP);
+	auto send = [&](const void *data, size_t length) {
+		sendto(sock, data, length, 0, (sockaddr *)&to, sizeof(to));
+		usleep(2000); // keep the order plain in the receive queues
+	};
+
+	if (joined == FOLLOWERS && sending)
+	{
+		wxSnapshot first = observation(1750000000, 1);
+		send(&first, sizeof(first));
+		for (uint32_t beat = 2; beat <= 4; beat++) // heartbeats: new sequence, same content
+		{
+			wxSnapshot heartbeat = observation(1750000000, beat);
+			send(&heartbeat, sizeof(heartbeat));
+		}
+		wxSnapshot forecast = observation(1750000000, 5);
+		strcpy(forecast.phraseShort, "Showers");
+		snapshotSeal(forecast, 5);
+		send(&forecast, sizeof(forecast));
+		wxSnapshot foreign = observation(1750000420, 6);
+		foreign.magic = 0x4B4E554A;
+		send(&foreign, sizeof(foreign));
+		wxSnapshot damaged = observation(1750000420, 6);
+		damaged.pressure++;
+		send(&damaged, sizeof(damaged));
+		wxSnapshot second = observation(1750000420, 6);
+		send(&second, sizeof(second));
+	}
+	uint32_t done = QUERY_MAGIC;
+	send(&done, sizeof(done));
+	close(sock);
+
+	int reports = 0;
+	for (int i = 0; i < joined && sending; i++)
+	{
+		followerCounts counts;
+		if (read(report[0], &counts, sizeof(counts)) != sizeof(counts))
+		{
+			continue;
+		}
+		reports++;
+		CHECK_EQUAL(counts.observations, 2); // each observation published once
+		CHECK_EQUAL(counts.forecasts, 1);
+		CHECK_EQUAL(counts.heartbeats, 3);
+		CHECK_EQUAL(counts.rejected, 2);
+	}
+	for (pid_t child : children)
+	{
+		if (child > 0)
+		{
+			kill(child, SIGTERM); // one that never joined may still wait
+			waitpid(child, nullptr, 0);
+		}
+	}
+	close(ready[0]);
+	close(ready[1]);
+	close(report[0]);
+	close(report[1]);
+	if (joined < FOLLOWERS || !sending)
+	{
+		printf("  skipped the multicast part: no multicast on loopback\n");
+		return;
+	}
+	CHECK_EQUAL(reports, FOLLOWERS);
+} // testMulticast()
+
+void testShare()
+{
+	testClassify();
+	testMulticast();
+} // testShare()
+
+// End of file
@@ -0,0 +1,144 @@
+/**
+ * @file testThingSpeak.cpp
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Tests of the ThingSpeak bulk update (tsPayload.h) against the stand-in.
+ * @details A batch is built the way thingSpeakService.cpp streams it and posted
+ *          to the stand-in's bulk_update.json; the reply is read with the same
+ *          tsBulkAccepted() the firmware uses.
+ */
+
+#include "unitTest.h"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "standIns.h"
+#include "tsPayload.h"
+
+static bool accepted(const char *body)
+{
+	return tsBulkAccepted(body, strlen(body));
+}
+
+static void testReply()
+{
+	CHECK(accepted("{\"success\":true}"));
+	CHECK(accepted(" {\r\n  \"success\" : true\r\n}"));
+	CHECK(accepted("{\"channel\":{\"id\":1,\"tags\":[\"a\",\"}\"]},\"success\":true}"));
+	CHECK(!accepted("{\"success\":false}"));
+	CHECK(!accepted("{\"success\":\"true\"}")); // a string is not the literal
+	CHECK(!accepted("{\"error\":\"true\",\"success\":false}"));
+	CHECK(!accepted("{\"status\":{\"success\":true}}")); // not the top level member
+	CHECK(!accepted("{\"successful\":true}"));
+	CHECK(!accepted("{\"success\":truest}"));
+	CHECK(!accepted("{\"success\":true")); // cut short
+	CHECK(!accepted("{\"success\":true,\"error\":")); // cut short after it
+	CHECK(!accepted("true"));
+	CHECK(!accepted(""));
+} // testReply()
+
+static void testRows()
+{
+	float field[TS_FIELDS] = {21.5f, 64, 1013.2f, 9, 225, 412.5f, 3.2f, 0};
+	char text[TS_BULK_ROW_MAX];
+	size_t length = tsFormatBulkRow(text, sizeof(text), 1750000000, field, "ok");
+	CHECK(std::string(text) == "{\"created_at\":1750000000,\"field1\":21.5,\"field2\":64,\"field3\":1013.2,"
+							   "\"field4\":9,\"field5\":225,\"field6\":412.5,\"field7\":3.2,\"field8\":0,\"status\":\"ok\"}");
+	CHECK_EQUAL(length, strlen(text));
+	length = tsFormatBulkRow(text, sizeof(text), 1750000000, field, nullptr);
+	CHECK_EQUAL(length, strlen(text));
+	CHECK(strstr(text, "status") == nullptr);
+	CHECK_EQUAL(tsFormatBulkRow(text, 20, 1750000000, field, ""), 19); // truncated, terminated
+	CHECK_EQUAL(tsFormatBulkStart(text, sizeof(text), "KEY"), 34);
+	CHECK(std::string(text) == "{\"write_api_key\":\"KEY\",\"updates\":[");
+} // testRows()
+
+// one POST to the stand-in, the status code and body of its reply
+static int post(uint16_t port, const std::string &path, const std::string &body, std::string &reply)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in address{};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	timeval timeout = {2, 0};
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	if (connect(fd, (sockaddr *)&address, sizeof(address)) != 0)
+	{
+		close(fd);
+		return 0;
+	}
+	std::string request = "POST " + path + " HTTP/1.1\r\nHost: api.thingspeak.com\r\nConnection: keep-alive\r\n"
+						  "Content-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+						  "\r\n\r\n" + body;
+	send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+	std::string response;
+	char buffer[512];
+	ssize_t got;
+	while ((got = recv(fd, buffer, sizeof(buffer), 0)) > 0)
+	{
+		response.append(buffer, got);
+	}
+	close(fd);
+	size_t headerEnd = response.find("\r\n\r\n");
+	reply = headerEnd == std::string::npos ? "" : response.substr(headerEnd + 4);
+	return response.compare(0, 9, "HTTP/1.0 ") == 0 ? atoi(response.c_str() + 9) : 0;
+} // post()
+
+// a batch as sendBatch() streams it
+static std::string batch(const char *key, int rows)
+{
+	char text[TS_BULK_ROW_MAX];
+	tsFormatBulkStart(text, sizeof(text), key);
+	std::string body = text;
+	for (int i = 0; i < rows; i++)
+	{
+		float field[TS_FIELDS] = {20.0f + i, 60, 1013, 5, 180, 300, 1.2f, 0};
+		tsFormatBulkRow(text, sizeof(text), 1750000000 + 300 * i, field, i == rows - 1 ? "fine" : "");
+		body += (i > 0 ? "," : "") + std::string(text);
+	}
+	return body + TS_BULK_END;
+} // batch()
+
+static void testStandIn()
+{
+	StandIns standIns;
+	standIns.thingspeakKey = "WRITEKEY";
+	if (!CHECK(standIns.start()))
+	{
+		return;
+	}
+	std::string reply;
+	CHECK_EQUAL(post(standIns.thingspeakPort, "/channels/12345/bulk_update.json", batch("WRITEKEY", 4), reply), 202);
+	CHECK(tsBulkAccepted(reply.data(), reply.size()));
+	CHECK_EQUAL(standIns.thingspeakUpdates, 4);
+
+	CHECK_EQUAL(post(standIns.thingspeakPort, "/channels/12345/bulk_update.json", batch("OTHERKEY", 2), reply), 401);
+	CHECK(!tsBulkAccepted(reply.data(), reply.size()));
+	std::string noTime = batch("WRITEKEY", 2);
+	noTime.replace(noTime.rfind("created_at"), 10, "created_on");
+	CHECK_EQUAL(post(standIns.thingspeakPort, "/channels/12345/bulk_update.json", noTime, reply), 400);
+	CHECK_EQUAL(post(standIns.thingspeakPort, "/channels/12345/bulk_update.json", batch("WRITEKEY", 0), reply), 400);
+	std::string open = batch("WRITEKEY", 2);
+	open.resize(open.size() - 2); // array never closed
+	CHECK_EQUAL(post(standIns.thingspeakPort, "/channels/12345/bulk_update.json", open, reply), 400);
+	CHECK_EQUAL(standIns.thingspeakUpdates, 4); // refused rows are not counted
+
+	// the gateway's single row update.json is still answered with an entry id
+	CHECK_EQUAL(post(standIns.thingspeakPort, "/update.json", "{\"api_key\":\"X\",\"field1\":1}", reply), 200);
+	CHECK(reply == "{\"entry_id\":5}");
+} // testStandIn()
+
+void testThingSpeak()
+{
+	testReply();
+	testRows();
+	testStandIn();
+} // testThingSpeak()
+
+// End of file
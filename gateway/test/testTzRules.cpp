@@ -0,0 +1,185 @@
+/**
+ * @file testTzRules.cpp
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Tests of the built-in POSIX TZ rules (tzRules.h) over several years.
+ * @details The C library reads the same POSIX rule strings as ezTime's setPosix(),
+ *          so each rule is installed as TZ and the UTC offset read just before and
+ *          at each transition. The expected transitions are worked out here from
+ *          the calendar, not from the rule strings.
+ */
+
+#include "unitTest.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <time.h>
+
+#include "tzRules.h"
+
+// days from 1970-01-01 to a civil date (Howard Hinnant's algorithm)
+static int64_t daysFromCivil(int year, int month, int day)
+{
+	year -= month <= 2;
+	int64_t era = (year >= 0 ? year : year - 399) / 400;
+	int yearOfEra = year - era * 400;
+	int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+} // daysFromCivil()
+
+static int daysInMonth(int year, int month)
+{
+	return (int)(daysFromCivil(month == 12 ? year + 1 : year, month == 12 ? 1 : month + 1, 1) -
+				 daysFromCivil(year, month, 1));
+}
+
+// day of the month of the nth Sunday, n = 5 for the last
+static int sunday(int year, int month, int n)
+{
+	int weekday = (int)((daysFromCivil(year, month, 1) + 4) % 7); // 1970-01-01 was a Thursday
+	int first = 1 + (7 - weekday) % 7;
+	int day = first + 7 * (n - 1);
+	return (day > daysInMonth(year, month)) ? day - 7 : day;
+} // sunday()
+
+// UTC of a wall-clock time read with the offset in force before it
+static int64_t wallToUtc(int year, int month, int day, int minuteOfDay, int offsetBefore)
+{
+	return daysFromCivil(year, month, day) * 86400 + minuteOfDay * 60 - offsetBefore;
+}
+
+static int offsetAt(int64_t utc)
+{
+	time_t t = (time_t)utc;
+	tm local;
+	localtime_r(&t, &local);
+	return (int)local.tm_gmtoff;
+}
+
+static bool useZone(const char *olson)
+{
+	char posix[TZ_POSIX_SIZE];
+	if (!CHECK(tzPosixRule(olson, posix, sizeof(posix))))
+	{
+		return false;
+	}
+	setenv("TZ", posix, 1);
+	tzset();
+	return true;
+} // useZone()
+
+struct zoneCase
+{
+	const char *olson;
+	int standard;	 // seconds east of UTC
+	int daylight;	 // seconds east of UTC in summer
+	int springMonth; // month, nth Sunday and local minute of the change to daylight time
+	int springWeek;
+	int springMinute;
+	int fallMonth; // the same for the change back
+	int fallWeek;
+	int fallMinute;
+};
+
+static const zoneCase ZONES[] = {
+	{"America/New_York", -5 * 3600, -4 * 3600, 3, 2, 120, 11, 1, 120},
+	{"America/Los_Angeles", -8 * 3600, -7 * 3600, 3, 2, 120, 11, 1, 120},
+	{"America/St_Johns", -12600, -9000, 3, 2, 120, 11, 1, 120},
+	{"Europe/London", 0, 3600, 3, 5, 60, 10, 5, 120},
+	{"Europe/Berlin", 3600, 7200, 3, 5, 120, 10, 5, 180},
+	{"Europe/Athens", 7200, 10800, 3, 5, 180, 10, 5, 240},
+	{"Australia/Sydney", 36000, 39600, 10, 1, 120, 4, 1, 180},
+	{"Australia/Adelaide", 34200, 37800, 10, 1, 120, 4, 1, 180},
+	{"Pacific/Auckland", 43200, 46800, 9, 5, 120, 4, 1, 180},
+};
+
+// the offset changes at the calculated second of each transition, 2026 through 2035
+static void testTransitions()
+{
+	for (const zoneCase &zone : ZONES)
+	{
+		if (!useZone(zone.olson))
+		{
+			continue;
+		}
+		for (int year = 2026; year <= 2035; year++)
+		{
+			int64_t spring = wallToUtc(year, zone.springMonth, sunday(year, zone.springMonth, zone.springWeek),
+									   zone.springMinute, zone.standard);
+			int64_t fall = wallToUtc(year, zone.fallMonth, sunday(year, zone.fallMonth, zone.fallWeek),
+									 zone.fallMinute, zone.daylight);
+			bool springOk = CHECK_EQUAL(offsetAt(spring - 1), zone.standard) &&
+							CHECK_EQUAL(offsetAt(spring), zone.daylight);
+			bool fallOk = CHECK_EQUAL(offsetAt(fall - 1), zone.daylight) && CHECK_EQUAL(offsetAt(fall), zone.standard);
+			if (!springOk || !fallOk)
+			{
+				printf("         %s %d\n", zone.olson, year);
+			}
+		}
+	}
+} // testTransitions()
+
+// dates checked by hand against published tables
+static void testKnownDates()
+{
+	useZone("America/New_York");
+	CHECK_EQUAL(offsetAt(1772953200 - 1), -5 * 3600); // 2026-03-08 07:00 UTC
+	CHECK_EQUAL(offsetAt(1772953200), -4 * 3600);
+	CHECK_EQUAL(offsetAt(1793512800), -5 * 3600); // 2026-11-01 06:00 UTC
+	useZone("Europe/Berlin");
+	CHECK_EQUAL(offsetAt(1774746000 - 1), 3600); // 2026-03-29 01:00 UTC
+	CHECK_EQUAL(offsetAt(1774746000), 7200);
+	CHECK_EQUAL(offsetAt(1792890000), 3600); // 2026-10-25 01:00 UTC
+	useZone("Australia/Sydney");
+	CHECK_EQUAL(offsetAt(1775318400 - 1), 39600); // 2026-04-04 16:00 UTC
+	CHECK_EQUAL(offsetAt(1775318400), 36000);
+	CHECK_EQUAL(offsetAt(1791043200), 39600); // 2026-10-03 16:00 UTC
+} // testKnownDates()
+
+// zones without daylight time keep one offset all year
+static void testFixedZones()
+{
+	const struct
+	{
+		const char *olson;
+		int offset;
+	} FIXED[] = {{"America/Phoenix", -7 * 3600}, {"Asia/Kolkata", 19800}, {"Asia/Tokyo", 9 * 3600}, {"UTC", 0}};
+	for (const auto &zone : FIXED)
+	{
+		if (!useZone(zone.olson))
+		{
+			continue;
+		}
+		for (int month = 1; month <= 12; month++)
+		{
+			CHECK_EQUAL(offsetAt(daysFromCivil(2030, month, 15) * 86400), zone.offset);
+		}
+	}
+} // testFixedZones()
+
+// unknown zones fall back to the server; a short buffer is refused
+static void testLookup()
+{
+	char posix[TZ_POSIX_SIZE];
+	CHECK(!tzPosixRule("Mars/Olympus_Mons", posix, sizeof(posix)));
+	CHECK(!tzPosixRule("America/New_York", posix, 8));
+	CHECK(tzPosixRule("America/New_York", posix, sizeof(posix)));
+	CHECK(strcmp(posix, "EST5EDT,M3.2.0,M11.1.0") == 0);
+} // testLookup()
+
+void testTzRules()
+{
+	const char *saved = getenv("TZ");
+	char *restore = saved ? strdup(saved) : nullptr;
+	testTransitions();
+	testKnownDates();
+	testFixedZones();
+	testLookup();
+	restore ? setenv("TZ", restore, 1) : unsetenv("TZ");
+	tzset();
+	free(restore);
+} // testTzRules()
+
+// End of file
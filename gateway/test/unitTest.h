@@ -0,0 +1,51 @@
+/**
+ * @file unitTest.h
+ * @author Karl Berger
+ * @date 2025-07-08
+ * @brief Host unit tests of the portable core and the stand-ins.
+ *
+ * `make test` builds wxtest from the files in this directory, lib/wxcore and
+ * the gateway's event loop and stand-ins, and runs every suite. A suite is a
+ * function listed in testMain.cpp that makes CHECK()s; a failed check prints
+ * its file, line and expression and the run goes on, so one pass reports every
+ * failure. wxtest exits with status 1 if any check failed.
+ *
+ * The core keeps its state in file statics, as the firmware does, so a suite
+ * that schedules tasks or starts coroutines leaves nothing behind for the next.
+ *
+ * Functions:
+ * - CHECK(condition): Count a check, report it if it failed.
+ * - CHECK_EQUAL(actual, expected): As CHECK(), printing both integer values.
+ * - fakeClock() / advanceClock(ms) / setFakeClock(ms): A millisecond clock the test moves.
+ */
+#ifndef UNIT_TEST_H
+#define UNIT_TEST_H
+
+#include <cstdint>
+
+#define CHECK(condition) checkThat((condition), #condition, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected) \
+	checkEqual((long long)(actual), (long long)(expected), #actual " == " #expected, __FILE__, __LINE__)
+
+bool checkThat(bool passed, const char *expression, const char *file, int line);					  ///< false if it failed
+bool checkEqual(long long actual, long long expected, const char *expression, const char *file, int line); ///< false if it failed
+
+uint32_t fakeClock();				///< milliseconds, moved only by the test
+void advanceClock(uint32_t ms);	///< move the fake clock forward
+void setFakeClock(uint32_t ms);	///< set the fake clock
+
+// suites, one per file
+void testScheduler();
+void testCoroutine();
+void testTzRules();
+void testBreaker();
+void testShare();
+void testMqtt();
+void testThingSpeak();
+void testDns();
+void testCalendar();
+void testLogFrame();
+void testPackedHistory();
+
+#endif // UNIT_TEST_H
+// End of file
@@ -7,16 +7,31 @@
 
 #include <Arduino.h> // for String
 
-// Bulletin tracking flags
-extern bool amBulletinSent; ///< Indicates if the morning bulletin was sent
-extern bool pmBulletinSent; ///< Indicates if the evening bulletin was sent
-
 /**
  * @brief Posts a message to APRS-IS.
+ * @details The post runs as a coroutine and returns at once. A message that arrives
+ *          while a post is under way is sent next by retryAPRSpost().
  * @param message Message to be posted.
  */
 void postToAPRS(String message);
 
+/**
+ * @brief Retries the last failed APRS post once its backoff has passed,
+ *        or sends a message that waited for the previous post.
+ */
+void retryAPRSpost();
+
+/**
+ * @brief Runs a post that is under way to the end.
+ */
+void finishAPRSpost();
+
+/**
+ * @brief Reports whether an APRS post is under way or waiting for a retry.
+ * @return true if the last post has not gone through yet.
+ */
+bool APRSpending();
+
 /**
  * @brief Formats and sends weather data to APRS-IS.
  * @return Formatted weather string.
@@ -75,4 +90,17 @@ String APRSpadCall(String callSign);
  */
 String APRSlocation(float lat, float lon);
 
-void processBulletins();
\ No newline at end of file
+/**
+ * @brief Sends the morning aphorism bulletin, run by the calendar at 0800 local.
+ */
+void sendMorningBulletin();
+
+/**
+ * @brief Sends the evening aphorism bulletin, run by the calendar at 2000 local.
+ */
+void sendEveningBulletin();
+
+/**
+ * @brief Sends tonight's forecast as a bulletin, run by the calendar at sunset.
+ */
+void sendSunsetBulletin();
@@ -0,0 +1,27 @@
+/**
+ * @file bootProfile.h
+ * @author Karl Berger
+ * @date 2025-07-02
+ * @brief Timestamps of the boot phases, up to the first live frame.
+ *
+ * setup() calls bootMark() as each phase ends, and the first sequential frame
+ * calls bootFirstFrame(). Each mark records millis(), so a phase's cost is the
+ * gap since the previous mark. The record stays for the "boot" console command
+ * and is printed once with debug output on.
+ *
+ * Functions:
+ * - bootMark(phase): Record the end of a boot phase.
+ * - bootFirstFrame(): Record the first live frame and close the profile.
+ * - printBootProfile(): Print each phase and its duration to Serial.
+ */
+#ifndef BOOT_PROFILE_H
+#define BOOT_PROFILE_H
+
+#define BOOT_PHASES 16 ///< marks kept, later ones are dropped
+
+void bootMark(const char *phase); ///< record the end of a boot phase
+void bootFirstFrame();			  ///< record the first live frame, once
+void printBootProfile();		  ///< print the boot phases
+
+#endif // BOOT_PROFILE_H
+// End of file
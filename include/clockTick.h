@@ -0,0 +1,35 @@
+/**
+ * @file clockTick.h
+ * @author Karl Berger
+ * @date 2025-07-01
+ * @brief Clock frame ticks aligned to the edge of each NTP second.
+ *
+ * A free-running 1000 ms timer samples the time at an arbitrary phase, so with a
+ * little jitter the clock shows one second twice and then skips the next. Each
+ * tick here is instead scheduled from ezTime's millisecond time to land
+ * CLOCK_TICK_LAG ms after the next second boundary, and a tick that arrives
+ * early for its second is not drawn.
+ *
+ * Statistics, for the "clock" console command:
+ * - phase: milliseconds past the second edge at which each tick ran (jitter)
+ * - skipped seconds, and early ticks that would have repeated a second
+ * - drift: how far millis() has moved against NTP-disciplined time, in ppm
+ *
+ * Functions:
+ * - startClockTick(): Tick on the next second edge, when the clock frame appears.
+ * - stopClockTick(): Stop ticking, when the clock frame goes away.
+ * - clockTick(): The taskSecondTick callback.
+ * - printClockStats(): Print phase, skip and drift statistics to Serial.
+ */
+#ifndef CLOCK_TICK_H
+#define CLOCK_TICK_H
+
+#define CLOCK_TICK_LAG 20 ///< milliseconds after the second edge to draw
+
+void startClockTick();	///< tick on the next second edge
+void stopClockTick();	///< stop ticking
+void clockTick();		///< draw the clock and schedule the next tick
+void printClockStats(); ///< print tick statistics
+
+#endif // CLOCK_TICK_H
+// End of file
@@ -0,0 +1,83 @@
+/**
+ * @file connectionPool.h
+ * @author Karl Berger
+ * @date 2025-06-14
+ * @brief Shared keep-alive connections for the weather, ThingSpeak and APRS clients.
+ *
+ * The pool owns one socket per host and port. A service acquires the socket,
+ * uses it, and releases it either for reuse or to be closed. Each service says
+ * when it expects to use its host again, the interval of its fetch or post, and
+ * an idle socket is drained and kept that long plus POOL_IDLE_MARGIN, at most
+ * POOL_MAX_IDLE. So a 7 minute fetch finds its socket still open, as long as the
+ * server keeps it; a socket the server closed is replaced on the next acquire.
+ * Free heap bounds all of it: below POOL_MIN_FREE_HEAP idle sockets are closed
+ * early, TLS sockets first, they hold the most RAM. When the radio sleeps between
+ * bursts (radioPower.h) the link drops and resetConnections() closes them all.
+ *
+ * Functions:
+ * - acquireConnection(host, port, secure, reused, nextUse): Get a connected socket, kept
+ *   open for nextUse ms after release.
+ * - releaseConnection(client, keepAlive): Return a socket to the pool.
+ * - beginHttpResponse(response, client, endpoint, maxBody, timeout): Prepare to read a response.
+ * - readHttpResponse(response): Protothread that reads the status, headers and body.
+ * - readLine(client, line): Append the bytes that have arrived, true at the end of a line.
+ * - maintainConnections(): Drain and recycle idle sockets, call from loop().
+ * - resetConnections(): Close every idle socket, used when Wi-Fi comes back.
+ * - printConnectionStats(): Print per-host connect/reuse counters.
+ */
+#ifndef CONNECTION_POOL_H
+#define CONNECTION_POOL_H
+
+#include <Arduino.h>		// for String
+#include <WiFiClient.h>		// for WiFiClient
+#include <protothread.h>	// stackless coroutines from lib/wxcore
+#include "netTiming.h"		// for netEndpoint
+
+#define POOL_SLOTS 4					 ///< hosts tracked by the pool
+#define POOL_IDLE_MARGIN 60000UL		 ///< kept open this long past the expected next use (ms)
+#define POOL_MAX_IDLE 1800000UL			 ///< longest an idle socket is kept (ms)
+#define POOL_MIN_FREE_HEAP 16000UL		 ///< close idle sockets below this free heap (bytes)
+#define POOL_MAX_BODY 512				 ///< default longest HTTP response body kept
+
+struct poolStats
+{
+	const char *host;	 ///< host name, nullptr if the slot is unused
+	uint16_t port;		 ///< host port
+	bool secure;		 ///< TLS connection
+	bool connected;		 ///< socket is open
+	uint32_t connects;	 ///< new connections made
+	uint32_t reuses;	 ///< warm connections reused
+	uint32_t failures;	 ///< connection attempts that failed
+};
+
+//! HTTP response being read by readHttpResponse()
+struct httpResponse
+{
+	protothread pt;		   ///< reader state
+	WiFiClient *client;	   ///< socket being read
+	netEndpoint endpoint;  ///< for phase timing
+	size_t maxBody;		   ///< body bytes kept, the rest are read and dropped
+	unsigned long timeout; ///< milliseconds allowed for each wait
+	int status;			   ///< HTTP status code, 0 on timeout or garbage
+	bool keepAlive;		   ///< the socket may be reused
+	String body;		   ///< response body
+	String line;		   ///< line being assembled
+	long remaining;		   ///< body or chunk bytes still to come
+	long contentLength;	   ///< Content-Length, -1 if not given
+	bool chunked;		   ///< chunked transfer encoding
+};
+
+WiFiClient *acquireConnection(const char *host, uint16_t port, bool secure, bool &reused,
+							  unsigned long nextUse);										   ///< get a connected socket, nullptr on failure
+void releaseConnection(WiFiClient *client, bool keepAlive);								   ///< return a socket to the pool
+void beginHttpResponse(httpResponse &response, WiFiClient *client, netEndpoint endpoint, size_t maxBody,
+					   unsigned long timeout);											   ///< prepare to read a response
+ptState readHttpResponse(httpResponse &response);										   ///< protothread: read a response
+bool readLine(WiFiClient &client, String &line);										   ///< true once a whole line has arrived
+void maintainConnections();																   ///< drain and recycle idle sockets
+void resetConnections();																	   ///< close every idle socket
+bool getConnectionStats(int slot, poolStats &stats);									   ///< read counters for a slot
+void printConnectionStats();															   ///< print counters to Serial
+
+#endif // CONNECTION_POOL_H
+// End of file
@@ -30,10 +30,32 @@ extern const String APHORISM_FILE;
 extern const String TS_WRITE_KEY;
 extern const String TS_CHANNEL;
 
+// Local station uploads
+extern const uint16_t INGEST_PORT; // port for station uploads on the LAN, 0 to disable
+extern const String INGEST_PASSKEY; // WU PASSWORD or Ecowitt PASSKEY the station sends, "" to accept any
+
+// Displays sharing one weather feed on the LAN
+extern const uint8_t SHARE_MODE; // SHARE_OFF, SHARE_LEADER or SHARE_FOLLOWER from wxShare.h
+
+// MQTT broker
+extern const String MQTT_BROKER;   // broker host name, "" to disable MQTT
+extern const uint16_t MQTT_PORT;   // broker port
+extern const String MQTT_USER;     // broker user name, "" if none
+extern const String MQTT_PASSWORD; // broker password, "" if none
+extern const String MQTT_TOPIC;    // topic prefix
+extern const uint8_t MQTT_QOS;     // 0 or 1
+
+// Headless gateway
+extern const bool HEADLESS_GATEWAY; // no display: fetch, post and deep sleep
+
+// Radio power
+extern const bool RADIO_SLEEP; // switch the Wi-Fi radio off between network bursts
+
 // Weather update intervals (note minutes)
 extern const unsigned int WX_CURRENT_INTERVAL;  // minutes between current weather requests (Should be >= 1)
 extern const unsigned int WX_FORECAST_INTERVAL; // minutes between forecast requests
 extern const unsigned int TS_POST_INTERVAL; // minutes between posting to ThingSpeak
+extern const unsigned int TS_BATCH_SIZE;    // ThingSpeak samples per upload
 extern const unsigned int WX_APRS_INTERVAL;     // minutes between posting weather data to APRS (Must be >= 5)
 extern const unsigned int SCREEN_DURATION;      // display frame interval in !!!seconds!!!
 
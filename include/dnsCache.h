@@ -0,0 +1,52 @@
+/**
+ * @file dnsCache.h
+ * @author Karl Berger
+ * @date 2025-06-15
+ * @brief Host name cache with TTL, stale-while-revalidate and negative caching.
+ *
+ * The cache itself is hostCache from lib/wxcore: answers are served while the
+ * record TTL lasts, a stale address for up to DNS_STALE_WINDOW while it is
+ * revalidated, and failed lookups are remembered for DNS_NEGATIVE_TTL. A host
+ * that is in use is looked up again before its TTL runs out, so it never goes
+ * stale in the first place.
+ *
+ * Lookups run in a coroutine. A small UDP resolver sends one A query so the
+ * record TTL is known and the coroutine waits for the answer without blocking.
+ * The server defaults to the one supplied by DHCP and can be pointed at a local
+ * stub responder with setDnsServer() or the DNS_SERVER build flag. Revalidation
+ * and prefetch run from maintainDnsCache(); only a host that is not in the cache
+ * at all makes resolveHost() wait for its lookup, as a connect would.
+ *
+ * A host that will be connected to by name, as TLS hosts are for SNI, is marked
+ * DNS_SYSTEM. The connect repeats the lookup, and lwIP answers it from its own
+ * table only if lwIP made the query, so these hosts are also looked up through
+ * lwIP after the UDP query. They are cached like any other host, so their TTL,
+ * stale and negative handling is the same; prefetch keeps lwIP's table warm.
+ *
+ * Functions:
+ * - beginDnsCache(): Apply the DNS_SERVER build flag, call from setup().
+ * - resolveHost(host, ip, system): Look up a host, true if an address is known.
+ * - maintainDnsCache(): Start background revalidation and prefetch, call from a task.
+ * - setDnsServer(ip, port): Use a specific DNS server.
+ * - flushDnsCache(): Forget all entries.
+ * - printDnsStats(): Print cache counters to Serial.
+ */
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#include <Arduino.h>   // for IPAddress
+#include <hostCache.h> // cache limits from lib/wxcore
+
+#define DNS_TIMEOUT 1000UL		  ///< milliseconds to wait for a UDP answer
+#define DNS_SYSTEM_TIMEOUT 5000UL ///< milliseconds to wait for lwIP's resolver
+#define DNS_SYSTEM true			  ///< resolveHost(): the host is connected to by name
+
+void beginDnsCache();											   ///< apply the DNS_SERVER build flag
+bool resolveHost(const char *host, IPAddress &ip, bool system = false); ///< look up a host, true if an address is known
+void maintainDnsCache();										   ///< background revalidation and prefetch
+void setDnsServer(IPAddress server, uint16_t port = 53);		   ///< use a specific DNS server
+void flushDnsCache();											   ///< forget all entries
+void printDnsStats();											   ///< print cache counters
+
+#endif // DNS_CACHE_H
+// End of file
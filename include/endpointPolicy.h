@@ -0,0 +1,26 @@
+/**
+ * @file endpointPolicy.h
+ * @author Karl Berger
+ * @date 2025-06-17
+ * @brief Retry, backoff and circuit breaker policy for network endpoints.
+ *
+ * The state machine is portable and lives in circuitBreaker.h in lib/wxcore,
+ * where it is tested on a host with a fake clock. This part gives it millis(),
+ * the Arduino random(), debug output and the serial report.
+ *
+ * Functions:
+ * - initEndpointPolicy(): Install the clock, jitter source and debug log, first in setup().
+ * - printEndpointHealth(): Print the state of every endpoint to Serial.
+ * - policyAllow(), policySuccess(), policyFailure(), policyRetryDue(), policyRetryAll(),
+ *   policyNextRetry(): see circuitBreaker.h.
+ */
+#ifndef ENDPOINT_POLICY_H
+#define ENDPOINT_POLICY_H
+
+#include <circuitBreaker.h> // retry and breaker state machine from lib/wxcore
+
+void initEndpointPolicy();	///< install the clock, jitter and log
+void printEndpointHealth(); ///< print all endpoints to Serial
+
+#endif // ENDPOINT_POLICY_H
+// End of file
@@ -0,0 +1,36 @@
+/**
+ * @file gatewayMode.h
+ * @author Karl Berger
+ * @date 2025-06-25
+ * @brief Headless fetch, post and deep sleep cycle for units without a display.
+ *
+ * With HEADLESS_GATEWAY set in credentials, setup() hands over to runGatewayCycle()
+ * and loop() is never reached. Each wake-up connects with the cached access point,
+ * fetches the current observation, posts it to APRS-IS and/or ThingSpeak if they are
+ * due, and sleeps until the next post is due. The display, sequential frames, clock
+ * and indoor sensor are never started.
+ *
+ * The schedule phase, the last observation posted to each service, the station
+ * position and the clock are kept in RTC memory, which survives deep sleep. A warm
+ * wake-up therefore needs no NTP wait and no discovery fetch; NTP is checked every
+ * GATEWAY_NTP_CYCLES wake-ups to correct the drift of the sleep timer.
+ *
+ * The awake time of every cycle is logged and sent as the ThingSpeak status.
+ * GPIO16 (D0) must be wired to RST for the timer to wake the board.
+ *
+ * Functions:
+ * - runGatewayCycle(): Run one cycle and deep sleep, does not return.
+ */
+#ifndef GATEWAY_MODE_H
+#define GATEWAY_MODE_H
+
+#define GATEWAY_RTC_BLOCK 16	 ///< RTC user memory offset in 4 byte blocks, after the Wi-Fi cache
+#define GATEWAY_NTP_CYCLES 12	 ///< wake-ups between NTP checks
+#define GATEWAY_NTP_WAIT 10		 ///< seconds allowed for NTP
+#define GATEWAY_RETRY 120		 ///< seconds to sleep after a failed cycle
+#define GATEWAY_EARLY 15		 ///< seconds early a post may be made rather than sleeping again
+
+void runGatewayCycle(); ///< one fetch, post and sleep cycle
+
+#endif // GATEWAY_MODE_H
+// End of file
@@ -2,6 +2,18 @@
  * @file indoorSensor.h
  * @brief Indoor sensor functions
  * @details This is the header file for the indoor sensor.
+ *          The AHTx0 is sampled in the background by taskIndoorSensor: one pass
+ *          triggers a measurement and the next, AHT_MEASURE_MS later, reads it, so
+ *          nothing waits on the sensor. Each reading goes through a median and
+ *          moving average filter (sampleFilter.h) into `indoor`, which the frames
+ *          and uplinks only read. The observation history (wxHistory.h) keeps the
+ *          indoor temperature with each sample.
+ *
+ *          Functions:
+ *          - initSensor(): Detect and initialize the sensor.
+ *          - sampleSensor(): The taskIndoorSensor callback, trigger or read.
+ *          - indoorReady(): True once `indoor` holds a reading.
+ *          - printIndoorStats(): Print the readings and errors to Serial.
  * @author Karl Berger
  * @date 2025-05-15
  */
@@ -9,6 +21,11 @@
 #ifndef INDOOR_SENSOR_H
 #define INDOOR_SENSOR_H
 
+#include <Arduino.h> // for fixed width types
+
+#define INDOOR_SAMPLE_MS 10000UL	  ///< milliseconds between measurements
+#define AHT_MEASURE_MS 80			  ///< AHTx0 conversion time after a trigger
+
 typedef struct // for indoor sensor
 {
 	float tempC;
@@ -17,11 +34,13 @@ typedef struct // for indoor sensor
 
 // Global sensor variables
 extern bool indoorSensor; // true if sensor exists
-extern SensorTH indoor;	  // Indoor sensor readings
+extern SensorTH indoor;	  // Indoor sensor readings, filtered
 
 // Function declarations
-void initSensor(); // Detect & initialize indoor sensor
-void readSensor(); // Read indoor sensor
+void initSensor();									///< Detect & initialize indoor sensor
+void sampleSensor();								///< trigger or read a measurement
+bool indoorReady();									///< true once indoor holds a reading
+void printIndoorStats();							///< print readings and errors
 
 #endif // INDOOR_SENSOR_H
 // End of file
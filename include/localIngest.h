@@ -0,0 +1,40 @@
+/**
+ * @file localIngest.h
+ * @author Karl Berger
+ * @date 2025-06-19
+ * @brief Receive station uploads directly on the local network.
+ *
+ * Point the station's custom server setting at this device and it will accept
+ * the same uploads it sends to the cloud:
+ * - Weather Underground protocol: GET /weatherstation/updateweatherstation.php?tempf=...
+ * - Ecowitt protocol: POST to any path with a form encoded body
+ *
+ * Parameters are parsed one at a time straight from the socket, converted to
+ * metric and stored in the `weather` model. While local uploads keep arriving,
+ * getWXcurrent() skips the cloud request and only polls as a fallback.
+ *
+ * The listener is disabled when INGEST_PORT is 0, the default, because it keeps
+ * the radio from sleeping (radioPower.h). When INGEST_PASSKEY is set,
+ * uploads without it are refused with 401. tools/ingest_sample.py sends one
+ * upload of each kind for testing.
+ *
+ * Functions:
+ * - beginLocalIngest(): Start the listener, call after Wi-Fi connects.
+ * - handleLocalIngest(): Accept an upload and parse what has arrived of it, call often.
+ * - localDataFresh(): True if a local upload arrived recently.
+ * - printIngestStats(): Print upload counters to Serial.
+ */
+#ifndef LOCAL_INGEST_H
+#define LOCAL_INGEST_H
+
+#define INGEST_FRESH_MS 300000UL ///< local data newer than this replaces the cloud poll
+#define INGEST_TIMEOUT 500		 ///< milliseconds allowed to receive one request
+#define INGEST_MAX_BODY 2048	 ///< longest POST body read
+
+void beginLocalIngest();  ///< start the listener
+void handleLocalIngest(); ///< parse what has arrived of an upload
+bool localDataFresh();	  ///< true if local data is current
+void printIngestStats();  ///< print upload counters
+
+#endif // LOCAL_INGEST_H
+// End of file
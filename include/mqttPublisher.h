@@ -0,0 +1,32 @@
+/**
+ * @file mqttPublisher.h
+ * @author Karl Berger
+ * @date 2025-06-18
+ * @brief MQTT output of the station observation and indoor sensor.
+ *
+ * One broker connection is kept open with a persistent session (clean session
+ * off). Each new observation is published as a compact retained JSON message on
+ * "<MQTT_TOPIC>/wx" and the indoor sensor on "<MQTT_TOPIC>/indoor". QoS 1 messages
+ * are kept until the broker acknowledges them and are resent after a reconnect.
+ * "<MQTT_TOPIC>/status" carries "online", or "offline" as the last will.
+ *
+ * MQTT is disabled when MQTT_BROKER is empty.
+ *
+ * Functions:
+ * - publishWXtoMQTT(): Publish the current observation and indoor readings.
+ * - mqttLoop(): Keep the connection alive and handle acknowledgements, call from loop().
+ */
+#ifndef MQTT_PUBLISHER_H
+#define MQTT_PUBLISHER_H
+
+#define MQTT_KEEPALIVE 60		 ///< seconds between keep-alive pings
+#define MQTT_ACK_TIMEOUT 10000UL ///< milliseconds before an unacknowledged QoS 1 message is resent
+#define MQTT_MAX_PACKET 384		 ///< largest packet built or accepted
+#define MQTT_CONNECT_TIMEOUT 5000UL ///< milliseconds allowed for the CONNACK
+#define MQTT_READ_TIMEOUT 1000UL	 ///< milliseconds allowed for a packet once its first byte arrives
+
+void publishWXtoMQTT(); ///< publish current observation and indoor readings
+void mqttLoop();		///< keep the broker connection alive
+
+#endif // MQTT_PUBLISHER_H
+// End of file
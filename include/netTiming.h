@@ -0,0 +1,66 @@
+/**
+ * @file netTiming.h
+ * @author Karl Berger
+ * @date 2025-06-16
+ * @brief Phase timing of outbound network operations.
+ *
+ * Each operation is started with netTimingBegin() and closed with netTimingEnd().
+ * In between, netTimingMark() records the time spent since the previous mark in
+ * the named phase. Durations go into fixed power-of-two millisecond histograms
+ * per endpoint and phase, so the cost is a micros() call and a counter increment.
+ *
+ * Phases:
+ * - DNS: host lookup (skipped on a reused socket)
+ * - CONNECT: TCP connect of a plain socket
+ * - TLS: TCP connect plus TLS handshake of a secure socket
+ * - FIRST_BYTE: request sent until the response status or server banner arrives
+ * - BODY: response transfer; for streamed JSON this includes deserialization
+ * - PARSE: copying the parsed values into the program's data
+ *
+ * Functions:
+ * - netTimingBegin(endpoint): Start timing an operation.
+ * - netTimingMark(phase): Close the current phase of the operation begun last.
+ * - netTimingMarkFor(endpoint, phase): Close the current phase of an endpoint's operation.
+ * - netTimingSkip(): Restart the phase clock without recording.
+ * - netTimingEnd(success): Finish the operation begun last.
+ * - netTimingEndFor(endpoint, success): Finish an endpoint's operation.
+ * - printNetTiming(): Print the histograms to Serial.
+ */
+#ifndef NET_TIMING_H
+#define NET_TIMING_H
+
+#include <Arduino.h> // for fixed width types
+
+enum netEndpoint
+{
+	NET_WX_CURRENT,	 ///< WU current observation
+	NET_WX_FORECAST, ///< WU 5 day forecast
+	NET_WX_HISTORY,	 ///< WU 1 day history
+	NET_THINGSPEAK,	 ///< ThingSpeak bulk update
+	NET_APRS,		 ///< APRS-IS post
+	NET_ENDPOINTS	 ///< number of endpoints
+};
+
+enum netPhase
+{
+	NET_PHASE_DNS,		  ///< host lookup
+	NET_PHASE_CONNECT,	  ///< TCP connect
+	NET_PHASE_TLS,		  ///< TCP connect and TLS handshake
+	NET_PHASE_FIRST_BYTE, ///< time to first response byte
+	NET_PHASE_BODY,		  ///< response transfer
+	NET_PHASE_PARSE,	  ///< data extraction
+	NET_PHASES			  ///< number of phases
+};
+
+#define NET_BUCKETS 14 ///< histogram buckets: <1, <2, <4 ... <4096, >=4096 ms
+
+void netTimingBegin(netEndpoint endpoint); ///< start timing an operation
+void netTimingMark(netPhase phase);		   ///< close the current phase
+void netTimingMarkFor(netEndpoint endpoint, netPhase phase); ///< close an endpoint's current phase
+void netTimingSkip();					   ///< restart the phase clock without recording
+void netTimingEnd(bool success);		   ///< finish the operation
+void netTimingEndFor(netEndpoint endpoint, bool success); ///< finish an endpoint's operation
+void printNetTiming();					   ///< print histograms to Serial
+
+#endif // NET_TIMING_H
+// End of file
@@ -0,0 +1,54 @@
+/**
+ * @file obsLog.h
+ * @author Karl Berger
+ * @date 2025-07-06
+ * @brief Append-only observation log on LittleFS.
+ *
+ * Every sample the history accepts is also appended to a log file, so a
+ * restart can rebuild the history from flash instead of starting with only
+ * the 1-day backfill. Records are CRC-framed (logFrame.h in lib/wxcore): a
+ * corrupt record is skipped, and a record torn by a reset during a write is
+ * cut off the end of the file at boot.
+ *
+ * Flash wear: records wait in RAM and are written OBSLOG_BATCH at a time, or
+ * OBSLOG_FLUSH_MS after the first one waits, by taskLogFlush.
+ *
+ * Size: when the current file would pass OBSLOG_SEGMENT_BYTES it replaces the
+ * previous file, which is deleted. The two files hold at most twice that, and
+ * never less than one full file, more than the week the history keeps.
+ *
+ * Seek: every OBSLOG_INDEX_EVERY records the time and file position go into
+ * an index in RAM, so logScan() starts reading near its window.
+ *
+ * The log is only written once beginObsLog() has run, so the headless gateway
+ * cycle, which does not keep a history, never writes it.
+ *
+ * Functions:
+ * - beginObsLog(replay): Check the log, index it, repair a torn end and replay every record.
+ * - logAppend(sample): Queue a sample for the next write.
+ * - logFlush(): Write the queued samples, the taskLogFlush callback.
+ * - logScan(from, each): Read the samples at or after a time, in order.
+ * - printLogStats(): Print file sizes, writes, repairs and seek time to Serial.
+ */
+#ifndef OBS_LOG_H
+#define OBS_LOG_H
+
+#include <Arduino.h>	 // for fixed width types
+#include "wxHistory.h" // for wxSample
+
+#define OBSLOG_FILE "/obs.log"		 ///< records being appended
+#define OBSLOG_OLD_FILE "/obs.old"	 ///< the file before the last rotation
+#define OBSLOG_SEGMENT_BYTES 40960UL ///< file size that starts a new file, about 7 days
+#define OBSLOG_BATCH 8				 ///< records written at once
+#define OBSLOG_FLUSH_MS 3600000UL	 ///< longest a record waits in RAM
+#define OBSLOG_INDEX_EVERY 32		 ///< records between index entries
+#define OBSLOG_INDEX_SLOTS 128		 ///< index entries, enough for both files
+
+bool beginObsLog(void (*replay)(const wxSample &sample)); ///< false if the file system is not mounted
+void logAppend(const wxSample &sample);					  ///< queue a sample for writing
+void logFlush();										  ///< write the queued samples
+int logScan(uint32_t from, bool (*each)(const wxSample &sample)); ///< samples read, each returns false to stop
+void printLogStats();									  ///< print log counters
+
+#endif // OBS_LOG_H
+// End of file
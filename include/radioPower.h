@@ -0,0 +1,34 @@
+/**
+ * @file radioPower.h
+ * @author Karl Berger
+ * @date 2025-06-24
+ * @brief Switches the Wi-Fi radio off between network bursts.
+ *
+ * The only network traffic of a plain display is a burst every few minutes when a
+ * scheduled task fetches or posts weather. Between bursts radioLoop() puts the modem to
+ * sleep and wakes it RADIO_WAKE_LEAD before the next scheduled task, pending retry or
+ * APRS bulletin, so the cached reconnect finishes before the task runs. Only retries
+ * with something waiting for them count, see policyNextRetry(). The CPU, display and
+ * clock keep running throughout.
+ *
+ * Sleeping is only possible when nothing needs to listen on the LAN: MQTT, local
+ * station uploads (INGEST_PORT other than 0) and LAN sharing each keep the radio on.
+ * All three are off by default. RADIO_SLEEP in credentials turns the manager off
+ * altogether.
+ *
+ * Functions:
+ * - radioLoop(): Sleep or wake the radio, call from loop().
+ * - printRadioStats(): Print the radio-on fraction to Serial.
+ */
+#ifndef RADIO_POWER_H
+#define RADIO_POWER_H
+
+#define RADIO_WAKE_LEAD 10000UL ///< milliseconds awake before a network task
+#define RADIO_MIN_SLEEP 30000UL ///< shortest sleep worth a reconnect
+#define RADIO_LINGER 2000UL		///< milliseconds online before sleeping again
+
+void radioLoop();		///< sleep or wake the radio
+void printRadioStats(); ///< print the radio-on fraction
+
+#endif // RADIO_POWER_H
+// End of file
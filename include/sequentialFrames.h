@@ -14,6 +14,7 @@
 void updateSequentialFrames();									 ///< update the sequential frames
 void drawFramePanels(int top_background, int bottom_background); ///< draws upper and lower panels for the frame
 void updateClock();												 ///< updates the selected clock
+void refreshWXframe();											 ///< redraws a weather frame that is showing
 
 #endif															 // SEQUENTIAL_FRAMES_H
 // End of file
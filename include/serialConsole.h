@@ -0,0 +1,18 @@
+/**
+ * @file serialConsole.h
+ * @author Karl Berger
+ * @date 2025-06-16
+ * @brief Diagnostic commands typed on the serial monitor.
+ *
+ * Commands are single words ended by a newline. Type "help" for the list.
+ *
+ * Functions:
+ * - processSerialCommands(): Read and run commands, call from loop().
+ */
+#ifndef SERIAL_CONSOLE_H
+#define SERIAL_CONSOLE_H
+
+void processSerialCommands(); ///< read and run serial commands
+
+#endif // SERIAL_CONSOLE_H
+// End of file
@@ -1,40 +1,71 @@
 /**
  * @file taskControl.h
  * @author Karl Berger
- * @date 2025-06-04
- * @brief Declarations for task scheduling and control using TickTwo timers.
+ * @date 2025-06-26
+ * @brief Declarations for task scheduling and control using the deadline scheduler.
  *
- * This header defines external TickTwo timer objects for various periodic tasks,
- * such as updating clocks, fetching weather data, and posting updates to APRS and ThingSpeak.
- * It also declares functions to start and update these scheduled tasks.
+ * Every periodic job, from the weather fetches to the service polls that used to
+ * run on each pass of loop(), is a scheduledTask kept in order of its next
+ * deadline (see taskScheduler.h in lib/wxcore). updateTasks() runs whatever is
+ * due and then delay()s until the next deadline, so the CPU idles instead of
+ * spinning through loop().
  *
- * External TickTwo timers:
- * - tmrSecondTick: Timer for second tick clock updates.
- * - tmrGetWXcurrent: Timer for current weather updates.
- * - tmrGetWXforecast: Timer for forecasted weather updates.
- * - tmrPostWXtoAPRS: Timer for posting weather data to APRS.
- * - tmrPostWXtoThingspeak: Timer for posting weather data to ThingSpeak.
- * - tmrUpdateFrame: Timer for sequential frame updates.
+ * Jobs that belong at a time of day rather than a time since boot are calendar
+ * events (see calendarScheduler.h in lib/wxcore), run by the one task taskCalendar
+ * that sleeps until the next of them. Weather fetches land on whole multiples of
+ * their interval from local midnight, the forecast WX_FORECAST_OFFSET seconds into
+ * its minute, and bulletins at 0800 and 2000 local time.
+ *
+ * External tasks:
+ * - taskSecondTick: Clock updates just after each second edge, only while a clock frame shows.
+ * - taskUpdateFrame: Sequential frame updates.
+ * - taskIndoorSensor: Indoor sensor trigger and read, every INDOOR_SAMPLE_MS.
+ * - taskLogFlush: Observation log write of the records queued (obsLog.h).
+ *
+ * External calendar events:
+ * - calWXcurrent: Current weather updates.
+ * - calWXforecast: Forecasted weather updates.
+ *
+ * APRS, ThingSpeak and MQTT are not timed: they subscribe to weather update
+ * events (wxEvents.h) with their own rate limits, so each post carries one new sample.
+ * Their requests, and the current weather fetch, are protothreads (coroutine.h) so
+ * the display keeps running while a server answers.
  *
  * Functions:
+ * - initTaskClocks(): Install the clocks of the scheduler, protothreads, calendar, DNS cache and retry policy.
+ * - finishCoroutine(co): Run a network coroutine to the end, for setup() and the gateway.
  * - startTasks(): Start the scheduled tasks.
- * - updateTasks(): Update the scheduled tasks.
+ * - updateTasks(): Run due tasks and idle until the next one, call from loop().
+ * - catchUpWeather(): Fetch stale weather data after Wi-Fi comes back.
+ * - nextNetworkTask(): Milliseconds until the next task that uses the network runs.
+ * - printTaskStats(): Print CPU idle percentage, the task schedule and the calendar to Serial.
  */
 #ifndef TASK_CONTROL_H
 #define TASK_CONTROL_H
 
-#include <Arduino.h> // for String
-#include <TickTwo.h> // v4.4.0 Stefan Staub
+#include <Arduino.h>		   // for String
+#include <calendarScheduler.h> // wall-clock events from lib/wxcore
+#include <coroutine.h>	   // protothreads from lib/wxcore
+#include <taskScheduler.h> // deadline scheduler from lib/wxcore
+
+#define TASK_MAX_IDLE 1000UL ///< longest single delay() in updateTasks()
+#define CALENDAR_MAX_WAIT 3600 ///< seconds between calendar checks with nothing due
+#define WX_FORECAST_OFFSET 30 ///< seconds past its minute the forecast fetch runs, clear of the current fetch
 
-extern TickTwo tmrSecondTick;		  ///< timer for second tick clock updates
-extern TickTwo tmrGetWXcurrent;		  ///< timer for current weather updates
-extern TickTwo tmrGetWXforecast;	  ///< timer for forecasted weather updates
-extern TickTwo tmrPostWXtoAPRS;		  ///< timer for posting weather data to APRS
-extern TickTwo tmrPostWXtoThingspeak; ///< timer for posting weather data to ThingSpeak
-extern TickTwo tmrUpdateFrame;		  ///< timer for sequential frames
+extern scheduledTask taskSecondTick;	///< second tick clock updates
+extern scheduledTask taskUpdateFrame;	///< sequential frames
+extern scheduledTask taskIndoorSensor;	///< indoor sensor sampling
+extern scheduledTask taskLogFlush;		///< observation log writes
+extern calendarEvent calWXcurrent;		///< current weather updates
+extern calendarEvent calWXforecast;		///< forecasted weather updates
 
-void startTasks();	///< start the scheduled tasks
-void updateTasks(); ///< update the scheduled tasks
+void initTaskClocks();			 ///< install the millisecond clocks, first in setup()
+void finishCoroutine(coroutine &co); ///< run a coroutine to the end
+void startTasks();				 ///< start the scheduled tasks
+void updateTasks();				 ///< run due tasks and idle until the next one
+void catchUpWeather();			 ///< fetch stale weather data after a Wi-Fi outage
+unsigned long nextNetworkTask(); ///< milliseconds until the next network task
+void printTaskStats();			 ///< print idle percentage and schedule
 
 #endif // TASK_CONTROL_H
-	   // End of file
\ No newline at end of file
+	   // End of file
@@ -0,0 +1,37 @@
+/**
+ * @file taskProfile.h
+ * @author Karl Berger
+ * @date 2025-06-28
+ * @brief Execution time and lateness of the scheduled tasks, and loop stalls.
+ *
+ * profileTask() is installed as the scheduler's task runner, so every scheduled
+ * callback is timed with the CPU cycle counter. Each task keeps min, mean and max
+ * run time, a power-of-two microsecond histogram, and how late it started against
+ * its deadline. updateTasks() reports each pass of loop() with profileLoopPass(),
+ * which keeps the longest stretch the loop ran without yielding and the longest
+ * gap spent outside it in the SDK.
+ *
+ * Functions:
+ * - profileTask(task, lateMs): Run and time one task, for setTaskRunner().
+ * - profileLoopPass(busyUs, outsideUs): Record one pass of loop().
+ * - printTaskProfile(): Print all timing to Serial.
+ * - resetTaskProfile(): Clear all timing.
+ */
+#ifndef TASK_PROFILE_H
+#define TASK_PROFILE_H
+
+#include <Arduino.h>	   // for fixed width types
+#include <taskScheduler.h> // scheduledTask
+
+#define PROFILE_TASKS 24	   ///< tasks tracked
+#define PROFILE_BUCKETS 24	   ///< histogram buckets: <1, <2, <4 ... >=4194304 us
+#define PROFILE_LATE_MS 10	   ///< a start later than this counts as late
+#define PROFILE_STALL_US 50000 ///< a loop pass longer than this counts as a stall
+
+void profileTask(scheduledTask &task, uint32_t lateMs);	 ///< run and time one task
+void profileLoopPass(uint32_t busyUs, uint32_t outsideUs); ///< record one pass of loop()
+void printTaskProfile();									 ///< print all timing
+void resetTaskProfile();									 ///< clear all timing
+
+#endif // TASK_PROFILE_H
+// End of file
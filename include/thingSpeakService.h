@@ -11,7 +11,10 @@
  *   - unitStatus: A String representing the current status of the ThingSpeak service.
  *
  * Functions:
- *   - postToThingSpeak(): Posts data to the ThingSpeak service.
+ *   - postWXtoThingspeak(): Buffers the current weather and uploads full batches.
+ *   - uploadThingspeakBatch(): Starts uploading all buffered rows with one bulk update.
+ *   - finishThingspeakUpload(): Uploads and waits for the result, for the deep-sleep gateway.
+ *   - retryThingspeakUpload(): Retries a failed upload once its backoff has passed.
  */
 #ifndef THINGSPEAK_SERVICE_H
 #define THINGSPEAK_SERVICE_H
@@ -20,7 +23,10 @@
 
 extern String unitStatus; // ThingSpeak status
 
-void postWXtoThingspeak();
+void postWXtoThingspeak();     ///< buffer current weather, upload when a batch is full
+void uploadThingspeakBatch();  ///< start uploading buffered rows
+bool finishThingspeakUpload(); ///< upload and wait, true if nothing is left buffered
+void retryThingspeakUpload();  ///< retry a failed upload when due
 
 #endif // THINGSPEAK_SERVICE_H
 // End of file
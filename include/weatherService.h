@@ -19,8 +19,13 @@
  * - wx: Externally declared instance of the `weather` struct for use across translation units.
  *
  * Functions:
- * - getWXforecast(): Retrieve and update forecasted weather data.
- * - getWXcurrent(): Retrieve and update current weather conditions.
+ * - getWXforecast(): Retrieve and update forecasted weather data; waits for a current fetch
+ *      to release the api.weather.com socket and keeps the last forecast on failure.
+ * - getWXcurrent(): Start retrieving current weather conditions; runs as a coroutine.
+ * - finishWXcurrent(): Retrieve current weather conditions and wait for them.
+ * - getWXhistory(): Backfill the observation history from the last 24 hours.
+ * - currentObservation(): The observation part of wx as a portable wxObservation.
+ * - nextSunset(after): The first sunset later than a UTC time, for the calendar.
  * - fetchDataAndParse(getQuery, filter, doc): Perform HTTP GET request to Weather Underground API,
  *      filter and parse the resulting JSON into the provided document.
  * - updateWXcurrent(): Update current weather conditions and post data to ThingSpeak.
@@ -30,6 +35,7 @@
 
 #include <Arduino.h>     // for struct
 #include <ArduinoJson.h> // for fetchData prototype v7.2 Benoit Blanchon https://arduinojson.org/
+#include <wxModel.h>     // portable observation from lib/wxcore
 
 struct weather
 {
@@ -40,6 +46,7 @@ struct weather
   int forCloud;             ///< forecasted average cloud coverage (%)
   unsigned long forSunRise; ///< sunrise (unix time UTC) from forecast
   unsigned long forSunSet;  ///< sunset (unix time UTC) from forecast
+  unsigned long obsEpoch;   ///< observation time (unix time UTC)
   float obsLat;             ///< station latitude in decimal degrees
   float obsLon;             ///< station longitude in decimal degrees
   String obsNeighborhood;   ///< station neighborhood assigned by Weather Underground
@@ -61,7 +68,11 @@ struct weather
 extern weather wx; // Declaration for use in other files
 
 void getWXforecast();   ///< get forecasted weather
-void getWXcurrent();    ///< get current conditions
+void getWXcurrent();    ///< start getting current conditions
+void finishWXcurrent(); ///< get current conditions and wait for them
+void getWXhistory();    ///< backfill observation history
+wxObservation currentObservation(); ///< copy of the observation in wx for the portable formatters
+uint32_t nextSunset(uint32_t after); ///< UTC of the next sunset, 0 before the first forecast
 
 #endif // WEATHER_SERVICE_H
 // End of file
@@ -1,19 +1,40 @@
 /**
  * @file wifiConnection.h
  * @author Karl W. Berger
- * @date 2025-05-28
+ * @date 2025-06-23
  * @brief Declares the interface for connecting the device to a Wi-Fi router.
  *
- * This header provides the declaration for the function responsible for establishing
- * a connection to a predefined Wi-Fi network. Ensure that the Wi-Fi credentials are
- * properly configured before invoking the connection function.
+ * logonToRouter() starts the connection at boot and waits a limited time for it.
+ * setup() splits it in two, beginWiFi() and waitForWiFi(), and does local work such
+ * as drawing the splash screen while the radio associates.
+ * After that checkWiFiConnection(), called from loop(), supervises the link without
+ * blocking: a lost link is retried with exponential backoff while the display and
+ * local tasks keep running. Functions registered with onWiFiRestored() run each
+ * time an IP address is obtained, so network services can resume at once.
+ *
+ * wifiSleep() and wifiWake() switch the radio off and on again for the radio power
+ * manager; a planned sleep is not treated as an outage.
+ *
+ * The access point and DHCP lease of the last connection are cached so the next
+ * connection can skip the scan, and DHCP while the lease is less than half its length old. The time to get an IP address is logged
+ * for every connection.
  */
 #ifndef WIFI_CONNECTION_H
 #define WIFI_CONNECTION_H
 
-void logonToRouter();		// function to connect to Wi-Fi
-void checkWiFiConnection(); // function to check Wi-Fi connection status
+typedef void (*wifiCallback)(); // connectivity restored
+
+void logonToRouter();					   // start Wi-Fi and wait for it at boot
+void beginWiFi();						   // start Wi-Fi without waiting
+void waitForWiFi();						   // wait a limited time after beginWiFi() for an IP address
+void checkWiFiConnection();				   // supervise the link, call from loop()
+bool wifiOnline();						   // true while an IP address is held
+void wifiSleep();						   // radio off until wifiWake()
+void wifiWake();						   // radio on and reconnect
+bool wifiAsleep();						   // true while the radio is off on purpose
+bool onWiFiRestored(wifiCallback callback); // run callback each time the link comes up
+void printWiFiStats();					   // print link quality and connection timing to Serial
 
 #endif // WIFI_CONNECTION_H
 
-// End of file
\ No newline at end of file
+// End of file
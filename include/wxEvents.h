@@ -0,0 +1,50 @@
+/**
+ * @file wxEvents.h
+ * @author Karl Berger
+ * @date 2025-06-27
+ * @brief Weather update events for the uplinks and the display.
+ *
+ * Every source of a new observation (the WU poll, a local station upload or a
+ * snapshot from the share leader) calls publishWXupdate() once the `wx` model
+ * holds the new sample. That raises the update version and schedules delivery.
+ * Each subscriber is called at most once per version, and no more often than its
+ * own minimum interval; an update that arrives inside the interval is held and
+ * the newest one is delivered when the interval ends. Posts therefore always
+ * carry a sample that has not been sent before, and never a stale one.
+ *
+ * Functions:
+ * - subscribeWX(subscription): Register a subscriber.
+ * - publishWXupdate(): Announce a new observation in `wx`.
+ * - wxUpdateVersion(): Version of the newest observation, 0 before the first.
+ * - wxDeliveryDueIn(): Milliseconds until a held update is delivered, ULONG_MAX if none.
+ * - printWXevents(): Print subscriber counters to Serial.
+ */
+#ifndef WX_EVENTS_H
+#define WX_EVENTS_H
+
+#include <Arduino.h> // for fixed width types
+
+#define WX_MAX_SUBSCRIBERS 6 ///< subscriptions accepted
+
+struct wxSubscription
+{
+	const char *name;		   ///< subscriber name for reports
+	void (*deliver)();		   ///< called with `wx` holding the update
+	unsigned long minInterval; ///< milliseconds between deliveries, 0 for every update
+	uint32_t version;		   ///< last version delivered
+	unsigned long deliveredAt; ///< millis() of the last delivery
+	uint32_t delivered;		   ///< updates delivered
+	uint32_t coalesced;		   ///< updates replaced by a newer one before delivery
+};
+
+//! subscription definition: name, function, minimum interval in ms
+#define WX_SUBSCRIPTION(name, deliver, minInterval) {name, deliver, minInterval, 0, 0, 0, 0}
+
+bool subscribeWX(wxSubscription &subscription); ///< register a subscriber, false if full
+void publishWXupdate();						   ///< announce a new observation
+uint32_t wxUpdateVersion();					   ///< version of the newest observation
+unsigned long wxDeliveryDueIn();			   ///< milliseconds until a held update is delivered
+void printWXevents();						   ///< print subscriber counters
+
+#endif // WX_EVENTS_H
+// End of file
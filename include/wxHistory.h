@@ -0,0 +1,70 @@
+/**
+ * @file wxHistory.h
+ * @author Karl Berger
+ * @date 2025-06-12
+ * @brief Compact in-RAM history of weather observations.
+ *
+ * This header defines the `wxSample` record and the functions that maintain a
+ * fixed-size history of observations. The history is filled at boot by
+ * getWXhistory() from the WU 1-day endpoint and extended by every successful
+ * getWXcurrent() so rolling values are available immediately after a restart.
+ *
+ * Samples are kept bit-packed (packedHistory.h in lib/wxcore): each is stored
+ * as the change from the one before, about 40 bits a sample, so the
+ * HISTORY_BYTES store holds more than 7 days at the 7 minute fetch interval.
+ * When it is full the oldest samples are dropped. Samples are read in time
+ * order from the start of a window, not by index. Every sample is also kept in
+ * an observation log on LittleFS (obsLog.h) so the history survives a restart.
+ *
+ * Functions:
+ * - historyAppend(sample): Add a sample, ignoring duplicates and out-of-order times.
+ * - historyRecordWX(): Add the current `wx` observation and indoor temperature to the history.
+ * - historyRestore(): Rebuild the history from the observation log at boot.
+ * - historyCount(): Number of samples held.
+ * - historyNewest(sample): Read the newest sample.
+ * - historyWindow(cursor, from): Start reading at the first sample at or after a time.
+ * - historyNext(cursor, sample): Read the next sample, false past the newest.
+ * - historyRain24h(): Rainfall over the last 24 hours (mm), NAN until the history spans them.
+ * - historyPressureTendency(): Pressure change over the last 3 hours (hPa).
+ * - historyTempHiLo(hi, lo): Temperature extremes over the last 24 hours (°C).
+ * - printHistoryStats(): Print span, size, bits per sample and scan times to Serial.
+ */
+#ifndef WX_HISTORY_H
+#define WX_HISTORY_H
+
+#include <Arduino.h>		// for fixed width types
+#include <packedHistory.h> // bit-packed store from lib/wxcore
+
+#define HISTORY_BYTES (PACKED_BLOCKS * PACKED_BLOCK_BYTES) ///< coded bytes held
+#define INDOOR_NONE INT16_MIN ///< indoorTemp when there is no indoor reading
+
+struct wxSample
+{
+	uint32_t epoch;		  ///< observation time (unix time UTC)
+	int16_t tempHigh;	  ///< interval high temperature (0.1 °C)
+	int16_t tempLow;	  ///< interval low temperature (0.1 °C)
+	uint16_t pressure;	  ///< sea level pressure (0.1 hPa)
+	uint16_t windSpeed;	  ///< wind speed (0.1 km/h, stored to 1 km/h)
+	uint16_t windGust;	  ///< wind gust (0.1 km/h, stored to 1 km/h)
+	uint16_t precipTotal; ///< precipitation since local midnight (0.1 mm)
+	uint16_t solar;		  ///< solar radiation (W/m²)
+	int16_t indoorTemp;	  ///< indoor temperature (0.1 °C), INDOOR_NONE if unknown
+	uint8_t humidity;	  ///< relative humidity (%)
+};
+
+typedef packedCursor historyCursor; ///< read position in the history
+
+void historyAppend(const wxSample &sample); ///< add a sample to the history
+void historyRecordWX();						///< add the current wx observation to the history
+bool historyRestore();						///< replay the observation log, false without a file system
+int historyCount();							///< number of samples in the history
+bool historyNewest(wxSample &sample);		///< read the newest sample, false if none
+void historyWindow(historyCursor &cursor, uint32_t from); ///< read from the first sample at or after from
+bool historyNext(historyCursor &cursor, wxSample &sample); ///< read the next sample, false past the newest
+float historyRain24h();						///< rainfall over the last 24 hours (mm), NAN if the history is shorter
+float historyPressureTendency();			///< pressure change over the last 3 hours (hPa), NAN if unknown
+bool historyTempHiLo(float &hi, float &lo); ///< temperature extremes over the last 24 hours (°C)
+void printHistoryStats();					///< print history size and scan times
+
+#endif // WX_HISTORY_H
+// End of file
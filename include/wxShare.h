@@ -0,0 +1,48 @@
+/**
+ * @file wxShare.h
+ * @author Karl Berger
+ * @date 2025-06-20
+ * @brief Share weather data between displays on the same LAN.
+ *
+ * With SHARE_MODE set to leader, this display fetches weather as usual and
+ * multicasts a compact binary snapshot of `wx` (observation and forecast) when
+ * the observation changes and at least every SHARE_HEARTBEAT. With SHARE_MODE
+ * set to follower, the display copies each snapshot into `wx` and the weather
+ * fetches are skipped while snapshots keep arriving. After SHARE_SILENT without
+ * one, the follower fetches for itself again until the leader returns.
+ *
+ * A follower asks for a snapshot at boot so it need not wait for a heartbeat.
+ *
+ * The snapshot layout and its checks are portable, in wxSnapshot.h in lib/wxcore.
+ * A follower redraws and posts only a new observation, and takes a new forecast
+ * quietly; a heartbeat with neither only shows the leader is alive.
+ *
+ * Functions:
+ * - beginShare(): Join the multicast group, call after Wi-Fi connects.
+ * - restartShare(): Join the group again after Wi-Fi comes back.
+ * - shareLoop(): Send or receive snapshots, call from loop().
+ * - shareFeedsWX(): True if a follower is receiving current snapshots.
+ * - printShareStats(): Print snapshot counters to Serial.
+ */
+#ifndef WX_SHARE_H
+#define WX_SHARE_H
+
+#include <Arduino.h> // for fixed width types
+
+#define SHARE_OFF 0		 ///< SHARE_MODE: standalone
+#define SHARE_LEADER 1	 ///< SHARE_MODE: fetch and send snapshots
+#define SHARE_FOLLOWER 2 ///< SHARE_MODE: receive snapshots, fetch only as fallback
+
+#define SHARE_PORT 4299				   ///< UDP port
+#define SHARE_HEARTBEAT 60000UL		   ///< longest time between snapshots (ms)
+#define SHARE_SILENT 200000UL		   ///< follower fetches for itself after this (ms)
+#define SHARE_BOOT_WAIT 1500UL		   ///< follower waits this long for the first snapshot (ms)
+
+void beginShare();		///< join the multicast group
+void restartShare();	///< join the group again
+void shareLoop();		///< send or receive snapshots
+bool shareFeedsWX();	///< true if snapshots replace the weather fetches
+void printShareStats(); ///< print snapshot counters
+
+#endif // WX_SHARE_H
+// End of file
@@ -0,0 +1,94 @@
+/**
+ * @file aprsFormat.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable APRS packet formatting.
+ * @details Moved from the firmware's aprsService.cpp so the gateway formats
+ *          packets byte for byte the same way.
+ */
+
+#include "aprsFormat.h"
+
+#include <math.h>  // round()
+#include <stdio.h> // snprintf()
+#include "wxUnits.h"
+
+size_t aprsPad(char *out, size_t size, float value, int width)
+{
+	// pads APRS rounded data element with leading 0s to the specified width
+	int written = snprintf(out, size, "%0*d", width, (int)round(value));
+	return written < 0 ? 0 : written;
+} // aprsPad()
+
+size_t aprsLocation(char *out, size_t size, float lat, float lon)
+{
+	// convert decimal latitude & longitude to DDmm.mmN/DDDmm.mmW
+	lat = fminf(fmaxf(lat, -90), 90);
+	lon = fminf(fmaxf(lon, -180), 180);
+
+	char latID = (lat < 0) ? 'S' : 'N';
+	char lonID = (lon < 0) ? 'W' : 'E';
+	lat = fabsf(lat);
+	lon = fabsf(lon);
+	unsigned latDeg = (int)lat;			// the characteristic of lat (degrees)
+	float latMin = 60 * (lat - latDeg); // the mantissa of lat (minutes)
+	unsigned lonDeg = (int)lon;
+	float lonMin = 60 * (lon - lonDeg);
+
+	int written = snprintf(out, size, "%02u%05.2f%c/%03u%05.2f%c", latDeg, latMin, latID, lonDeg, lonMin, lonID);
+	return written < 0 ? 0 : written;
+} // aprsLocation()
+
+// append "<tag><padded value>" at out + length
+static size_t appendField(char *out, size_t size, size_t length, char tag, float value, int width)
+{
+	if (length + 1 < size)
+	{
+		out[length++] = tag;
+		length += aprsPad(out + length, size - length, value, width);
+	}
+	return length < size ? length : size - 1;
+} // appendField()
+
+size_t aprsFormatWeather(char *out, size_t size, const char *callsign, const wxObservation &obs, float rain24h,
+						 const char *comment)
+{
+	/* page 65 http://www.aprs.org/doc/APRS101.PDF
+	   Using Complete Weather Report Format — with Lat/Long position, no Timestamp pg 75
+	   ________________________________________________________________
+	   |!|Lat|/|Lon|_|Wind Dir|/|Wind Speed|Weather Data|Software|Unit|
+	   |1| 8 |1| 9 |1|    3   |1|    3     |      n     |    1   |2-4 |
+	   |_|___|_|___|_|________|_|__________|____________|________|____|
+	*/
+	if (size == 0)
+	{
+		return 0;
+	}
+	int humid = (obs.humidity == 100) ? 0 : obs.humidity; // pg 74
+
+	int written = snprintf(out, size, "%s>APRS,TCPIP*:!", callsign);
+	size_t length = (written < 0) ? 0 : ((size_t)written < size ? written : size - 1);
+	if (length + 1 < size)
+	{
+		length += aprsLocation(out + length, size - length, obs.lat, obs.lon); // position in DDmm.mmN/DDDmm.mmW
+		length = length < size ? length : size - 1;
+	}
+	length = appendField(out, size, length, '_', obs.windDir, 3);					  // degrees clockwise from north
+	length = appendField(out, size, length, '/', KMtoMILES(obs.windSpeed), 3);		  // speed in mph
+	length = appendField(out, size, length, 'g', KMtoMILES(obs.windGust), 3);		  // speed in mph
+	length = appendField(out, size, length, 't', CtoF(obs.temp), 3);				  // temperature in Fahrenheit
+	length = appendField(out, size, length, 'L', obs.solarRadiation, 3);			  // luminosity < 999
+	length = appendField(out, size, length, 'r', 100 * MMtoIN(obs.precipRate), 3);	  // rainfall rate in 100th of inches per hour
+	if (!isnan(rain24h))
+	{
+		length = appendField(out, size, length, 'p', 100 * MMtoIN(rain24h), 3);		  // rainfall in the last 24 hours in 100th of inches
+	}
+	length = appendField(out, size, length, 'P', 100 * MMtoIN(obs.precipTotal), 3);  // rainfall since midnight in 100th of inches
+	length = appendField(out, size, length, 'h', humid, 2);						  // relative humidity in % 00 = 100%
+	length = appendField(out, size, length, 'b', 10 * obs.pressure, 5);			  // sea level pressure in 10ths of millibars
+	written = snprintf(out + length, size - length, "%s", comment ? comment : "");
+	length += (written < 0) ? 0 : written;
+	return length < size ? length : size - 1;
+} // aprsFormatWeather()
+
+// End of file
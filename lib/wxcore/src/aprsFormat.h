@@ -0,0 +1,36 @@
+/**
+ * @file aprsFormat.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable APRS packet formatting.
+ *
+ * Writes into caller supplied buffers and returns the length written, like
+ * snprintf(). Output is truncated, never overrun, when the buffer is short.
+ *
+ * Functions:
+ * - aprsPad(out, size, value, width): Rounded value with leading zeros.
+ * - aprsLocation(out, size, lat, lon): Position as DDmm.mmN/DDDmm.mmW.
+ * - aprsFormatWeather(out, size, callsign, obs, rain24h, comment): Complete weather report.
+ */
+#ifndef APRS_FORMAT_H
+#define APRS_FORMAT_H
+
+#include <stddef.h>	 // size_t
+#include "wxModel.h" // wxObservation
+
+#define APRS_PACKET_MAX 160 ///< buffer size that holds any weather report
+
+size_t aprsPad(char *out, size_t size, float value, int width);	  ///< rounded value padded with zeros
+size_t aprsLocation(char *out, size_t size, float lat, float lon); ///< DDmm.mmN/DDDmm.mmW
+
+/**
+ * @brief Complete weather report with position and no timestamp, APRS101.pdf page 75.
+ * @param callsign source call-SSID
+ * @param rain24h rain in the last 24 hours (mm), NAN to leave the "p" field out
+ * @param comment text after the weather data, may be empty
+ */
+size_t aprsFormatWeather(char *out, size_t size, const char *callsign, const wxObservation &obs, float rain24h,
+						 const char *comment);
+
+#endif // APRS_FORMAT_H
+// End of file
@@ -0,0 +1,185 @@
+/**
+ * @file calendarScheduler.cpp
+ * @author Karl Berger
+ * @date 2025-06-30
+ * @brief Portable wall-clock scheduler for cron-like events.
+ * @details Local times are converted to UTC with the offset in force at that
+ *          moment, found in two steps: a first guess from the offset at the local
+ *          time read as UTC, then the offset at the guess. CAL_EVERY steps use the
+ *          offset at the present instead, so they stay evenly spaced through a DST
+ *          change and pick up the new local alignment at the next midnight.
+ */
+
+#include "calendarScheduler.h"
+
+static uint32_t zeroClock()
+{
+	return 0; // unset until setCalendarClock()
+}
+
+static int32_t noOffset(uint32_t)
+{
+	return 0;
+}
+
+static calendarClock clockNow = zeroClock;
+static calendarOffset offsetAt = noOffset;
+static calendarEvent *events[CAL_MAX_EVENTS];
+static int eventCount = 0;
+
+#define CAL_MAX_AHEAD (2 * 86400UL) // a later next occurrence means the clock stepped back
+
+void setCalendarClock(calendarClock utcNow, calendarOffset utcOffset)
+{
+	clockNow = utcNow;
+	offsetAt = utcOffset;
+	for (int i = 0; i < eventCount; i++)
+	{
+		events[i]->next = 0; // recalculate with the new clock
+	}
+} // setCalendarClock()
+
+bool calendarAdd(calendarEvent &event)
+{
+	for (int i = 0; i < eventCount; i++)
+	{
+		if (events[i] == &event)
+		{
+			return true;
+		}
+	}
+	if (eventCount == CAL_MAX_EVENTS)
+	{
+		return false;
+	}
+	event.next = 0;
+	events[eventCount++] = &event;
+	return true;
+} // calendarAdd()
+
+void calendarRemove(calendarEvent &event)
+{
+	for (int i = 0; i < eventCount; i++)
+	{
+		if (events[i] == &event)
+		{
+			events[i] = events[--eventCount]; // order does not matter
+			return;
+		}
+	}
+} // calendarRemove()
+
+// UTC of a local time, with the offset in force at that moment
+static int64_t toUtc(int64_t local)
+{
+	int64_t guess = local - offsetAt((uint32_t)local);
+	return local - offsetAt((uint32_t)guess);
+} // toUtc()
+
+uint32_t calendarNext(const calendarEvent &event, uint32_t after)
+{
+	int32_t offset = offsetAt(after);
+	int64_t local = (int64_t)after + offset;
+	int64_t midnight = local - local % 86400;
+	int64_t second = local - midnight;
+
+	switch (event.kind)
+	{
+	case CAL_EVERY:
+	{
+		if (event.period == 0)
+		{
+			return CAL_NEVER;
+		}
+		int64_t step = (second < event.at) ? event.at : event.at + ((second - event.at) / event.period + 1) * event.period;
+		if (step >= 86400)
+		{
+			step = 86400 + event.at; // steps start over at midnight
+		}
+		return (uint32_t)(midnight + step - offset);
+	}
+	case CAL_DAILY:
+		for (int day = 0; day < 3; day++)
+		{
+			int64_t utc = toUtc(midnight + day * 86400 + event.at);
+			if (utc > after)
+			{
+				return (uint32_t)utc;
+			}
+		}
+		return CAL_NEVER;
+	case CAL_CUSTOM:
+	{
+		uint32_t utc = event.nextAfter ? event.nextAfter(after) : 0;
+		return (utc > after) ? utc : CAL_NEVER;
+	}
+	}
+	return CAL_NEVER;
+} // calendarNext()
+
+// seconds from now until an event, CAL_RETRY while its time is unknown
+static uint32_t waitFor(const calendarEvent &event, uint32_t now)
+{
+	return (event.next == 0 || event.next == CAL_NEVER) ? CAL_RETRY : event.next - now;
+}
+
+uint32_t calendarRun()
+{
+	uint32_t now = clockNow();
+	if (now < CAL_VALID_AFTER)
+	{
+		return CAL_RETRY; // no wall clock yet
+	}
+	uint32_t wait = CAL_NEVER;
+	for (int i = 0; i < eventCount; i++)
+	{
+		calendarEvent &event = *events[i];
+		if (event.next == 0 || event.next == CAL_NEVER)
+		{
+			event.next = calendarNext(event, now); // first run, or not known before
+		}
+		else if (event.next <= now)
+		{
+			if (now - event.next <= event.grace)
+			{
+				event.runs++;
+				if (event.run)
+				{
+					event.run();
+				}
+			}
+			else
+			{
+				event.missed++; // asleep or the clock stepped forward
+			}
+			event.next = calendarNext(event, now); // occurrences in between are not repeated
+		}
+		else if (event.next - now > CAL_MAX_AHEAD)
+		{
+			event.next = calendarNext(event, now); // the clock stepped back
+		}
+		uint32_t eventWait = waitFor(event, now);
+		wait = (eventWait < wait) ? eventWait : wait;
+	}
+	return wait;
+} // calendarRun()
+
+uint32_t calendarDueIn()
+{
+	uint32_t now = clockNow();
+	uint32_t wait = CAL_NEVER;
+	for (int i = 0; i < eventCount; i++)
+	{
+		const calendarEvent &event = *events[i];
+		uint32_t eventWait = (event.next != 0 && event.next != CAL_NEVER && event.next <= now) ? 0 : waitFor(event, now);
+		wait = (eventWait < wait) ? eventWait : wait;
+	}
+	return wait;
+} // calendarDueIn()
+
+calendarEvent *calendarEventAt(int index)
+{
+	return (index >= 0 && index < eventCount) ? events[index] : nullptr;
+}
+
+// End of file
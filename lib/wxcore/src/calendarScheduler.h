@@ -0,0 +1,94 @@
+/**
+ * @file calendarScheduler.h
+ * @author Karl Berger
+ * @date 2025-06-30
+ * @brief Portable wall-clock scheduler for cron-like events.
+ *
+ * The deadline scheduler (taskScheduler.h) counts milliseconds from boot, so its
+ * tasks run at whatever minute the unit happened to start. A calendar event
+ * instead names the wall-clock times it wants:
+ * - CALENDAR_EVERY: every N minutes from local midnight, plus an offset, like
+ *   cron's minute step; "every 10 min at :00" is CALENDAR_EVERY(name, fn, 10, 0, grace).
+ *   CALENDAR_EVERY_SECONDS gives the offset in seconds instead.
+ * - CALENDAR_DAILY: once a day at a local hour and minute.
+ * - CALENDAR_CUSTOM: a function that gives the next occurrence, such as sunset.
+ *
+ * The next occurrence is calculated, not polled: calendarRun() runs the events
+ * that are due and returns the seconds until the next one, so the caller can
+ * sleep for that long. Local time comes from a UTC offset function that knows
+ * the daylight saving rules, so events keep their local time across a DST
+ * change. A daily time that DST skips or repeats runs once, up to an hour off.
+ *
+ * An event found late by more than its grace, after a sleep or a clock step,
+ * is counted as missed instead of run, then the next occurrence is calculated
+ * from the present. Within the grace a late event runs once, however many of
+ * its occurrences went by.
+ *
+ * The clock is supplied by the caller (UTC seconds and offset); nothing runs
+ * until it reads later than CAL_VALID_AFTER, so an unset clock fires nothing.
+ *
+ * Functions:
+ * - setCalendarClock(utcNow, utcOffset): Set the UTC clock and the local offset function.
+ * - calendarAdd(event): Put an event on the calendar.
+ * - calendarRemove(event): Take an event off the calendar.
+ * - calendarNext(event, after): The first occurrence of an event later than a UTC time.
+ * - calendarRun(): Run due events, return seconds until the next one.
+ * - calendarDueIn(): Seconds until the next event, CAL_NEVER if none.
+ * - calendarEventAt(index): The events on the calendar, for reports.
+ */
+#ifndef CALENDAR_SCHEDULER_H
+#define CALENDAR_SCHEDULER_H
+
+#include <stdint.h> // fixed width types
+
+#define CAL_MAX_EVENTS 8			///< events on the calendar at once
+#define CAL_NEVER 0xFFFFFFFFUL		///< no occurrence
+#define CAL_VALID_AFTER 1577836800UL ///< 2020-01-01, earlier clocks are unset
+#define CAL_RETRY 60				///< seconds between checks while the clock is unset
+
+enum calendarKind
+{
+	CAL_EVERY,	///< every period seconds from local midnight, plus at
+	CAL_DAILY,	///< once a day at local second-of-day at
+	CAL_CUSTOM ///< nextAfter() gives the occurrence
+};
+
+typedef uint32_t (*calendarClock)(); ///< UTC seconds
+typedef int32_t (*calendarOffset)(uint32_t utc); ///< local minus UTC seconds at a UTC time
+
+struct calendarEvent
+{
+	const char *name;					///< event name for reports
+	void (*run)();						///< called when due
+	calendarKind kind;					///< rule type
+	uint32_t period;					///< CAL_EVERY: seconds between occurrences
+	uint32_t at;						///< seconds after midnight (DAILY) or after each step (EVERY)
+	uint32_t (*nextAfter)(uint32_t utc); ///< CAL_CUSTOM: next occurrence after utc, 0 if unknown
+	uint32_t grace;						///< seconds late an occurrence may still run
+	uint32_t next;						///< UTC of the next occurrence, 0 until calculated
+	uint32_t runs;						///< times run
+	uint32_t missed;					///< occurrences skipped for lateness
+};
+
+//! every minutes from local midnight, atMinute past each step
+#define CALENDAR_EVERY(name, run, minutes, atMinute, grace) \
+	{name, run, CAL_EVERY, (uint32_t)(minutes) * 60, (uint32_t)(atMinute) * 60, nullptr, grace, 0, 0, 0}
+//! every minutes from local midnight, atSecond past each step, to keep apart from a minute grid
+#define CALENDAR_EVERY_SECONDS(name, run, minutes, atSecond, grace) \
+	{name, run, CAL_EVERY, (uint32_t)(minutes) * 60, (uint32_t)(atSecond), nullptr, grace, 0, 0, 0}
+//! daily at a local hour and minute
+#define CALENDAR_DAILY(name, run, hour, minute, grace) \
+	{name, run, CAL_DAILY, 86400, (uint32_t)(hour) * 3600 + (uint32_t)(minute) * 60, nullptr, grace, 0, 0, 0}
+//! when nextAfter() says
+#define CALENDAR_CUSTOM(name, run, nextAfter, grace) {name, run, CAL_CUSTOM, 0, 0, nextAfter, grace, 0, 0, 0}
+
+void setCalendarClock(calendarClock utcNow, calendarOffset utcOffset); ///< set the clock
+bool calendarAdd(calendarEvent &event);								   ///< false if the calendar is full
+void calendarRemove(calendarEvent &event);							   ///< take an event off the calendar
+uint32_t calendarNext(const calendarEvent &event, uint32_t after);	   ///< UTC occurrence, CAL_NEVER if none
+uint32_t calendarRun();												   ///< run due events, seconds until the next
+uint32_t calendarDueIn();											   ///< seconds until the next event
+calendarEvent *calendarEventAt(int index);							   ///< nullptr past the last event
+
+#endif // CALENDAR_SCHEDULER_H
+// End of file
@@ -0,0 +1,193 @@
+/**
+ * @file circuitBreaker.cpp
+ * @author Karl Berger
+ * @date 2025-06-17
+ * @brief Portable retry, backoff and circuit breaker policy for network endpoints.
+ * @details Backoff uses "equal jitter": half of the exponential delay is fixed and
+ *          the other half random, so several units restarting together spread out
+ *          without ever retrying immediately. Clock comparisons are written as
+ *          signed differences so they survive millis() roll-over.
+ */
+
+#include "circuitBreaker.h"
+
+static uint32_t stoppedClock()
+{
+	return 0;
+}
+
+// a fixed sequence until setPolicyRandom(), enough to spread retries
+static uint32_t simpleRandom(uint32_t bound)
+{
+	static uint32_t state = 2463534242UL;
+	state ^= state << 13; // xorshift32
+	state ^= state >> 17;
+	state ^= state << 5;
+	return bound ? state % bound : 0;
+}
+
+static policyClock clockNow = stoppedClock;	   // replaced by setPolicyClock()
+static policyRandom randomBelow = simpleRandom; // replaced by setPolicyRandom()
+static policyLog report = nullptr;				   // set by setPolicyLog()
+static endpointHealth *endpoints[POLICY_MAX_ENDPOINTS];
+
+// remember an endpoint the first time it is seen
+static void registerEndpoint(endpointHealth &health)
+{
+	for (int i = 0; i < POLICY_MAX_ENDPOINTS; i++)
+	{
+		if (endpoints[i] == &health)
+		{
+			return;
+		}
+		if (endpoints[i] == nullptr)
+		{
+			endpoints[i] = &health;
+			return;
+		}
+	}
+} // registerEndpoint()
+
+static bool reached(uint32_t now, uint32_t time)
+{
+	return (int32_t)(now - time) >= 0;
+}
+
+// half fixed, half random
+static uint32_t jitter(uint32_t delay)
+{
+	return delay / 2 + randomBelow(delay / 2 + 1);
+}
+
+static void logEvent(const endpointHealth &health, const char *event)
+{
+	if (report)
+	{
+		report(health, event);
+	}
+}
+
+void setPolicyClock(policyClock clock)
+{
+	clockNow = clock;
+}
+
+void setPolicyRandom(policyRandom random)
+{
+	randomBelow = random;
+}
+
+void setPolicyLog(policyLog log)
+{
+	report = log;
+}
+
+bool policyAllow(endpointHealth &health)
+{
+	registerEndpoint(health);
+	uint32_t now = clockNow();
+	switch (health.state)
+	{
+	case BREAKER_CLOSED:
+		if (health.failures == 0 || reached(now, health.retryAt))
+		{
+			return true;
+		}
+		break;
+	case BREAKER_OPEN:
+		if (reached(now, health.retryAt))
+		{
+			health.state = BREAKER_HALF_OPEN; // let one probe through
+			health.retryAt = now + health.policy.openTime;
+			logEvent(health, "circuit half-open");
+			return true;
+		}
+		break;
+	case BREAKER_HALF_OPEN:
+		if (reached(now, health.retryAt))
+		{
+			return true; // the probe never reported, try again
+		}
+		break;
+	}
+	health.refused++;
+	return false;
+} // policyAllow()
+
+void policySuccess(endpointHealth &health)
+{
+	if (health.state != BREAKER_CLOSED)
+	{
+		health.state = BREAKER_CLOSED;
+		logEvent(health, "circuit closed");
+	}
+	health.failures = 0;
+	health.successes++;
+} // policySuccess()
+
+void policyFailure(endpointHealth &health)
+{
+	registerEndpoint(health);
+	uint32_t now = clockNow();
+	health.errors++;
+	if (health.failures < UINT8_MAX)
+	{
+		health.failures++;
+	}
+
+	if (health.state == BREAKER_HALF_OPEN || health.failures >= health.policy.failureThreshold)
+	{
+		health.state = BREAKER_OPEN;
+		health.retryAt = now + jitter(health.policy.openTime);
+		logEvent(health, "circuit open");
+		return;
+	}
+	int shift = (health.failures - 1 < 16) ? health.failures - 1 : 16;
+	uint64_t delay = (uint64_t)health.policy.baseDelay << shift;
+	health.retryAt = now + jitter(delay < health.policy.maxDelay ? (uint32_t)delay : health.policy.maxDelay);
+	logEvent(health, "backing off");
+} // policyFailure()
+
+bool policyRetryDue(endpointHealth &health)
+{
+	return health.failures > 0 && health.state != BREAKER_HALF_OPEN && reached(clockNow(), health.retryAt);
+}
+
+void policyRetryAll()
+{
+	// failures during an outage say nothing about the servers, so try each one now
+	uint32_t now = clockNow();
+	for (int i = 0; i < POLICY_MAX_ENDPOINTS && endpoints[i]; i++)
+	{
+		if (endpoints[i]->failures > 0)
+		{
+			endpoints[i]->retryAt = now;
+		}
+	}
+} // policyRetryAll()
+
+uint32_t policyNextRetry()
+{
+	uint32_t now = clockNow();
+	uint32_t next = POLICY_NEVER;
+	for (int i = 0; i < POLICY_MAX_ENDPOINTS && endpoints[i]; i++)
+	{
+		const endpointHealth &health = *endpoints[i];
+		// an overdue retry nothing is waiting for would hold the caller awake for ever
+		if (health.failures > 0 && health.state != BREAKER_HALF_OPEN && health.retryPending &&
+			health.retryPending())
+		{
+			int32_t wait = (int32_t)(health.retryAt - now);
+			uint32_t due = wait > 0 ? wait : 0; // overdue: its service runs it on the next pass
+			next = due < next ? due : next;
+		}
+	}
+	return next;
+} // policyNextRetry()
+
+endpointHealth *policyEndpointAt(int index)
+{
+	return (index >= 0 && index < POLICY_MAX_ENDPOINTS) ? endpoints[index] : nullptr;
+}
+
+// End of file
@@ -0,0 +1,92 @@
+/**
+ * @file circuitBreaker.h
+ * @author Karl Berger
+ * @date 2025-06-17
+ * @brief Portable retry, backoff and circuit breaker policy for network endpoints.
+ *
+ * Each service keeps an `endpointHealth` for its endpoint and asks policyAllow()
+ * before making a connection. Failures back off exponentially with jitter; after
+ * `failureThreshold` consecutive failures the circuit opens and attempts are
+ * refused for `openTime`. The first attempt after that is a single half-open
+ * probe: success closes the circuit, failure opens it again.
+ *
+ * The millisecond clock and the random numbers for the jitter are supplied by
+ * the caller (millis() and random() on the ESP8266, a fake clock on a host). The
+ * clock may roll over; times are compared as signed differences. A log function,
+ * if set, hears of each change of breaker state and each backoff.
+ *
+ * An endpoint whose service retries on its own (ENDPOINT_HEALTH_RETRIED) names a
+ * function that says whether anything is waiting for that retry. Only those
+ * endpoints count in policyNextRetry(); the others are retried by their next
+ * scheduled attempt, which the caller already knows about.
+ *
+ * Functions:
+ * - setPolicyClock(clock): Set the millisecond clock.
+ * - setPolicyRandom(random): Set the random source of the jitter.
+ * - setPolicyLog(log): Report breaker changes and backoffs, nullptr for none.
+ * - policyAllow(health): True if an attempt may be made now.
+ * - policySuccess(health): Record a successful attempt.
+ * - policyFailure(health): Record a failed attempt and schedule the next one.
+ * - policyRetryDue(health): True if a failed attempt is waiting and its backoff has passed.
+ * - policyRetryAll(): End the wait of every failed endpoint, used when Wi-Fi comes back.
+ * - policyNextRetry(): Milliseconds until the earliest retry that will run, POLICY_NEVER if none.
+ * - policyEndpointAt(index): The endpoints seen so far, for reports.
+ */
+#ifndef CIRCUIT_BREAKER_H
+#define CIRCUIT_BREAKER_H
+
+#include <stdint.h> // fixed width types
+
+#define POLICY_MAX_ENDPOINTS 6	   ///< endpoints kept for policyRetryAll() and reports
+#define POLICY_NEVER 0xFFFFFFFFUL ///< no retry pending
+
+enum breakerState
+{
+	BREAKER_CLOSED,	   ///< normal operation
+	BREAKER_OPEN,	   ///< attempts refused until the open time passes
+	BREAKER_HALF_OPEN  ///< one probe attempt in flight
+};
+
+struct retryPolicy
+{
+	uint32_t baseDelay;		  ///< backoff after the first failure (ms)
+	uint32_t maxDelay;		  ///< longest backoff (ms)
+	uint8_t failureThreshold; ///< consecutive failures that open the circuit
+	uint32_t openTime;		  ///< time the circuit stays open (ms)
+};
+
+struct endpointHealth
+{
+	const char *name;		   ///< endpoint name for reports
+	const retryPolicy &policy; ///< timing rules
+	breakerState state;		   ///< circuit breaker state
+	uint8_t failures;		   ///< consecutive failures
+	uint32_t retryAt;		   ///< clock time of the next allowed attempt
+	uint32_t successes;		   ///< successful attempts
+	uint32_t errors;		   ///< failed attempts
+	uint32_t refused;		   ///< attempts refused by backoff or open circuit
+	bool (*retryPending)();	   ///< true while a retry is waiting to run, nullptr if none is
+};
+
+//! endpoint definition: name, retryPolicy
+#define ENDPOINT_HEALTH(name, policy) {name, policy, BREAKER_CLOSED, 0, 0, 0, 0, 0, nullptr}
+//! endpoint whose service retries failed attempts: name, retryPolicy, bool pending()
+#define ENDPOINT_HEALTH_RETRIED(name, policy, pending) {name, policy, BREAKER_CLOSED, 0, 0, 0, 0, 0, pending}
+
+typedef uint32_t (*policyClock)();						  ///< milliseconds
+typedef uint32_t (*policyRandom)(uint32_t bound);		  ///< 0 to bound - 1
+typedef void (*policyLog)(const endpointHealth &health, const char *event); ///< state change or backoff
+
+void setPolicyClock(policyClock clock);		 ///< set the millisecond clock
+void setPolicyRandom(policyRandom random);	 ///< set the jitter source
+void setPolicyLog(policyLog log);			 ///< report changes, nullptr for none
+bool policyAllow(endpointHealth &health);	 ///< true if an attempt may be made now
+void policySuccess(endpointHealth &health);	 ///< record a successful attempt
+void policyFailure(endpointHealth &health);	 ///< record a failed attempt
+bool policyRetryDue(endpointHealth &health); ///< true if a failed attempt may be retried now
+void policyRetryAll();						 ///< let every failed endpoint retry now
+uint32_t policyNextRetry();					 ///< milliseconds until the next pending retry is due
+endpointHealth *policyEndpointAt(int index); ///< nullptr past the last endpoint
+
+#endif // CIRCUIT_BREAKER_H
+// End of file
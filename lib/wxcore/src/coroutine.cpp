@@ -0,0 +1,128 @@
+/**
+ * @file coroutine.cpp
+ * @author Karl Berger
+ * @date 2025-06-29
+ * @brief Runs protothreads from the task scheduler.
+ */
+
+#include "coroutine.h"
+
+#include "taskScheduler.h" // resume task
+
+static uint32_t stoppedClock()
+{
+	return 0;
+}
+
+static uint32_t (*clockNow)() = stoppedClock; // replaced by setProtothreadClock()
+
+uint32_t ptClock()
+{
+	return clockNow();
+}
+
+void setProtothreadClock(uint32_t (*clock)())
+{
+	clockNow = clock;
+}
+
+static coroutine *running[CO_MAX]; // active coroutines, nullptr if free
+
+static void resumeAll();
+scheduledTask taskCoroutines = SCHEDULED_TASK("coroutines", resumeAll, CO_POLL_MS);
+
+static bool resume(coroutine &co)
+{
+	co.resumes++;
+	if (co.body(&co.pt) == PT_DONE)
+	{
+		co.active = false;
+		return false;
+	}
+	return true;
+} // resume()
+
+static void resumeAll()
+{
+	int active = 0;
+	for (int i = 0; i < CO_MAX; i++)
+	{
+		if (running[i] == nullptr)
+		{
+			continue;
+		}
+		if (!running[i]->active || !resume(*running[i]))
+		{
+			running[i] = nullptr; // finished, or finished by coFinish()
+			continue;
+		}
+		active++;
+	}
+	if (active == 0)
+	{
+		taskCancel(taskCoroutines); // nothing left to poll
+	}
+} // resumeAll()
+
+bool coStart(coroutine &co)
+{
+	if (co.active)
+	{
+		return false;
+	}
+	int slot = -1;
+	for (int i = 0; i < CO_MAX; i++)
+	{
+		bool free = running[i] == nullptr || !running[i]->active; // ended by coFinish(), not yet cleared
+		if (running[i] == &co || (slot < 0 && free))
+		{
+			slot = i;
+		}
+	}
+	if (slot < 0)
+	{
+		return false;
+	}
+	PT_INIT(&co.pt);
+	co.active = true;
+	co.started++;
+	running[slot] = &co;
+	if (!taskScheduled(taskCoroutines))
+	{
+		taskSchedule(taskCoroutines, 0); // first resume at once
+	}
+	return true;
+} // coStart()
+
+bool coActive(const coroutine &co)
+{
+	return co.active;
+}
+
+bool coResume(coroutine &co)
+{
+	return co.active && resume(co);
+}
+
+void coFinish(coroutine &co, void (*idle)())
+{
+	while (co.active && resume(co))
+	{
+		idle();
+	}
+} // coFinish()
+
+int coRunning()
+{
+	int active = 0;
+	for (int i = 0; i < CO_MAX; i++)
+	{
+		if (running[i] && running[i]->active)
+		{
+			active++;
+		}
+	}
+	return active;
+} // coRunning()
+
+// End of file
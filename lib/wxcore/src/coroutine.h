@@ -0,0 +1,51 @@
+/**
+ * @file coroutine.h
+ * @author Karl Berger
+ * @date 2025-06-29
+ * @brief Runs protothreads from the task scheduler.
+ *
+ * A coroutine is a named protothread function with its own state. coStart() makes
+ * it active, and a scheduler task then resumes every active coroutine each
+ * CO_POLL_MS until it returns PT_DONE. The task is only scheduled while a
+ * coroutine is active, so nothing is polled when the network is quiet. Scheduled
+ * tasks such as the display keep running between resumes.
+ *
+ * Code that must have the result before it continues, such as setup() or a
+ * deep-sleep cycle, calls coFinish() to resume one coroutine until it is done.
+ *
+ * Functions:
+ * - coStart(co): Start a coroutine, false if it is already running.
+ * - coActive(co): True while a coroutine is running.
+ * - coResume(co): Resume a coroutine once now, false once it is done.
+ * - coFinish(co, idle): Resume a coroutine until it is done, calling idle() between resumes.
+ * - coRunning(): Number of active coroutines.
+ */
+#ifndef COROUTINE_H
+#define COROUTINE_H
+
+#include "protothread.h" // protothread state and macros
+
+#define CO_MAX 4	   ///< coroutines active at once
+#define CO_POLL_MS 10 ///< milliseconds between resumes
+
+struct coroutine
+{
+	const char *name;				   ///< coroutine name for reports
+	ptState (*body)(protothread *pt); ///< protothread function
+	protothread pt;					   ///< resume point
+	bool active;					   ///< running
+	uint32_t started;				   ///< times started
+	uint32_t resumes;				   ///< times resumed
+};
+
+//! coroutine definition: name, protothread function
+#define COROUTINE(name, body) {name, body, {0, 0, false}, false, 0, 0}
+
+bool coStart(coroutine &co);					///< start, false if already running
+bool coActive(const coroutine &co);				///< true while running
+bool coResume(coroutine &co);					///< resume once, false once done
+void coFinish(coroutine &co, void (*idle)());	///< resume until done
+int coRunning();								///< active coroutines
+
+#endif // COROUTINE_H
+// End of file
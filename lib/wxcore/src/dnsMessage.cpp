@@ -0,0 +1,183 @@
+/**
+ * @file dnsMessage.cpp
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Portable coding of RFC 1035 A queries and their answers.
+ */
+
+#include "dnsMessage.h"
+
+#include <string.h> // memcpy(), strchr(), strlen()
+
+static uint16_t get16(const uint8_t *in)
+{
+	return (in[0] << 8) | in[1];
+}
+
+static void put16(uint8_t *out, uint16_t value)
+{
+	out[0] = value >> 8;
+	out[1] = value & 0xFF;
+}
+
+// skip a possibly compressed name, return the offset after it or -1
+static int skipName(const uint8_t *packet, size_t length, size_t offset)
+{
+	while (offset < length)
+	{
+		uint8_t label = packet[offset];
+		if (label == 0)
+		{
+			return offset + 1;
+		}
+		if ((label & 0xC0) == 0xC0)
+		{
+			return offset + 2; // compression pointer ends the name
+		}
+		offset += label + 1;
+	}
+	return -1;
+} // skipName()
+
+size_t dnsQuery(uint8_t *out, size_t size, uint16_t id, const char *host)
+{
+	if (size < 12)
+	{
+		return 0;
+	}
+	put16(out, id);
+	out[2] = 0x01; // recursion desired
+	out[3] = 0x00;
+	put16(out + 4, 1); // one question
+	memset(out + 6, 0, 6); // no answer, authority or additional records
+	size_t length = 12;
+	const char *label = host;
+	while (*label)
+	{
+		const char *dot = strchr(label, '.');
+		size_t labelSize = dot ? dot - label : strlen(label);
+		if (labelSize == 0 || labelSize > 63 || length + labelSize + 6 > size)
+		{
+			return 0;
+		}
+		out[length++] = labelSize;
+		memcpy(out + length, label, labelSize);
+		length += labelSize;
+		label += labelSize + (dot ? 1 : 0);
+	}
+	if (length == 12 || length + 5 > size)
+	{
+		return 0; // empty name
+	}
+	out[length++] = 0x00;
+	put16(out + length, 1); // type A
+	put16(out + length + 2, 1); // class IN
+	return length + 4;
+} // dnsQuery()
+
+dnsResult dnsAnswer(const uint8_t *packet, size_t length, uint16_t id, uint32_t &address, uint32_t &ttl)
+{
+	if (length < 12 || get16(packet) != id || !(packet[2] & 0x80))
+	{
+		return DNS_NOT_OURS;
+	}
+	uint8_t rcode = packet[3] & 0x0F;
+	if (rcode == DNS_RCODE_NXDOMAIN)
+	{
+		return DNS_NO_HOST;
+	}
+	if (rcode != DNS_RCODE_OK)
+	{
+		return DNS_NO_ANSWER;
+	}
+	int questions = get16(packet + 4);
+	int answers = get16(packet + 6);
+	int offset = 12;
+	for (int q = 0; q < questions && offset > 0; q++)
+	{
+		offset = skipName(packet, length, offset);
+		offset = (offset > 0) ? offset + 4 : -1; // type and class
+	}
+	for (int a = 0; a < answers; a++)
+	{
+		offset = (offset > 0) ? skipName(packet, length, offset) : -1;
+		if (offset < 0 || (size_t)offset + 10 > length)
+		{
+			return DNS_NO_ANSWER;
+		}
+		uint16_t type = get16(packet + offset);
+		uint32_t recordTtl = ((uint32_t)get16(packet + offset + 4) << 16) | get16(packet + offset + 6);
+		uint16_t rdLength = get16(packet + offset + 8);
+		offset += 10;
+		if (type == 1 && rdLength == 4 && (size_t)offset + 4 <= length) // A record, CNAMEs are skipped
+		{
+			address = ((uint32_t)packet[offset] << 24) | ((uint32_t)packet[offset + 1] << 16) |
+					  ((uint32_t)packet[offset + 2] << 8) | packet[offset + 3];
+			ttl = recordTtl;
+			return DNS_FOUND;
+		}
+		offset += rdLength;
+	}
+	return offset > 0 ? DNS_NO_HOST : DNS_NO_ANSWER; // no A record is the same as no host
+} // dnsAnswer()
+
+int dnsQuestion(const uint8_t *packet, size_t length, uint16_t &id, char *host, size_t size)
+{
+	if (length < 12 || (packet[2] & 0x80) || get16(packet + 4) != 1 || size == 0)
+	{
+		return -1; // an answer, or not one question
+	}
+	id = get16(packet);
+	size_t offset = 12;
+	size_t used = 0;
+	while (offset < length && packet[offset] != 0)
+	{
+		uint8_t label = packet[offset++];
+		if ((label & 0xC0) || offset + label > length || used + label + 1 >= size)
+		{
+			return -1;
+		}
+		if (used > 0)
+		{
+			host[used++] = '.';
+		}
+		memcpy(host + used, packet + offset, label);
+		used += label;
+		offset += label;
+	}
+	host[used] = '\0';
+	return (offset + 5 <= length) ? (int)offset + 5 : -1; // root label, type and class
+} // dnsQuestion()
+
+size_t dnsReply(uint8_t *out, size_t size, const uint8_t *query, int questionEnd, uint8_t rcode, uint32_t address,
+				uint32_t ttl)
+{
+	bool answer = rcode == DNS_RCODE_OK && address != 0;
+	size_t length = questionEnd + (answer ? 16 : 0);
+	if (questionEnd < 12 || length > size)
+	{
+		return 0;
+	}
+	memcpy(out, query, questionEnd);
+	out[2] = 0x81; // answer, recursion desired
+	out[3] = 0x80 | rcode; // recursion available
+	put16(out + 6, answer ? 1 : 0);
+	memset(out + 8, 0, 4);
+	if (answer)
+	{
+		uint8_t *record = out + questionEnd;
+		put16(record, 0xC00C); // the name of the question
+		put16(record + 2, 1);	// type A
+		put16(record + 4, 1);	// class IN
+		put16(record + 6, ttl >> 16);
+		put16(record + 8, ttl & 0xFFFF);
+		put16(record + 10, 4);
+		record[12] = address >> 24;
+		record[13] = address >> 16;
+		record[14] = address >> 8;
+		record[15] = address;
+	}
+	return length;
+} // dnsReply()
+
+// End of file
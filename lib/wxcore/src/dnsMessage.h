@@ -0,0 +1,49 @@
+/**
+ * @file dnsMessage.h
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Portable coding of RFC 1035 A queries and their answers.
+ *
+ * The firmware's resolver sends one A query and reads the address and TTL of
+ * the answer; the gateway's stub responder reads the question and writes the
+ * answer. Addresses are 32-bit with the first octet in the high byte.
+ *
+ * Functions:
+ * - dnsQuery(out, size, id, host): Build an A query, its length or 0.
+ * - dnsAnswer(packet, length, id, address, ttl): Read the answer to query id.
+ * - dnsQuestion(packet, length, id, host, size): Read the name of a query, the question end or -1.
+ * - dnsReply(out, size, query, questionEnd, rcode, address, ttl): Build the answer to a query.
+ */
+#ifndef DNS_MESSAGE_H
+#define DNS_MESSAGE_H
+
+#include <stddef.h> // size_t
+#include <stdint.h> // fixed width types
+
+#define DNS_PACKET_SIZE 512 ///< classic DNS over UDP limit
+#define DNS_NAME_MAX 253	///< longest host name
+#define DNS_RCODE_OK 0		///< answer, possibly empty
+#define DNS_RCODE_SERVFAIL 2 ///< server could not answer
+#define DNS_RCODE_NXDOMAIN 3 ///< host does not exist
+
+enum dnsResult
+{
+	DNS_NOT_OURS = -2,	///< not an answer to this query, keep waiting
+	DNS_NO_ANSWER = -1, ///< server failure or malformed answer
+	DNS_NO_HOST = 0,	///< NXDOMAIN, or no A record
+	DNS_FOUND = 1		///< address and TTL set
+};
+
+size_t dnsQuery(uint8_t *out, size_t size, uint16_t id, const char *host); ///< query length, 0 if the name is invalid
+dnsResult dnsAnswer(const uint8_t *packet, size_t length, uint16_t id, uint32_t &address, uint32_t &ttl); ///< read an answer
+int dnsQuestion(const uint8_t *packet, size_t length, uint16_t &id, char *host, size_t size); ///< question end, -1 if not a query
+
+/**
+ * @brief Answer a query: header, its question, and one A record if rcode is DNS_RCODE_OK and address is not 0.
+ * @return reply length, 0 if it does not fit
+ */
+size_t dnsReply(uint8_t *out, size_t size, const uint8_t *query, int questionEnd, uint8_t rcode, uint32_t address,
+				uint32_t ttl);
+
+#endif // DNS_MESSAGE_H
+// End of file
@@ -0,0 +1,166 @@
+/**
+ * @file hostCache.cpp
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Portable host name cache with TTL, stale-while-revalidate, negative entries and prefetch.
+ * @details Ages are unsigned differences of the clock, so they survive its
+ *          roll-over. A server that does not answer is not proof that a host is
+ *          gone: an entry that has an address keeps serving it for another stale
+ *          window instead of turning negative.
+ */
+
+#include "hostCache.h"
+
+#include <string.h> // strcmp()
+
+static uint32_t stoppedClock()
+{
+	return 0;
+}
+
+static hostCacheClock clockNow = stoppedClock; // replaced by setHostCacheClock()
+static hostEntry entries[DNS_CACHE_SLOTS];
+static hostCacheStats counters;
+
+static hostEntry *findEntry(const char *host)
+{
+	for (hostEntry &entry : entries)
+	{
+		if (entry.host && strcmp(entry.host, host) == 0)
+		{
+			return &entry;
+		}
+	}
+	return nullptr;
+} // findEntry()
+
+void setHostCacheClock(hostCacheClock clock)
+{
+	clockNow = clock;
+}
+
+hostAnswer hostCacheFind(const char *host, uint32_t &address)
+{
+	hostEntry *entry = findEntry(host);
+	if (entry == nullptr)
+	{
+		return HOST_MISS;
+	}
+	uint32_t age = clockNow() - entry->fetched;
+	if (age < entry->ttl && entry->negative)
+	{
+		counters.negative++;
+		return HOST_NEGATIVE;
+	}
+	if (age < entry->ttl)
+	{
+		counters.hits++;
+		entry->used = true;
+		address = entry->address;
+		return HOST_FRESH;
+	}
+	if (!entry->negative && entry->address != 0 && age - entry->ttl < 1000UL * DNS_STALE_WINDOW)
+	{
+		counters.stale++;
+		entry->used = true;
+		entry->refresh = true; // revalidate outside the caller's request
+		address = entry->address;
+		return HOST_STALE;
+	}
+	return HOST_MISS;
+} // hostCacheFind()
+
+hostEntry &hostCacheClaim(const char *host)
+{
+	hostEntry *entry = findEntry(host);
+	if (entry)
+	{
+		return *entry;
+	}
+	// an unused slot, or the one fetched longest ago
+	uint32_t now = clockNow();
+	entry = &entries[0];
+	for (hostEntry &candidate : entries)
+	{
+		if (candidate.host == nullptr)
+		{
+			entry = &candidate;
+			break;
+		}
+		if (now - candidate.fetched > now - entry->fetched)
+		{
+			entry = &candidate;
+		}
+	}
+	*entry = hostEntry{host, 0, now, 0, false, false, false, false};
+	return *entry;
+} // hostCacheClaim()
+
+void hostCacheStore(hostEntry &entry, dnsResult result, uint32_t address, uint32_t ttlSeconds)
+{
+	counters.lookups++;
+	entry.fetched = clockNow();
+	entry.refresh = false;
+	entry.used = false;
+	if (result == DNS_FOUND)
+	{
+		ttlSeconds = ttlSeconds < DNS_MIN_TTL ? DNS_MIN_TTL : ttlSeconds > DNS_MAX_TTL ? DNS_MAX_TTL : ttlSeconds;
+		entry.address = address;
+		entry.ttl = 1000UL * ttlSeconds;
+		entry.negative = false;
+	}
+	else if (result != DNS_NO_HOST && entry.address != 0 && !entry.negative)
+	{
+		entry.ttl = 0; // server silent: serve the old address for another stale window
+	}
+	else
+	{
+		entry.address = 0;
+		entry.ttl = 1000UL * DNS_NEGATIVE_TTL;
+		entry.negative = true;
+	}
+} // hostCacheStore()
+
+hostEntry *hostCacheDue()
+{
+	uint32_t now = clockNow();
+	for (hostEntry &entry : entries)
+	{
+		if (entry.host && entry.refresh)
+		{
+			return &entry;
+		}
+	}
+	for (hostEntry &entry : entries)
+	{
+		uint32_t age = now - entry.fetched;
+		if (entry.host && entry.used && !entry.negative && age < entry.ttl &&
+			age >= entry.ttl / 100 * DNS_PREFETCH_PERCENT)
+		{
+			counters.prefetches++;
+			entry.refresh = true;
+			return &entry;
+		}
+	}
+	return nullptr;
+} // hostCacheDue()
+
+void hostCacheFlush()
+{
+	for (hostEntry &entry : entries)
+	{
+		entry.host = nullptr;
+	}
+} // hostCacheFlush()
+
+const hostEntry *hostCacheAt(int index)
+{
+	return (index >= 0 && index < DNS_CACHE_SLOTS) ? &entries[index] : nullptr;
+}
+
+const hostCacheStats &hostCacheCounters()
+{
+	return counters;
+}
+
+// End of file
@@ -0,0 +1,86 @@
+/**
+ * @file hostCache.h
+ * @author Karl Berger
+ * @date 2025-07-10
+ * @brief Portable host name cache with TTL, stale-while-revalidate, negative entries and prefetch.
+ *
+ * Lookups are answered from the cache while the record TTL lasts. After the TTL
+ * the old address is still returned for up to DNS_STALE_WINDOW while the entry
+ * waits for a fresh query in the background (hostCacheDue()). Failed lookups
+ * are remembered for DNS_NEGATIVE_TTL so a dead host does not cost a timeout on
+ * every post. An entry that was used since its answer arrived is due again at
+ * DNS_PREFETCH_PERCENT of its TTL, so a host in regular use never goes stale.
+ *
+ * The cache makes no queries itself. The caller looks a host up when
+ * hostCacheFind() reports a miss or hostCacheDue() names an entry, and hands
+ * the dnsResult to hostCacheStore(). Time comes from a millisecond clock set
+ * with setHostCacheClock(); it may roll over.
+ *
+ * Host names must have static storage duration; the cache keeps the pointer.
+ *
+ * Functions:
+ * - setHostCacheClock(clock): Set the millisecond clock.
+ * - hostCacheFind(host, address): Answer from the cache, HOST_MISS if a lookup is needed.
+ * - hostCacheClaim(host): The entry for a host, claiming the oldest slot if it has none.
+ * - hostCacheStore(entry, result, address, ttl): Record the outcome of a lookup.
+ * - hostCacheDue(): The next entry to look up in the background, nullptr if none.
+ * - hostCacheFlush(): Forget all entries.
+ * - hostCacheAt(index): The entries, for reports.
+ * - hostCacheCounters(): Hit, stale, negative and lookup counts.
+ */
+#ifndef HOST_CACHE_H
+#define HOST_CACHE_H
+
+#include <stdint.h>		  // fixed width types
+#include "dnsMessage.h" // dnsResult
+
+#define DNS_CACHE_SLOTS 6		  ///< cached host names
+#define DNS_MIN_TTL 30UL		  ///< shortest TTL honoured (seconds)
+#define DNS_MAX_TTL 3600UL		  ///< longest TTL honoured (seconds)
+#define DNS_DEFAULT_TTL 300UL	  ///< TTL used when the answer carries none (seconds)
+#define DNS_STALE_WINDOW 600UL	  ///< seconds a stale address may be served while revalidating
+#define DNS_NEGATIVE_TTL 60UL	  ///< seconds a failed lookup is remembered
+#define DNS_PREFETCH_PERCENT 75	  ///< share of the TTL after which a used entry is refreshed
+
+enum hostAnswer
+{
+	HOST_FRESH,	   ///< address within its TTL
+	HOST_STALE,	   ///< address past its TTL, revalidation queued
+	HOST_NEGATIVE, ///< the host recently failed to resolve
+	HOST_MISS	   ///< nothing usable, look the host up now
+};
+
+struct hostEntry
+{
+	const char *host; ///< host name, nullptr if unused
+	uint32_t address; ///< last good address, 0 if none
+	uint32_t fetched; ///< clock time the answer arrived
+	uint32_t ttl;	  ///< milliseconds the answer is fresh
+	bool negative;	  ///< lookup failed
+	bool refresh;	  ///< stale or near expiry, due for a background lookup
+	bool used;		  ///< answered a caller since the last lookup
+	bool system;	  ///< caller's flag, kept with the entry
+};
+
+struct hostCacheStats
+{
+	uint32_t hits;		 ///< fresh answers
+	uint32_t stale;		 ///< stale answers served while revalidating
+	uint32_t negative;	 ///< failures answered from the cache
+	uint32_t lookups;	 ///< outcomes stored
+	uint32_t prefetches; ///< entries queued before they expired
+};
+
+typedef uint32_t (*hostCacheClock)(); ///< milliseconds
+
+void setHostCacheClock(hostCacheClock clock);		   ///< set the millisecond clock
+hostAnswer hostCacheFind(const char *host, uint32_t &address); ///< answer from the cache
+hostEntry &hostCacheClaim(const char *host);		   ///< entry for a host, claimed if new
+void hostCacheStore(hostEntry &entry, dnsResult result, uint32_t address, uint32_t ttlSeconds); ///< record a lookup
+hostEntry *hostCacheDue();							   ///< next background lookup, nullptr if none
+void hostCacheFlush();								   ///< forget all entries
+const hostEntry *hostCacheAt(int index);			   ///< nullptr past the last slot
+const hostCacheStats &hostCacheCounters();			   ///< counters
+
+#endif // HOST_CACHE_H
+// End of file
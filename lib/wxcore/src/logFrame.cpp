@@ -0,0 +1,75 @@
+/**
+ * @file logFrame.cpp
+ * @author Karl Berger
+ * @date 2025-07-06
+ * @brief Portable CRC-framed records for append-only logs.
+ * @details The CRC is computed a nibble at a time from a 16 entry table, a
+ *          fair trade between a 1 kB table and a loop per bit.
+ */
+
+#include "logFrame.h"
+
+#include <string.h> // memcpy
+
+static const uint32_t CRC_NIBBLE[16] = {0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+										0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+										0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+static uint32_t crcUpdate(uint32_t crc, const uint8_t *data, size_t length)
+{
+	while (length--)
+	{
+		crc ^= *data++;
+		crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+		crc = (crc >> 4) ^ CRC_NIBBLE[crc & 0x0F];
+	}
+	return crc;
+} // crcUpdate()
+
+uint32_t frameCrc(const uint8_t *data, size_t length)
+{
+	return ~crcUpdate(0xFFFFFFFF, data, length);
+}
+
+size_t frameEncode(const uint8_t *payload, uint8_t length, uint8_t *frame)
+{
+	frame[0] = FRAME_MAGIC;
+	frame[1] = length;
+	memcpy(frame + 2, payload, length);
+	uint32_t crc = frameCrc(frame + 1, length + 1);
+	for (int i = 0; i < 4; i++)
+	{
+		frame[2 + length + i] = crc >> (8 * i);
+	}
+	return length + FRAME_OVERHEAD;
+} // frameEncode()
+
+frameResult frameDecode(const uint8_t *data, size_t available, const uint8_t *&payload, uint8_t &length)
+{
+	if (available < 2)
+	{
+		return (available == 0 || data[0] == FRAME_MAGIC) ? FRAME_SHORT : FRAME_BAD;
+	}
+	if (data[0] != FRAME_MAGIC)
+	{
+		return FRAME_BAD;
+	}
+	length = data[1];
+	if (available < (size_t)length + FRAME_OVERHEAD)
+	{
+		return FRAME_SHORT;
+	}
+	uint32_t crc = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		crc |= (uint32_t)data[2 + length + i] << (8 * i);
+	}
+	if (crc != frameCrc(data + 1, length + 1))
+	{
+		return FRAME_BAD;
+	}
+	payload = data + 2;
+	return FRAME_OK;
+} // frameDecode()
+
+// End of file
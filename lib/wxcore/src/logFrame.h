@@ -0,0 +1,40 @@
+/**
+ * @file logFrame.h
+ * @author Karl Berger
+ * @date 2025-07-06
+ * @brief Portable CRC-framed records for append-only logs.
+ *
+ * A frame is a magic byte, a payload length byte, the payload and a CRC-32 of
+ * the length and payload, least significant byte first. A reader that meets a
+ * bad frame moves on one byte and looks for the next magic byte, so a
+ * corrupted record costs only itself. A frame cut short at the end of a file
+ * is a write torn by a reset and can be truncated away.
+ *
+ * Functions:
+ * - frameCrc(data, length): CRC-32 (IEEE 802.3) of a buffer.
+ * - frameEncode(payload, length, frame): Frame a payload, return the frame size.
+ * - frameDecode(data, available, payload, length): Check the frame at data.
+ */
+#ifndef LOG_FRAME_H
+#define LOG_FRAME_H
+
+#include <stddef.h> // size_t
+#include <stdint.h> // fixed width types
+
+#define FRAME_MAGIC 0xA5	   ///< first byte of every frame
+#define FRAME_OVERHEAD 6	   ///< magic, length and CRC bytes
+#define FRAME_MAX_PAYLOAD 255 ///< longest payload
+
+enum frameResult
+{
+	FRAME_OK,	 ///< a whole frame with a good CRC
+	FRAME_SHORT, ///< the frame runs past the data available
+	FRAME_BAD	 ///< no magic byte or a bad CRC
+};
+
+uint32_t frameCrc(const uint8_t *data, size_t length);						 ///< CRC-32 of a buffer
+size_t frameEncode(const uint8_t *payload, uint8_t length, uint8_t *frame); ///< frame size, length + FRAME_OVERHEAD
+frameResult frameDecode(const uint8_t *data, size_t available, const uint8_t *&payload, uint8_t &length); ///< check a frame
+
+#endif // LOG_FRAME_H
+// End of file
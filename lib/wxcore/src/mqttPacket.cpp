@@ -0,0 +1,134 @@
+/**
+ * @file mqttPacket.cpp
+ * @author Karl Berger
+ * @date 2025-07-09
+ * @brief Portable MQTT 3.1.1 packet coding.
+ */
+
+#include "mqttPacket.h"
+
+#include <string.h> // memcpy(), strlen()
+
+size_t mqttHeader(uint8_t header[MQTT_HEADER_MAX], uint8_t type, size_t length)
+{
+	size_t used = 0;
+	header[used++] = type;
+	do
+	{
+		uint8_t digit = length % 128;
+		length /= 128;
+		header[used++] = digit | (length > 0 ? 0x80 : 0);
+	} while (length > 0 && used < MQTT_HEADER_MAX);
+	return used;
+} // mqttHeader()
+
+int mqttParseHeader(const uint8_t *data, size_t available, size_t &length)
+{
+	length = 0;
+	for (size_t at = 1; at < MQTT_HEADER_MAX; at++)
+	{
+		if (at >= available)
+		{
+			return 0; // more to come
+		}
+		length |= (size_t)(data[at] & 0x7F) << (7 * (at - 1));
+		if ((data[at] & 0x80) == 0)
+		{
+			return at + 1;
+		}
+	}
+	return -1; // a fifth length byte
+} // mqttParseHeader()
+
+size_t mqttPutString(uint8_t *out, size_t size, size_t at, const char *text, size_t length)
+{
+	if (length > UINT16_MAX || at + 2 + length > size)
+	{
+		return 0;
+	}
+	out[at++] = length >> 8;
+	out[at++] = length & 0xFF;
+	memcpy(out + at, text, length);
+	return at + length;
+} // mqttPutString()
+
+bool mqttGetString(const uint8_t *body, size_t length, size_t &at, const char *&text, size_t &textLength)
+{
+	if (at + 2 > length)
+	{
+		return false;
+	}
+	textLength = (body[at] << 8) | body[at + 1];
+	if (at + 2 + textLength > length)
+	{
+		return false;
+	}
+	text = (const char *)body + at + 2;
+	at += 2 + textLength;
+	return true;
+} // mqttGetString()
+
+static bool present(const char *text)
+{
+	return text && text[0];
+}
+
+size_t mqttConnectBody(uint8_t *out, size_t size, const mqttConnectFields &fields)
+{
+	uint8_t flags = fields.cleanSession ? MQTT_CLEAN_SESSION : 0;
+	if (fields.willTopic)
+	{
+		flags |= MQTT_WILL | (fields.willQos << 3) | (fields.willRetain ? MQTT_WILL_RETAIN : 0);
+	}
+	flags |= present(fields.user) ? MQTT_USER_FLAG : 0;
+	flags |= present(fields.password) ? MQTT_PASSWORD_FLAG : 0;
+
+	size_t at = mqttPutString(out, size, 0, "MQTT", 4);
+	if (at == 0 || at + 4 > size)
+	{
+		return 0;
+	}
+	out[at++] = 4; // protocol level 3.1.1
+	out[at++] = flags;
+	out[at++] = fields.keepAlive >> 8;
+	out[at++] = fields.keepAlive & 0xFF;
+	at = mqttPutString(out, size, at, fields.clientId, strlen(fields.clientId));
+	if (at && fields.willTopic)
+	{
+		at = mqttPutString(out, size, at, fields.willTopic, strlen(fields.willTopic));
+		at = at ? mqttPutString(out, size, at, fields.willMessage, strlen(fields.willMessage)) : 0;
+	}
+	if (at && present(fields.user))
+	{
+		at = mqttPutString(out, size, at, fields.user, strlen(fields.user));
+	}
+	if (at && present(fields.password))
+	{
+		at = mqttPutString(out, size, at, fields.password, strlen(fields.password));
+	}
+	return at;
+} // mqttConnectBody()
+
+uint8_t mqttPublishType(uint8_t qos, bool dup, bool retain)
+{
+	return MQTT_PUBLISH | (dup ? MQTT_DUP : 0) | (qos << 1) | (retain ? MQTT_RETAIN : 0);
+}
+
+size_t mqttPublishBody(uint8_t *out, size_t size, const char *topic, const uint8_t *payload, size_t payloadLength,
+					   uint8_t qos, uint16_t id)
+{
+	size_t at = mqttPutString(out, size, 0, topic, strlen(topic));
+	if (at == 0 || at + (qos > 0 ? 2 : 0) + payloadLength > size)
+	{
+		return 0;
+	}
+	if (qos > 0)
+	{
+		out[at++] = id >> 8;
+		out[at++] = id & 0xFF;
+	}
+	memcpy(out + at, payload, payloadLength);
+	return at + payloadLength;
+} // mqttPublishBody()
+
+// End of file
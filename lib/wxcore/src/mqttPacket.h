@@ -0,0 +1,86 @@
+/**
+ * @file mqttPacket.h
+ * @author Karl Berger
+ * @date 2025-07-09
+ * @brief Portable MQTT 3.1.1 packet coding.
+ *
+ * Builds the packets the firmware sends and reads the fixed header of the
+ * ones it receives, so the gateway's broker stand-in and its tests code them
+ * the same way. Bodies are written into a caller's buffer; a packet is the
+ * fixed header from mqttHeader() followed by the body.
+ *
+ * Functions:
+ * - mqttHeader(header, type, length): Fixed header for a body of length bytes.
+ * - mqttParseHeader(data, available, length): Read a fixed header, its size or 0 if incomplete.
+ * - mqttPutString(out, size, at, text, length): Append a length-prefixed string.
+ * - mqttGetString(body, length, at, text, textLength): Read a length-prefixed string.
+ * - mqttConnectBody(out, size, fields): CONNECT variable header and payload.
+ * - mqttPublishType(qos, dup, retain): PUBLISH fixed header type byte.
+ * - mqttPublishBody(out, size, topic, payload, payloadLength, qos, id): PUBLISH topic, id and payload.
+ */
+#ifndef MQTT_PACKET_H
+#define MQTT_PACKET_H
+
+#include <stddef.h> // size_t
+#include <stdint.h> // fixed width types
+
+// control packet types, the high nibble of the first byte
+#define MQTT_CONNECT 0x10
+#define MQTT_CONNACK 0x20
+#define MQTT_PUBLISH 0x30
+#define MQTT_PUBACK 0x40
+#define MQTT_SUBSCRIBE 0x82 ///< with its required flags
+#define MQTT_SUBACK 0x90
+#define MQTT_PINGREQ 0xC0
+#define MQTT_PINGRESP 0xD0
+#define MQTT_DISCONNECT 0xE0
+
+// PUBLISH flags, the low nibble
+#define MQTT_RETAIN 0x01
+#define MQTT_DUP 0x08
+
+// CONNECT flags
+#define MQTT_CLEAN_SESSION 0x02
+#define MQTT_WILL 0x04
+#define MQTT_WILL_RETAIN 0x20
+#define MQTT_PASSWORD_FLAG 0x40
+#define MQTT_USER_FLAG 0x80
+
+#define MQTT_HEADER_MAX 5 ///< type byte and up to four length bytes
+
+struct mqttConnectFields
+{
+	const char *clientId;	 ///< required
+	const char *willTopic;	 ///< nullptr for no will
+	const char *willMessage; ///< sent if the connection drops without DISCONNECT
+	uint8_t willQos;		 ///< 0 or 1
+	bool willRetain;		 ///< the broker keeps the will as the topic's retained message
+	const char *user;		 ///< nullptr or empty for none
+	const char *password;	 ///< nullptr or empty for none
+	uint16_t keepAlive;		 ///< seconds
+	bool cleanSession;		 ///< false asks the broker to keep the session
+};
+
+size_t mqttHeader(uint8_t header[MQTT_HEADER_MAX], uint8_t type, size_t length); ///< header bytes used
+
+/**
+ * @brief Read the fixed header at the start of data.
+ * @return header bytes, with the body length in length; 0 if more bytes are needed, -1 if malformed
+ */
+int mqttParseHeader(const uint8_t *data, size_t available, size_t &length);
+
+size_t mqttPutString(uint8_t *out, size_t size, size_t at, const char *text, size_t length); ///< new end, 0 if it does not fit
+bool mqttGetString(const uint8_t *body, size_t length, size_t &at, const char *&text, size_t &textLength); ///< false past the body
+
+size_t mqttConnectBody(uint8_t *out, size_t size, const mqttConnectFields &fields); ///< body length, 0 if it does not fit
+uint8_t mqttPublishType(uint8_t qos, bool dup, bool retain);						  ///< PUBLISH type byte
+
+/**
+ * @brief PUBLISH body: topic, the packet identifier when qos > 0, then the payload.
+ * @return body length, 0 if it does not fit
+ */
+size_t mqttPublishBody(uint8_t *out, size_t size, const char *topic, const uint8_t *payload, size_t payloadLength,
+					   uint8_t qos, uint16_t id);
+
+#endif // MQTT_PACKET_H
+// End of file
@@ -0,0 +1,238 @@
+/**
+ * @file packedHistory.cpp
+ * @author Karl Berger
+ * @date 2025-07-05
+ * @brief Portable bit-packed store of timed integer records.
+ * @details Bits are written most significant first. A record is coded into a
+ *          scratch buffer before it is copied, so a record that does not fit the
+ *          current block starts the next one instead of being split.
+ */
+
+#include "packedHistory.h"
+
+#include <string.h> // memset, memcpy
+
+// prefix codes: bits of payload after 0, 1, 2, 3 and 4 one-bits
+static const uint8_t PAYLOAD_BITS[] = {0, 3, 6, 10, 32};
+
+static uint32_t zigzag(int32_t value)
+{
+	return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+	return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static void putBits(uint8_t *data, uint16_t &bit, uint32_t value, int count)
+{
+	while (count-- > 0)
+	{
+		if ((value >> count) & 1)
+		{
+			data[bit >> 3] |= 0x80 >> (bit & 7);
+		}
+		bit++;
+	}
+} // putBits()
+
+static uint32_t getBits(const uint8_t *data, uint16_t &bit, int count)
+{
+	uint32_t value = 0;
+	while (count-- > 0)
+	{
+		value = (value << 1) | ((data[bit >> 3] >> (7 - (bit & 7))) & 1);
+		bit++;
+	}
+	return value;
+} // getBits()
+
+static void putValue(uint8_t *data, uint16_t &bit, int32_t value)
+{
+	uint32_t z = zigzag(value);
+	int code = (z == 0) ? 0 : (z < 8) ? 1 : (z < 64) ? 2 : (z < 1024) ? 3 : 4;
+	if (code < 4)
+	{
+		putBits(data, bit, ((1u << code) - 1) << 1, code + 1); // code ones and a zero
+	}
+	else
+	{
+		putBits(data, bit, 0x0F, 4);
+	}
+	putBits(data, bit, z, PAYLOAD_BITS[code]);
+} // putValue()
+
+static int32_t getValue(const uint8_t *data, uint16_t &bit)
+{
+	int code = 0;
+	while (code < 4 && getBits(data, bit, 1))
+	{
+		code++;
+	}
+	return unzigzag(getBits(data, bit, PAYLOAD_BITS[code]));
+} // getValue()
+
+void packedClear(packedStore &store)
+{
+	store.head = 0;
+	store.used = 0;
+	store.count = 0;
+	store.dropped = 0;
+	store.timeDelta = 0;
+	memset(&store.newest, 0, sizeof(store.newest));
+} // packedClear()
+
+// an empty block at the end of the ring, dropping the oldest if the ring is full
+static packedBlock &startBlock(packedStore &store, uint32_t epoch)
+{
+	if (store.used == PACKED_BLOCKS)
+	{
+		store.count -= store.block[store.head].count;
+		store.dropped += store.block[store.head].count;
+		store.head = (store.head + 1) % PACKED_BLOCKS;
+		store.used--;
+	}
+	packedBlock &block = store.block[(store.head + store.used++) % PACKED_BLOCKS];
+	block.firstEpoch = epoch;
+	block.bits = 0;
+	block.count = 0;
+	memset(block.data, 0, sizeof(block.data));
+	return block;
+} // startBlock()
+
+bool packedAppend(packedStore &store, const packedRecord &record)
+{
+	if (store.count > 0 && record.epoch <= store.newest.epoch)
+	{
+		return false; // duplicate or out of order
+	}
+	uint8_t scratch[(PACKED_MAX_BITS + 7) / 8] = {0};
+	uint16_t length = 0;
+	int32_t timeDelta = 0;
+	bool first = (store.used == 0);
+	if (!first)
+	{
+		timeDelta = (int32_t)(record.epoch - store.newest.epoch);
+		putValue(scratch, length, timeDelta - store.timeDelta);
+		for (int i = 0; i < PACKED_CHANNELS; i++)
+		{
+			putValue(scratch, length, record.value[i] - store.newest.value[i]);
+		}
+	}
+	packedBlock *block = first ? nullptr : &store.block[(store.head + store.used - 1) % PACKED_BLOCKS];
+	if (first || block->bits + length > PACKED_BLOCK_BYTES * 8)
+	{
+		// a block starts with its time in the header and its values against zero
+		block = &startBlock(store, record.epoch);
+		memset(scratch, 0, sizeof(scratch));
+		length = 0;
+		timeDelta = 0;
+		for (int i = 0; i < PACKED_CHANNELS; i++)
+		{
+			putValue(scratch, length, record.value[i]);
+		}
+	}
+	// copy the scratch bits to the end of the block
+	uint16_t read = 0;
+	while (read < length)
+	{
+		int count = (length - read < 32) ? length - read : 32;
+		putBits(block->data, block->bits, getBits(scratch, read, count), count);
+	}
+	block->count++;
+	store.count++;
+	store.newest = record;
+	store.timeDelta = timeDelta;
+	return true;
+} // packedAppend()
+
+bool packedNewest(const packedStore &store, packedRecord &record)
+{
+	if (store.count == 0)
+	{
+		return false;
+	}
+	record = store.newest;
+	return true;
+} // packedNewest()
+
+void packedBegin(const packedStore &store, packedCursor &cursor, uint32_t from)
+{
+	cursor.store = &store;
+	cursor.index = 0;
+	cursor.bit = 0;
+	cursor.from = from;
+	cursor.timeDelta = 0;
+	// last block that starts at or before the window, by binary search
+	int lo = 0;
+	int hi = (int)store.used - 1;
+	cursor.block = 0;
+	while (lo <= hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (store.block[(store.head + mid) % PACKED_BLOCKS].firstEpoch <= from)
+		{
+			cursor.block = mid;
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+} // packedBegin()
+
+bool packedNext(packedCursor &cursor, packedRecord &record)
+{
+	const packedStore &store = *cursor.store;
+	while (cursor.block < store.used)
+	{
+		const packedBlock &block = store.block[(store.head + cursor.block) % PACKED_BLOCKS];
+		if (cursor.index == block.count)
+		{
+			cursor.block++;
+			cursor.index = 0;
+			cursor.bit = 0;
+			continue;
+		}
+		packedRecord &current = cursor.record;
+		if (cursor.index == 0)
+		{
+			current.epoch = block.firstEpoch;
+			cursor.timeDelta = 0;
+			for (int i = 0; i < PACKED_CHANNELS; i++)
+			{
+				current.value[i] = getValue(block.data, cursor.bit);
+			}
+		}
+		else
+		{
+			cursor.timeDelta += getValue(block.data, cursor.bit);
+			current.epoch += cursor.timeDelta;
+			for (int i = 0; i < PACKED_CHANNELS; i++)
+			{
+				current.value[i] += getValue(block.data, cursor.bit);
+			}
+		}
+		cursor.index++;
+		if (current.epoch >= cursor.from)
+		{
+			record = current;
+			return true;
+		}
+	}
+	return false;
+} // packedNext()
+
+uint32_t packedBits(const packedStore &store)
+{
+	uint32_t bits = 0;
+	for (int i = 0; i < store.used; i++)
+	{
+		bits += store.block[(store.head + i) % PACKED_BLOCKS].bits;
+	}
+	return bits;
+} // packedBits()
+
+// End of file
@@ -0,0 +1,89 @@
+/**
+ * @file packedHistory.h
+ * @author Karl Berger
+ * @date 2025-07-05
+ * @brief Portable bit-packed store of timed integer records.
+ *
+ * Each record is a time and PACKED_CHANNELS scaled integer values, such as
+ * temperature in 0.1 °C. A record is stored as the change from the record
+ * before it, with a short prefix code, so a value that did not change costs
+ * one bit:
+ * - time: delta-of-delta, 0 while the reporting interval holds steady
+ * - values: delta; weather values wander, so a second difference would be
+ *   larger than the first
+ *
+ * Codes (zigzag z of the difference, prefix then payload):
+ *   z = 0: "0"   z < 8: "10" + 3 bits   z < 64: "110" + 6 bits
+ *   z < 1024: "1110" + 10 bits           otherwise "1111" + 32 bits
+ *
+ * Records go into fixed blocks of PACKED_BLOCK_BYTES. The first record of a
+ * block is coded against zero and the block keeps its time, so each block
+ * decodes on its own, a window is found by binary search over the block
+ * times, and when the store is full the oldest block is dropped whole.
+ *
+ * Records must arrive in time order; one that is not newer than the last is
+ * refused, so a backfill can overlap the live records.
+ *
+ * Functions:
+ * - packedClear(store): Empty the store.
+ * - packedAppend(store, record): Add a record, false if not newer than the last.
+ * - packedNewest(store, record): The newest record.
+ * - packedBegin(store, cursor, from): Start reading at the first record at or after a time.
+ * - packedNext(cursor, record): Read the next record, false past the newest.
+ * - packedBits(store): Bits used by the records held.
+ */
+#ifndef PACKED_HISTORY_H
+#define PACKED_HISTORY_H
+
+#include <stdint.h> // fixed width types
+
+#define PACKED_CHANNELS 9 ///< values per record
+#define PACKED_BLOCKS 32 ///< blocks in a store
+#define PACKED_BLOCK_BYTES 256 ///< coded bytes per block
+#define PACKED_MAX_BITS (36 * (PACKED_CHANNELS + 1)) ///< longest coded record
+
+struct packedRecord
+{
+	uint32_t epoch;					///< record time (unix time UTC)
+	int32_t value[PACKED_CHANNELS]; ///< scaled values
+};
+
+struct packedBlock
+{
+	uint32_t firstEpoch;			 ///< time of the first record
+	uint16_t bits;					 ///< bits written
+	uint16_t count;					 ///< records in the block
+	uint8_t data[PACKED_BLOCK_BYTES]; ///< coded records
+};
+
+struct packedStore
+{
+	packedBlock block[PACKED_BLOCKS]; ///< ring of blocks
+	uint16_t head;					  ///< index of the oldest block
+	uint16_t used;					  ///< blocks in use
+	uint32_t count;					  ///< records held
+	uint32_t dropped;				  ///< records dropped with old blocks
+	packedRecord newest;			  ///< last record, the base of the next delta
+	int32_t timeDelta;				  ///< last time step, the base of the next delta-of-delta
+};
+
+struct packedCursor
+{
+	const packedStore *store; ///< store being read
+	uint16_t block;			  ///< blocks from the oldest
+	uint16_t index;			  ///< records read from the block
+	uint16_t bit;			  ///< read position in the block
+	uint32_t from;			  ///< records before this time are skipped
+	packedRecord record;	  ///< last record read
+	int32_t timeDelta;		  ///< last time step
+};
+
+void packedClear(packedStore &store);									 ///< empty the store
+bool packedAppend(packedStore &store, const packedRecord &record);		 ///< false if not newer
+bool packedNewest(const packedStore &store, packedRecord &record);		 ///< false if empty
+void packedBegin(const packedStore &store, packedCursor &cursor, uint32_t from); ///< start reading at a time
+bool packedNext(packedCursor &cursor, packedRecord &record);			 ///< false past the newest
+uint32_t packedBits(const packedStore &store);							 ///< bits used by the records
+
+#endif // PACKED_HISTORY_H
+// End of file
@@ -0,0 +1,110 @@
+/**
+ * @file protothread.h
+ * @author Karl Berger
+ * @date 2025-06-29
+ * @brief Stackless coroutines (protothreads) for long-running network operations.
+ *
+ * A protothread is a function that returns PT_WAITING whenever it has to wait and
+ * is called again later to carry on from the same line, in the manner of Adam
+ * Dunkels' protothreads. The resume point is a line number stored in the
+ * `protothread` struct and reached through a switch, so a thread costs a few
+ * bytes and no stack of its own. The C++ toolchain of the ESP8266 core (GCC 10,
+ * C++17) has no C++20 coroutines.
+ *
+ * Rules that follow from having no stack:
+ * - Local variables do not survive a wait; keep state in a context struct.
+ * - A wait may not sit inside a switch statement of the thread's own.
+ * - Only one wait per source line.
+ *
+ * Awaitables:
+ * - PT_WAIT_UNTIL(pt, condition): until condition is true.
+ * - PT_YIELD(pt): let other work run once.
+ * - PT_SLEEP(pt, ms): for a time.
+ * - PT_AWAIT(pt, condition, ms): until condition or timeout; PT_TIMED_OUT(pt) tells which.
+ * - PT_AWAIT_READABLE(pt, client, ms): until a socket has data or is closed, or timeout.
+ * - PT_AWAIT_THREAD(pt, call): until a child protothread finishes.
+ *
+ * Time comes from ptClock(), a millisecond clock set with setProtothreadClock().
+ */
+#ifndef PROTOTHREAD_H
+#define PROTOTHREAD_H
+
+#include <stdint.h> // fixed width types
+
+enum ptState
+{
+	PT_WAITING, ///< suspended, call again
+	PT_DONE		///< finished, the next call starts over
+};
+
+struct protothread
+{
+	uint16_t line;	  ///< resume point, 0 at the start
+	uint32_t wakeAt;  ///< deadline of the current sleep or timeout
+	bool timedOut;	  ///< the last PT_AWAIT ended by timeout
+};
+
+uint32_t ptClock();							  ///< milliseconds
+void setProtothreadClock(uint32_t (*clock)()); ///< replace the millisecond clock
+
+//! true once the deadline of the current wait has passed
+#define PT_EXPIRED(pt) ((int32_t)(ptClock() - (pt)->wakeAt) >= 0)
+
+#define PT_INIT(pt) ((pt)->line = 0)
+#define PT_BEGIN(pt) \
+	switch ((pt)->line) \
+	{ \
+	case 0:
+#define PT_END(pt) \
+	} \
+	(pt)->line = 0; \
+	return PT_DONE
+#define PT_EXIT(pt) \
+	do \
+	{ \
+		(pt)->line = 0; \
+		return PT_DONE; \
+	} while (0)
+
+#define PT_WAIT_UNTIL(pt, condition) \
+	do \
+	{ \
+		(pt)->line = __LINE__; \
+		[[fallthrough]]; \
+	case __LINE__: \
+		if (!(condition)) \
+			return PT_WAITING; \
+	} while (0)
+
+#define PT_YIELD(pt) \
+	do \
+	{ \
+		(pt)->line = __LINE__; \
+		return PT_WAITING; \
+	case __LINE__:; \
+	} while (0)
+
+#define PT_SLEEP(pt, ms) \
+	do \
+	{ \
+		(pt)->wakeAt = ptClock() + (ms); \
+		PT_WAIT_UNTIL(pt, PT_EXPIRED(pt)); \
+	} while (0)
+
+//! condition is evaluated once per resume, so it may consume input
+#define PT_AWAIT(pt, condition, ms) \
+	do \
+	{ \
+		(pt)->wakeAt = ptClock() + (ms); \
+		(pt)->timedOut = true; \
+		PT_WAIT_UNTIL(pt, (condition) ? ((pt)->timedOut = false, true) : PT_EXPIRED(pt)); \
+	} while (0)
+
+#define PT_TIMED_OUT(pt) ((pt)->timedOut)
+
+#define PT_AWAIT_READABLE(pt, client, ms) PT_AWAIT(pt, (client).available() > 0 || !(client).connected(), ms)
+
+#define PT_AWAIT_THREAD(pt, call) PT_WAIT_UNTIL(pt, (call) == PT_DONE)
+
+#endif // PROTOTHREAD_H
+// End of file
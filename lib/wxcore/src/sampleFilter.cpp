@@ -0,0 +1,48 @@
+/**
+ * @file sampleFilter.cpp
+ * @author Karl Berger
+ * @date 2025-07-04
+ * @brief Portable median and exponential moving average filter for sensor samples.
+ * @details Until the window is full the median is taken over the samples there
+ *          are, and the first sample sets the average directly.
+ */
+
+#include "sampleFilter.h"
+
+// median of up to FILTER_MEDIAN values, by insertion sort of a copy
+static float median(const float *values, int count)
+{
+	float sorted[FILTER_MEDIAN];
+	for (int i = 0; i < count; i++)
+	{
+		int j = i;
+		for (; j > 0 && sorted[j - 1] > values[i]; j--)
+		{
+			sorted[j] = sorted[j - 1];
+		}
+		sorted[j] = values[i];
+	}
+	return (count % 2) ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+} // median()
+
+float filterAdd(sampleFilter &filter, float sample)
+{
+	filter.window[filter.next] = sample;
+	filter.next = (filter.next + 1) % FILTER_MEDIAN;
+	bool first = (filter.count == 0);
+	if (filter.count < FILTER_MEDIAN)
+	{
+		filter.count++;
+	}
+	float middle = median(filter.window, filter.count);
+	filter.value = first ? middle : filter.value + filter.alpha * (middle - filter.value);
+	return filter.value;
+} // filterAdd()
+
+void filterReset(sampleFilter &filter)
+{
+	filter.count = 0;
+	filter.next = 0;
+} // filterReset()
+
+// End of file
@@ -0,0 +1,39 @@
+/**
+ * @file sampleFilter.h
+ * @author Karl Berger
+ * @date 2025-07-04
+ * @brief Portable median and exponential moving average filter for sensor samples.
+ *
+ * Each sample first goes through a median of the last FILTER_MEDIAN samples,
+ * which drops a single spike such as a bad I2C read, then into an exponential
+ * moving average that smooths the remaining noise. A larger alpha follows the
+ * samples more closely; 1 turns the average off.
+ *
+ * Functions:
+ * - filterAdd(filter, sample): Add a sample and return the filtered value.
+ * - filterReset(filter): Forget the samples, the next one starts the average.
+ */
+#ifndef SAMPLE_FILTER_H
+#define SAMPLE_FILTER_H
+
+#include <stdint.h> // fixed width types
+
+#define FILTER_MEDIAN 3 ///< samples in the median window
+
+struct sampleFilter
+{
+	float alpha;				 ///< EMA weight of a new median, 0 to 1
+	float window[FILTER_MEDIAN]; ///< last samples, oldest overwritten
+	uint8_t count;				 ///< samples in the window
+	uint8_t next;				 ///< window index of the next sample
+	float value;				 ///< filtered value, valid once count > 0
+};
+
+//! a filter with the given EMA weight
+#define SAMPLE_FILTER(alpha) {alpha, {0}, 0, 0, 0}
+
+float filterAdd(sampleFilter &filter, float sample); ///< add a sample, return the filtered value
+void filterReset(sampleFilter &filter);				 ///< forget the samples
+
+#endif // SAMPLE_FILTER_H
+// End of file
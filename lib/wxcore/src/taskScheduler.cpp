@@ -0,0 +1,174 @@
+/**
+ * @file taskScheduler.cpp
+ * @author Karl Berger
+ * @date 2025-06-26
+ * @brief Portable deadline-ordered task scheduler.
+ * @details A task is popped before it runs, so it may cancel or reschedule itself
+ *          or any other task from inside its function.
+ */
+
+#include "taskScheduler.h"
+
+static uint32_t stoppedClock()
+{
+	return 0;
+}
+
+static schedulerClock clockNow = stoppedClock; // replaced by setSchedulerClock()
+static taskRunner runner = nullptr;			   // optional wrapper around task.run()
+static scheduledTask *heap[SCHED_MAX_TASKS];   // heap[0] has the earliest deadline
+static int heapSize = 0;
+
+static bool earlier(const scheduledTask *a, const scheduledTask *b)
+{
+	return (int32_t)(a->due - b->due) < 0;
+}
+
+static void place(int slot, scheduledTask *task)
+{
+	heap[slot] = task;
+	task->slot = slot;
+}
+
+static void siftUp(int slot)
+{
+	scheduledTask *task = heap[slot];
+	while (slot > 0)
+	{
+		int parent = (slot - 1) / 2;
+		if (!earlier(task, heap[parent]))
+		{
+			break;
+		}
+		place(slot, heap[parent]);
+		slot = parent;
+	}
+	place(slot, task);
+} // siftUp()
+
+static void siftDown(int slot)
+{
+	scheduledTask *task = heap[slot];
+	while (true)
+	{
+		int child = 2 * slot + 1;
+		if (child >= heapSize)
+		{
+			break;
+		}
+		if (child + 1 < heapSize && earlier(heap[child + 1], heap[child]))
+		{
+			child++;
+		}
+		if (!earlier(heap[child], task))
+		{
+			break;
+		}
+		place(slot, heap[child]);
+		slot = child;
+	}
+	place(slot, task);
+} // siftDown()
+
+static void removeAt(int slot)
+{
+	heap[slot]->slot = -1;
+	heapSize--;
+	if (slot == heapSize)
+	{
+		return;
+	}
+	scheduledTask *moved = heap[heapSize]; // the last leaf fills the hole
+	place(slot, moved);
+	siftDown(slot);
+	siftUp(moved->slot);
+} // removeAt()
+
+void setSchedulerClock(schedulerClock clock)
+{
+	clockNow = clock;
+}
+
+void setTaskRunner(taskRunner wrapper)
+{
+	runner = wrapper;
+}
+
+bool taskSchedule(scheduledTask &task, uint32_t delay)
+{
+	if (task.slot >= 0)
+	{
+		removeAt(task.slot);
+	}
+	if (heapSize == SCHED_MAX_TASKS)
+	{
+		return false;
+	}
+	task.due = clockNow() + delay;
+	heap[heapSize] = &task;
+	task.slot = heapSize++;
+	siftUp(task.slot);
+	return true;
+} // taskSchedule()
+
+void taskCancel(scheduledTask &task)
+{
+	if (task.slot >= 0)
+	{
+		removeAt(task.slot);
+	}
+}
+
+bool taskScheduled(const scheduledTask &task)
+{
+	return task.slot >= 0;
+}
+
+uint32_t taskDueIn(const scheduledTask &task)
+{
+	if (task.slot < 0)
+	{
+		return TASK_NEVER;
+	}
+	int32_t wait = (int32_t)(task.due - clockNow());
+	return wait > 0 ? wait : 0;
+} // taskDueIn()
+
+uint32_t schedulerRun()
+{
+	while (heapSize > 0)
+	{
+		uint32_t now = clockNow();
+		scheduledTask *task = heap[0];
+		int32_t wait = (int32_t)(task->due - now);
+		if (wait > 0)
+		{
+			return wait;
+		}
+
+		removeAt(0);
+		uint32_t late = now - task->due;
+		if (task->period > 0)
+		{
+			// next deadline from the old one, not from now, so lateness does not drift
+			uint32_t missed = late / task->period;
+			task->skipped += missed;
+			task->due += (missed + 1) * task->period;
+			heap[heapSize] = task;
+			task->slot = heapSize++;
+			siftUp(task->slot);
+		}
+		task->runs++;
+		if (runner)
+		{
+			runner(*task, late);
+		}
+		else
+		{
+			task->run();
+		}
+	}
+	return TASK_NEVER;
+} // schedulerRun()
+
+// End of file
@@ -0,0 +1,69 @@
+/**
+ * @file taskScheduler.h
+ * @author Karl Berger
+ * @date 2025-06-26
+ * @brief Portable deadline-ordered task scheduler.
+ *
+ * Scheduled tasks are kept in a binary min-heap ordered by their next deadline,
+ * so finding the next task is O(1) and rescheduling is O(log n). schedulerRun()
+ * runs every task that is due and returns the time until the next deadline; the
+ * caller can sleep for that long instead of polling.
+ *
+ * A task with a period repeats at absolute deadlines (due += period), so late
+ * runs do not accumulate drift. If a task falls more than a whole period behind,
+ * the missed runs are skipped and the original phase is kept. A task with period
+ * 0 runs once.
+ *
+ * The clock is a millisecond counter supplied by the caller (millis() on the
+ * ESP8266, a fake clock on a host) and may roll over; deadlines are compared as
+ * signed differences and must lie within 24 days of each other.
+ *
+ * A runner installed with setTaskRunner() is called in place of each task's
+ * function, with how late the task is, so a platform can time its tasks.
+ *
+ * Functions:
+ * - setSchedulerClock(clock): Set the millisecond clock.
+ * - setTaskRunner(runner): Run tasks through a wrapper, nullptr to call them directly.
+ * - taskSchedule(task, delay): Schedule a task to run after delay ms.
+ * - taskCancel(task): Remove a task from the schedule.
+ * - taskScheduled(task): True if a task is waiting to run.
+ * - taskDueIn(task): Milliseconds until a task runs, TASK_NEVER if not scheduled.
+ * - schedulerRun(): Run due tasks, return milliseconds until the next one.
+ */
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <stdint.h> // fixed width types
+
+#define SCHED_MAX_TASKS 20		 ///< tasks that can be scheduled at once
+#define TASK_NEVER 0xFFFFFFFFUL ///< no deadline
+
+typedef void (*taskFunction)();		///< work done by a task
+typedef uint32_t (*schedulerClock)(); ///< millisecond clock
+struct scheduledTask;
+typedef void (*taskRunner)(scheduledTask &task, uint32_t lateMs); ///< calls task.run()
+
+struct scheduledTask
+{
+	const char *name;	///< task name for reports
+	taskFunction run;	///< called when due
+	uint32_t period;	///< milliseconds between runs, 0 for one-shot
+	uint32_t due;		///< clock time of the next run
+	int16_t slot;		///< heap position, -1 when not scheduled
+	uint32_t runs;		///< times run
+	uint32_t skipped;	///< periods missed because the task ran late
+};
+
+//! task definition: name, function, period in ms
+#define SCHEDULED_TASK(name, function, period) {name, function, period, 0, -1, 0, 0}
+
+void setSchedulerClock(schedulerClock clock);			 ///< set the millisecond clock
+void setTaskRunner(taskRunner runner);					 ///< wrap every task run
+bool taskSchedule(scheduledTask &task, uint32_t delay); ///< run after delay ms, false if the heap is full
+void taskCancel(scheduledTask &task);					 ///< remove from the schedule
+bool taskScheduled(const scheduledTask &task);			 ///< true if waiting to run
+uint32_t taskDueIn(const scheduledTask &task);			 ///< ms until the task runs
+uint32_t schedulerRun();								 ///< run due tasks, ms until the next one
+
+#endif // TASK_SCHEDULER_H
+// End of file
@@ -0,0 +1,197 @@
+/**
+ * @file tsPayload.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable ThingSpeak channel payload.
+ */
+
+#include "tsPayload.h"
+
+#include <stdio.h>	// snprintf()
+#include <string.h> // strncmp()
+
+void tsFields(const wxObservation &obs, float field[TS_FIELDS])
+{
+	field[0] = obs.temp;
+	field[1] = obs.humidity;
+	field[2] = obs.pressure;
+	field[3] = obs.windSpeed;
+	field[4] = obs.windDir;
+	field[5] = obs.solarRadiation;
+	field[6] = obs.precipTotal;
+	field[7] = obs.precipRate;
+} // tsFields()
+
+size_t tsFormatUpdate(char *out, size_t size, const char *writeKey, const wxObservation &obs, const char *status)
+{
+	float field[TS_FIELDS];
+	tsFields(obs, field);
+	int written = snprintf(out, size, "{\"api_key\":\"%s\",\"created_at\":%lu", writeKey, (unsigned long)obs.epoch);
+	size_t length = (written < 0) ? 0 : written;
+	for (int f = 0; f < TS_FIELDS && length < size; f++)
+	{
+		written = snprintf(out + length, size - length, ",\"field%d\":%.6g", f + 1, field[f]);
+		length += (written < 0) ? 0 : written;
+	}
+	if (length < size && status && status[0])
+	{
+		written = snprintf(out + length, size - length, ",\"status\":\"%s\"", status);
+		length += (written < 0) ? 0 : written;
+	}
+	if (length < size)
+	{
+		written = snprintf(out + length, size - length, "}");
+		length += (written < 0) ? 0 : written;
+	}
+	return length < size ? length : (size ? size - 1 : 0);
+} // tsFormatUpdate()
+
+size_t tsFormatBulkStart(char *out, size_t size, const char *writeKey)
+{
+	int written = snprintf(out, size, "{\"write_api_key\":\"%s\",\"updates\":[", writeKey);
+	size_t length = (written < 0) ? 0 : written;
+	return length < size ? length : (size ? size - 1 : 0);
+} // tsFormatBulkStart()
+
+size_t tsFormatBulkRow(char *out, size_t size, uint32_t epoch, const float field[TS_FIELDS], const char *status)
+{
+	int written = snprintf(out, size, "{\"created_at\":%lu", (unsigned long)epoch);
+	size_t length = (written < 0) ? 0 : written;
+	for (int f = 0; f < TS_FIELDS && length < size; f++)
+	{
+		written = snprintf(out + length, size - length, ",\"field%d\":%.6g", f + 1, field[f]);
+		length += (written < 0) ? 0 : written;
+	}
+	if (length < size && status && status[0])
+	{
+		written = snprintf(out + length, size - length, ",\"status\":\"%s\"", status);
+		length += (written < 0) ? 0 : written;
+	}
+	if (length < size)
+	{
+		written = snprintf(out + length, size - length, "}");
+		length += (written < 0) ? 0 : written;
+	}
+	return length < size ? length : (size ? size - 1 : 0);
+} // tsFormatBulkRow()
+
+/*
+ * A small JSON reader for the bulk reply: enough to walk the members of the
+ * top level object and step over any value, so "true" inside another member
+ * or a nested "success" is never taken for the answer.
+ */
+static const char *skipSpace(const char *p, const char *end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+	{
+		p++;
+	}
+	return p;
+} // skipSpace()
+
+// past the closing quote of the string starting at p, nullptr if unterminated
+static const char *skipString(const char *p, const char *end)
+{
+	for (p++; p < end; p++)
+	{
+		if (*p == '\\')
+		{
+			p++;
+		}
+		else if (*p == '"')
+		{
+			return p + 1;
+		}
+	}
+	return nullptr;
+} // skipString()
+
+// past the value starting at p, nullptr if malformed
+static const char *skipValue(const char *p, const char *end)
+{
+	if (p >= end)
+	{
+		return nullptr;
+	}
+	if (*p == '"')
+	{
+		return skipString(p, end);
+	}
+	if (*p == '{' || *p == '[')
+	{
+		int depth = 0;
+		while (p < end)
+		{
+			if (*p == '"')
+			{
+				p = skipString(p, end);
+				if (!p)
+				{
+					return nullptr;
+				}
+				continue;
+			}
+			depth += (*p == '{' || *p == '[') ? 1 : (*p == '}' || *p == ']') ? -1 : 0;
+			p++;
+			if (depth == 0)
+			{
+				return p;
+			}
+		}
+		return nullptr;
+	}
+	const char *start = p; // number or literal
+	while (p < end && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\r' && *p != '\n' && *p != '\t')
+	{
+		p++;
+	}
+	return p > start ? p : nullptr;
+} // skipValue()
+
+bool tsBulkAccepted(const char *body, size_t length)
+{
+	const char *end = body + length;
+	const char *p = skipSpace(body, end);
+	if (p >= end || *p != '{')
+	{
+		return false;
+	}
+	p = skipSpace(p + 1, end);
+	bool found = false;
+	bool success = false;
+	while (p < end && *p == '"')
+	{
+		const char *key = p + 1;
+		p = skipString(p, end);
+		if (!p)
+		{
+			return false;
+		}
+		bool isSuccess = (size_t)(p - 1 - key) == 7 && strncmp(key, "success", 7) == 0;
+		p = skipSpace(p, end);
+		if (p >= end || *p != ':')
+		{
+			return false;
+		}
+		p = skipSpace(p + 1, end);
+		const char *value = p;
+		p = skipValue(p, end);
+		if (!p)
+		{
+			return false;
+		}
+		if (isSuccess && !found)
+		{
+			found = true;
+			success = p - value == 4 && strncmp(value, "true", 4) == 0;
+		}
+		p = skipSpace(p, end);
+		if (p < end && *p == ',')
+		{
+			p = skipSpace(p + 1, end);
+		}
+	}
+	return success && p < end && *p == '}'; // a reply cut short is not an answer
+} // tsBulkAccepted()
+
+// End of file
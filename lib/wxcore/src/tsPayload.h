@@ -0,0 +1,56 @@
+/**
+ * @file tsPayload.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable ThingSpeak channel payload.
+ *
+ * The channel layout is fixed so every uploader writes the same fields:
+ * 1 temperature (°C), 2 humidity (%), 3 pressure (hPa), 4 wind speed (km/h),
+ * 5 wind direction (degrees), 6 solar radiation (W/m^2), 7 rain today (mm),
+ * 8 rain rate (mm/h).
+ *
+ * Functions:
+ * - tsFields(obs, field): Fill the eight channel fields from an observation.
+ * - tsFormatUpdate(out, size, writeKey, obs, status): JSON body for update.json.
+ * - tsFormatBulkStart(out, size, writeKey): Opening of a bulk_update.json body.
+ * - tsFormatBulkRow(out, size, epoch, field, status): One row of the updates array.
+ * - tsBulkAccepted(body, length): True if a bulk_update.json reply says "success":true.
+ *
+ * A bulk body is tsFormatBulkStart(), the rows separated by commas, then
+ * TS_BULK_END, so a sender can stream rows without holding the whole body.
+ */
+#ifndef TS_PAYLOAD_H
+#define TS_PAYLOAD_H
+
+#include <stddef.h>	 // size_t
+#include "wxModel.h" // wxObservation
+
+#define TS_FIELDS 8			 ///< fields per channel row
+#define TS_UPDATE_MAX 320	 ///< buffer size that holds any update body
+#define TS_BULK_ROW_MAX 320	 ///< buffer size that holds any bulk row
+#define TS_BULK_END "]}"	 ///< closes a bulk body
+
+void tsFields(const wxObservation &obs, float field[TS_FIELDS]); ///< channel fields 1 - 8
+
+/**
+ * @brief JSON body for a single row POST to /update.json.
+ * @param status channel status text, may be empty; must not need JSON escaping
+ */
+size_t tsFormatUpdate(char *out, size_t size, const char *writeKey, const wxObservation &obs, const char *status);
+
+size_t tsFormatBulkStart(char *out, size_t size, const char *writeKey); ///< {"write_api_key":"...","updates":[
+
+/**
+ * @brief One object of the bulk updates array, created_at in epoch seconds.
+ * @param status channel status text, may be empty or nullptr; must not need JSON escaping
+ */
+size_t tsFormatBulkRow(char *out, size_t size, uint32_t epoch, const float field[TS_FIELDS], const char *status);
+
+/**
+ * @brief Read the reply of bulk_update.json.
+ * @return true only if the top level object has "success" with the literal true
+ */
+bool tsBulkAccepted(const char *body, size_t length);
+
+#endif // TS_PAYLOAD_H
+// End of file
@@ -0,0 +1,93 @@
+/**
+ * @file tzRules.cpp
+ * @author Karl Berger
+ * @date 2025-07-03
+ * @brief Built-in POSIX TZ rules for common Olson timezones.
+ * @details Fixed-size rows so the ESP8266 can keep the table in flash and copy
+ *          one row at a time; about 2.5 kB of flash and no RAM.
+ */
+
+#include "tzRules.h"
+
+#include <string.h> // strcmp, strcpy, strlen
+
+#ifdef ARDUINO_ARCH_ESP8266
+#include <pgmspace.h> // keep the table in flash
+#else
+#define PROGMEM
+#define memcpy_P memcpy
+#endif
+
+struct tzRule
+{
+	char olson[TZ_OLSON_SIZE]; // Olson name
+	char posix[TZ_POSIX_SIZE]; // POSIX TZ rule
+};
+
+// the zones listed in credentials.cpp and a few more, from tzdata 2025b
+static const tzRule TZ_RULES[] PROGMEM = {
+	{"America/New_York",    "EST5EDT,M3.2.0,M11.1.0"},
+	{"America/Chicago",     "CST6CDT,M3.2.0,M11.1.0"},
+	{"America/Denver",      "MST7MDT,M3.2.0,M11.1.0"},
+	{"America/Phoenix",     "MST7"},
+	{"America/Los_Angeles", "PST8PDT,M3.2.0,M11.1.0"},
+	{"America/Anchorage",   "AKST9AKDT,M3.2.0,M11.1.0"},
+	{"America/Juneau",      "AKST9AKDT,M3.2.0,M11.1.0"},
+	{"Pacific/Honolulu",    "HST10"},
+	{"America/St_Johns",    "NST3:30NDT,M3.2.0,M11.1.0"},
+	{"America/Halifax",     "AST4ADT,M3.2.0,M11.1.0"},
+	{"America/Puerto_Rico", "AST4"},
+	{"America/Toronto",     "EST5EDT,M3.2.0,M11.1.0"},
+	{"America/Winnipeg",    "CST6CDT,M3.2.0,M11.1.0"},
+	{"America/Regina",      "CST6"},
+	{"America/Edmonton",    "MST7MDT,M3.2.0,M11.1.0"},
+	{"America/Vancouver",   "PST8PDT,M3.2.0,M11.1.0"},
+	{"America/Mexico_City", "CST6"},
+	{"Europe/London",       "GMT0BST,M3.5.0/1,M10.5.0"},
+	{"Europe/Lisbon",       "WET0WEST,M3.5.0/1,M10.5.0"},
+	{"Europe/Berlin",       "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Paris",        "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Madrid",       "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Rome",         "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Amsterdam",    "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Stockholm",    "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Warsaw",       "CET-1CEST,M3.5.0,M10.5.0/3"},
+	{"Europe/Athens",       "EET-2EEST,M3.5.0/3,M10.5.0/4"},
+	{"Europe/Helsinki",     "EET-2EEST,M3.5.0/3,M10.5.0/4"},
+	{"Europe/Moscow",       "MSK-3"},
+	{"Africa/Lagos",        "WAT-1"},
+	{"Africa/Johannesburg", "SAST-2"},
+	{"Asia/Kolkata",        "IST-5:30"},
+	{"Asia/Hong_Kong",      "HKT-8"},
+	{"Asia/Shanghai",       "CST-8"},
+	{"Asia/Seoul",          "KST-9"},
+	{"Asia/Tokyo",          "JST-9"},
+	{"Australia/Perth",     "AWST-8"},
+	{"Australia/Adelaide",  "ACST-9:30ACDT,M10.1.0,M4.1.0/3"},
+	{"Australia/Brisbane",  "AEST-10"},
+	{"Australia/Sydney",    "AEST-10AEDT,M10.1.0,M4.1.0/3"},
+	{"Australia/Melbourne", "AEST-10AEDT,M10.1.0,M4.1.0/3"},
+	{"Pacific/Auckland",    "NZST-12NZDT,M9.5.0,M4.1.0/3"},
+	{"UTC",                 "UTC0"},
+};
+
+bool tzPosixRule(const char *olson, char *posix, size_t size)
+{
+	tzRule row;
+	for (size_t i = 0; i < sizeof(TZ_RULES) / sizeof(TZ_RULES[0]); i++)
+	{
+		memcpy_P(&row, &TZ_RULES[i], sizeof(row));
+		if (strcmp(row.olson, olson) == 0)
+		{
+			if (strlen(row.posix) >= size)
+			{
+				return false; // a cut-off rule would be a different rule
+			}
+			strcpy(posix, row.posix);
+			return true;
+		}
+	}
+	return false;
+} // tzPosixRule()
+
+// End of file
@@ -0,0 +1,31 @@
+/**
+ * @file tzRules.h
+ * @author Karl Berger
+ * @date 2025-07-03
+ * @brief Built-in POSIX TZ rules for common Olson timezones.
+ *
+ * ezTime's setLocation() asks the ezTime timezone server for the rule of an
+ * Olson name, a network round trip at every boot unless the EEPROM cache
+ * matches. This table gives the same rule from flash, so setPosix() can be
+ * used instead and the server is only asked about zones not listed here.
+ *
+ * The rules are the footer lines of the tzdata TZif files, which describe the
+ * present rule of each zone:  tail -1 /usr/share/zoneinfo/America/New_York
+ * Zones whose rule uses quoted names such as <+04>-4, or a transition hour
+ * past 23, are left out because ezTime does not parse them.
+ *
+ * Functions:
+ * - tzPosixRule(olson, posix, size): Copy the POSIX rule of an Olson name.
+ */
+#ifndef TZ_RULES_H
+#define TZ_RULES_H
+
+#include <stddef.h> // size_t
+
+#define TZ_OLSON_SIZE 24 ///< longest Olson name in the table, plus the terminator
+#define TZ_POSIX_SIZE 36 ///< longest rule in the table, plus the terminator
+
+bool tzPosixRule(const char *olson, char *posix, size_t size); ///< false if the zone is not listed or the rule does not fit
+
+#endif // TZ_RULES_H
+// End of file
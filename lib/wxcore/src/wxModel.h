@@ -0,0 +1,37 @@
+/**
+ * @file wxModel.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable weather observation shared by the firmware and the gateway.
+ *
+ * Plain data with no Arduino types, so the same formatting code runs on the
+ * ESP8266 and on Linux. All values are metric, as delivered by the Weather
+ * Underground API with units=m.
+ */
+#ifndef WX_MODEL_H
+#define WX_MODEL_H
+
+#include <stdint.h> // fixed width types
+
+struct wxObservation
+{
+	uint32_t epoch;		  ///< observation time (unix time UTC)
+	float lat;			  ///< station latitude in decimal degrees
+	float lon;			  ///< station longitude in decimal degrees
+	float solarRadiation; ///< luminosity (W/m^2)
+	float uv;			  ///< UV index
+	float humidity;		  ///< relative humidity (%)
+	float dewPt;		  ///< dewpoint (°C)
+	float temp;			  ///< temperature (°C)
+	float heatIndex;	  ///< temperature feel (°C)
+	float windChill;	  ///< temperature feel (°C)
+	float windDir;		  ///< degrees clockwise from north
+	float windSpeed;	  ///< km/h
+	float windGust;		  ///< km/h
+	float pressure;		  ///< sea level pressure (hPa)
+	float precipRate;	  ///< mm/h
+	float precipTotal;	  ///< mm since local midnight
+};
+
+#endif // WX_MODEL_H
+// End of file
@@ -0,0 +1,146 @@
+/**
+ * @file wxParse.cpp
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable parser for the Weather Underground current observation.
+ * @details A single pass scanner rather than a JSON library: it tracks nesting
+ *          depth, remembers the last key and stores numbers whose key is known.
+ *          The names used by the observation and its "metric" object do not
+ *          overlap, so the key alone identifies each value.
+ */
+
+#include "wxParse.h"
+
+#include <stdlib.h> // strtod()
+#include <string.h> // strcmp(), memset()
+
+#define KEY_MAX 24 // longest key kept
+
+struct fieldName
+{
+	const char *key;
+	float wxObservation::*member;
+};
+
+const fieldName FIELDS[] = {
+	{"lat", &wxObservation::lat},
+	{"lon", &wxObservation::lon},
+	{"solarRadiation", &wxObservation::solarRadiation},
+	{"uv", &wxObservation::uv},
+	{"humidity", &wxObservation::humidity},
+	{"winddir", &wxObservation::windDir},
+	{"temp", &wxObservation::temp},
+	{"heatIndex", &wxObservation::heatIndex},
+	{"dewpt", &wxObservation::dewPt},
+	{"windChill", &wxObservation::windChill},
+	{"windSpeed", &wxObservation::windSpeed},
+	{"windGust", &wxObservation::windGust},
+	{"pressure", &wxObservation::pressure},
+	{"precipRate", &wxObservation::precipRate},
+	{"precipTotal", &wxObservation::precipTotal},
+};
+const int FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+static void storeNumber(wxObservation &obs, const char *key, double value)
+{
+	if (strcmp(key, "epoch") == 0)
+	{
+		obs.epoch = (uint32_t)value;
+		return;
+	}
+	for (int i = 0; i < FIELD_COUNT; i++)
+	{
+		if (strcmp(key, FIELDS[i].key) == 0)
+		{
+			obs.*FIELDS[i].member = (float)value;
+			return;
+		}
+	}
+} // storeNumber()
+
+bool wxParseCurrent(const char *json, size_t length, wxObservation &obs)
+{
+	memset(&obs, 0, sizeof(obs));
+	char key[KEY_MAX + 1] = "";
+	bool haveKey = false;	 // a key was read and its value is next
+	bool inArray = false;	 // inside "observations"
+	int depth = 0;			 // object nesting
+	int observationDepth = 0; // depth of the first observation object, 0 before it
+	const char *end = json + length;
+
+	for (const char *p = json; p < end; p++)
+	{
+		char c = *p;
+		if (c == '"')
+		{
+			const char *start = ++p;
+			while (p < end && *p != '"')
+			{
+				p += (*p == '\\') ? 2 : 1; // escaped character
+			}
+			if (p >= end)
+			{
+				break;
+			}
+			const char *next = p + 1;
+			while (next < end && (*next == ' ' || *next == '\t' || *next == '\r' || *next == '\n'))
+			{
+				next++;
+			}
+			if (next < end && *next == ':')
+			{
+				size_t keyLength = p - start;
+				keyLength = keyLength < KEY_MAX ? keyLength : KEY_MAX;
+				memcpy(key, start, keyLength);
+				key[keyLength] = '\0';
+				haveKey = true;
+				p = next;
+			}
+			else
+			{
+				haveKey = false; // a string value
+			}
+		}
+		else if (c == '{')
+		{
+			depth++;
+			if (inArray && observationDepth == 0)
+			{
+				observationDepth = depth;
+			}
+			haveKey = false;
+		}
+		else if (c == '}')
+		{
+			if (observationDepth != 0 && depth == observationDepth)
+			{
+				break; // end of the first observation
+			}
+			depth--;
+			haveKey = false;
+		}
+		else if (c == '[')
+		{
+			inArray = inArray || (haveKey && strcmp(key, "observations") == 0);
+			haveKey = false;
+		}
+		else if (haveKey && (c == '-' || (c >= '0' && c <= '9')))
+		{
+			char *after;
+			double value = strtod(p, &after);
+			if (observationDepth != 0)
+			{
+				storeNumber(obs, key, value);
+			}
+			p = after - 1;
+			haveKey = false;
+		}
+		else if (c == ',' || c == ']')
+		{
+			haveKey = false; // null, true, false or end of a value
+		}
+	}
+	return obs.lat != 0;
+} // wxParseCurrent()
+
+// End of file
@@ -0,0 +1,24 @@
+/**
+ * @file wxParse.h
+ * @author Karl Berger
+ * @date 2025-06-21
+ * @brief Portable parser for the Weather Underground current observation.
+ *
+ * Reads the response of v2/pws/observations/current (format=json, units=m)
+ * from a complete buffer without allocating. The buffer must end in a non-digit,
+ * as any complete JSON document does. Only the first observation is
+ * read. Unknown keys are skipped, so the API may add fields freely.
+ *
+ * Functions:
+ * - wxParseCurrent(json, length, obs): Fill obs, true if a station position was found.
+ */
+#ifndef WX_PARSE_H
+#define WX_PARSE_H
+
+#include <stddef.h>	 // size_t
+#include "wxModel.h" // wxObservation
+
+bool wxParseCurrent(const char *json, size_t length, wxObservation &obs); ///< parse the first observation
+
+#endif // WX_PARSE_H
+// End of file
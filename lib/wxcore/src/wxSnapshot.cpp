@@ -0,0 +1,73 @@
+/**
+ * @file wxSnapshot.cpp
+ * @author Karl Berger
+ * @date 2025-06-20
+ * @brief Portable wire format of the weather snapshots shared between displays.
+ * @details Observation values are scaled integers to keep the snapshot near
+ *          150 bytes, well inside one datagram. The struct is packed, so the
+ *          forecast fields are compared byte for byte.
+ */
+
+#include "wxSnapshot.h"
+
+#include <string.h> // memcmp, memcpy
+
+static uint16_t crc16(const uint8_t *data, size_t length)
+{
+	uint16_t crc = 0xFFFF;
+	while (length--)
+	{
+		crc ^= (uint16_t)*data++ << 8;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+		}
+	}
+	return crc;
+} // crc16()
+
+void snapshotSeal(wxSnapshot &snap, uint32_t sequence)
+{
+	snap.magic = SNAPSHOT_MAGIC;
+	snap.version = SNAPSHOT_VERSION;
+	snap.length = sizeof(wxSnapshot);
+	snap.sequence = sequence;
+	snap.crc = crc16((const uint8_t *)&snap, offsetof(wxSnapshot, crc));
+} // snapshotSeal()
+
+snapshotKind snapshotReceive(const uint8_t *packet, size_t length, wxSnapshot &last)
+{
+	wxSnapshot snap;
+	if (length < sizeof(snap))
+	{
+		return SNAPSHOT_REJECTED;
+	}
+	memcpy(&snap, packet, sizeof(snap)); // a longer snapshot from a newer minor revision: the known prefix
+	if (snap.magic != SNAPSHOT_MAGIC || snap.version != SNAPSHOT_VERSION || snap.length > length ||
+		snap.length < sizeof(snap) ||
+		crc16(packet, snap.length - 2) != (packet[snap.length - 2] | (packet[snap.length - 1] << 8)))
+	{
+		return SNAPSHOT_REJECTED;
+	}
+
+	const size_t FORECAST = offsetof(wxSnapshot, tempMax);
+	const size_t FORECAST_SIZE = offsetof(wxSnapshot, crc) - FORECAST;
+	snapshotKind kind;
+	if (last.magic != SNAPSHOT_MAGIC || snap.obsEpoch != last.obsEpoch)
+	{
+		kind = SNAPSHOT_OBSERVATION;
+	}
+	else if (snap.flags != last.flags ||
+			 memcmp((const uint8_t *)&snap + FORECAST, (const uint8_t *)&last + FORECAST, FORECAST_SIZE) != 0)
+	{
+		kind = SNAPSHOT_FORECAST_UPDATE;
+	}
+	else
+	{
+		kind = SNAPSHOT_HEARTBEAT;
+	}
+	last = snap;
+	return kind;
+} // snapshotReceive()
+
+// End of file
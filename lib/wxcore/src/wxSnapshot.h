@@ -0,0 +1,81 @@
+/**
+ * @file wxSnapshot.h
+ * @author Karl Berger
+ * @date 2025-06-20
+ * @brief Portable wire format of the weather snapshots shared between displays.
+ *
+ * A snapshot is one UDP datagram, little endian: magic "WUGS", version, flags,
+ * length, sequence, observation, forecast, CRC-16. A newer minor revision may
+ * append fields before the CRC; receivers read the fields they know. A change
+ * to existing fields must raise SNAPSHOT_VERSION.
+ *
+ * The leader numbers every snapshot, heartbeats included, so the sequence
+ * tells nothing about the content. snapshotReceive() checks a datagram and
+ * compares it with the last one accepted: a new observation time is a new
+ * observation, the same time with a different forecast is a forecast update,
+ * and anything else is a heartbeat that only shows the leader is alive.
+ *
+ * Functions:
+ * - snapshotSeal(snap, sequence): Fill in magic, version, length, sequence and CRC.
+ * - snapshotReceive(packet, length, last): Check a datagram and classify it against the last one.
+ */
+#ifndef WX_SNAPSHOT_H
+#define WX_SNAPSHOT_H
+
+#include <stddef.h> // size_t
+#include <stdint.h> // fixed width types
+
+#define SNAPSHOT_VERSION 1			  ///< snapshot format version
+#define SNAPSHOT_MAGIC 0x53475557UL ///< "WUGS"
+#define QUERY_MAGIC 0x51475557UL	  ///< "WUGQ" follower asks for a snapshot
+#define SNAPSHOT_FORECAST 0x01		  ///< flags: forecast fields are valid
+
+struct __attribute__((packed)) wxSnapshot
+{
+	uint32_t magic;
+	uint8_t version;
+	uint8_t flags;
+	uint16_t length; ///< bytes up to and including crc
+	uint32_t sequence;
+	// observation
+	uint32_t obsEpoch;
+	int32_t lat;		   ///< degrees x 100000
+	int32_t lon;		   ///< degrees x 100000
+	int16_t temp;		   ///< Celsius x 10
+	int16_t dewPt;		   ///< Celsius x 10
+	int16_t heatIndex;	   ///< Celsius x 10
+	int16_t windChill;	   ///< Celsius x 10
+	uint16_t humidity;	   ///< % x 10
+	uint16_t pressure;	   ///< hPa x 10
+	uint16_t windDir;	   ///< degrees
+	uint16_t windSpeed;	   ///< km/h x 10
+	uint16_t windGust;	   ///< km/h x 10
+	uint16_t precipRate;   ///< mm/h x 10
+	uint16_t precipTotal;  ///< mm x 10
+	uint16_t solar;		   ///< W/m^2 x 10
+	uint16_t uv;		   ///< index x 10
+	char neighborhood[32]; ///< NUL padded
+	// forecast
+	int8_t tempMax;
+	int8_t tempMin;
+	uint8_t cloud;
+	uint32_t sunRise;
+	uint32_t sunSet;
+	char phraseShort[13];
+	char phraseLong[33];
+	uint16_t crc; ///< CRC-16/CCITT of everything before it
+};
+
+enum snapshotKind
+{
+	SNAPSHOT_REJECTED,		  ///< bad magic, version, length or CRC
+	SNAPSHOT_HEARTBEAT,		  ///< nothing new
+	SNAPSHOT_FORECAST_UPDATE, ///< same observation, new forecast
+	SNAPSHOT_OBSERVATION	  ///< a new observation
+};
+
+void snapshotSeal(wxSnapshot &snap, uint32_t sequence);						   ///< finish a snapshot for sending
+snapshotKind snapshotReceive(const uint8_t *packet, size_t length, wxSnapshot &last); ///< last is replaced when accepted
+
+#endif // WX_SNAPSHOT_H
+// End of file
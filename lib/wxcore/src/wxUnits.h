@@ -0,0 +1,25 @@
+/**
+ * @file wxUnits.h
+ * @author Karl W. Berger
+ * @date 2025-06-21
+ * @brief Portable unit conversions.
+ */
+#ifndef WX_UNITS_H
+#define WX_UNITS_H
+
+float CtoF(float tempC);     ///< convert Celsius to Fahrenheit
+float MStoMPH(float ms);     ///< convert meters per second to miles per hour
+float MMtoIN(float mm);      ///< convert millimeters to inches
+float CMtoIN(float cm);      ///< convert centimeters to inches
+float KMtoMILES(float km);   ///< convert kilometers to miles or km/h to mph
+float DEGtoRAD(float deg);   ///< convert degrees to radians
+float HPAtoINHG(float hpa);  ///< convert hectoPascal (millibar) to inches of mercury
+float MtoFT(float meters);   ///< convert meters to feet
+float KMHtoKNOTS(float kmh); ///< convert kilometers per hour to knots
+float FtoC(float tempF);     ///< convert Fahrenheit to Celsius
+float MPHtoKMH(float mph);   ///< convert miles per hour to kilometers per hour
+float INtoMM(float inches);  ///< convert inches to millimeters
+float INHGtoHPA(float inHg); ///< convert inches of mercury to hectoPascal (millibar)
+
+#endif // WX_UNITS_H
+// End of file
@@ -90,9 +90,9 @@ void analogClockFrame(bool drawFrame)
     tft.setTextDatum(TR_DATUM); // flush right
     tft.drawString((myTZ.hour() > 12) ? "PM" : "AM", 126, 0);
 
-    if (!DIGITAL_CLOCK && indoorSensor) // if indoor sensor exists & no digital clock
+    if (!DIGITAL_CLOCK && indoorSensor && indoorReady()) // if indoor sensor exists & no digital clock
     {
-      readSensor();
+      // cached by taskIndoorSensor, no I2C while drawing
       tft.setTextColor(C_ANALOG_INDOOR, C_ANALOG_DIAL_BG); // print over dial
       String temp = (METRIC_DISPLAY) ? String(indoor.tempC, 1) + " C" : String(CtoF(indoor.tempC), 0) + " F";
       tft.setTextDatum(TC_DATUM);
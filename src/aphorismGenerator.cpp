@@ -59,12 +59,21 @@ void mountFS()
     DEBUG_PRINTLN("FS failed to open file");
   }
   /************** Count Lines in File *******************/
+  // count newlines a block at a time; a last line without one counts too
   int lineCount = 0;
-  while (file.available())
+  char block[256];
+  char last = '\n';
+  size_t length;
+  while ((length = file.read((uint8_t *)block, sizeof(block))) > 0)
   {
-    file.readStringUntil('\n');
-    lineCount++;
+    for (size_t i = 0; i < length; i++)
+    {
+      lineCount += (block[i] == '\n');
+    }
+    last = block[length - 1];
+    yield(); // Wi-Fi associates meanwhile
   }
+  lineCount += (last != '\n');
   file.close();
 
   DEBUG_PRINT("FS: ");
@@ -8,12 +8,18 @@
 #include "aprsService.h"
 
 #include <Arduino.h>		   // Arduino functions
-#include <WiFiClient.h>		   // APRS connection
 #include "aphorismGenerator.h" // aphorism generator for bulletins
+#include <aprsFormat.h>		   // packet formatting from lib/wxcore
+#include "connectionPool.h"	   // shared keep-alive sockets
+#include <coroutine.h>		   // protothreads from lib/wxcore
 #include "credentials.h"	   // APRS, Wi-Fi and weather station credentials
+#include "endpointPolicy.h"	   // retry and circuit breaker
+#include "netTiming.h"		   // phase timing
+#include "taskControl.h"	   // finishCoroutine()
 #include "timeFunctions.h"	   // time functions
 #include "unitConversions.h"   // unit conversion functions
 #include "weatherService.h"	   // weather data
+#include "wxHistory.h"		   // rolling 24 hour rainfall
 #include "wug_debug.h"		   // debug print
 
 //! ***************** APRS *******************
@@ -32,11 +38,20 @@ const char *APRS_DEVICE_NAME = "https://w4krl.com/iot-kits/"; // link to my webs
 #define APRS_PORT 14580										  // do not change port
 #define APRS_TIMEOUT 2000L									  // milliseconds
 
+//! back off 5 s doubling to 10 min, open the circuit for 10 min after 3 failures
+const retryPolicy APRS_POLICY = {5000UL, 600000UL, 3, 600000UL};
+String aprsPending = ""; // message waiting for a retry
+
+static bool aprsRetryPending()
+{
+	return !aprsPending.isEmpty();
+}
+
+endpointHealth aprsHealth = ENDPOINT_HEALTH_RETRIED("aprs", APRS_POLICY, aprsRetryPending);
+
 //! ************ APRS Bulletin globals ***************
 // int *lineArray;				 // holds shuffled index to aphorisms
 int lineCount;				 // number of aphorisms in file
-bool amBulletinSent = false; // APRS morning bulletin
-bool pmBulletinSent = false; // APRS evening bulletin
 int lineIndex = 1;			 // APRS bulletin index
 
 /*
@@ -44,74 +59,153 @@ int lineIndex = 1;			 // APRS bulletin index
 **************** Post data to APRS-IS *****************
 *******************************************************
 */
-void postToAPRS(String message)
+// one APRS-IS exchange; only this state survives the waits of aprsPost()
+struct aprsSession
+{
+	String message;		// packet being posted
+	String queued;		// newer packet that arrived while posting
+	WiFiClient *client; // pooled socket
+	bool reused;		// the session was already logged on
+	String line;		// server line being assembled
+};
+aprsSession aprs;
+
+// record a failed post and keep the message for retryAPRSpost()
+static void aprsFailed()
+{
+	netTimingEndFor(NET_APRS, false);
+	policyFailure(aprsHealth);
+	aprsPending = aprs.message;
+} // aprsFailed()
+
+// a verified logon reply, not "unverified"
+static bool logonVerified(const String &line)
+{
+	return line.indexOf("verified") != -1 && line.indexOf("unverified") == -1;
+}
+
+// the post as a protothread: the banner and logon replies are awaited, not polled
+static ptState aprsPost(protothread *pt)
 {
 	// 12/20/2024
 	// See http://www.aprs-is.net/Connecting.aspx
 	// user mycall[-ss] pass passcode[ vers softwarename softwarevers[ UDP udpport][ servercommand]]
+	PT_BEGIN(pt);
 
-	// Create a WiFiClient object to handle the connection to the APRS server
-	WiFiClient client;
-	if (client.connect(APRS_SERVER, APRS_PORT))
+	if (!policyAllow(aprsHealth))
 	{
-		DEBUG_PRINTLN(F("APRS connected"));
+		DEBUG_PRINTLN(F("APRS: backing off"));
+		aprsPending = aprs.message; // newest message waits for the retry
+		PT_EXIT(pt);
 	}
-	else
+
+	// The pool keeps the verified APRS-IS session open between posts
+	netTimingBegin(NET_APRS);
+	// a post waits out the rate limit, then for the next observation
+	aprs.client = acquireConnection(APRS_SERVER, APRS_PORT, false, aprs.reused,
+									(WX_APRS_INTERVAL + WX_CURRENT_INTERVAL) * 60000UL);
+	if (aprs.client == nullptr)
 	{
 		DEBUG_PRINTLN(F("APRS connection failed."));
+		aprsFailed();
+		PT_EXIT(pt);
 	}
 
-	String rcvLine = client.readStringUntil('\n');
-	DEBUG_PRINTLN("Rcvd: " + rcvLine);
-	if (rcvLine.indexOf("full") > 0)
+	if (aprs.reused)
+	{
+		DEBUG_PRINTLN(F("APRS session reused"));
+	}
+	else
 	{
-		DEBUG_PRINTLN(F("APRS port full. Retrying."));
-		client.stop(); // disconnect from port
-		delay(500);
-		if (client.connect(APRS_SERVER, APRS_PORT)) // retry
+		DEBUG_PRINTLN(F("APRS connected"));
+		aprs.line = "";
+		PT_AWAIT(pt, readLine(*aprs.client, aprs.line) || !aprs.client->connected(), APRS_TIMEOUT);
+		netTimingMarkFor(NET_APRS, NET_PHASE_FIRST_BYTE); // server banner
+		DEBUG_PRINTLN("Rcvd: " + aprs.line);
+		if (aprs.line.indexOf("full") > 0)
 		{
-			DEBUG_PRINTLN(F("APRS reconnected successfully."));
+			DEBUG_PRINTLN(F("APRS port full. Will retry."));
+			releaseConnection(aprs.client, false); // disconnect from port
+			aprsFailed();						   // retried after the backoff instead of blocking
+			PT_EXIT(pt);
 		}
-		else
+
+		// send APRS-IS logon info
+		aprs.line = "user " + CALLSIGN + " pass " + APRS_PASSCODE;
+		aprs.line += " vers IoT-Kits " + APRS_SOFTWARE_VERS; // softwarevers
+		aprs.client->println(aprs.line);					  // send to APRS-IS
+		DEBUG_PRINTLN("APRS logon: " + aprs.line);
+
+		// one timeout for the whole reply; server comment lines may come first
+		pt->wakeAt = ptClock() + APRS_TIMEOUT;
+		do
 		{
-			DEBUG_PRINTLN(F("APRS reconnection failed."));
-			return; // Exit if reconnection fails
+			aprs.line = "";
+			PT_WAIT_UNTIL(pt, readLine(*aprs.client, aprs.line) || !aprs.client->connected() || PT_EXPIRED(pt));
+			DEBUG_PRINTLN("Rcvd: " + aprs.line);
+		} while (!logonVerified(aprs.line) && aprs.client->connected() && !PT_EXPIRED(pt));
+
+		if (!logonVerified(aprs.line))
+		{
+			DEBUG_PRINTLN("APRS user unverified.");
+			releaseConnection(aprs.client, false);
+			aprsFailed();
+			PT_EXIT(pt);
 		}
 	}
 
-	// send APRS-IS logon info
-	String dataString = "user " + CALLSIGN + " pass " + APRS_PASSCODE;
-	dataString += " vers IoT-Kits " + APRS_SOFTWARE_VERS; // softwarevers
-	client.println(dataString);							  // send to APRS-IS
-	DEBUG_PRINTLN("APRS logon: " + dataString);
+	DEBUG_PRINTLN("APRS send: " + aprs.message);
+	aprs.client->println(aprs.message);
+	netTimingMarkFor(NET_APRS, NET_PHASE_BODY); // logon and packet
+	releaseConnection(aprs.client, true);		// stay logged on for the next post
+	netTimingEndFor(NET_APRS, true);
+	policySuccess(aprsHealth);
+	aprsPending = "";
+	DEBUG_PRINTLN("APRS done.");
+	PT_END(pt);
+} // aprsPost()
+
+coroutine aprsCoroutine = COROUTINE("aprs", aprsPost);
 
-	boolean verified = false;
-	unsigned long timeBegin = millis();
-	while (!verified && (millis() - timeBegin < APRS_TIMEOUT))
+void postToAPRS(String message)
+{
+	if (coActive(aprsCoroutine))
 	{
-		if (client.available())
-		{
-			String rcvLine = client.readStringUntil('\n');
-			DEBUG_PRINTLN("Rcvd: " + rcvLine);
-			if (rcvLine.indexOf("verified") != -1 && rcvLine.indexOf("unverified") == -1)
-			{
-				verified = true;
-			}
-		}
-		yield(); // Allow other tasks to run
+		aprs.queued = message; // posted by retryAPRSpost() when this one is done
+		return;
 	}
+	aprs.message = message;
+	coStart(aprsCoroutine);
+} // postToAPRS()
 
-	if (!verified)
+void retryAPRSpost()
+{
+	if (coActive(aprsCoroutine))
 	{
-		DEBUG_PRINTLN("APRS user unverified.");
 		return;
 	}
+	if (!aprs.queued.isEmpty())
+	{
+		String message = aprs.queued;
+		aprs.queued = "";
+		postToAPRS(message);
+	}
+	else if (!aprsPending.isEmpty() && policyRetryDue(aprsHealth))
+	{
+		String message = aprsPending;
+		postToAPRS(message);
+	}
+} // retryAPRSpost()
 
-	DEBUG_PRINTLN("APRS send: " + message);
-	client.println(message);
-	client.stop(); // disconnect from APRS-IS server
-	DEBUG_PRINTLN("APRS done.");
-} // postToAPRS()
+void finishAPRSpost()
+{
+	finishCoroutine(aprsCoroutine);
+}
+
+bool APRSpending()
+{
+	return !aprsPending.isEmpty() || !aprs.queued.isEmpty() || coActive(aprsCoroutine);
+}
 
 /*
 *******************************************************
@@ -120,35 +214,16 @@ void postToAPRS(String message)
 */
 String APRSformatWeather()
 {
-	/* page 65 http://www.aprs.org/doc/APRS101.PDF
-	   Using Complete Weather Report Format — with Lat/Long position, no Timestamp pg 75
-	   ________________________________________________________________
-	   |!|Lat|/|Lon|_|Wind Dir|/|Wind Speed|Weather Data|Software|Unit|
-	   |1| 8 |1| 9 |1|    3   |1|    3     |      n     |    1   |2-4 |
-	   |_|___|_|___|_|________|_|__________|____________|________|____|
-   */
-	int humid = (wx.obsHumidity == 100) ? 0 : wx.obsHumidity; // pg 74
-
-	String dataString = CALLSIGN;
-	dataString += ">APRS,TCPIP*:";
-	dataString += "!" + APRSlocation(wx.obsLat, wx.obsLon);				// position in DDmm.mmN/DDDmm.mmW
-	dataString += "_" + APRSpadder(wx.obsWindDir, 3);					// degrees clockwise from north
-	dataString += "/" + APRSpadder(KMtoMILES(wx.obsWindSpeed), 3);		// speed in mph
-	dataString += "g" + APRSpadder(KMtoMILES(wx.obsWindGust), 3);		// speed in mph
-	dataString += "t" + APRSpadder(CtoF(wx.obsTemp), 3);				// temperature in Fahrenheit
-	dataString += "L" + APRSpadder(wx.obsSolarRadiation, 3);			// luminosity < 999
-	dataString += "r" + APRSpadder(100 * MMtoIN(wx.obsPrecipRate), 3);	// rainfall rate in 100th of inches per hour
-	dataString += "P" + APRSpadder(100 * MMtoIN(wx.obsPrecipTotal), 3); // rainfall since midnight in 100th of inches
-	dataString += "h" + APRSpadder(humid, 2);							// relative humidity in % 00 = 100%
-	dataString += "b" + APRSpadder(10 * wx.obsPressure, 5);				// sea level pressure in 10ths of millibars
-	dataString += APRS_DEVICE_NAME;
-	// dataString += " ";
-	// dataString += APRS_SOFTWARE_VERS;
+	// Complete Weather Report Format, see aprsFormat.cpp in lib/wxcore; pNNN is left out
+	// while historyRain24h() is NAN, so a short history is not reported as a dry day
+	char packet[APRS_PACKET_MAX];
+	aprsFormatWeather(packet, sizeof(packet), CALLSIGN.c_str(), currentObservation(), historyRain24h(), APRS_DEVICE_NAME);
+	String dataString = packet;
 	DEBUG_PRINTLN("APRS Weather: " + dataString);
 	return dataString;
 } // APRSformatWeather()
 
-// ******** weather TickTwo callback ********
+// ******** weather task callback ********
 void postWXtoAPRS()
 {
 	postToAPRS(APRSformatWeather());
@@ -176,7 +251,7 @@ String APRSformatBulletin(String message, String ID)
 	return str;
 } // APRSformatBulletin()
 
-// ******** bulletin TickTwo callback ********
+// ******** bulletin task callback ********
 void APRSsendBulletin(String msg, String ID)
 {
 	postToAPRS(APRSformatBulletin(msg, ID));
@@ -190,11 +265,8 @@ void APRSsendBulletin(String msg, String ID)
 String APRSpadder(float value, int width)
 {
 	// pads APRS rounded data element with leading 0s to the specified width
-	int val = round(value);
-	char format[6]; // Stores the string format specifier (e.g., "%04d")
-	snprintf(format, sizeof(format), "%%0%dd", width);
-	char paddedValue[width + 1]; // Buffer to store the formatted string
-	snprintf(paddedValue, sizeof(paddedValue), format, val);
+	char paddedValue[16];
+	aprsPad(paddedValue, sizeof(paddedValue), value, width);
 	return paddedValue;
 } // APRSpadder()
 
@@ -220,83 +292,27 @@ String APRSpadCall(String callSign)
 */
 String APRSlocation(float lat, float lon)
 {
-	// 12/20/2024
 	// convert decimal latitude & longitude to DDmm.mmN/DDDmm.mmW
-	lat = constrain(lat, -90, 90);
-	lon = constrain(lon, -180, 180);
-
-	const char *latID = (lat < 0) ? "S" : "N";
-	const char *lonID = (lon < 0) ? "W" : "E";
-	lat = abs(lat);
-	lon = abs(lon);
-	uint8_t latDeg = (int)lat;			// the characteristic of lat (degrees)
-	float latMin = 60 * (lat - latDeg); // the mantissa of lat (minutes)
-	uint8_t lonDeg = (int)lon;
-	float lonMin = 60 * (lon - lonDeg);
-
-	char buf[20]; // Increased buffer size to safely accommodate the formatted string
-	snprintf(buf, sizeof(buf), "%02u%05.2f%.1s/%03u%05.2f%.1s",
-			 latDeg, latMin, latID, lonDeg, lonMin, lonID);
+	char buf[20];
+	aprsLocation(buf, sizeof(buf), lat, lon);
 	return String(buf);
 } // APRSlocation()
 
-void processBulletins()
+// ******** bulletin calendar callbacks ********
+void sendMorningBulletin()
 {
-	//! process APRS bulletins
-	//? Check if it is 0800 EST and the morning bulletin has not been sent
-	String bulletinText = "";
-	if (myTZ.hour() == 8 && myTZ.minute() == 0 && !amBulletinSent)
-	{
-		bulletinText = pickAphorism(APHORISM_FILE, lineArray);
-		APRSsendBulletin(bulletinText, "M"); // send morning bulletin
-		amBulletinSent = true;				 // mark it sent
-	}
-
-	//? Check if it is 2000 EST and the evening bulletin has not been sent
-	if (myTZ.hour() == 20 && myTZ.minute() == 0 && !pmBulletinSent)
-	{
-		bulletinText = pickAphorism(APHORISM_FILE, lineArray);
-		APRSsendBulletin(bulletinText, "E"); // send evening bulletin
-		pmBulletinSent = true;				 // mark it sent
-	}
-
-	//? Reset the bulletin flags at midnight if either is true
-	static int lastDay = -1;
-	int currentDay = myTZ.day();
-	if (currentDay != lastDay)
-	{
-		lastDay = currentDay;
-		amBulletinSent = false;
-		pmBulletinSent = false;
-	}
+	APRSsendBulletin(pickAphorism(APHORISM_FILE, lineArray), "M");
 }
 
-// ********** Bulletin scheduling functions **********
-// void sendMorningBulletin() {
-//     if (!amBulletinSent) {
-//         String bulletinText = pickAphorism(APHORISM_FILE, lineArray);
-//         APRSsendBulletin(bulletinText, "M");
-//         amBulletinSent = true;
-//     }
-//     // Re-schedule for tomorrow at 8:00
-//     myTZ.setEvent(sendMorningBulletin, 8, 0, 0);
-// }
-
-// void sendEveningBulletin() {
-//     if (!pmBulletinSent) {
-//         String bulletinText = pickAphorism(APHORISM_FILE, lineArray);
-//         APRSsendBulletin(bulletinText, "E");
-//         pmBulletinSent = true;
-//     }
-//     // Re-schedule for tomorrow at 20:00
-//     myTZ.setEvent(sendEveningBulletin, 20, 0, 0);
-// }
-
-// void resetBulletinFlags() {
-//     amBulletinSent = false;
-//     pmBulletinSent = false;
-//     // Reschedule for next midnight
-//     myTZ.setEvent(resetBulletinFlags, 0, 0, 0);
-// }
-
+void sendEveningBulletin()
+{
+	APRSsendBulletin(pickAphorism(APHORISM_FILE, lineArray), "E");
+}
 
+void sendSunsetBulletin()
+{
+	// after mid-afternoon the forecast's first daypart is tonight
+	char message[68];
+	snprintf(message, sizeof(message), "Sunset. Tonight %s, low %dC", wx.forPhraseLong.c_str(), wx.forTempMin);
+	APRSsendBulletin(message, "S");
+} // sendSunsetBulletin()
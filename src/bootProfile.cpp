@@ -0,0 +1,63 @@
+/**
+ * @file bootProfile.cpp
+ * @author Karl Berger
+ * @date 2025-07-02
+ * @brief Timestamps of the boot phases, up to the first live frame.
+ * @details The phase names are string literals, so only pointers are kept.
+ *          Marks after the first frame are ignored so the record describes boot,
+ *          and "boot" on the console prints the full table.
+ */
+
+#include "bootProfile.h"
+
+#include <Arduino.h>	 // Arduino functions
+#include "wug_debug.h" // debug print macro
+
+struct bootPhase
+{
+	const char *name; // phase that ended
+	uint32_t at;	  // millis() when it ended
+};
+
+bootPhase bootPhases[BOOT_PHASES];
+int bootCount = 0;
+bool bootDone = false; // first frame drawn
+
+void bootMark(const char *phase)
+{
+	if (bootDone || bootCount == BOOT_PHASES)
+	{
+		return;
+	}
+	bootPhases[bootCount++] = {phase, (uint32_t)millis()};
+} // bootMark()
+
+void bootFirstFrame()
+{
+	if (bootDone)
+	{
+		return;
+	}
+	bootMark("first frame");
+	bootDone = true;
+	DEBUG_PRINT("Boot to first frame, ms: ");
+	DEBUG_PRINTLN(bootPhases[bootCount - 1].at);
+} // bootFirstFrame()
+
+void printBootProfile()
+{
+	Serial.printf("Boot profile, reset reason: %s\n", ESP.getResetReason().c_str());
+	uint32_t previous = 0; // millis() starts at power on, so the first phase includes the ROM boot
+	for (int i = 0; i < bootCount; i++)
+	{
+		Serial.printf("\t%-16s at %6u ms, took %6u ms\n", bootPhases[i].name, bootPhases[i].at,
+					  bootPhases[i].at - previous);
+		previous = bootPhases[i].at;
+	}
+	if (!bootDone)
+	{
+		Serial.println("\tno live frame yet");
+	}
+} // printBootProfile()
+
+// End of file
@@ -0,0 +1,138 @@
+/**
+ * @file clockTick.cpp
+ * @author Karl Berger
+ * @date 2025-07-01
+ * @brief Clock frame ticks aligned to the edge of each NTP second.
+ * @details ezTime keeps UTC as the last NTP time plus millis() since, and each
+ *          update may nudge it, so the next edge is recalculated on every tick
+ *          rather than adding 1000 ms. Drift is the change in millis() minus NTP
+ *          time since the first tick, over the NTP time elapsed. Both spans are
+ *          kept in 64 bits, so the statistic holds past the 24.8 day int32_t
+ *          millisecond range and the 49.7 day millis() wrap.
+ */
+
+#include "clockTick.h"
+
+#include <Arduino.h>		  // Arduino functions
+#include <ezTime.h>			  // [manager] v0.8.3 Rop Gonggrijp https://github.com/ropg/ezTime
+#include "sequentialFrames.h" // for updateClock()
+#include "taskControl.h"	  // for taskSecondTick
+
+struct tickStats
+{
+	uint32_t ticks;			   // ticks drawn
+	uint32_t early;			   // ticks that arrived before their second
+	uint32_t skipped;		   // seconds never drawn
+	int32_t phaseMin;		   // ms past the edge
+	int32_t phaseMax;		   // ms past the edge
+	int32_t phaseSum;		   // for the mean
+	float phaseSumSq;		   // for the standard deviation
+	unsigned long lastMillis;  // millis() at the last tick
+	uint64_t elapsedMillis;	   // millis() since the first tick, summed tick to tick across the wrap
+	time_t firstSecond;		   // NTP second of the first tick
+	uint16_t firstMs;		   // and its milliseconds
+	int32_t driftMs;		   // millis() minus NTP time, change since the first tick
+	uint32_t driftSpan;		   // seconds the drift was measured over
+};
+
+tickStats tick = {0, 0, 0, INT32_MAX, INT32_MIN, 0, 0, 0, 0, 0, 0, 0, 0};
+time_t lastDrawn = 0; // second last shown, 0 after a start
+
+// milliseconds from now to CLOCK_TICK_LAG past the next second edge
+static uint32_t untilNextEdge()
+{
+	uint16_t ms = UTC.ms();
+	return (ms < CLOCK_TICK_LAG) ? CLOCK_TICK_LAG - ms : 1000 - ms + CLOCK_TICK_LAG;
+} // untilNextEdge()
+
+// NTP second, its milliseconds and millis() from one instant: ezTime reads the clock
+// afresh in each call, so read again if the second turned between them
+static time_t readClock(uint16_t &ms, unsigned long &sampled)
+{
+	time_t second;
+	do
+	{
+		second = UTC.now();
+		ms = UTC.ms();
+		sampled = millis();
+	} while (UTC.now() != second);
+	return second;
+} // readClock()
+
+static void recordTick(time_t second, uint16_t ms, unsigned long sampled)
+{
+	int32_t phase = ms;
+	tick.ticks++;
+	tick.phaseMin = min(tick.phaseMin, phase);
+	tick.phaseMax = max(tick.phaseMax, phase);
+	tick.phaseSum += phase;
+	tick.phaseSumSq += (float)phase * phase;
+
+	if (tick.firstSecond == 0)
+	{
+		tick.lastMillis = sampled;
+		tick.elapsedMillis = 0;
+		tick.firstSecond = second;
+		tick.firstMs = ms;
+		return;
+	}
+	tick.elapsedMillis += sampled - tick.lastMillis; // unsigned difference, right across the wrap
+	tick.lastMillis = sampled;
+	int64_t elapsedNtp = (int64_t)(second - tick.firstSecond) * 1000 + ms - tick.firstMs;
+	tick.driftMs = (int32_t)((int64_t)tick.elapsedMillis - elapsedNtp);
+	tick.driftSpan = elapsedNtp / 1000;
+} // recordTick()
+
+void clockTick()
+{
+	uint16_t ms;
+	unsigned long sampled;
+	time_t second = readClock(ms, sampled);
+	if (second == lastDrawn)
+	{
+		tick.early++; // still in the second already drawn
+	}
+	else
+	{
+		if (lastDrawn != 0 && second - lastDrawn > 1)
+		{
+			tick.skipped += second - lastDrawn - 1;
+		}
+		lastDrawn = second;
+		recordTick(second, ms, sampled);
+		updateClock();
+	}
+	taskSchedule(taskSecondTick, untilNextEdge());
+} // clockTick()
+
+void startClockTick()
+{
+	lastDrawn = 0; // the frame was just drawn in full
+	taskSchedule(taskSecondTick, untilNextEdge());
+}
+
+void stopClockTick()
+{
+	taskCancel(taskSecondTick);
+}
+
+void printClockStats()
+{
+	if (tick.ticks == 0)
+	{
+		Serial.println("Clock: no ticks yet");
+		return;
+	}
+	float mean = (float)tick.phaseSum / tick.ticks;
+	float sd = sqrt(max(0.0f, tick.phaseSumSq / tick.ticks - mean * mean));
+	Serial.printf("Clock ticks %u, phase ms past the edge: mean %.1f sd %.1f min %d max %d (target %d)\n", tick.ticks,
+				  mean, sd, tick.phaseMin, tick.phaseMax, CLOCK_TICK_LAG);
+	Serial.printf("\tseconds skipped %u, early ticks %u\n", tick.skipped, tick.early);
+	if (tick.driftSpan > 0)
+	{
+		Serial.printf("\tmillis() drift vs NTP %d ms over %u s (%.0f ppm)\n", tick.driftMs, tick.driftSpan,
+					  1000.0 * tick.driftMs / tick.driftSpan);
+	}
+} // printClockStats()
+
+// End of file
@@ -0,0 +1,402 @@
+/**
+ * @file connectionPool.cpp
+ * @author Karl Berger
+ * @date 2025-06-14
+ * @brief Shared keep-alive connections for the weather, ThingSpeak and APRS clients.
+ * @details Each slot belongs to one host and port and keeps its counters for the life
+ *          of the program. The socket in a slot is created on demand, reused while the
+ *          server keeps it open, and deleted when it has been idle past the owner's
+ *          next expected use or heap runs short.
+ *          Host names are looked up through the DNS cache before a new socket is made.
+ *          Host names must have static storage duration; the pool keeps the pointer.
+ *          Responses are read by a protothread, so the display keeps running while a
+ *          server thinks; TCP connect and the TLS handshake still block.
+ */
+
+#include "connectionPool.h"
+
+#include <Arduino.h>		  // Arduino functions
+#include <WiFiClientSecure.h> // [builtin] for https
+#include <limits.h>			  // for LONG_MAX
+#include "dnsCache.h"		  // cached host lookups
+#include "netTiming.h"		  // phase timing
+#include "wifiConnection.h"	  // link state
+#include "wug_debug.h"		  // debug print
+
+struct poolSlot
+{
+	const char *host;		// host name, nullptr if unused
+	uint16_t port;			// host port
+	bool secure;			// TLS connection
+	WiFiClient *client;		// open socket or nullptr
+	bool inUse;				// acquired by a service
+	unsigned long lastUsed; // millis() at release
+	unsigned long idleFor;	// milliseconds an idle socket is kept
+	uint32_t connects;		// new connections made
+	uint32_t reuses;		// warm connections reused
+	uint32_t failures;		// failed connection attempts
+};
+
+poolSlot pool[POOL_SLOTS]; // zero initialized
+
+// find the slot for a host, or claim an unused one
+static poolSlot *findSlot(const char *host, uint16_t port, bool secure)
+{
+	for (int i = 0; i < POOL_SLOTS; i++)
+	{
+		if (pool[i].host && pool[i].port == port && pool[i].secure == secure && strcmp(pool[i].host, host) == 0)
+		{
+			return &pool[i];
+		}
+	}
+	for (int i = 0; i < POOL_SLOTS; i++)
+	{
+		if (pool[i].host == nullptr)
+		{
+			pool[i].host = host;
+			pool[i].port = port;
+			pool[i].secure = secure;
+			return &pool[i];
+		}
+	}
+	return nullptr;
+} // findSlot()
+
+static void closeSlot(poolSlot &slot)
+{
+	if (slot.client)
+	{
+		slot.client->stop();
+		delete slot.client;
+		slot.client = nullptr;
+	}
+	slot.inUse = false;
+} // closeSlot()
+
+// close idle sockets until the heap floor is met, TLS sockets first
+static void relieveHeap()
+{
+	for (int pass = 0; pass < 2 && ESP.getFreeHeap() < POOL_MIN_FREE_HEAP; pass++)
+	{
+		for (int i = 0; i < POOL_SLOTS; i++)
+		{
+			bool candidate = (pass == 0) ? pool[i].secure : !pool[i].secure;
+			if (candidate && pool[i].client && !pool[i].inUse)
+			{
+				DEBUG_PRINT("Pool: low heap, closing ");
+				DEBUG_PRINTLN(pool[i].host);
+				closeSlot(pool[i]);
+			}
+		}
+	}
+} // relieveHeap()
+
+/*
+******************************************************
+************** Acquire and release *******************
+******************************************************
+*/
+WiFiClient *acquireConnection(const char *host, uint16_t port, bool secure, bool &reused, unsigned long nextUse)
+{
+	reused = false;
+	if (!wifiOnline())
+	{
+		return nullptr; // fail fast, the caller's policy backs off
+	}
+	poolSlot *slot = findSlot(host, port, secure);
+	if (slot == nullptr || slot->inUse)
+	{
+		DEBUG_PRINTLN("Pool: no slot available");
+		return nullptr;
+	}
+	slot->idleFor = min(nextUse + POOL_IDLE_MARGIN, POOL_MAX_IDLE);
+
+	if (slot->client && slot->client->connected())
+	{
+		while (slot->client->available())
+		{
+			slot->client->read(); // discard anything left from the last exchange
+		}
+		slot->reuses++;
+		slot->inUse = true;
+		reused = true;
+		netTimingSkip(); // no lookup or connect on a warm socket
+		return slot->client;
+	}
+
+	closeSlot(*slot); // server closed it
+	IPAddress ip;
+	if (!resolveHost(host, ip, secure)) // TLS hosts through lwIP, see below
+	{
+		slot->failures++; // unknown host, possibly from the negative cache
+		return nullptr;
+	}
+	netTimingMark(NET_PHASE_DNS);
+	relieveHeap();
+	if (secure)
+	{
+		WiFiClientSecure *tls = new WiFiClientSecure;
+		tls->setInsecure();
+		slot->client = tls;
+	}
+	else
+	{
+		slot->client = new WiFiClient;
+	}
+
+	// TLS connects by name so the server gets SNI; the core has no connect by address with
+	// a server name. The connect looks the name up again, and lwIP answers from the table
+	// DNS_SYSTEM lookups and their prefetch keep filled.
+	bool connected = secure ? slot->client->connect(host, port) : slot->client->connect(ip, port);
+	if (!connected)
+	{
+		slot->failures++;
+		closeSlot(*slot);
+		return nullptr;
+	}
+	netTimingMark(secure ? NET_PHASE_TLS : NET_PHASE_CONNECT);
+	slot->connects++;
+	slot->inUse = true;
+	return slot->client;
+} // acquireConnection()
+
+void releaseConnection(WiFiClient *client, bool keepAlive)
+{
+	for (int i = 0; i < POOL_SLOTS; i++)
+	{
+		if (pool[i].client == client && client != nullptr)
+		{
+			pool[i].inUse = false;
+			pool[i].lastUsed = millis();
+			if (!keepAlive || !client->connected())
+			{
+				closeSlot(pool[i]);
+			}
+			return;
+		}
+	}
+} // releaseConnection()
+
+/*
+******************************************************
+***************** HTTP response **********************
+******************************************************
+*/
+bool readLine(WiFiClient &client, String &line)
+{
+	while (client.available())
+	{
+		char c = client.read();
+		if (c == '\n')
+		{
+			return true;
+		}
+		if (c != '\r')
+		{
+			line += c;
+		}
+	}
+	return false;
+} // readLine()
+
+// read what has arrived of the body or chunk, true once it is complete
+static bool readBody(httpResponse &response)
+{
+	while (response.remaining > 0 && response.client->available())
+	{
+		int c = response.client->read();
+		if (response.body.length() < response.maxBody)
+		{
+			response.body += (char)c;
+		}
+		response.remaining--;
+	}
+	return response.remaining <= 0;
+} // readBody()
+
+// next line of the response, false once the socket is closed and drained
+static bool lineArrived(httpResponse &response)
+{
+	return readLine(*response.client, response.line) || !response.client->connected();
+}
+
+void beginHttpResponse(httpResponse &response, WiFiClient *client, netEndpoint endpoint, size_t maxBody,
+					   unsigned long timeout)
+{
+	PT_INIT(&response.pt);
+	response.client = client;
+	response.endpoint = endpoint;
+	response.maxBody = maxBody;
+	response.timeout = timeout;
+	response.status = 0;
+	response.keepAlive = false;
+	response.body = "";
+	response.line = "";
+} // beginHttpResponse()
+
+ptState readHttpResponse(httpResponse &response)
+{
+	protothread *pt = &response.pt;
+	PT_BEGIN(pt);
+
+	// status line, e.g. "HTTP/1.1 202 Accepted"
+	PT_AWAIT(pt, lineArrived(response), response.timeout);
+	if (!response.line.startsWith("HTTP/"))
+	{
+		PT_EXIT(pt); // status stays 0
+	}
+	netTimingMarkFor(response.endpoint, NET_PHASE_FIRST_BYTE);
+	response.status = response.line.substring(response.line.indexOf(' ') + 1).toInt();
+	response.keepAlive = response.line.startsWith("HTTP/1.1"); // HTTP/1.1 defaults to keep-alive
+	response.contentLength = -1;
+	response.chunked = false;
+
+	// headers end with an empty line
+	while (true)
+	{
+		response.line = "";
+		PT_AWAIT(pt, lineArrived(response), response.timeout);
+		if (PT_TIMED_OUT(pt))
+		{
+			response.status = 0;
+			PT_EXIT(pt);
+		}
+		response.line.trim();
+		if (response.line.isEmpty())
+		{
+			break;
+		}
+		response.line.toLowerCase();
+		if (response.line.startsWith("content-length:"))
+		{
+			response.contentLength = response.line.substring(15).toInt();
+		}
+		else if (response.line.startsWith("transfer-encoding:") && response.line.indexOf("chunked") > 0)
+		{
+			response.chunked = true;
+		}
+		else if (response.line.startsWith("connection:"))
+		{
+			response.keepAlive = response.line.indexOf("close") < 0;
+		}
+	}
+
+	if (response.chunked)
+	{
+		while (true)
+		{
+			response.line = "";
+			PT_AWAIT(pt, lineArrived(response), response.timeout);
+			if (PT_TIMED_OUT(pt) || response.line.isEmpty())
+			{
+				response.remaining = -1; // cut short
+				break;
+			}
+			response.remaining = strtol(response.line.c_str(), nullptr, 16);
+			if (response.remaining <= 0)
+			{
+				response.line = "";
+				PT_AWAIT(pt, lineArrived(response), response.timeout); // blank line after the last chunk
+				response.remaining = PT_TIMED_OUT(pt) ? -1 : 0;
+				break;
+			}
+			PT_AWAIT(pt, readBody(response) || !response.client->connected(), response.timeout);
+			if (response.remaining > 0)
+			{
+				break; // cut short
+			}
+			response.line = "";
+			PT_AWAIT(pt, lineArrived(response), response.timeout); // CRLF after the chunk
+		}
+	}
+	else if (response.contentLength >= 0)
+	{
+		response.remaining = response.contentLength;
+		PT_AWAIT(pt, readBody(response) || !response.client->connected(), response.timeout);
+	}
+	else
+	{
+		response.remaining = LONG_MAX; // body ends when the server closes
+		PT_AWAIT(pt, (readBody(response), !response.client->connected()), response.timeout);
+	}
+	netTimingMarkFor(response.endpoint, NET_PHASE_BODY);
+	response.keepAlive = response.keepAlive && response.remaining == 0;
+	PT_END(pt);
+} // readHttpResponse()
+
+/*
+******************************************************
+*************** Idle socket upkeep *******************
+******************************************************
+*/
+void maintainConnections()
+{
+	static unsigned long lastCheck = 0;
+	if (millis() - lastCheck < 1000)
+	{
+		return;
+	}
+	lastCheck = millis();
+
+	for (int i = 0; i < POOL_SLOTS; i++)
+	{
+		poolSlot &slot = pool[i];
+		if (slot.client == nullptr || slot.inUse)
+		{
+			continue;
+		}
+		while (slot.client->available())
+		{
+			slot.client->read(); // discard server keep-alive chatter
+		}
+		if (!slot.client->connected() || millis() - slot.lastUsed > slot.idleFor)
+		{
+			closeSlot(slot);
+		}
+	}
+	relieveHeap();
+} // maintainConnections()
+
+void resetConnections()
+{
+	// sockets opened before a link loss are dead even if they still look connected
+	for (int i = 0; i < POOL_SLOTS; i++)
+	{
+		if (!pool[i].inUse)
+		{
+			closeSlot(pool[i]);
+		}
+	}
+} // resetConnections()
+
+bool getConnectionStats(int slot, poolStats &stats)
+{
+	if (slot < 0 || slot >= POOL_SLOTS || pool[slot].host == nullptr)
+	{
+		return false;
+	}
+	stats.host = pool[slot].host;
+	stats.port = pool[slot].port;
+	stats.secure = pool[slot].secure;
+	stats.connected = pool[slot].client != nullptr;
+	stats.connects = pool[slot].connects;
+	stats.reuses = pool[slot].reuses;
+	stats.failures = pool[slot].failures;
+	return true;
+} // getConnectionStats()
+
+void printConnectionStats()
+{
+	poolStats stats;
+	Serial.println("Connections: host port open connects reuses failures");
+	for (int i = 0; i < POOL_SLOTS; i++)
+	{
+		if (getConnectionStats(i, stats))
+		{
+			Serial.printf("\t%s %u %s %u %u %u\n", stats.host, stats.port, stats.connected ? "yes" : "no",
+						  stats.connects, stats.reuses, stats.failures);
+		}
+	}
+} // printConnectionStats()
+
+// End of file
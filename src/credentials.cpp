@@ -8,6 +8,7 @@
 #include "credentials.h"
 
 #include <Arduino.h> // for String
+#include "wxShare.h" // for SHARE_MODE values
 
 const String FW_VERSION = "250529"; // Firmware version
 
@@ -22,7 +23,8 @@ const String WX_STATION_ID = "KVACENTR126";               // your Weather Underg
 const String WX_KEY = "c41eb27afef64b6b9eb27afef62b6bed"; // your Weather Underground API key
 const String MY_TIMEZONE = "America/New_York";            // Olson timezone https://en.wikipedia.org/wiki/List_of_tz_database_time_zones
 /*
-Common Olson Timezones:
+Common Olson Timezones, all with built-in rules in lib/wxcore/src/tzRules.cpp
+(other zones are fetched from the ezTime timezone server):
 EST  America/New_York
 CST  America/Chicago
 MST  America/Denver
@@ -67,10 +69,40 @@ const String TS_CHANNEL = "88666";
    Status
 */
 
+// Local station uploads
+//! Set the station's custom server to this device's IP address and port
+//! Weather Underground protocol or Ecowitt protocol, e.g. 8080. 0 disables it and lets the radio sleep
+const uint16_t INGEST_PORT = 0; // port for station uploads on the LAN
+//! The station's WU password, or its Ecowitt PASSKEY as shown in the upload. "" accepts any upload
+const String INGEST_PASSKEY = ""; // upload password
+
+// Displays sharing one weather feed on the LAN
+//! One display is the leader and fetches weather, the others follow it
+const uint8_t SHARE_MODE = SHARE_OFF; // SHARE_OFF, SHARE_LEADER or SHARE_FOLLOWER
+
+// MQTT broker
+//! Place strings in quotes " ". Leave MQTT_BROKER empty to disable MQTT
+const String MQTT_BROKER = "";               // broker host name
+const uint16_t MQTT_PORT = 1883;             // broker port
+const String MQTT_USER = "";                 // broker user name, "" if none
+const String MQTT_PASSWORD = "";             // broker password, "" if none
+const String MQTT_TOPIC = "wug/KVACENTR126"; // topic prefix
+const uint8_t MQTT_QOS = 1;                  // 0 = fire and forget, 1 = resend until acknowledged
+
+// Headless gateway
+//! Use true/false. true for a unit without a display that only relays to APRS and ThingSpeak
+//! Wire GPIO16 (D0) to RST so the board can wake from deep sleep
+const bool HEADLESS_GATEWAY = false; // fetch, post and deep sleep
+
+// Radio power
+//! Use true/false. The radio only sleeps when MQTT, local uploads and sharing are all off
+const bool RADIO_SLEEP = true; // switch the Wi-Fi radio off between network bursts
+
 // Weather update intervals (note minutes)
 //! Use unsigned integer values. No quote marks
 const unsigned int WX_CURRENT_INTERVAL = 7;   // minutes between current weather requests (Should be >= 1)
 const unsigned int TS_POST_INTERVAL = 7;      // minutes between posting to ThingSpeak same as WX_CURRENT_INTERVAL
+const unsigned int TS_BATCH_SIZE = 4;         // ThingSpeak samples per upload (1 to 32)
 const unsigned int WX_APRS_INTERVAL = 10;     // minutes between posting weather data to APRS (Must be >= 5)
 const unsigned int WX_FORECAST_INTERVAL = 13; // minutes between forecast requests
 const unsigned int SCREEN_DURATION = 5;       // display frame interval in !!!seconds!!!
@@ -0,0 +1,270 @@
+/**
+ * @file dnsCache.cpp
+ * @author Karl Berger
+ * @date 2025-06-15
+ * @brief Host name cache with TTL, stale-while-revalidate and negative caching.
+ * @details The lookup is a protothread. It sends one A query built by dnsMessage,
+ *          then awaits the answer while the scheduler runs other tasks. If no
+ *          answer arrives, and always for DNS_SYSTEM hosts, lwIP's non-blocking
+ *          dns_gethostbyname() is started and awaited the same way; its callback
+ *          carries a generation number so a late answer to an abandoned lookup is
+ *          ignored. lwIP does not report a TTL, so its answers are cached for
+ *          DNS_DEFAULT_TTL unless the UDP answer gave one.
+ *          Only one lookup runs at a time. A miss in resolveHost() first finishes
+ *          any background lookup, then runs its own to the end.
+ */
+
+#include "dnsCache.h"
+
+#include <Arduino.h>		// Arduino functions
+#include <ESP8266WiFi.h>	// for WiFi.dnsIP()
+#include <WiFiUdp.h>		// DNS transport
+#include <coroutine.h>		// lookup coroutine from lib/wxcore
+#include <dnsMessage.h>		// query and answer coding from lib/wxcore
+#include <lwip/dns.h>		// dns_gethostbyname()
+#include "taskControl.h"	// finishCoroutine()
+#include "wifiConnection.h" // link state
+#include "wug_debug.h"		// debug print
+
+#ifndef DNS_SERVER
+#define DNS_SERVER "" // "a.b.c.d" to send queries to a fixed server, empty for the DHCP one
+#endif
+#ifndef DNS_PORT
+#define DNS_PORT 53 // port of the DNS_SERVER
+#endif
+
+struct dnsLookup
+{
+	hostEntry *entry;		  // entry being looked up
+	WiFiUDP udp;			  // query socket
+	uint16_t id;			  // transaction id
+	dnsResult result;		  // outcome so far
+	uint32_t address;		  // answer, first octet high
+	uint32_t ttl;			  // answer TTL in seconds
+	uint32_t generation;	  // tags lwIP callbacks, later lookups ignore earlier answers
+	volatile bool systemDone; // lwIP callback arrived
+	uint32_t systemAddress;	  // lwIP answer, 0 if none
+};
+
+dnsLookup lookup;
+IPAddress dnsServer;		// 0.0.0.0 means use the DHCP server
+uint16_t dnsPort = 53;		// DNS server port
+uint32_t dnsQueries = 0;	// UDP queries sent
+uint32_t dnsSystem = 0;		// lookups handed to lwIP
+
+static uint32_t toAddress(const IPAddress &ip)
+{
+	return ((uint32_t)ip[0] << 24) | ((uint32_t)ip[1] << 16) | ((uint32_t)ip[2] << 8) | ip[3];
+}
+
+static IPAddress toIP(uint32_t address)
+{
+	return IPAddress(address >> 24, (address >> 16) & 0xFF, (address >> 8) & 0xFF, address & 0xFF);
+}
+
+/*
+******************************************************
+****************** UDP resolver **********************
+******************************************************
+*/
+// send one A query, false if there is no server or socket
+static bool sendQuery()
+{
+	IPAddress server = dnsServer.isSet() ? dnsServer : WiFi.dnsIP();
+	static uint8_t packet[DNS_PACKET_SIZE];
+	size_t length = dnsQuery(packet, sizeof(packet), ++lookup.id, lookup.entry->host);
+	if (!server.isSet() || length == 0 || !lookup.udp.begin(0))
+	{
+		return false;
+	}
+	dnsQueries++;
+	lookup.udp.beginPacket(server, dnsPort);
+	lookup.udp.write(packet, length);
+	lookup.udp.endPacket();
+	return true;
+} // sendQuery()
+
+// read one waiting datagram, true once it answered the query
+static bool receiveAnswer()
+{
+	static uint8_t packet[DNS_PACKET_SIZE];
+	if (lookup.udp.parsePacket() <= 0)
+	{
+		return false;
+	}
+	int length = lookup.udp.read(packet, sizeof(packet));
+	dnsResult result = dnsAnswer(packet, length > 0 ? length : 0, lookup.id, lookup.address, lookup.ttl);
+	if (result == DNS_NOT_OURS)
+	{
+		return false; // a late answer to an earlier query
+	}
+	lookup.result = result;
+	return true;
+} // receiveAnswer()
+
+/*
+******************************************************
+******************** lwIP resolver *******************
+******************************************************
+*/
+// runs in the lwIP context; a stale generation belongs to an abandoned lookup
+static void systemFound(const char *name, const ip_addr_t *ip, void *arg)
+{
+	(void)name;
+	if ((uint32_t)(uintptr_t)arg != lookup.generation)
+	{
+		return;
+	}
+	lookup.systemAddress = ip ? toAddress(IPAddress(ip)) : 0;
+	lookup.systemDone = true;
+} // systemFound()
+
+// start lwIP's resolver; true once it has answered or will call back
+static bool startSystem()
+{
+	dnsSystem++;
+	ip_addr_t ip;
+	lookup.systemDone = false;
+	lookup.systemAddress = 0;
+	err_t err = dns_gethostbyname(lookup.entry->host, &ip, systemFound, (void *)(uintptr_t)++lookup.generation);
+	if (err == ERR_OK)
+	{
+		lookup.systemAddress = toAddress(IPAddress(&ip)); // from lwIP's table
+		lookup.systemDone = true;
+	}
+	return err == ERR_OK || err == ERR_INPROGRESS;
+} // startSystem()
+
+/*
+******************************************************
+********************* Lookup *************************
+******************************************************
+*/
+static ptState lookupThread(protothread *pt)
+{
+	PT_BEGIN(pt);
+	lookup.result = DNS_NO_ANSWER;
+	lookup.ttl = DNS_DEFAULT_TTL;
+	if (sendQuery())
+	{
+		PT_AWAIT(pt, receiveAnswer(), DNS_TIMEOUT);
+		lookup.udp.stop();
+	}
+
+	// a silent server gets a second opinion, a TLS host warms lwIP's table for its connect
+	if (lookup.result == DNS_NO_ANSWER || (lookup.entry->system && lookup.result == DNS_FOUND))
+	{
+		if (startSystem())
+		{
+			PT_AWAIT(pt, lookup.systemDone, DNS_SYSTEM_TIMEOUT);
+		}
+		lookup.generation++; // ignore a callback that is still to come
+		if (lookup.result == DNS_NO_ANSWER && lookup.systemAddress != 0)
+		{
+			lookup.result = DNS_FOUND; // lwIP does not report a TTL
+			lookup.address = lookup.systemAddress;
+			lookup.ttl = DNS_DEFAULT_TTL;
+		}
+	}
+
+	if (lookup.result != DNS_FOUND)
+	{
+		DEBUG_PRINT("DNS: no address for ");
+		DEBUG_PRINTLN(lookup.entry->host);
+	}
+	hostCacheStore(*lookup.entry, lookup.result, lookup.address, lookup.ttl);
+	PT_END(pt);
+} // lookupThread()
+
+coroutine dnsCoroutine = COROUTINE("dns", lookupThread);
+
+/*
+******************************************************
+********************* Cache **************************
+******************************************************
+*/
+void beginDnsCache()
+{
+	IPAddress server;
+	if (server.fromString(DNS_SERVER))
+	{
+		setDnsServer(server, DNS_PORT);
+	}
+} // beginDnsCache()
+
+bool resolveHost(const char *host, IPAddress &ip, bool system)
+{
+	if (ip.fromString(host))
+	{
+		return true; // numeric address
+	}
+	uint32_t address = 0;
+	hostAnswer answer = hostCacheFind(host, address);
+	if (answer == HOST_MISS && coActive(dnsCoroutine))
+	{
+		finishCoroutine(dnsCoroutine); // the lookup under way may be for this host
+		answer = hostCacheFind(host, address);
+	}
+	if (answer == HOST_MISS)
+	{
+		lookup.entry = &hostCacheClaim(host);
+		lookup.entry->system = system;
+		coStart(dnsCoroutine);
+		finishCoroutine(dnsCoroutine); // nothing to connect to until it answers
+		address = lookup.entry->address;
+		answer = lookup.entry->negative || address == 0 ? HOST_NEGATIVE : HOST_FRESH;
+	}
+	if (answer == HOST_NEGATIVE)
+	{
+		return false;
+	}
+	ip = toIP(address);
+	return true;
+} // resolveHost()
+
+void maintainDnsCache()
+{
+	if (!wifiOnline() || coActive(dnsCoroutine))
+	{
+		return; // keep stale answers until the link is back
+	}
+	hostEntry *due = hostCacheDue(); // stale, or in use and close to its TTL
+	if (due)
+	{
+		lookup.entry = due;
+		coStart(dnsCoroutine);
+	}
+} // maintainDnsCache()
+
+void setDnsServer(IPAddress server, uint16_t port)
+{
+	finishCoroutine(dnsCoroutine); // its entry is about to go
+	dnsServer = server;
+	dnsPort = port;
+	flushDnsCache();
+} // setDnsServer()
+
+void flushDnsCache()
+{
+	hostCacheFlush();
+} // flushDnsCache()
+
+void printDnsStats()
+{
+	const hostCacheStats &stats = hostCacheCounters();
+	Serial.printf("DNS: %u hits, %u stale, %u negative, %u prefetches, %u queries, %u system\n", stats.hits,
+				  stats.stale, stats.negative, stats.prefetches, dnsQueries, dnsSystem);
+	const hostEntry *entry;
+	for (int i = 0; (entry = hostCacheAt(i)) != nullptr; i++)
+	{
+		if (entry->host)
+		{
+			long remaining = ((long)entry->ttl - (long)(millis() - entry->fetched)) / 1000;
+			Serial.printf("\t%s %s ttl %ld s%s%s\n", entry->host,
+						  entry->negative ? "-" : toIP(entry->address).toString().c_str(), remaining,
+						  entry->refresh ? " (refresh)" : "", entry->system ? " (lwIP)" : "");
+		}
+	}
+} // printDnsStats()
+
+// End of file
@@ -0,0 +1,59 @@
+/**
+ * @file endpointPolicy.cpp
+ * @author Karl Berger
+ * @date 2025-06-17
+ * @brief Retry, backoff and circuit breaker policy for network endpoints.
+ * @details The ESP8266 side of circuitBreaker.cpp: its clock, its random numbers
+ *          and its reports.
+ */
+
+#include "endpointPolicy.h"
+
+#include <Arduino.h>   // Arduino functions
+#include "wug_debug.h" // debug print
+
+static uint32_t policyMillis()
+{
+	return millis();
+}
+
+static uint32_t policyRandomBelow(uint32_t bound)
+{
+	return random(bound);
+}
+
+static void policyDebug(const endpointHealth &health, const char *event)
+{
+	DEBUG_PRINT(health.name);
+	DEBUG_PRINT(": ");
+	DEBUG_PRINT(event);
+	if (health.state == BREAKER_CLOSED && health.failures > 0)
+	{
+		DEBUG_PRINT(", retry in ms ");
+		DEBUG_PRINT(health.retryAt - millis());
+	}
+	DEBUG_PRINTLN("");
+} // policyDebug()
+
+void initEndpointPolicy()
+{
+	setPolicyClock(policyMillis);
+	setPolicyRandom(policyRandomBelow);
+	setPolicyLog(policyDebug);
+} // initEndpointPolicy()
+
+void printEndpointHealth()
+{
+	const char *const STATE_NAMES[] = {"closed", "open", "half-open"};
+	uint32_t now = millis();
+	Serial.println("Endpoints: state failures ok errors refused retry-in-s");
+	endpointHealth *health;
+	for (int i = 0; (health = policyEndpointAt(i)) != nullptr; i++)
+	{
+		long retryIn = (health->failures > 0) ? (int32_t)(health->retryAt - now) / 1000 : 0;
+		Serial.printf("\t%s %s %u %u %u %u %ld\n", health->name, STATE_NAMES[health->state], health->failures,
+					  health->successes, health->errors, health->refused, max(retryIn, 0L));
+	}
+} // printEndpointHealth()
+
+// End of file
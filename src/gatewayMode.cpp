@@ -0,0 +1,183 @@
+/**
+ * @file gatewayMode.cpp
+ * @author Karl Berger
+ * @date 2025-06-25
+ * @brief Headless fetch, post and deep sleep cycle for units without a display.
+ * @details Due times are kept as UTC epochs on the wall-clock slots of each interval
+ *          (calendarScheduler.h), so the posting phase does not creep by the length of
+ *          each awake period, and a slot slept through is simply dropped. The clock
+ *          is carried across a sleep as the epoch at sleep plus the requested sleep;
+ *          the ESP8266 sleep timer drifts by a few percent, which the periodic NTP
+ *          check corrects. Rows ThingSpeak refuses are lost with the RAM at sleep, and
+ *          the next cycle posts a newer observation instead.
+ */
+
+#include "gatewayMode.h"
+
+#include <Arduino.h>		   // Arduino functions
+#include <calendarScheduler.h> // wall-clock slots from lib/wxcore
+#include <ezTime.h>			   // [manager] v0.8.3 Rop Gonggrijp https://github.com/ropg/ezTime
+#include "aprsService.h"	   // APRS posting
+#include "credentials.h"	   // post intervals
+#include "thingSpeakService.h" // ThingSpeak posting
+#include "weatherService.h"	   // weather data
+#include "wifiConnection.h"	   // Wi-Fi connection
+#include "wug_debug.h"		   // debug print
+
+#define GATEWAY_MAGIC 0x57554747 // "WUGG"
+
+struct gatewayState
+{
+	uint32_t magic;		   // GATEWAY_MAGIC when valid
+	uint32_t cycles;	   // wake-ups since power on
+	uint32_t sleepEpoch;   // UTC when the last sleep began
+	uint32_t sleepSeconds; // length of the last sleep
+	uint32_t aprsDue;	   // UTC when the next APRS post is due
+	uint32_t tsDue;		   // UTC when the next ThingSpeak post is due
+	uint32_t aprsSentObs;  // observation epoch last posted to APRS
+	uint32_t tsSentObs;	   // observation epoch last posted to ThingSpeak
+	float lat;			   // station position from the last observation
+	float lon;
+	uint32_t awakeMs;	   // awake time of the last cycle
+	uint32_t awakeAvgMs;   // running average awake time
+	uint32_t crc;		   // of everything above
+};
+
+gatewayState state;
+
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	while (length--)
+	{
+		crc ^= *data++;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+} // crc32()
+
+static bool loadState()
+{
+	return ESP.rtcUserMemoryRead(GATEWAY_RTC_BLOCK, (uint32_t *)&state, sizeof(state)) &&
+		   state.magic == GATEWAY_MAGIC && state.crc == crc32((const uint8_t *)&state, offsetof(gatewayState, crc));
+} // loadState()
+
+static void saveState()
+{
+	state.magic = GATEWAY_MAGIC;
+	state.crc = crc32((const uint8_t *)&state, offsetof(gatewayState, crc));
+	ESP.rtcUserMemoryWrite(GATEWAY_RTC_BLOCK, (uint32_t *)&state, sizeof(state));
+} // saveState()
+
+// the next wall-clock slot of an interval, as the display's calendar events use
+static uint32_t nextSlot(uint32_t now, unsigned int minutes)
+{
+	calendarEvent slot = CALENDAR_EVERY("gateway", nullptr, minutes, 0, 0);
+	return calendarNext(slot, now + GATEWAY_EARLY);
+} // nextSlot()
+
+// record the cycle and deep sleep; the board resets on waking, so this does not return
+static void sleepFor(uint32_t seconds, unsigned long start)
+{
+	uint64_t maxSeconds = ESP.deepSleepMax() / 1000000ULL;
+	seconds = constrain(seconds, 10U, (uint32_t)min(maxSeconds, (uint64_t)UINT32_MAX));
+	state.sleepEpoch = UTC.now();
+	state.sleepSeconds = seconds;
+	state.awakeMs = millis() - start;
+	state.awakeAvgMs = state.awakeAvgMs ? (state.awakeAvgMs * 7 + state.awakeMs) / 8 : state.awakeMs;
+	saveState();
+
+	DEBUG_PRINT("Gateway cycle ");
+	DEBUG_PRINT(state.cycles);
+	DEBUG_PRINT(" awake ms ");
+	DEBUG_PRINT(state.awakeMs);
+	DEBUG_PRINT(", average ");
+	DEBUG_PRINT(state.awakeAvgMs);
+	DEBUG_PRINT(", sleeping s ");
+	DEBUG_PRINTLN(seconds);
+	ESP.deepSleep(seconds * 1000000ULL, WAKE_RF_DEFAULT);
+} // sleepFor()
+
+void runGatewayCycle()
+{
+	unsigned long start = millis();
+	bool warm = loadState();
+	if (!warm)
+	{
+		memset(&state, 0, sizeof(state));
+	}
+	state.cycles++;
+
+	// carry the clock across the sleep, check it against NTP now and then;
+	// set before the logon, which reuses the cached lease only while it can tell its age
+	bool ntpDue = !warm || state.cycles % GATEWAY_NTP_CYCLES == 0;
+	if (warm)
+	{
+		UTC.setTime(state.sleepEpoch + state.sleepSeconds + millis() / 1000);
+	}
+
+	logonToRouter();
+	if (!wifiOnline())
+	{
+		sleepFor(GATEWAY_RETRY, start);
+	}
+	if (ntpDue && !waitForSync(GATEWAY_NTP_WAIT) && !warm)
+	{
+		sleepFor(GATEWAY_RETRY, start); // no time at all, the schedule means nothing
+	}
+
+	uint32_t now = UTC.now();
+	bool aprsDue = !CALLSIGN.isEmpty() && (state.aprsDue == 0 || now + GATEWAY_EARLY >= state.aprsDue);
+	bool tsDue = !TS_WRITE_KEY.isEmpty() && (state.tsDue == 0 || now + GATEWAY_EARLY >= state.tsDue);
+	if (aprsDue || tsDue)
+	{
+		wx.obsLat = state.lat; // position until the fetch replaces it
+		wx.obsLon = state.lon;
+		finishWXcurrent();
+		if (wx.obsEpoch == 0)
+		{
+			sleepFor(GATEWAY_RETRY, start); // nothing to post
+		}
+		state.lat = wx.obsLat;
+		state.lon = wx.obsLon;
+
+		if (aprsDue && wx.obsEpoch != state.aprsSentObs)
+		{
+			postWXtoAPRS();
+			finishAPRSpost();
+			if (!APRSpending())
+			{
+				state.aprsSentObs = wx.obsEpoch;
+				state.aprsDue = nextSlot(now, WX_APRS_INTERVAL);
+			}
+		}
+		if (tsDue && wx.obsEpoch != state.tsSentObs)
+		{
+			unitStatus = "awake ms " + String(state.awakeMs) + ", average " + String(state.awakeAvgMs);
+			postWXtoThingspeak();
+			if (finishThingspeakUpload()) // nothing may stay buffered across the sleep
+			{
+				state.tsSentObs = wx.obsEpoch;
+				state.tsDue = nextSlot(now, TS_POST_INTERVAL);
+			}
+		}
+	}
+
+	// sleep until the next post, or retry soon if one is still waiting
+	now = UTC.now();
+	uint32_t wake = UINT32_MAX;
+	if (!CALLSIGN.isEmpty())
+	{
+		wake = min(wake, state.aprsDue > now ? state.aprsDue : now + GATEWAY_RETRY);
+	}
+	if (!TS_WRITE_KEY.isEmpty())
+	{
+		wake = min(wake, state.tsDue > now ? state.tsDue : now + GATEWAY_RETRY);
+	}
+	sleepFor(wake == UINT32_MAX ? GATEWAY_RETRY : wake - now, start);
+} // runGatewayCycle()
+
+// End of file
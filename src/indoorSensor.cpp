@@ -1,7 +1,11 @@
 /**
  * @file indoorSensor.cpp
  * @brief Indoor sensor functions
- * @details This file contains the functions to initialize and read the indoor sensor.
+ * @details This file contains the functions to initialize and sample the indoor sensor.
+ *          The Adafruit library's getEvent() triggers a measurement and then polls
+ *          the busy bit with delay() for about 80 ms. Here the library only
+ *          initializes and calibrates the sensor; the trigger and the six byte
+ *          read are separate passes of taskIndoorSensor.
  * @author Karl Berger
  * @date 2025-05-15
  */
@@ -11,6 +15,13 @@
 #include <Arduino.h>        // PlatformIO
 #include <Wire.h>           // I2C library
 #include <Adafruit_AHTX0.h> // Adafruit sensor library
+#include <sampleFilter.h>   // median and moving average from lib/wxcore
+#include "taskControl.h"    // for taskIndoorSensor
+
+#define AHT_ADDRESS 0x38 // AHT10/AHT20 I2C address
+#define AHT_BUSY 0x80    // status bit set while converting
+#define AHT_RETRY_MS 20  // wait again if still busy
+#define AHT_RETRIES 5    // then count a failure
 
 Adafruit_AHTX0 aht; // Create sensor object
 
@@ -18,6 +29,13 @@ Adafruit_AHTX0 aht; // Create sensor object
 bool indoorSensor = false;    // Default to false = no sesnor found
 SensorTH indoor = {0.0, 0.0}; // initialize global sensor variable
 
+sampleFilter tempFilter = SAMPLE_FILTER(0.3);  // about 30 s time constant at 10 s samples
+sampleFilter humidFilter = SAMPLE_FILTER(0.3);
+bool measuring = false;    // triggered, read on the next pass
+uint8_t busyPolls = 0;     // reads that found the conversion unfinished
+uint32_t readings = 0;     // measurements read
+uint32_t readErrors = 0;   // I2C failures and timeouts
+
 void initSensor()
 {
   Wire.begin(SDA, SCL); // Define I2C pins
@@ -25,13 +43,92 @@ void initSensor()
   indoorSensor = aht.begin(); // True if AHT10 sensor is found
 }
 
-void readSensor()
+// start a conversion, false if the sensor did not answer
+static bool triggerMeasurement()
+{
+  Wire.beginTransmission(AHT_ADDRESS);
+  Wire.write(0xAC); // trigger measurement
+  Wire.write(0x33);
+  Wire.write(0x00);
+  return Wire.endTransmission() == 0;
+} // triggerMeasurement()
+
+// read a finished conversion: 0 done, 1 still busy, -1 failed
+static int readMeasurement(float &tempC, float &humid)
 {
-  if (indoorSensor)
+  uint8_t data[6];
+  if (Wire.requestFrom((uint8_t)AHT_ADDRESS, (uint8_t)6) != 6)
+  {
+    return -1;
+  }
+  for (uint8_t &byte : data)
+  {
+    byte = Wire.read();
+  }
+  if (data[0] & AHT_BUSY)
   {
-    sensors_event_t humidity, temp;
-    aht.getEvent(&humidity, &temp);
-    indoor.tempC = temp.temperature;
-    indoor.humid = humidity.relative_humidity;
+    return 1;
   }
-}
\ No newline at end of file
+  // 20 bits of humidity then 20 bits of temperature, both fractions of 2^20
+  uint32_t rawHumid = ((uint32_t)data[1] << 12) | ((uint32_t)data[2] << 4) | (data[3] >> 4);
+  uint32_t rawTemp = ((uint32_t)(data[3] & 0x0F) << 16) | ((uint32_t)data[4] << 8) | data[5];
+  humid = rawHumid * 100.0 / 0x100000;
+  tempC = rawTemp * 200.0 / 0x100000 - 50;
+  return 0;
+} // readMeasurement()
+
+void sampleSensor()
+{
+  if (!indoorSensor)
+  {
+    return; // no sensor, the task is not rescheduled
+  }
+  if (!measuring)
+  {
+    measuring = triggerMeasurement();
+    busyPolls = 0;
+    if (!measuring)
+    {
+      readErrors++;
+    }
+    taskSchedule(taskIndoorSensor, measuring ? AHT_MEASURE_MS : INDOOR_SAMPLE_MS);
+    return;
+  }
+
+  float tempC, humid;
+  int result = readMeasurement(tempC, humid);
+  if (result == 1 && ++busyPolls < AHT_RETRIES)
+  {
+    taskSchedule(taskIndoorSensor, AHT_RETRY_MS); // still converting
+    return;
+  }
+  measuring = false;
+  if (result == 0)
+  {
+    readings++;
+    indoor.tempC = filterAdd(tempFilter, tempC);
+    indoor.humid = filterAdd(humidFilter, humid);
+  }
+  else
+  {
+    readErrors++;
+  }
+  taskSchedule(taskIndoorSensor, INDOOR_SAMPLE_MS - AHT_MEASURE_MS);
+} // sampleSensor()
+
+bool indoorReady()
+{
+  return readings > 0;
+}
+
+void printIndoorStats()
+{
+  if (!indoorSensor)
+  {
+    Serial.println("Indoor sensor: not found");
+    return;
+  }
+  Serial.printf("Indoor %.1f C %.0f%%, readings %u, errors %u\n", indoor.tempC, indoor.humid, readings, readErrors);
+} // printIndoorStats()
+
+// End of file
@@ -0,0 +1,455 @@
+/**
+ * @file localIngest.cpp
+ * @author Karl Berger
+ * @date 2025-06-19
+ * @brief Receive station uploads directly on the local network.
+ * @details The request is parsed a character at a time by a state machine that
+ *          keeps its place between calls, so each call only takes what has already
+ *          arrived and an upload trickling in never holds up the other tasks. One
+ *          client is served at a time; the next waits in the listener's backlog.
+ *          Only the current key and value are buffered, so the size of an upload
+ *          does not matter. Values
+ *          are collected in an `upload` first and copied to `wx` only when the
+ *          request carried a temperature, so a malformed request changes nothing.
+ *          Fields the station does not send keep their last cloud value.
+ *          When INGEST_PASSKEY is set, an upload must carry it as the WU PASSWORD
+ *          or the Ecowitt PASSKEY.
+ */
+
+#include "localIngest.h"
+
+#include <Arduino.h>		 // Arduino functions
+#include <ESP8266WiFi.h>	 // [builtin] WiFiServer
+#include <ezTime.h>			 // [manager] v0.8.3 Rop Gonggrijp https://github.com/ropg/ezTime
+#include "credentials.h"	 // INGEST_PORT, INGEST_PASSKEY and station id
+#include "unitConversions.h" // imperial to metric
+#include "weatherService.h"	 // weather data
+#include "wxEvents.h"		 // update events
+#include "wxHistory.h"		 // observation history
+#include "wug_debug.h"		 // debug print
+
+#define INGEST_KEY 16	// longest parameter name kept
+#define INGEST_VALUE 40 // longest parameter value kept, an Ecowitt PASSKEY is 32
+#define INGEST_LINE 48	// longest header line kept
+
+struct upload
+{
+	float temp = NAN;		   // Celsius
+	float humidity = NAN;	   // %
+	float dewPt = NAN;		   // Celsius
+	float windChill = NAN;	   // Celsius
+	float heatIndex = NAN;	   // Celsius
+	float windDir = NAN;	   // degrees
+	float windSpeed = NAN;	   // km/h
+	float windGust = NAN;	   // km/h
+	float pressure = NAN;	   // hPa at sea level
+	float precipRate = NAN;	   // mm/h
+	float precipTotal = NAN;   // mm since midnight
+	float solarRadiation = NAN; // W/m^2
+	float uv = NAN;			   // index
+	unsigned long epoch = 0;   // unix time UTC, 0 if not sent
+	bool wrongStation = false; // WU upload for another station id
+	bool keyMatched = false;   // PASSWORD or PASSKEY equals INGEST_PASSKEY
+};
+
+enum ingestPhase
+{
+	IN_METHOD,	// GET or POST
+	IN_PATH,	// path, not checked
+	IN_QUERY,	// query string parameters
+	IN_VERSION, // rest of the request line
+	IN_HEADERS, // header lines up to the blank one
+	IN_BODY,	// POST body parameters
+	IN_DONE		// ready for the reply
+};
+
+// request being received, kept from one call to the next
+struct ingestRequest
+{
+	bool active = false;			// a client is being served
+	WiFiClient client;				// its socket
+	unsigned long deadline = 0;		// millis() by which the request must have arrived
+	ingestPhase phase = IN_METHOD;	// where the parser is
+	upload data;					// values so far
+	char method[8];					// request method
+	int methodLength = 0;			// characters in method[]
+	char line[INGEST_LINE + 1];		// header line
+	int lineLength = 0;				// characters in line[]
+	long contentLength = 0;			// Content-Length header
+	long left = 0;					// query or body characters still accepted
+	char key[INGEST_KEY + 1];		// parameter name
+	char value[INGEST_VALUE + 1];	// parameter value
+	int keyLength = 0;				// characters in key[]
+	int valueLength = 0;			// characters in value[]
+	bool inValue = false;			// after the '='
+	int escape = 0;					// hex digits of a %XX still to come
+	int escaped = 0;				// %XX value so far
+};
+
+WiFiServer *ingestServer = nullptr;
+unsigned long lastLocalUpload = 0; // millis() of the last accepted upload
+uint32_t ingestAccepted = 0;	   // uploads stored in wx
+uint32_t ingestRejected = 0;	   // malformed or foreign uploads
+uint32_t ingestRefused = 0;		   // wrong or missing passkey
+ingestRequest request;			   // the client being served
+
+/*
+******************************************************
+****************** Request parsing *******************
+******************************************************
+*/
+static int hexDigit(int c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return 0;
+} // hexDigit()
+
+// "2025-06-19 14:05:00" or "now"
+static unsigned long parseDateUTC(const char *text)
+{
+	int year, month, day, hour, minute, second;
+	if (sscanf(text, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) == 6)
+	{
+		return makeTime(hour, minute, second, day, month, year);
+	}
+	return UTC.now();
+} // parseDateUTC()
+
+// store one decoded parameter, WU and Ecowitt names
+static void applyParam(upload &data, const char *key, const char *value)
+{
+	float number = atof(value);
+	if (strcasecmp(key, "tempf") == 0)
+		data.temp = FtoC(number);
+	else if (strcasecmp(key, "humidity") == 0)
+		data.humidity = number;
+	else if (strcasecmp(key, "dewptf") == 0)
+		data.dewPt = FtoC(number);
+	else if (strcasecmp(key, "windchillf") == 0)
+		data.windChill = FtoC(number);
+	else if (strcasecmp(key, "heatindexf") == 0)
+		data.heatIndex = FtoC(number);
+	else if (strcasecmp(key, "winddir") == 0)
+		data.windDir = number;
+	else if (strcasecmp(key, "windspeedmph") == 0)
+		data.windSpeed = MPHtoKMH(number);
+	else if (strcasecmp(key, "windgustmph") == 0)
+		data.windGust = MPHtoKMH(number);
+	else if (strcasecmp(key, "baromin") == 0 || strcasecmp(key, "baromrelin") == 0)
+		data.pressure = INHGtoHPA(number);
+	else if (strcasecmp(key, "rainin") == 0 || strcasecmp(key, "rainratein") == 0)
+		data.precipRate = INtoMM(number);
+	else if (strcasecmp(key, "dailyrainin") == 0)
+		data.precipTotal = INtoMM(number);
+	else if (strcasecmp(key, "solarradiation") == 0)
+		data.solarRadiation = number;
+	else if (strcasecmp(key, "uv") == 0)
+		data.uv = number;
+	else if (strcasecmp(key, "dateutc") == 0)
+		data.epoch = parseDateUTC(value);
+	else if (strcmp(key, "ID") == 0)
+		data.wrongStation = !WX_STATION_ID.equalsIgnoreCase(value);
+	else if (strcmp(key, "PASSWORD") == 0 || strcmp(key, "PASSKEY") == 0)
+		data.keyMatched = INGEST_PASSKEY == value;
+} // applyParam()
+
+// one character of key=value&key=value, c < 0 ends the list
+static void paramChar(ingestRequest &req, int c)
+{
+	if (c < 0 || c == '&')
+	{
+		if (req.inValue)
+		{
+			req.key[req.keyLength] = '\0';
+			req.value[req.valueLength] = '\0';
+			applyParam(req.data, req.key, req.value);
+		}
+		req.keyLength = req.valueLength = 0;
+		req.inValue = false;
+		req.escape = 0;
+		return;
+	}
+	if (req.escape > 0)
+	{
+		req.escaped = (req.escaped << 4) | hexDigit(c);
+		if (--req.escape > 0)
+		{
+			return;
+		}
+		c = req.escaped;
+	}
+	else if (c == '=' && !req.inValue)
+	{
+		req.inValue = true;
+		return;
+	}
+	else if (c == '+')
+	{
+		c = ' ';
+	}
+	else if (c == '%')
+	{
+		req.escape = 2;
+		req.escaped = 0;
+		return;
+	}
+	if (req.inValue && req.valueLength < INGEST_VALUE)
+	{
+		req.value[req.valueLength++] = c;
+	}
+	else if (!req.inValue && req.keyLength < INGEST_KEY)
+	{
+		req.key[req.keyLength++] = c;
+	}
+} // paramChar()
+
+// a header line is complete; the blank one ends the headers
+static void headerLine(ingestRequest &req)
+{
+	req.line[req.lineLength] = '\0';
+	if (req.lineLength > 0)
+	{
+		if (strncasecmp(req.line, "Content-Length:", 15) == 0)
+		{
+			req.contentLength = atol(req.line + 15);
+		}
+		req.lineLength = 0;
+		return;
+	}
+	req.method[req.methodLength] = '\0';
+	if (strcmp(req.method, "POST") == 0 && req.contentLength > 0)
+	{
+		req.left = min(req.contentLength, (long)INGEST_MAX_BODY);
+		req.phase = IN_BODY;
+	}
+	else
+	{
+		req.phase = IN_DONE;
+	}
+} // headerLine()
+
+/**
+ * @brief Advance the request parser by one character.
+ * @param c next character, -1 when the request ends early (closed or timed out)
+ */
+static void requestChar(ingestRequest &req, int c)
+{
+	if (c < 0)
+	{
+		paramChar(req, -1); // keep a parameter cut short, as a complete one
+		req.phase = IN_DONE;
+		return;
+	}
+	switch (req.phase)
+	{
+	case IN_METHOD: // request line: METHOD /path?query HTTP/1.1
+		if (c == ' ')
+		{
+			req.phase = IN_PATH;
+		}
+		else if (req.methodLength < (int)sizeof(req.method) - 1)
+		{
+			req.method[req.methodLength++] = c;
+		}
+		break;
+	case IN_PATH: // stations let the user choose it
+		if (c == '?')
+		{
+			req.left = INGEST_MAX_BODY;
+			req.phase = IN_QUERY;
+		}
+		else if (c == ' ')
+		{
+			req.phase = IN_VERSION;
+		}
+		break;
+	case IN_QUERY:
+		if (c == ' ')
+		{
+			paramChar(req, -1);
+			req.phase = IN_VERSION;
+			break;
+		}
+		paramChar(req, c);
+		if (--req.left == 0)
+		{
+			paramChar(req, -1);
+			req.phase = IN_VERSION; // the rest of a long query is skipped with the line
+		}
+		break;
+	case IN_VERSION:
+		if (c == '\n')
+		{
+			req.phase = IN_HEADERS;
+		}
+		break;
+	case IN_HEADERS:
+		if (c == '\n')
+		{
+			headerLine(req);
+		}
+		else if (c != '\r' && req.lineLength < INGEST_LINE)
+		{
+			req.line[req.lineLength++] = c;
+		}
+		break;
+	case IN_BODY:
+		paramChar(req, c);
+		if (--req.left == 0)
+		{
+			paramChar(req, -1);
+			req.phase = IN_DONE;
+		}
+		break;
+	case IN_DONE:
+		break;
+	}
+} // requestChar()
+
+// Magnus formula, for stations that do not send a dew point
+static float dewPoint(float tempC, float humidity)
+{
+	float gamma = log(max(humidity, 1.0f) / 100.0f) + 17.62f * tempC / (243.12f + tempC);
+	return 243.12f * gamma / (17.62f - gamma);
+} // dewPoint()
+
+static void storeUpload(const upload &data)
+{
+	wx.obsEpoch = data.epoch ? data.epoch : UTC.now();
+	wx.obsTemp = data.temp;
+	if (!isnan(data.humidity))
+		wx.obsHumidity = data.humidity;
+	wx.obsDewPt = !isnan(data.dewPt) ? data.dewPt : dewPoint(wx.obsTemp, wx.obsHumidity);
+	wx.obsWindChill = !isnan(data.windChill) ? data.windChill : wx.obsTemp;
+	wx.obsHeatIndex = !isnan(data.heatIndex) ? data.heatIndex : wx.obsTemp;
+	if (!isnan(data.windDir))
+		wx.obsWindDir = data.windDir;
+	if (!isnan(data.windSpeed))
+		wx.obsWindSpeed = data.windSpeed;
+	if (!isnan(data.windGust))
+		wx.obsWindGust = data.windGust;
+	if (!isnan(data.pressure))
+		wx.obsPressure = data.pressure;
+	if (!isnan(data.precipRate))
+		wx.obsPrecipRate = data.precipRate;
+	if (!isnan(data.precipTotal))
+		wx.obsPrecipTotal = data.precipTotal;
+	if (!isnan(data.solarRadiation))
+		wx.obsSolarRadiation = data.solarRadiation;
+	if (!isnan(data.uv))
+		wx.obsUV = data.uv;
+	historyRecordWX();
+	publishWXupdate(); // uplinks and display
+} // storeUpload()
+
+static void reply(WiFiClient &client, const char *status, const char *body)
+{
+	client.printf("HTTP/1.1 %s\r\nContent-Type: text/plain\r\nContent-Length: %u\r\nConnection: close\r\n\r\n%s",
+				  status, strlen(body), body);
+	client.stop();
+} // reply()
+
+/*
+******************************************************
+********************* Public *************************
+******************************************************
+*/
+void beginLocalIngest()
+{
+	if (INGEST_PORT == 0 || ingestServer != nullptr)
+	{
+		return;
+	}
+	ingestServer = new WiFiServer(INGEST_PORT);
+	ingestServer->begin();
+	DEBUG_PRINT("Local upload listener on port ");
+	DEBUG_PRINTLN(INGEST_PORT);
+} // beginLocalIngest()
+
+// answer a completely received request and let the next client in
+static void finishRequest(ingestRequest &req)
+{
+	req.active = false;
+	const upload &data = req.data;
+	if (!INGEST_PASSKEY.isEmpty() && !data.keyMatched)
+	{
+		ingestRefused++;
+		reply(req.client, "401 Unauthorized", "bad passkey\n");
+		return;
+	}
+	if (isnan(data.temp) || data.wrongStation)
+	{
+		ingestRejected++;
+		reply(req.client, "400 Bad Request", "rejected\n");
+		return;
+	}
+	storeUpload(data);
+	lastLocalUpload = millis();
+	ingestAccepted++;
+	reply(req.client, "200 OK", "success\n");
+	DEBUG_PRINTLN("Local upload stored");
+} // finishRequest()
+
+void handleLocalIngest()
+{
+	if (ingestServer == nullptr)
+	{
+		return;
+	}
+	if (!request.active)
+	{
+		if (!ingestServer->hasClient())
+		{
+			return;
+		}
+		request = ingestRequest(); // fresh parser state
+		request.client = ingestServer->accept();
+		request.deadline = millis() + INGEST_TIMEOUT;
+		request.active = true;
+	}
+
+	// only what has arrived; the rest waits for the next call
+	while (request.phase != IN_DONE && request.client.available() > 0)
+	{
+		requestChar(request, request.client.read());
+	}
+	if (request.phase != IN_DONE && (!request.client.connected() || (long)(millis() - request.deadline) >= 0))
+	{
+		requestChar(request, -1); // closed or too slow: answer what came
+	}
+	if (request.phase == IN_DONE)
+	{
+		finishRequest(request);
+	}
+} // handleLocalIngest()
+
+bool localDataFresh()
+{
+	return ingestAccepted > 0 && millis() - lastLocalUpload < INGEST_FRESH_MS;
+}
+
+void printIngestStats()
+{
+	if (ingestServer == nullptr)
+	{
+		Serial.println("Local uploads disabled");
+		return;
+	}
+	Serial.printf("Local uploads on port %u: %u accepted, %u rejected, %u refused, ", INGEST_PORT, ingestAccepted,
+				  ingestRejected, ingestRefused);
+	if (ingestAccepted > 0)
+	{
+		Serial.printf("last %lu s ago\n", (millis() - lastLocalUpload) / 1000);
+	}
+	else
+	{
+		Serial.println("none yet");
+	}
+} // printIngestStats()
+
+// End of file
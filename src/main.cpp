@@ -7,7 +7,6 @@
  *          from the Weather Underground API, and formats it for display and posting to
  *          ThingSpeak, and APRS-IS.
  * @todo read day/night indicator and choose json data accordingly
- * @todo add APRS bulletin for sunrise/sunset
  * @todo test WUG API responses for absence. Do not update WX data if response missing
  * @todo add WiFiManager for configuration or SCPI commands
  *
@@ -16,6 +15,8 @@
 
 #define WUG_DEBUG //! uncomment this line for serial debug output
 
+#define DATA_SCREEN_HOLD 2000 //! minimum ms the data screen stays up
+
 /*
 ******************************************************
 ******************** INCLUDES ************************
@@ -25,9 +26,14 @@
 #include "analogClock.h"       // analog clock functions
 #include "aphorismGenerator.h" // aphorism functions
 #include "aprsService.h"       // APRS functions
+#include "bootProfile.h"       // boot phase timing
+#include "connectionPool.h"    // shared keep-alive sockets
 #include "credentials.h"       // account information
 #include "digitalClock.h"      // digital clock display
+#include "gatewayMode.h"       // headless deep sleep cycle
+#include "endpointPolicy.h"    // retry after an outage
 #include "indoorSensor.h"      // indoor sensor functions
+#include "localIngest.h"       // station uploads on the LAN
 #include "onetimeScreens.h"    // splash screen and information screens
 #include "sequentialFrames.h"  // sequential weather, almanac, and clock frames
 #include "taskControl.h"       // task control functions
@@ -38,6 +44,8 @@
 #include "weatherService.h"    // weather data from Weather Underground API
 #include "wifiConnection.h"    // Wi-Fi connection
 #include "wug_debug.h"         // debug print macro
+#include "wxHistory.h"         // observation history
+#include "wxShare.h"           // weather snapshots shared on the LAN
 
 /*
 ******************************************************
@@ -47,17 +55,46 @@
 void setup()
 {
   Serial.begin(115200); // initialize serial monitor
-  initSensor();         // initialize indoor sensor
+  initTaskClocks();     // millisecond clock for the scheduler and coroutines
+  if (HEADLESS_GATEWAY)
+  {
+    runGatewayCycle(); // fetch, post and deep sleep, does not return
+  }
+  bootMark("serial");
+  beginWiFi();          // the radio associates while the local work below is done
   setupTFTdisplay();    // initialize TFT display
   showSplashScreen();   // stays on until logon is complete
-  logonToRouter();      // connect to WiFi
-  getWXcurrent();       // find latitude & longitude for your weather station
-  setTimeZone();        // set timezone
+  bootMark("splash");
+  initSensor();         // initialize indoor sensor
+  bootMark("sensor");
   mountFS();            // mount LittleFS and prepare APRS bulletin file
+  bootMark("file system");
+  historyRestore();     // the last week of observations from the log
+  bootMark("history log");
+  waitForWiFi();        // connect to WiFi
+  bootMark("wifi");
+  beginLocalIngest();   // listen for station uploads on the LAN
+  beginShare();         // join the display group, a follower waits for a snapshot
+  onWiFiRestored(resetConnections); // sockets from the old link are dead
+  onWiFiRestored(policyRetryAll);   // outage failures are not server failures
+  onWiFiRestored(restartShare);     // rejoin the multicast group
+  onWiFiRestored(catchUpWeather);   // refresh data that went stale offline
+  getWXcurrent();       // send the request, the server answers while NTP syncs
+  setTimeZone();        // set timezone
+  bootMark("ntp");
+  finishWXcurrent();    // find latitude & longitude for your weather station
+  bootMark("current wx");
   showDataScreen();     // show configuration data
+  unsigned long shown = millis();
+  bootMark("data screen");
   getWXforecast();      // initialize weather API: needs lat/lon from getWXcurrent
-  delay(2000);          // delay to show connection info
-  startTasks();         // start the scheduled tasks
+  getWXhistory();       // backfill the last 24 hours of observations
+  bootMark("forecast");
+  while (millis() - shown < DATA_SCREEN_HOLD)
+  {
+    delay(10); // show connection info for what is left of the hold
+  }
+  startTasks();         // start the scheduled tasks, the first frame replaces the data screen
 } // setup()
 
 /*
@@ -67,10 +104,7 @@ void setup()
 */
 void loop()
 {
-  checkWiFiConnection(); // check Wi-Fi connection status
-  events();              // ezTime events including autoconnect to NTP server
-  processBulletins();    // process APRS bulletins
-  updateTasks();         // update the scheduled tasks
+  updateTasks(); // run due tasks, then idle until the next deadline
 } // loop()
 
 /*
@@ -0,0 +1,417 @@
+/**
+ * @file mqttPublisher.cpp
+ * @author Karl Berger
+ * @date 2025-06-18
+ * @brief MQTT output of the station observation and indoor sensor.
+ * @details A minimal MQTT 3.1.1 client: CONNECT with a last will, PUBLISH at QoS 0 or 1,
+ *          PUBACK handling and PINGREQ keep-alive. Nothing is subscribed. Packets are
+ *          coded by mqttPacket.h in lib/wxcore, which the gateway's broker stand-in tests. The socket
+ *          comes from the connection pool and is held for as long as the broker keeps it.
+ *          Each topic has one in-flight slot, so a newer observation replaces an older
+ *          one that was never acknowledged.
+ *          Waiting for the CONNACK and for the rest of an incoming packet are protothreads
+ *          resumed by mqttLoop(), each with a deadline, so a slow broker never holds up
+ *          the other tasks.
+ */
+
+#include "mqttPublisher.h"
+
+#include <Arduino.h>		// Arduino functions
+#include <ArduinoJson.h>	// [manager] v7.2 Benoit Blanchon https://arduinojson.org/
+#include "connectionPool.h" // shared sockets
+#include "credentials.h"	// MQTT broker settings
+#include "endpointPolicy.h" // reconnect backoff
+#include "indoorSensor.h"	// indoor readings
+#include <mqttPacket.h>		// packet coding from lib/wxcore
+#include <protothread.h>	// CONNACK and packet readers from lib/wxcore
+#include "weatherService.h" // weather data
+#include "wug_debug.h"		// debug print
+
+enum mqttTopic
+{
+	TOPIC_WX,	  // outdoor observation
+	TOPIC_INDOOR, // indoor sensor
+	TOPICS		  // number of in-flight slots
+};
+
+struct mqttMessage
+{
+	bool waiting;		   // not yet acknowledged
+	uint16_t id;		   // packet identifier
+	String payload;		   // JSON text
+	unsigned long sentAt;  // millis() of the last send, 0 if never sent
+};
+
+// packet arriving from the broker
+struct mqttIncoming
+{
+	protothread pt;	   // reader state
+	uint32_t deadline; // ptClock() time the whole packet must have arrived by
+	uint8_t type;	   // fixed header type and flags
+	size_t length;	   // remaining length
+	int shift;		   // bit position of the next length digit
+	int digit;		   // last length digit, -1 if none came
+	size_t got;		   // body bytes read so far
+	uint8_t body[4];   // start of the body, nothing we accept is longer
+};
+
+// CONNECT in progress
+struct mqttSession
+{
+	protothread pt;	   // connect state
+	uint32_t deadline; // ptClock() time the CONNACK must have arrived by
+	uint8_t ack[4];	   // CONNACK: 0x20 0x02 session-present return-code
+	size_t got;		   // CONNACK bytes read so far
+	String willTopic;  // "<MQTT_TOPIC>/status"
+};
+
+const char *const TOPIC_SUFFIX[TOPICS] = {"/wx", "/indoor"};
+
+//! back off 5 s doubling to 5 min, open the circuit for 10 min after 5 failures
+const retryPolicy MQTT_POLICY = {5000UL, 300000UL, 5, 600000UL};
+endpointHealth mqttHealth = ENDPOINT_HEALTH("mqtt", MQTT_POLICY);
+
+WiFiClient *mqttClient = nullptr; // broker socket while connected
+bool brokerReady = false;		  // CONNACK accepted, packets may be sent
+mqttSession session;			  // connect protothread
+mqttIncoming incoming;			  // packet reader protothread
+mqttMessage inflight[TOPICS];	  // QoS 1 messages awaiting PUBACK
+uint16_t nextPacketId = 1;		  // never 0
+unsigned long lastSent = 0;		  // millis() of the last packet sent
+unsigned long pingSentAt = 0;	  // millis() of an unanswered PINGREQ, 0 if none
+uint8_t packet[MQTT_MAX_PACKET];  // packet assembly buffer
+
+/*
+******************************************************
+***************** Packet helpers *********************
+******************************************************
+*/
+// milliseconds left until deadline, 0 once it has passed
+static uint32_t timeLeft(uint32_t deadline)
+{
+	int32_t left = (int32_t)(deadline - ptClock());
+	return left > 0 ? left : 0;
+}
+
+// send a fixed header followed by the first length bytes of packet[]
+static bool sendPacket(uint8_t type, size_t length)
+{
+	uint8_t header[MQTT_HEADER_MAX];
+	size_t used = mqttHeader(header, type, length);
+	bool ok = mqttClient->write(header, used) == used && mqttClient->write(packet, length) == length;
+	lastSent = millis();
+	return ok;
+} // sendPacket()
+
+static void disconnectBroker()
+{
+	if (mqttClient)
+	{
+		releaseConnection(mqttClient, false);
+		mqttClient = nullptr;
+	}
+	brokerReady = false;
+	PT_INIT(&session.pt);
+	PT_INIT(&incoming.pt);
+	pingSentAt = 0;
+	for (int t = 0; t < TOPICS; t++)
+	{
+		inflight[t].sentAt = 0; // resend after reconnect
+	}
+} // disconnectBroker()
+
+static bool publish(const String &topic, const String &payload, uint8_t qos, uint16_t id, bool dup)
+{
+	size_t length = mqttPublishBody(packet, sizeof(packet), topic.c_str(), (const uint8_t *)payload.c_str(),
+									payload.length(), qos, id);
+	if (length == 0)
+	{
+		DEBUG_PRINTLN("MQTT: message too long");
+		return false;
+	}
+	return sendPacket(mqttPublishType(qos, dup, true), length); // always retained
+} // publish()
+
+static void sendInflight(int t)
+{
+	mqttMessage &message = inflight[t];
+	bool dup = message.sentAt != 0;
+	if (publish(MQTT_TOPIC + TOPIC_SUFFIX[t], message.payload, 1, message.id, dup))
+	{
+		message.sentAt = max(millis(), 1UL);
+	}
+} // sendInflight()
+
+/*
+******************************************************
+******************* Connection ***********************
+******************************************************
+*/
+// open the socket and send CONNECT, false on failure
+static bool sendConnect()
+{
+	bool reused;
+	mqttClient = acquireConnection(MQTT_BROKER.c_str(), MQTT_PORT, false, reused, 0); // held while the session lasts
+	if (mqttClient == nullptr)
+	{
+		return false;
+	}
+	mqttClient->setNoDelay(true);
+
+	// stable client id so the broker can keep the session
+	String clientId = "wug-" + String(ESP.getChipId(), HEX);
+	session.willTopic = MQTT_TOPIC + "/status";
+	mqttConnectFields fields = {clientId.c_str(), session.willTopic.c_str(), "offline", 1, true,
+								MQTT_USER.c_str(), MQTT_PASSWORD.c_str(), MQTT_KEEPALIVE, false};
+	size_t length = mqttConnectBody(packet, sizeof(packet), fields);
+	if (length == 0)
+	{
+		DEBUG_PRINTLN("MQTT: connect too long");
+		return false;
+	}
+	return sendPacket(MQTT_CONNECT, length);
+} // sendConnect()
+
+// protothread: connect and await the CONNACK
+static ptState connectBroker(protothread *pt)
+{
+	PT_BEGIN(pt);
+	if (!sendConnect())
+	{
+		disconnectBroker();
+		policyFailure(mqttHealth);
+		PT_EXIT(pt);
+	}
+
+	session.deadline = ptClock() + MQTT_CONNECT_TIMEOUT;
+	session.got = 0;
+	memset(session.ack, 0, sizeof(session.ack));
+	while (session.got < sizeof(session.ack))
+	{
+		PT_AWAIT_READABLE(pt, *mqttClient, timeLeft(session.deadline));
+		if (mqttClient->available() <= 0)
+		{
+			break; // timed out or closed
+		}
+		while (session.got < sizeof(session.ack) && mqttClient->available() > 0)
+		{
+			session.ack[session.got++] = mqttClient->read();
+		}
+	}
+	if (session.got < sizeof(session.ack) || session.ack[0] != MQTT_CONNACK || session.ack[3] != 0)
+	{
+		DEBUG_PRINT("MQTT: connect refused ");
+		DEBUG_PRINTLN(session.ack[3]);
+		disconnectBroker();
+		policyFailure(mqttHealth);
+		PT_EXIT(pt);
+	}
+	policySuccess(mqttHealth);
+	brokerReady = true;
+	DEBUG_PRINT("MQTT connected, session ");
+	DEBUG_PRINTLN((session.ack[2] & 0x01) ? "resumed" : "new");
+
+	publish(session.willTopic, "online", 0, 0, false);
+	for (int t = 0; t < TOPICS; t++)
+	{
+		if (inflight[t].waiting)
+		{
+			sendInflight(t); // unacknowledged before the disconnect
+		}
+	}
+	PT_END(pt);
+} // connectBroker()
+
+// act on one whole packet
+static void handlePacket()
+{
+	if ((incoming.type & 0xF0) == MQTT_PUBACK)
+	{
+		uint16_t id = (incoming.body[0] << 8) | incoming.body[1];
+		for (int t = 0; t < TOPICS; t++)
+		{
+			if (inflight[t].waiting && inflight[t].id == id)
+			{
+				inflight[t].waiting = false;
+				inflight[t].payload = "";
+			}
+		}
+	}
+	else if ((incoming.type & 0xF0) == MQTT_PINGRESP)
+	{
+		pingSentAt = 0;
+	}
+} // handlePacket()
+
+// protothread: read one packet, started once its first byte has arrived
+static ptState readPacket(protothread *pt)
+{
+	PT_BEGIN(pt);
+	incoming.deadline = ptClock() + MQTT_READ_TIMEOUT;
+	incoming.type = mqttClient->read();
+	incoming.length = 0;
+	incoming.shift = 0;
+	do
+	{
+		PT_AWAIT_READABLE(pt, *mqttClient, timeLeft(incoming.deadline));
+		incoming.digit = mqttClient->read();
+		if (incoming.digit < 0 || incoming.shift > 21)
+		{
+			disconnectBroker(); // malformed, closed or stalled
+			PT_EXIT(pt);
+		}
+		incoming.length |= (size_t)(incoming.digit & 0x7F) << incoming.shift;
+		incoming.shift += 7;
+	} while (incoming.digit & 0x80);
+
+	incoming.got = 0;
+	memset(incoming.body, 0, sizeof(incoming.body));
+	while (incoming.got < incoming.length)
+	{
+		PT_AWAIT_READABLE(pt, *mqttClient, timeLeft(incoming.deadline));
+		if (mqttClient->available() <= 0)
+		{
+			disconnectBroker(); // closed or stalled part way through
+			PT_EXIT(pt);
+		}
+		while (incoming.got < incoming.length && mqttClient->available() > 0)
+		{
+			int c = mqttClient->read(); // nothing we accept is longer than body[]
+			if (incoming.got < sizeof(incoming.body))
+			{
+				incoming.body[incoming.got] = c;
+			}
+			incoming.got++;
+		}
+	}
+	handlePacket();
+	PT_END(pt);
+} // readPacket()
+
+// read whatever has arrived, leaving a partial packet for the next call
+static void readPackets()
+{
+	while (mqttClient && (incoming.pt.line != 0 || mqttClient->available() > 0))
+	{
+		if (readPacket(&incoming.pt) == PT_WAITING)
+		{
+			return;
+		}
+	}
+} // readPackets()
+
+/*
+******************************************************
+********************* Public *************************
+******************************************************
+*/
+void mqttLoop()
+{
+	if (MQTT_BROKER.isEmpty())
+	{
+		return;
+	}
+	if (session.pt.line != 0)
+	{
+		connectBroker(&session.pt); // awaiting the CONNACK
+		return;
+	}
+	if (!brokerReady || !mqttClient->connected())
+	{
+		if (mqttClient)
+		{
+			DEBUG_PRINTLN("MQTT: connection lost");
+			disconnectBroker();
+		}
+		if (policyAllow(mqttHealth))
+		{
+			connectBroker(&session.pt);
+		}
+		return;
+	}
+
+	readPackets();
+	if (mqttClient == nullptr)
+	{
+		return;
+	}
+
+	unsigned long now = millis();
+	if (pingSentAt != 0 && now - pingSentAt > MQTT_KEEPALIVE * 1000UL)
+	{
+		DEBUG_PRINTLN("MQTT: no ping response");
+		disconnectBroker();
+		return;
+	}
+	if (pingSentAt == 0 && now - lastSent > MQTT_KEEPALIVE * 750UL)
+	{
+		sendPacket(MQTT_PINGREQ, 0);
+		pingSentAt = max(now, 1UL);
+	}
+	for (int t = 0; t < TOPICS; t++)
+	{
+		if (inflight[t].waiting && (inflight[t].sentAt == 0 || now - inflight[t].sentAt > MQTT_ACK_TIMEOUT))
+		{
+			sendInflight(t);
+		}
+	}
+} // mqttLoop()
+
+// queue or send one message
+static void publishTopic(int t, const String &payload)
+{
+	if (MQTT_QOS == 0)
+	{
+		if (brokerReady && mqttClient->connected())
+		{
+			publish(MQTT_TOPIC + TOPIC_SUFFIX[t], payload, 0, 0, false);
+		}
+		return; // the next observation replaces a missed one
+	}
+	inflight[t].waiting = true;
+	inflight[t].id = nextPacketId;
+	inflight[t].payload = payload;
+	inflight[t].sentAt = 0;
+	nextPacketId = (nextPacketId == UINT16_MAX) ? 1 : nextPacketId + 1;
+	if (brokerReady && mqttClient->connected())
+	{
+		sendInflight(t);
+	}
+} // publishTopic()
+
+void publishWXtoMQTT()
+{
+	if (MQTT_BROKER.isEmpty())
+	{
+		return;
+	}
+
+	JsonDocument doc;
+	doc["ts"] = wx.obsEpoch;
+	doc["t"] = wx.obsTemp;
+	doc["h"] = wx.obsHumidity;
+	doc["dp"] = wx.obsDewPt;
+	doc["p"] = wx.obsPressure;
+	doc["ws"] = wx.obsWindSpeed;
+	doc["wg"] = wx.obsWindGust;
+	doc["wd"] = wx.obsWindDir;
+	doc["sr"] = wx.obsSolarRadiation;
+	doc["uv"] = wx.obsUV;
+	doc["rr"] = wx.obsPrecipRate;
+	doc["rt"] = wx.obsPrecipTotal;
+	String payload;
+	serializeJson(doc, payload);
+	publishTopic(TOPIC_WX, payload);
+
+	if (indoorSensor && indoorReady())
+	{
+		doc.clear(); // filtered values cached by taskIndoorSensor
+		doc["t"] = indoor.tempC;
+		doc["h"] = indoor.humid;
+		payload = "";
+		serializeJson(doc, payload);
+		publishTopic(TOPIC_INDOOR, payload);
+	}
+} // publishWXtoMQTT()
+
+// End of file
@@ -0,0 +1,170 @@
+/**
+ * @file netTiming.cpp
+ * @author Karl Berger
+ * @date 2025-06-16
+ * @brief Phase timing of outbound network operations.
+ * @details Each endpoint has its own operation clock, because coroutines let operations
+ *          on different endpoints overlap. netTimingMark() and netTimingEnd() apply to the
+ *          operation begun last, which is right for code that has not waited since;
+ *          code that resumes after a wait names its endpoint. Marks made while no
+ *          operation is active (for example a pool connection outside a timed request)
+ *          are ignored.
+ */
+
+#include "netTiming.h"
+
+#include <Arduino.h> // Arduino functions
+
+const char *const ENDPOINT_NAMES[NET_ENDPOINTS] = {"wx current", "wx forecast", "wx history", "thingspeak", "aprs"};
+const char *const PHASE_NAMES[NET_PHASES] = {"dns", "connect", "tls", "1st byte", "body", "parse"};
+
+struct phaseStats
+{
+	uint16_t bucket[NET_BUCKETS]; // counts per power of two milliseconds
+	uint32_t totalMs;			  // sum for the mean
+	uint32_t maxMs;				  // longest seen
+};
+
+struct endpointStats
+{
+	phaseStats phase[NET_PHASES];
+	uint32_t total[NET_BUCKETS]; // whole operation histogram
+	uint32_t ok;				 // successful operations
+	uint32_t failed;			 // failed operations
+};
+
+endpointStats netStats[NET_ENDPOINTS];
+int currentEndpoint = -1;					 // operation begun last, -1 if none
+bool active[NET_ENDPOINTS];					 // operation in progress
+unsigned long operationStart[NET_ENDPOINTS]; // micros() at begin
+unsigned long phaseStart[NET_ENDPOINTS];	 // micros() at the last mark
+
+static int bucketFor(uint32_t ms)
+{
+	int bucket = 0;
+	while (ms > 0 && bucket < NET_BUCKETS - 1)
+	{
+		ms >>= 1;
+		bucket++;
+	}
+	return bucket;
+} // bucketFor()
+
+void netTimingBegin(netEndpoint endpoint)
+{
+	currentEndpoint = endpoint;
+	active[endpoint] = true;
+	operationStart[endpoint] = micros();
+	phaseStart[endpoint] = operationStart[endpoint];
+}
+
+void netTimingMarkFor(netEndpoint endpoint, netPhase phase)
+{
+	if (!active[endpoint])
+	{
+		return;
+	}
+	unsigned long now = micros();
+	uint32_t ms = (now - phaseStart[endpoint]) / 1000;
+	phaseStats &stats = netStats[endpoint].phase[phase];
+	uint16_t &count = stats.bucket[bucketFor(ms)];
+	if (count < UINT16_MAX)
+	{
+		count++;
+	}
+	stats.totalMs += ms;
+	stats.maxMs = max(stats.maxMs, ms);
+	phaseStart[endpoint] = now;
+} // netTimingMarkFor()
+
+void netTimingMark(netPhase phase)
+{
+	if (currentEndpoint >= 0)
+	{
+		netTimingMarkFor((netEndpoint)currentEndpoint, phase);
+	}
+}
+
+void netTimingSkip()
+{
+	if (currentEndpoint >= 0)
+	{
+		phaseStart[currentEndpoint] = micros();
+	}
+}
+
+void netTimingEndFor(netEndpoint endpoint, bool success)
+{
+	if (!active[endpoint])
+	{
+		return;
+	}
+	endpointStats &stats = netStats[endpoint];
+	stats.total[bucketFor((micros() - operationStart[endpoint]) / 1000)]++;
+	if (success)
+	{
+		stats.ok++;
+	}
+	else
+	{
+		stats.failed++;
+	}
+	active[endpoint] = false;
+	if (currentEndpoint == endpoint)
+	{
+		currentEndpoint = -1;
+	}
+} // netTimingEndFor()
+
+void netTimingEnd(bool success)
+{
+	if (currentEndpoint >= 0)
+	{
+		netTimingEndFor((netEndpoint)currentEndpoint, success);
+	}
+}
+
+void printNetTiming()
+{
+	Serial.print("Network timing (ms buckets <1 <2 <4 ... >=");
+	Serial.print(1 << (NET_BUCKETS - 2));
+	Serial.println(")");
+	for (int e = 0; e < NET_ENDPOINTS; e++)
+	{
+		endpointStats &stats = netStats[e];
+		if (stats.ok + stats.failed == 0)
+		{
+			continue;
+		}
+		Serial.printf("%s: %u ok, %u failed\n", ENDPOINT_NAMES[e], stats.ok, stats.failed);
+		Serial.print("\ttotal\t\t");
+		for (int b = 0; b < NET_BUCKETS; b++)
+		{
+			Serial.print(stats.total[b]);
+			Serial.print(' ');
+		}
+		Serial.println();
+		for (int p = 0; p < NET_PHASES; p++)
+		{
+			phaseStats &phase = stats.phase[p];
+			uint32_t count = 0;
+			for (int b = 0; b < NET_BUCKETS; b++)
+			{
+				count += phase.bucket[b];
+			}
+			if (count == 0)
+			{
+				continue;
+			}
+			Serial.printf("\t%-8s mean %u max %u:\t", PHASE_NAMES[p], phase.totalMs / count, phase.maxMs);
+			for (int b = 0; b < NET_BUCKETS; b++)
+			{
+				Serial.print(phase.bucket[b]);
+				Serial.print(' ');
+			}
+			Serial.println();
+		}
+	}
+} // printNetTiming()
+
+// End of file
@@ -0,0 +1,434 @@
+/**
+ * @file obsLog.cpp
+ * @author Karl Berger
+ * @date 2025-07-06
+ * @brief Append-only observation log on LittleFS.
+ * @details A record is the wxSample fields written little-endian, OBSLOG_RECORD
+ *          bytes, so the file does not depend on the struct's padding. Files are
+ *          read through a small buffer; the boot scan reads both files once,
+ *          checking, indexing and replaying in the same pass.
+ */
+
+#include "obsLog.h"
+
+#include <Arduino.h>	  // Arduino functions
+#include <LittleFS.h>	  // [builtin] log files
+#include <logFrame.h>	  // CRC-framed records from lib/wxcore
+#include "taskControl.h" // for taskLogFlush
+#include "wug_debug.h"	  // debug print macro
+
+#define OBSLOG_RECORD 21 // payload bytes of a record
+#define OBSLOG_FRAME (OBSLOG_RECORD + FRAME_OVERHEAD)
+#define READ_BUFFER 256 // bytes read from flash at a time
+
+enum logSegment // index of a file in SEGMENT_FILES
+{
+	SEGMENT_OLD,
+	SEGMENT_CURRENT,
+	SEGMENTS
+};
+const char *const SEGMENT_FILES[SEGMENTS] = {OBSLOG_OLD_FILE, OBSLOG_FILE};
+
+struct logIndexEntry
+{
+	uint32_t epoch;	 // time of the record
+	uint16_t offset; // frame position in its file
+	uint8_t segment; // logSegment
+};
+
+struct logStats
+{
+	uint32_t records[SEGMENTS]; // records in each file
+	uint32_t bytes[SEGMENTS];	// size of each file
+	uint32_t writes;			// batches written
+	uint32_t written;			// records written
+	uint32_t rotations;			// files replaced
+	uint32_t corrupt;			// bytes skipped over bad frames at boot
+	uint32_t tornBytes;			// bytes cut off the end at boot
+	uint32_t replayed;			// records replayed at boot
+	uint32_t rebuildMs;			// boot scan and replay time
+	uint32_t failures;			// writes that did not complete
+};
+
+bool logOpen = false; // beginObsLog() has run
+logStats logCount = {};
+uint32_t logNewest = 0; // time of the newest record, written or queued
+wxSample pending[OBSLOG_BATCH];
+int pendingCount = 0;
+logIndexEntry logIndex[OBSLOG_INDEX_SLOTS];
+int indexCount = 0;
+
+/*
+******************************************************
+***************** Record coding **********************
+******************************************************
+*/
+static void put16(uint8_t *&out, uint16_t value)
+{
+	*out++ = value;
+	*out++ = value >> 8;
+}
+
+static uint16_t get16(const uint8_t *&in)
+{
+	uint16_t value = in[0] | (in[1] << 8);
+	in += 2;
+	return value;
+}
+
+static void packRecord(const wxSample &sample, uint8_t *out)
+{
+	put16(out, sample.epoch);
+	put16(out, sample.epoch >> 16);
+	put16(out, sample.tempHigh);
+	put16(out, sample.tempLow);
+	put16(out, sample.pressure);
+	put16(out, sample.windSpeed);
+	put16(out, sample.windGust);
+	put16(out, sample.precipTotal);
+	put16(out, sample.solar);
+	put16(out, sample.indoorTemp);
+	*out = sample.humidity;
+} // packRecord()
+
+static void unpackRecord(const uint8_t *in, wxSample &sample)
+{
+	sample.epoch = get16(in);
+	sample.epoch |= (uint32_t)get16(in) << 16;
+	sample.tempHigh = get16(in);
+	sample.tempLow = get16(in);
+	sample.pressure = get16(in);
+	sample.windSpeed = get16(in);
+	sample.windGust = get16(in);
+	sample.precipTotal = get16(in);
+	sample.solar = get16(in);
+	sample.indoorTemp = get16(in);
+	sample.humidity = *in;
+} // unpackRecord()
+
+/*
+******************************************************
+******************* Reading **************************
+******************************************************
+*/
+struct frameReader
+{
+	File file;
+	uint8_t buffer[READ_BUFFER];
+	size_t length;	  // bytes in the buffer
+	size_t position;  // next byte to decode
+	uint32_t offset;  // file position of buffer[0]
+	uint32_t corrupt; // bytes skipped before good frames
+};
+
+static void startReader(frameReader &reader, uint32_t offset)
+{
+	reader.length = 0;
+	reader.position = 0;
+	reader.offset = offset;
+	reader.corrupt = 0;
+	reader.file.seek(offset, SeekSet);
+} // startReader()
+
+// keep the undecoded bytes and fill up behind them, return the bytes read
+static size_t fillReader(frameReader &reader)
+{
+	memmove(reader.buffer, reader.buffer + reader.position, reader.length - reader.position);
+	reader.offset += reader.position;
+	reader.length -= reader.position;
+	reader.position = 0;
+	size_t read = reader.file.read(reader.buffer + reader.length, READ_BUFFER - reader.length);
+	reader.length += read;
+	return read;
+} // fillReader()
+
+// the next good record; false at the end of the file, where end is just past the last good frame
+static bool readRecord(frameReader &reader, wxSample &sample, uint32_t &frameOffset, uint32_t &end)
+{
+	uint32_t skipped = 0;
+	while (true)
+	{
+		if (reader.length - reader.position < OBSLOG_FRAME)
+		{
+			fillReader(reader);
+		}
+		if (reader.position == reader.length)
+		{
+			return false; // skipped bytes here are a torn write, not corruption
+		}
+		const uint8_t *payload;
+		uint8_t length;
+		frameResult result = frameDecode(reader.buffer + reader.position, reader.length - reader.position, payload, length);
+		if (result == FRAME_SHORT && (reader.position == 0 || fillReader(reader) == 0))
+		{
+			result = FRAME_BAD; // at the end of the file, or longer than the buffer: not a frame
+		}
+		if (result == FRAME_SHORT)
+		{
+			continue; // decode again with the bytes just read
+		}
+		if (result == FRAME_BAD)
+		{
+			reader.position++; // look for the next frame
+			skipped++;
+			continue;
+		}
+		reader.corrupt += skipped;
+		skipped = 0;
+		frameOffset = reader.offset + reader.position;
+		reader.position += length + FRAME_OVERHEAD;
+		end = reader.offset + reader.position;
+		if (length == OBSLOG_RECORD)
+		{
+			unpackRecord(payload, sample);
+			return true;
+		}
+	}
+} // readRecord()
+
+static void addIndex(uint32_t epoch, uint32_t offset, uint8_t segment)
+{
+	if (indexCount == OBSLOG_INDEX_SLOTS)
+	{
+		memmove(logIndex, logIndex + 1, sizeof(logIndex) - sizeof(logIndex[0])); // drop the oldest
+		indexCount--;
+	}
+	logIndex[indexCount++] = {epoch, (uint16_t)offset, segment};
+} // addIndex()
+
+bool beginObsLog(void (*replay)(const wxSample &sample))
+{
+	if (!LittleFS.begin())
+	{
+		return false;
+	}
+	unsigned long start = millis();
+	frameReader reader;
+	for (int segment = 0; segment < SEGMENTS; segment++)
+	{
+		logCount.records[segment] = 0;
+		logCount.bytes[segment] = 0;
+		reader.file = LittleFS.open(SEGMENT_FILES[segment], "r");
+		if (!reader.file)
+		{
+			continue;
+		}
+		uint32_t size = reader.file.size();
+		uint32_t end = 0, frameOffset = 0;
+		wxSample sample;
+		startReader(reader, 0);
+		while (readRecord(reader, sample, frameOffset, end))
+		{
+			if (logCount.records[segment]++ % OBSLOG_INDEX_EVERY == 0)
+			{
+				addIndex(sample.epoch, frameOffset, segment);
+			}
+			if (sample.epoch > logNewest)
+			{
+				logNewest = sample.epoch;
+				replay(sample);
+				logCount.replayed++;
+			}
+			yield();
+		}
+		reader.file.close();
+		logCount.corrupt += reader.corrupt;
+		if (end < size && segment == SEGMENT_CURRENT)
+		{
+			File file = LittleFS.open(SEGMENT_FILES[segment], "r+");
+			if (file && file.truncate(end))
+			{
+				logCount.tornBytes += size - end;
+				DEBUG_PRINTLN("Observation log: torn record removed");
+			}
+			file.close();
+		}
+		logCount.bytes[segment] = end;
+	}
+	logCount.rebuildMs = millis() - start;
+	logOpen = true;
+	DEBUG_PRINT("Observation log: records replayed ");
+	DEBUG_PRINT(logCount.replayed);
+	DEBUG_PRINT(" in ms ");
+	DEBUG_PRINTLN(logCount.rebuildMs);
+	return true;
+} // beginObsLog()
+
+int logScan(uint32_t from, bool (*each)(const wxSample &sample))
+{
+	// start at the last index entry at or before from, by binary search
+	int lo = 0, hi = indexCount - 1, found = -1;
+	while (lo <= hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (logIndex[mid].epoch <= from)
+		{
+			found = mid;
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	int segment = (found >= 0) ? logIndex[found].segment : SEGMENT_OLD;
+	uint32_t offset = (found >= 0) ? logIndex[found].offset : 0;
+
+	int count = 0;
+	frameReader reader;
+	wxSample sample;
+	uint32_t frameOffset, end;
+	for (; segment < SEGMENTS; segment++, offset = 0)
+	{
+		reader.file = LittleFS.open(SEGMENT_FILES[segment], "r");
+		if (!reader.file)
+		{
+			continue;
+		}
+		startReader(reader, offset);
+		while (readRecord(reader, sample, frameOffset, end))
+		{
+			if (sample.epoch >= from)
+			{
+				count++;
+				if (!each(sample))
+				{
+					reader.file.close();
+					return count;
+				}
+			}
+		}
+		reader.file.close();
+	}
+	for (int i = 0; i < pendingCount; i++) // not written yet
+	{
+		if (pending[i].epoch >= from)
+		{
+			count++;
+			if (!each(pending[i]))
+			{
+				break;
+			}
+		}
+	}
+	return count;
+} // logScan()
+
+/*
+******************************************************
+******************* Writing **************************
+******************************************************
+*/
+// the current file becomes the old one, its index entries with it
+static void rotate()
+{
+	LittleFS.remove(OBSLOG_OLD_FILE);
+	LittleFS.rename(OBSLOG_FILE, OBSLOG_OLD_FILE);
+	int kept = 0;
+	for (int i = 0; i < indexCount; i++)
+	{
+		if (logIndex[i].segment == SEGMENT_CURRENT)
+		{
+			logIndex[kept] = logIndex[i];
+			logIndex[kept++].segment = SEGMENT_OLD;
+		}
+	}
+	indexCount = kept;
+	logCount.records[SEGMENT_OLD] = logCount.records[SEGMENT_CURRENT];
+	logCount.bytes[SEGMENT_OLD] = logCount.bytes[SEGMENT_CURRENT];
+	logCount.records[SEGMENT_CURRENT] = 0;
+	logCount.bytes[SEGMENT_CURRENT] = 0;
+	logCount.rotations++;
+} // rotate()
+
+void logAppend(const wxSample &sample)
+{
+	if (!logOpen || sample.epoch <= logNewest)
+	{
+		return; // not started, or already logged
+	}
+	logNewest = sample.epoch;
+	pending[pendingCount++] = sample;
+	if (pendingCount == OBSLOG_BATCH)
+	{
+		logFlush(); // now, since a backfill queues many at once
+	}
+	else if (pendingCount == 1)
+	{
+		taskSchedule(taskLogFlush, OBSLOG_FLUSH_MS);
+	}
+} // logAppend()
+
+void logFlush()
+{
+	taskCancel(taskLogFlush);
+	if (pendingCount == 0)
+	{
+		return;
+	}
+	if (logCount.bytes[SEGMENT_CURRENT] + pendingCount * OBSLOG_FRAME > OBSLOG_SEGMENT_BYTES)
+	{
+		rotate();
+	}
+	uint8_t frames[OBSLOG_BATCH * OBSLOG_FRAME];
+	uint8_t record[OBSLOG_RECORD];
+	size_t frameEnd[OBSLOG_BATCH];
+	size_t length = 0;
+	for (int i = 0; i < pendingCount; i++)
+	{
+		packRecord(pending[i], record);
+		length += frameEncode(record, OBSLOG_RECORD, frames + length);
+		frameEnd[i] = length;
+	}
+
+	// one write per batch; a short write leaves a torn frame that the next boot skips
+	File file = LittleFS.open(OBSLOG_FILE, "a");
+	size_t written = file ? file.write(frames, length) : 0;
+	file.close();
+
+	// only whole frames on flash are counted and indexed
+	uint32_t offset = logCount.bytes[SEGMENT_CURRENT];
+	for (int i = 0; i < pendingCount && frameEnd[i] <= written; i++)
+	{
+		if (logCount.records[SEGMENT_CURRENT] % OBSLOG_INDEX_EVERY == 0)
+		{
+			addIndex(pending[i].epoch, offset + (i > 0 ? frameEnd[i - 1] : 0), SEGMENT_CURRENT);
+		}
+		logCount.records[SEGMENT_CURRENT]++;
+		logCount.written++;
+	}
+	logCount.bytes[SEGMENT_CURRENT] += written;
+	logCount.writes++;
+	if (written != length)
+	{
+		logCount.failures++;
+		DEBUG_PRINTLN("Observation log: write failed");
+	}
+	pendingCount = 0;
+} // logFlush()
+
+static bool countSample(const wxSample &)
+{
+	return true;
+}
+
+void printLogStats()
+{
+	if (!logOpen)
+	{
+		Serial.println("Observation log: not open");
+		return;
+	}
+	Serial.printf("Observation log: current %u records %u bytes, old %u records %u bytes, %d queued\n",
+				  logCount.records[SEGMENT_CURRENT], logCount.bytes[SEGMENT_CURRENT], logCount.records[SEGMENT_OLD],
+				  logCount.bytes[SEGMENT_OLD], pendingCount);
+	Serial.printf("\t%u records in %u writes (%u failed), %u rotations, %d index entries\n", logCount.written,
+				  logCount.writes, logCount.failures, logCount.rotations, indexCount);
+	Serial.printf("\tboot: %u replayed in %u ms, %u corrupt bytes skipped, %u torn bytes cut\n", logCount.replayed,
+				  logCount.rebuildMs, logCount.corrupt, logCount.tornBytes);
+	unsigned long start = micros();
+	int count = logScan(logNewest - 86400, countSample);
+	Serial.printf("\tseek and read the last 24 h: %d records in %lu us\n", count, micros() - start);
+} // printLogStats()
+
+// End of file
@@ -0,0 +1,128 @@
+/**
+ * @file radioPower.cpp
+ * @author Karl Berger
+ * @date 2025-06-24
+ * @brief Switches the Wi-Fi radio off between network bursts.
+ * @details The next network deadline is the earliest of the scheduled network tasks,
+ *          calendar events (fetches and APRS bulletins) and endpoint retries. Sockets left in the pool are
+ *          closed before sleeping, and ezTime's NTP updates are paused while the radio
+ *          is off; they resume on wake-up and catch up if one is overdue.
+ */
+
+#include "radioPower.h"
+
+#include <Arduino.h>		// Arduino functions
+#include <ezTime.h>			// [manager] v0.8.3 Rop Gonggrijp https://github.com/ropg/ezTime
+#include "connectionPool.h" // close sockets before sleeping
+#include "credentials.h"	// RADIO_SLEEP and listening services
+#include "endpointPolicy.h" // for policyNextRetry()
+#include "taskControl.h"	// for nextNetworkTask()
+#include "wifiConnection.h" // link control
+#include "wug_debug.h"		// debug print
+#include "wxShare.h"		// for SHARE_OFF
+
+unsigned long radioOffMs = 0;	// total time asleep before the current sleep
+unsigned long sleptAt = 0;		// millis() when the current sleep began
+unsigned long onlineAt = 0;		// millis() when the link came up, 0 until it has
+bool waking = false;			// wifiWake() called, link not yet up
+uint32_t radioSleeps = 0;		// times the radio was switched off
+uint32_t lateWakes = 0;			// tasks that came due before the link was back
+
+// the reason the radio must stay on, nullptr if it may sleep
+static const char *sleepBlocker()
+{
+	if (!RADIO_SLEEP)
+	{
+		return "RADIO_SLEEP is false";
+	}
+	if (!MQTT_BROKER.isEmpty())
+	{
+		return "MQTT session";
+	}
+	if (INGEST_PORT != 0)
+	{
+		return "local station uploads";
+	}
+	if (SHARE_MODE != SHARE_OFF)
+	{
+		return "LAN sharing";
+	}
+	return nullptr;
+} // sleepBlocker()
+
+static unsigned long nextDeadline()
+{
+	unsigned long next = nextNetworkTask();
+	uint32_t retry = policyNextRetry();
+	next = min(next, (retry == POLICY_NEVER) ? ULONG_MAX : (unsigned long)retry);
+	return next;
+} // nextDeadline()
+
+void radioLoop()
+{
+	if (sleepBlocker())
+	{
+		return;
+	}
+	unsigned long now = millis();
+	unsigned long next = nextDeadline();
+
+	if (wifiAsleep())
+	{
+		if (next <= RADIO_WAKE_LEAD)
+		{
+			radioOffMs += now - sleptAt;
+			setInterval(NTP_INTERVAL); // events() catches up if an update is overdue
+			wifiWake();
+			waking = true;
+			onlineAt = 0;
+		}
+		return;
+	}
+	if (!wifiOnline())
+	{
+		if (waking && next == 0)
+		{
+			lateWakes++; // the task fails and is retried under its backoff
+			waking = false;
+		}
+		return; // connecting, or an outage the supervisor is handling
+	}
+	if (onlineAt == 0)
+	{
+		onlineAt = now;
+		waking = false;
+	}
+	if (now - onlineAt < RADIO_LINGER || next < RADIO_WAKE_LEAD + RADIO_MIN_SLEEP)
+	{
+		return; // burst in progress or the next one is close
+	}
+
+	DEBUG_PRINT("Radio off, next network task in s ");
+	DEBUG_PRINTLN(next / 1000);
+	resetConnections(); // the sockets would not survive the sleep
+	setInterval(0);		// no NTP updates while the radio is off
+	wifiSleep();
+	sleptAt = now;
+	radioSleeps++;
+} // radioLoop()
+
+void printRadioStats()
+{
+	unsigned long now = millis();
+	unsigned long off = radioOffMs + (wifiAsleep() ? now - sleptAt : 0);
+	Serial.printf("Radio %s, on %.1f%% of uptime, %u sleeps, %u late wake-ups\n", wifiAsleep() ? "asleep" : "on",
+				  100.0 * (now - off) / max(now, 1UL), radioSleeps, lateWakes);
+	const char *blocker = sleepBlocker();
+	if (blocker)
+	{
+		Serial.printf("\tsleep disabled: %s\n", blocker);
+	}
+	else
+	{
+		unsigned long next = nextDeadline();
+		Serial.printf("\tnext network task in %lu s\n", next == ULONG_MAX ? 0 : next / 1000);
+	}
+} // printRadioStats()
+
+// End of file
@@ -19,11 +19,13 @@
 #include "almanacFrame.h"  // for almanac frame
 #include "analogClock.h"   // for analog clock frame
 #include "digitalClock.h"  // for digital clock frame
-#include "taskControl.h"   // for tmrSecondTick to update clocks
+#include "clockTick.h"     // second-edge clock ticks
+#include "bootProfile.h"   // time to the first live frame
 
 // If either ANALOG_CLOCK or DIGITAL_CLOCK is enabled, maxFrames is set to 4.
 // Otherwise, maxFrames is set to 3.
 int maxFrames = (ANALOG_CLOCK || DIGITAL_CLOCK) ? 4 : 3;
+int currentFrame = 0; // Tracks which frame is active
 
 /**
  * @brief Updates the clock display based on the current clock mode.
@@ -49,14 +51,31 @@ void updateClock()
   }
 } // updateClock()
 
+/**
+ * @brief Redraws the weather frame that is showing, so a new observation appears at once.
+ *
+ * Subscribed to weather update events. The almanac and clock frames are left alone.
+ */
+void refreshWXframe()
+{
+  if (currentFrame == 1)
+  {
+    firstWXframe();
+  }
+  else if (currentFrame == 2)
+  {
+    secondWXframe();
+  }
+} // refreshWXframe()
+
 /**
  * @brief Updates and displays the next sequential frame on the display.
  *
  * This function cycles through a set of predefined frames (weather, almanac, and clock)
  * each time it is called. It increments the current frame index, wraps around to the first
  * frame after the last, and displays the corresponding frame. When switching to the clock
- * frame, it restarts the second tick timer and draws either a digital or analog clock
- * depending on configuration. The second tick timer is stopped during other frames to
+ * frame, it starts the second ticks and draws either a digital or analog clock
+ * depending on configuration. The second ticks are stopped during other frames to
  * prevent clock updates.
  *
  * Frames:
@@ -67,17 +86,16 @@ void updateClock()
  *
  * Assumes the existence of:
  *   - maxFrames: total number of frames to cycle through
- *   - tmrSecondTick: timer object for second ticks
+ *   - startClockTick(), stopClockTick(): second ticks for the clock frame
  *   - DIGITAL_CLOCK, ANALOG_CLOCK: configuration flags
  *   - firstWXframe(), secondWXframe(), almanacFrame(), 
  *     digitalClockFrame(), analogClockFrame(): frame rendering functions
  */
 void updateSequentialFrames()
 {
-  static int currentFrame = 0; // Tracks which frame is active
   // Increment frame, reset to 1 if exceeds maxFrames
   currentFrame = currentFrame < maxFrames ? currentFrame + 1 : 1;
-  tmrSecondTick.stop(); // Stop second tick timer to prevent clock when not displayed
+  stopClockTick(); // Stop second ticks to prevent clock when not displayed
   // Draw the appropriate frame
   switch (currentFrame)
   {
@@ -91,7 +109,7 @@ void updateSequentialFrames()
     almanacFrame();
     break;
   case 4:
-    tmrSecondTick.start(); // Restart second tick timer for clock updates
+    startClockTick(); // Tick just after each second edge for clock updates
     if (DIGITAL_CLOCK)
     {
       digitalClockFrame(true); // Full draw on entry
@@ -105,6 +123,7 @@ void updateSequentialFrames()
     // Handle unexpected frame numbers, if needed
     break;
   }
+  bootFirstFrame(); // only the first call counts
 }
 
 /**
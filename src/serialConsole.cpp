@@ -0,0 +1,112 @@
+/**
+ * @file serialConsole.cpp
+ * @author Karl Berger
+ * @date 2025-06-16
+ * @brief Diagnostic commands typed on the serial monitor.
+ * @details Characters are collected without blocking until a newline arrives,
+ *          then the command is looked up in the command table.
+ */
+
+#include "serialConsole.h"
+
+#include <Arduino.h>		// Arduino functions
+#include "bootProfile.h"	// for printBootProfile()
+#include "clockTick.h"		// for printClockStats()
+#include "connectionPool.h" // for printConnectionStats()
+#include "dnsCache.h"		// for printDnsStats()
+#include "endpointPolicy.h" // for printEndpointHealth()
+#include "indoorSensor.h"	// for printIndoorStats()
+#include "localIngest.h"	// for printIngestStats()
+#include "netTiming.h"		// for printNetTiming()
+#include "obsLog.h"			// for printLogStats()
+#include "radioPower.h"		// for printRadioStats()
+#include "taskControl.h"	// for printTaskStats()
+#include "taskProfile.h"	// for printTaskProfile()
+#include "wifiConnection.h" // for printWiFiStats()
+#include "wxHistory.h"		// for printHistoryStats()
+#include "wxEvents.h"		// for printWXevents()
+#include "wxShare.h"		// for printShareStats()
+
+#define CONSOLE_LINE 32 // longest command
+
+static void printHelp();
+
+struct consoleCommand
+{
+	const char *name; // command word
+	void (*run)();	  // handler
+	const char *help; // one line description
+};
+
+const consoleCommand COMMANDS[] = {
+	{"help", printHelp, "list commands"},
+	{"boot", printBootProfile, "boot phase timing to the first frame"},
+	{"clock", printClockStats, "clock tick phase, skips and drift"},
+	{"history", printHistoryStats, "history span, bits per sample and scan time"},
+	{"indoor", printIndoorStats, "indoor readings and history"},
+	{"obslog", printLogStats, "observation log files, writes and seek time"},
+	{"net", printNetTiming, "network phase timing histograms"},
+	{"pool", printConnectionStats, "connection pool counters"},
+	{"dns", printDnsStats, "DNS cache entries and counters"},
+	{"events", printWXevents, "weather update subscribers"},
+	{"health", printEndpointHealth, "endpoint backoff and circuit state"},
+	{"ingest", printIngestStats, "local station upload counters"},
+	{"profile", printTaskProfile, "task run times, lateness and loop stalls"},
+	{"profreset", resetTaskProfile, "clear task timing"},
+	{"radio", printRadioStats, "radio-on fraction and next wake-up"},
+	{"share", printShareStats, "LAN snapshot counters"},
+	{"tasks", printTaskStats, "CPU idle and task schedule"},
+	{"wifi", printWiFiStats, "link quality and time to IP"},
+};
+const int COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+static void printHelp()
+{
+	for (int i = 0; i < COMMAND_COUNT; i++)
+	{
+		Serial.printf("\t%-8s %s\n", COMMANDS[i].name, COMMANDS[i].help);
+	}
+} // printHelp()
+
+void processSerialCommands()
+{
+	static char line[CONSOLE_LINE + 1];
+	static int length = 0;
+
+	while (Serial.available())
+	{
+		char c = Serial.read();
+		if (c != '\n' && c != '\r')
+		{
+			if (length < CONSOLE_LINE)
+			{
+				line[length++] = c;
+			}
+			continue;
+		}
+		if (length == 0)
+		{
+			continue; // blank line or CR of CRLF
+		}
+		line[length] = '\0';
+		length = 0;
+
+		bool found = false;
+		for (int i = 0; i < COMMAND_COUNT; i++)
+		{
+			if (strcmp(line, COMMANDS[i].name) == 0)
+			{
+				COMMANDS[i].run();
+				found = true;
+			}
+		}
+		if (!found)
+		{
+			Serial.print("Unknown command: ");
+			Serial.println(line);
+			printHelp();
+		}
+	}
+} // processSerialCommands()
+
+// End of file
@@ -2,61 +2,261 @@
  * @file taskControl.cpp
  * @author KarlB
  * @date   2024-06-09
- * @brief Implements scheduled task management using TickTwo timers for weather data retrieval, posting, and display updates.
+ * @brief Implements scheduled task management using the deadline scheduler for weather data retrieval, posting, and display updates.
  *
  * This file sets up and manages periodic tasks for:
- * - Fetching current and forecasted weather data.
- * - Posting weather data to APRS and ThingSpeak services.
+ * - Fetching current and forecasted weather data at wall-clock aligned minutes.
+ * - Sending the 0800, 2000 and sunset APRS bulletins.
+ * - Posting each new observation to APRS, ThingSpeak and MQTT through wxEvents subscriptions.
  * - Updating sequential display frames and clock ticks.
+ * - Polling the Wi-Fi supervisor, network services and serial console.
  *
- * Timers are instantiated using the TickTwo library and started in the `startTasks()` function, which should be called in the Arduino `setup()`.
- * The `updateTasks()` function should be called in the Arduino `loop()` to ensure timers are serviced and scheduled tasks are executed.
+ * Tasks are scheduled in the `startTasks()` function, which should be called in the Arduino `setup()`.
+ * The `updateTasks()` function is the whole of the Arduino `loop()`: it runs the tasks that are due
+ * and delay()s until the next deadline. delay() yields to the SDK, which lets the Wi-Fi modem sleep.
+ * Forced light sleep is not used because it stops the UART, and with it the serial console.
  *
  * Dependencies:
  * - Arduino.h: Core Arduino functions.
- * - TickTwo.h: Timer library for scheduling tasks.
+ * - taskScheduler.h: Deadline scheduler from lib/wxcore.
+ * - calendarScheduler.h: Wall-clock events from lib/wxcore, run by one scheduled task.
+ * - coroutine.h: Protothreads for the network requests, resumed by a scheduler task.
  * - aprsService.h: APRS posting functions.
  * - credentials.h: Interval definitions and credentials.
  * - sequentialFrames.h: Display frame management.
+ * - mqttPublisher.h: MQTT publishing.
  * - thingSpeakService.h: ThingSpeak posting functions.
  * - weatherService.h: Weather data retrieval.
  */
 #include "taskControl.h" // task control functions
 
 #include <Arduino.h>		   // Arduino functions
-#include <TickTwo.h>		   // v4.4.0 Stefan Staub https://github.com/sstaub/TickTwo
+#include <calendarScheduler.h> // wall-clock events from lib/wxcore
+#include <coroutine.h>		   // protothreads from lib/wxcore
+#include <ezTime.h>			   // UTC time and events()
+#include <taskScheduler.h>	   // deadline scheduler from lib/wxcore
 #include "aprsService.h"	   // APRS functions
+#include "clockTick.h"		   // second-edge clock ticks
+#include "connectionPool.h"	   // idle socket maintenance
 #include "credentials.h"	   // for WX_CURRENT_INTERVAL, WX_FORECAST_INTERVAL, etc.
+#include "indoorSensor.h"	   // background indoor sampling
+#include "dnsCache.h"		   // host lookups in the background
+#include "endpointPolicy.h"	   // retry clock
+#include "localIngest.h"	   // station uploads on the LAN
+#include "mqttPublisher.h"	   // MQTT publishing
+#include "obsLog.h"			   // observation log writes
+#include "radioPower.h"		   // radio sleep between network bursts
 #include "sequentialFrames.h"  // sequential weather and almanac frames
+#include "serialConsole.h"	   // diagnostic commands
+#include "taskProfile.h"	   // task timing
 #include "thingSpeakService.h" // ThingSpeak posting
+#include "timeFunctions.h"	   // local timezone
 #include "weatherService.h"	   // weather data from Weather Underground API
+#include "wifiConnection.h"	   // Wi-Fi supervisor
+#include "wxEvents.h"		   // weather update subscriptions
+#include "wxShare.h"		   // weather snapshots shared on the LAN
 
-//! Instantiate the scheduled tasks
-TickTwo tmrGetWXcurrent(getWXcurrent, WX_CURRENT_INTERVAL * 60 * 1000, 0, MILLIS);
-TickTwo tmrGetWXforecast(getWXforecast, WX_FORECAST_INTERVAL * 60 * 1000, 0, MILLIS);
-TickTwo tmrPostWXtoAPRS(postWXtoAPRS, WX_APRS_INTERVAL * 60 * 1000, 0, MILLIS);
-TickTwo tmrPostWXtoThingspeak(postWXtoThingspeak, TS_POST_INTERVAL * 60 * 1000, 0, MILLIS);
-TickTwo tmrUpdateFrame(updateSequentialFrames, SCREEN_DURATION * 1000, 0, MILLIS);
-TickTwo tmrSecondTick(updateClock, 1000, 0, MILLIS);
+unsigned long idleMs = 0;	  // time spent in delay() by updateTasks()
+unsigned long loopExitUs = 0; // micros() when updateTasks() last returned
 
-//! Start the TickTwo timers in setup()
+//! Retry failed posts once their backoff has passed
+static void retryPosts()
+{
+	retryThingspeakUpload(); // retry a failed ThingSpeak upload when due
+	retryAPRSpost();		 // retry a failed APRS post when due
+} // retryPosts()
+
+static uint32_t millisClock()
+{
+	return millis();
+}
+
+static uint32_t utcClock()
+{
+	return UTC.now();
+}
+
+// ezTime gives minutes west of UTC, the calendar wants seconds east
+static int32_t localOffset(uint32_t utc)
+{
+	return -60L * myTZ.getOffset(utc, UTC_TIME);
+}
+
+static void coroutineIdle()
+{
+	delay(CO_POLL_MS); // yields to the SDK while a socket waits
+}
+
+//! Fetch whatever went stale while Wi-Fi was down instead of waiting for the timers
+void catchUpWeather()
+{
+	if (UTC.now() - wx.obsEpoch > WX_CURRENT_INTERVAL * 60)
+	{
+		getWXcurrent();
+	}
+	if (wx.forSunRise == 0)
+	{
+		getWXforecast(); // the boot fetch never succeeded
+	}
+} // catchUpWeather()
+
+//! Wall-clock events; a missed fetch still runs within one interval, a bulletin within half an hour.
+//! No minute offset keeps two minute grids apart, so the forecast runs WX_FORECAST_OFFSET seconds
+//! into its minute, after a current fetch that started on the same minute has let go of the socket.
+calendarEvent calWXcurrent = CALENDAR_EVERY("wx current", getWXcurrent, WX_CURRENT_INTERVAL, 0, WX_CURRENT_INTERVAL * 60);
+calendarEvent calWXforecast = CALENDAR_EVERY_SECONDS("wx forecast", getWXforecast, WX_FORECAST_INTERVAL, WX_FORECAST_OFFSET,
+													 WX_FORECAST_INTERVAL * 60);
+calendarEvent calMorningBulletin = CALENDAR_DAILY("bulletin am", sendMorningBulletin, 8, 0, 1800);
+calendarEvent calEveningBulletin = CALENDAR_DAILY("bulletin pm", sendEveningBulletin, 20, 0, 1800);
+calendarEvent calSunsetBulletin = CALENDAR_CUSTOM("sunset", sendSunsetBulletin, nextSunset, 1800);
+
+//! Run the calendar events that are due, then sleep until the next one
+static void runCalendar();
+scheduledTask taskCalendar = SCHEDULED_TASK("calendar", runCalendar, 0);
+
+static void runCalendar()
+{
+	uint32_t wait = min(calendarRun(), (uint32_t)CALENDAR_MAX_WAIT); // wake now and then in case NTP steps the clock
+	// land on the second edge; ezTime counts the fraction in ms()
+	taskSchedule(taskCalendar, wait * 1000UL - (wait > 0 ? UTC.ms() : 0));
+} // runCalendar()
+
+//! Define the scheduled tasks
+scheduledTask taskUpdateFrame = SCHEDULED_TASK("frame", updateSequentialFrames, SCREEN_DURATION * 1000);
+scheduledTask taskSecondTick = SCHEDULED_TASK("clock", clockTick, 0); // reschedules itself to each second edge
+scheduledTask taskIndoorSensor = SCHEDULED_TASK("indoor", sampleSensor, 0); // reschedules itself, trigger then read
+scheduledTask taskLogFlush = SCHEDULED_TASK("obslog", logFlush, 0);			// scheduled when a record is queued
+
+//! Each new observation goes out once, no more often than these intervals
+wxSubscription subAPRS = WX_SUBSCRIPTION("aprs", postWXtoAPRS, WX_APRS_INTERVAL * 60 * 1000);
+wxSubscription subThingspeak = WX_SUBSCRIPTION("thingspeak", postWXtoThingspeak, TS_POST_INTERVAL * 60 * 1000);
+wxSubscription subMQTT = WX_SUBSCRIPTION("mqtt", publishWXtoMQTT, 0);
+wxSubscription subDisplay = WX_SUBSCRIPTION("display", refreshWXframe, 0);
+
+//! Service polls that used to run on every pass of loop()
+scheduledTask servicePolls[] = {
+	SCHEDULED_TASK("wifi", checkWiFiConnection, 100),	  // link supervisor, LED blink
+	SCHEDULED_TASK("radio", radioLoop, 1000),			  // radio sleep between bursts
+	SCHEDULED_TASK("eztime", events, 1000),				  // NTP updates
+	SCHEDULED_TASK("pool", maintainConnections, 1000),	  // drain and recycle idle sockets
+	SCHEDULED_TASK("dns", maintainDnsCache, 1000),		  // revalidate and prefetch host names
+	SCHEDULED_TASK("retry", retryPosts, 1000),			  // failed posts
+	SCHEDULED_TASK("mqtt", mqttLoop, 100),				  // keep-alive and acknowledgements
+	SCHEDULED_TASK("ingest", handleLocalIngest, 50),	  // station uploads on the LAN
+	SCHEDULED_TASK("share", shareLoop, 100),			  // weather snapshots
+	SCHEDULED_TASK("console", processSerialCommands, 50), // diagnostic commands
+};
+const int POLL_COUNT = sizeof(servicePolls) / sizeof(servicePolls[0]);
+
+//! for printTaskStats()
+scheduledTask *const ALL_TASKS[] = {&taskCalendar, &taskUpdateFrame, &taskSecondTick, &taskIndoorSensor, &taskLogFlush};
+
+// milliseconds until a scheduled task runs
+static unsigned long dueIn(const scheduledTask &task)
+{
+	uint32_t wait = taskDueIn(task);
+	return (wait == TASK_NEVER) ? ULONG_MAX : wait;
+} // dueIn()
+
+//! Time until the next scheduled task that uses the network
+unsigned long nextNetworkTask()
+{
+	uint32_t calendar = calendarDueIn(); // weather fetches and bulletins
+	unsigned long next = (calendar == CAL_NEVER) ? ULONG_MAX : calendar * 1000UL;
+	next = min(next, wxDeliveryDueIn()); // uplinks held by their rate limits
+	return next;
+} // nextNetworkTask()
+
+//! Give the scheduler, the protothreads and the retry policy their clocks, first thing in setup()
+void initTaskClocks()
+{
+	setSchedulerClock(millisClock);
+	setProtothreadClock(millisClock);
+	setCalendarClock(utcClock, localOffset);
+	setHostCacheClock(millisClock); // DNS TTLs
+	beginDnsCache();				// DNS_SERVER build flag
+	initEndpointPolicy();			// retry backoff runs on millis() too
+} // initTaskClocks()
+
+//! Run a network coroutine to the end, for code that needs its result before it goes on
+void finishCoroutine(coroutine &co)
+{
+	coFinish(co, coroutineIdle);
+} // finishCoroutine()
+
+//! Start the scheduled tasks in setup()
 void startTasks()
 {
-	tmrGetWXcurrent.start();	   // timer for current weather
-	tmrGetWXforecast.start();	   // timer for forecasted weather
-	tmrPostWXtoThingspeak.start(); // timer for posting to ThingSpeak
-	tmrPostWXtoAPRS.start();	   // timer for posting weather to APRS
-	tmrUpdateFrame.start();		   // timer for sequential frames
-								   // tmrSecondTick is started in the clock frame
+	setTaskRunner(profileTask); // time every task
+	calendarAdd(calWXcurrent);		  // current weather
+	calendarAdd(calWXforecast);		  // forecasted weather
+	calendarAdd(calMorningBulletin); // APRS bulletins
+	calendarAdd(calEveningBulletin);
+	calendarAdd(calSunsetBulletin);	 // tonight's forecast, at the forecast's sunset
+	taskSchedule(taskCalendar, 0);						   // first calendar pass now
+	taskSchedule(taskUpdateFrame, 0); // first live frame now, replacing the data screen
+									  // taskSecondTick is scheduled in the clock frame
+	if (indoorSensor)
+	{
+		taskSchedule(taskIndoorSensor, 0); // first reading before the first clock frame
+	}
+	for (int i = 0; i < POLL_COUNT; i++)
+	{
+		taskSchedule(servicePolls[i], 0);
+	}
+	subscribeWX(subAPRS);		// post each new observation to APRS
+	subscribeWX(subThingspeak); // buffer each new observation for ThingSpeak
+	subscribeWX(subMQTT);		// publish each new observation to MQTT
+	subscribeWX(subDisplay);	// redraw a weather frame that is showing
 } // startTasks()
 
-//! Update the TickTwo timers in loop()
+//! Run due tasks, then idle until the next deadline; this is the whole of loop()
 void updateTasks()
 {
-	tmrGetWXcurrent.update();		// get current weather
-	tmrPostWXtoThingspeak.update(); // post selected current weather to ThingSpeak
-	tmrPostWXtoAPRS.update();		// post selected weather data to APRS
-	tmrGetWXforecast.update();		// get forecasted weather for display
-	tmrUpdateFrame.update();		// update sequential frames
-	tmrSecondTick.update();			// update seconds for clock & frame displays
-} // updateTasks()
\ No newline at end of file
+	unsigned long enterUs = micros();
+	uint32_t wait = schedulerRun();
+	profileLoopPass(micros() - enterUs, loopExitUs ? enterUs - loopExitUs : 0);
+	if (wait > 0)
+	{
+		unsigned long start = millis();
+		delay(min((unsigned long)wait, TASK_MAX_IDLE));
+		idleMs += millis() - start;
+	}
+	loopExitUs = micros();
+} // updateTasks()
+
+static void printTask(const scheduledTask &task)
+{
+	unsigned long due = dueIn(task);
+	if (due == ULONG_MAX)
+	{
+		Serial.printf("\t%-12s %7lu ms  stopped  %u runs\n", task.name, (unsigned long)task.period, task.runs);
+	}
+	else
+	{
+		Serial.printf("\t%-12s %7lu ms  in %5lu  %u runs, %u skipped\n", task.name, (unsigned long)task.period, due,
+					  task.runs, task.skipped);
+	}
+} // printTask()
+
+void printTaskStats()
+{
+	unsigned long now = millis();
+	Serial.printf("CPU idle %.1f%% of uptime, %d coroutines running\n", 100.0 * idleMs / max(now, 1UL), coRunning());
+	Serial.println("\ttask         period      next ms");
+	for (const scheduledTask *task : ALL_TASKS)
+	{
+		printTask(*task);
+	}
+	for (int i = 0; i < POLL_COUNT; i++)
+	{
+		printTask(servicePolls[i]);
+	}
+	Serial.println("\tevent        next local       runs missed");
+	calendarEvent *event;
+	for (int i = 0; (event = calendarEventAt(i)) != nullptr; i++)
+	{
+		String next = event->next ? myTZ.dateTime(event->next, UTC_TIME, "Y-m-d H:i:s") : "unknown";
+		Serial.printf("\t%-12s %s  %u %u\n", event->name, next.c_str(), event->runs, event->missed);
+	}
+} // printTaskStats()
@@ -0,0 +1,168 @@
+/**
+ * @file taskProfile.cpp
+ * @author Karl Berger
+ * @date 2025-06-28
+ * @brief Execution time and lateness of the scheduled tasks, and loop stalls.
+ * @details The cycle counter gives sub-microsecond resolution but wraps after about
+ *          53 s at 80 MHz, so a run that micros() shows to be longer than 10 s is
+ *          measured with micros() instead. Recording is a few counter updates and
+ *          costs about a microsecond per task run.
+ */
+
+#include "taskProfile.h"
+
+#include <Arduino.h> // Arduino functions
+
+struct taskStats
+{
+	const scheduledTask *task;			// task measured, nullptr if unused
+	uint32_t runs;						// runs timed
+	uint32_t minUs;						// shortest run
+	uint32_t maxUs;						// longest run
+	uint64_t totalUs;					// sum for the mean
+	uint16_t bucket[PROFILE_BUCKETS];	// runs per power of two microseconds
+	uint32_t late;						// starts later than PROFILE_LATE_MS
+	uint32_t maxLateMs;					// latest start
+	uint64_t totalLateMs;				// sum for the mean
+};
+
+taskStats profile[PROFILE_TASKS];
+uint32_t untracked = 0;		// runs of tasks that found no free slot
+uint32_t loopPasses = 0;	// passes of loop()
+uint32_t maxBusyUs = 0;		// longest pass without yielding
+const char *maxBusyTask = ""; // slowest task when the longest pass was seen
+uint32_t maxOutsideUs = 0;	// longest time between passes spent in the SDK
+uint32_t stalls = 0;		// passes longer than PROFILE_STALL_US
+const scheduledTask *lastSlowest = nullptr; // slowest task of the current pass
+uint32_t lastSlowestUs = 0;
+
+static taskStats *statsFor(const scheduledTask &task)
+{
+	for (int i = 0; i < PROFILE_TASKS; i++)
+	{
+		if (profile[i].task == &task)
+		{
+			return &profile[i];
+		}
+		if (profile[i].task == nullptr)
+		{
+			profile[i].task = &task;
+			profile[i].minUs = UINT32_MAX;
+			return &profile[i];
+		}
+	}
+	return nullptr;
+} // statsFor()
+
+static int bucketFor(uint32_t us)
+{
+	int bucket = 0;
+	while (us > 0 && bucket < PROFILE_BUCKETS - 1)
+	{
+		us >>= 1;
+		bucket++;
+	}
+	return bucket;
+} // bucketFor()
+
+void profileTask(scheduledTask &task, uint32_t lateMs)
+{
+	uint32_t startCycles = ESP.getCycleCount();
+	unsigned long startUs = micros();
+	task.run();
+	uint32_t cycles = ESP.getCycleCount() - startCycles;
+	uint32_t us = micros() - startUs;
+	if (us < 10000000UL)
+	{
+		us = cycles / ESP.getCpuFreqMHz();
+	}
+
+	if (us >= lastSlowestUs)
+	{
+		lastSlowest = &task;
+		lastSlowestUs = us;
+	}
+	taskStats *stats = statsFor(task);
+	if (stats == nullptr)
+	{
+		untracked++;
+		return;
+	}
+	stats->runs++;
+	stats->minUs = min(stats->minUs, us);
+	stats->maxUs = max(stats->maxUs, us);
+	stats->totalUs += us;
+	uint16_t &count = stats->bucket[bucketFor(us)];
+	if (count < UINT16_MAX)
+	{
+		count++;
+	}
+	if (lateMs > PROFILE_LATE_MS)
+	{
+		stats->late++;
+	}
+	stats->maxLateMs = max(stats->maxLateMs, lateMs);
+	stats->totalLateMs += lateMs;
+} // profileTask()
+
+void profileLoopPass(uint32_t busyUs, uint32_t outsideUs)
+{
+	loopPasses++;
+	if (busyUs > PROFILE_STALL_US)
+	{
+		stalls++;
+	}
+	if (busyUs > maxBusyUs)
+	{
+		maxBusyUs = busyUs;
+		maxBusyTask = lastSlowest ? lastSlowest->name : "";
+	}
+	maxOutsideUs = max(maxOutsideUs, outsideUs);
+	lastSlowest = nullptr;
+	lastSlowestUs = 0;
+} // profileLoopPass()
+
+void printTaskProfile()
+{
+	Serial.printf("Loop: %u passes, longest %lu us (%s), %u over %u us, longest SDK gap %lu us\n", loopPasses,
+				  (unsigned long)maxBusyUs, maxBusyTask, stalls, PROFILE_STALL_US, (unsigned long)maxOutsideUs);
+	Serial.printf("Tasks (us buckets <1 <2 <4 ... >=%lu), late means > %u ms\n", 1UL << (PROFILE_BUCKETS - 2),
+				  PROFILE_LATE_MS);
+	for (int i = 0; i < PROFILE_TASKS && profile[i].task; i++)
+	{
+		taskStats &stats = profile[i];
+		if (stats.runs == 0)
+		{
+			continue;
+		}
+		Serial.printf("%s: %u runs, us min %lu mean %lu max %lu; late %u, ms mean %lu max %lu\n\t", stats.task->name,
+					  stats.runs, (unsigned long)stats.minUs, (unsigned long)(stats.totalUs / stats.runs),
+					  (unsigned long)stats.maxUs, stats.late, (unsigned long)(stats.totalLateMs / stats.runs),
+					  (unsigned long)stats.maxLateMs);
+		// print up to the highest non-empty bucket
+		int last = PROFILE_BUCKETS - 1;
+		while (last > 0 && stats.bucket[last] == 0)
+		{
+			last--;
+		}
+		for (int b = 0; b <= last; b++)
+		{
+			Serial.print(stats.bucket[b]);
+			Serial.print(' ');
+		}
+		Serial.println();
+	}
+	if (untracked)
+	{
+		Serial.printf("%u runs of untracked tasks\n", untracked);
+	}
+} // printTaskProfile()
+
+void resetTaskProfile()
+{
+	memset(profile, 0, sizeof(profile));
+	untracked = loopPasses = maxBusyUs = maxOutsideUs = stalls = 0;
+	maxBusyTask = "";
+} // resetTaskProfile()
+
+// End of file
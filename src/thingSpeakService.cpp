@@ -1,14 +1,28 @@
 /**
  * @file thingSpeakService.cpp
  * @author Karl W. Berger
- * @date 2025-05-28
+ * @date 2025-06-12
  * @brief Posts weather observation data to ThingSpeak.
  *
- * Establishes a connection to the ThingSpeak server and sends the current weather
- * data (temperature, humidity, pressure, wind speed, wind direction, solar radiation,
- * precipitation total, and precipitation rate) as fields 1-8. Optionally includes a
- * status message if set. Uses the API key defined in TS_WRITE_KEY and posts data
- * using HTTP POST to the /update endpoint.
+ * Each call of postWXtoThingspeak() buffers the current weather data (temperature,
+ * humidity, pressure, wind speed, wind direction, solar radiation, precipitation
+ * total, and precipitation rate as fields 1-8) together with its observation time.
+ * When TS_BATCH_SIZE samples are waiting they are uploaded in one HTTP POST to the
+ * channel's bulk_update.json endpoint, so one connection carries many rows and the
+ * full sample resolution is kept at longer uplink intervals. Optionally includes a
+ * status message with the newest row if set.
+ *
+ * The socket is kept open in the connection pool and the server response is checked;
+ * the upload is a coroutine, so the display keeps running while ThingSpeak answers.
+ * Rows stay buffered until ThingSpeak accepts them. Failed uploads are retried by
+ * retryThingspeakUpload() under the endpoint's backoff and circuit breaker policy.
+ * A batch refused with a 4xx (bad key, malformed rows) is dropped instead, since
+ * sending it again would be refused again; 408 and 429 are retried. The reply
+ * is accepted only if its "success" member is true (tsBulkAccepted()).
+ * When the buffer is full the oldest row is dropped.
+ *
+ * THINGSPEAK_SERVER and THINGSPEAK_PORT may be overridden in build_flags to point
+ * the service at a local stand-in server.
  *
  * Dependencies:
  * - Requires WiFi connection to be established.
@@ -19,49 +33,240 @@
  */
 #include "thingSpeakService.h"
 
-#include <WiFiClient.h>     // ThingSpeak connection
+#include "connectionPool.h" // shared keep-alive sockets
+#include <coroutine.h>      // protothreads from lib/wxcore
 #include "credentials.h"    // Wi-Fi and weather station credentials
+#include "endpointPolicy.h" // retry and circuit breaker
+#include "netTiming.h"      // phase timing
+#include "taskControl.h"    // finishCoroutine()
+#include "timeFunctions.h"  // for UTC time of unstamped samples
+#include <tsPayload.h>      // channel field layout from lib/wxcore
 #include "weatherService.h" // weather data
 #include "wug_debug.h"      // debug print
 
 //! ************** THINGSPEAK ACCOUNT ********************
+#ifndef THINGSPEAK_SERVER
 #define THINGSPEAK_SERVER "api.thingspeak.com" // ThingSpeak Server
-String unitStatus = "";                        // ThingSpeak status global
+#endif
+#ifndef THINGSPEAK_PORT
+#define THINGSPEAK_PORT 80 // ThingSpeak HTTP port
+#endif
+#define TS_TIMEOUT 5000L // milliseconds to wait for the response
+#define TS_SLOTS 32      // buffered rows, must be >= TS_BATCH_SIZE
+// a 4xx other than timeout or rate limit refuses the request itself, not this moment
+#define TS_REFUSED(code) ((code) >= 400 && (code) < 500 && (code) != 408 && (code) != 429)
 
-void postWXtoThingspeak()
+String unitStatus = ""; // ThingSpeak status global
+
+//! back off 1 min doubling to 30 min, open the circuit for 15 min after 3 failures
+const retryPolicy TS_POLICY = {60000UL, 1800000UL, 3, 900000UL};
+
+struct tsSample
+{
+  uint32_t epoch;         // observation time (unix time UTC)
+  float field[TS_FIELDS]; // field1 - field8
+};
+
+tsSample tsBuffer[TS_SLOTS]; // ring of rows waiting for upload
+int tsHead = 0;              // index of the oldest row
+int tsUsed = 0;              // number of rows waiting
+uint32_t tsDropped = 0;      // rows the server refused outright
+
+static bool tsRetryPending()
+{
+  return tsUsed > 0;
+}
+
+endpointHealth tsHealth = ENDPOINT_HEALTH_RETRIED("thingspeak", TS_POLICY, tsRetryPending);
+
+/*
+******************************************************
+************** Upload buffered samples ***************
+******************************************************
+*/
+// one bulk update; only this state survives the waits of tsUpload()
+struct tsUploadState
+{
+  int rows;              // rows in the request, removed from the buffer once accepted
+  int attempt;           // a stale keep-alive socket earns one fresh retry
+  WiFiClient *client;    // pooled socket
+  bool reused;           // socket came warm from the pool
+  httpResponse response; // server reply
+};
+tsUploadState tsUpload;
+
+// one row of the request, the status goes with the newest
+static size_t formatRow(char *out, int i, int rows)
+{
+  const tsSample &row = tsBuffer[(tsHead + i) % TS_SLOTS];
+  const char *status = (i == rows - 1) ? unitStatus.c_str() : "";
+  return tsFormatBulkRow(out, TS_BULK_ROW_MAX, row.epoch, row.field, status);
+} // formatRow()
+
+// write the request for the oldest rows; no wait may happen here
+static void sendBatch(WiFiClient &client, int rows)
+{
+  // https://www.mathworks.com/help/thingspeak/bulkwritejsondata.html
+  // rows are formatted twice, once to measure, so the body is never held whole
+  char text[TS_BULK_ROW_MAX];
+  size_t length = tsFormatBulkStart(text, sizeof(text), TS_WRITE_KEY.c_str()) + strlen(TS_BULK_END);
+  for (int i = 0; i < rows; i++)
+  {
+    length += formatRow(text, i, rows) + (i > 0 ? 1 : 0);
+  }
+
+  client.println("POST /channels/" + TS_CHANNEL + "/bulk_update.json HTTP/1.1");
+  client.print("Host: ");
+  client.println(THINGSPEAK_SERVER);
+  client.println("Connection: keep-alive");
+  client.println("Content-Type: application/json");
+  client.println("Content-Length: " + String(length));
+  client.println("");
+  tsFormatBulkStart(text, sizeof(text), TS_WRITE_KEY.c_str());
+  client.print(text);
+  for (int i = 0; i < rows; i++)
+  {
+    if (i > 0)
+    {
+      client.print(',');
+    }
+    formatRow(text, i, rows);
+    client.print(text);
+  }
+  client.print(TS_BULK_END);
+} // sendBatch()
+
+// the upload as a protothread: the display runs while ThingSpeak answers
+static ptState uploadBatch(protothread *pt)
 {
-  WiFiClient client;
-  // assemble and post the data
-  if (client.connect(THINGSPEAK_SERVER, 80))
+  PT_BEGIN(pt);
+  if (!policyAllow(tsHealth))
+  {
+    DEBUG_PRINTLN("ThingSpeak: backing off");
+    PT_EXIT(pt);
+  }
+
+  // a reused socket may have been closed by the server, so allow one fresh retry
+  for (tsUpload.attempt = 0; tsUpload.attempt < 2; tsUpload.attempt++)
   {
+    netTimingBegin(NET_THINGSPEAK);
+    tsUpload.client = acquireConnection(THINGSPEAK_SERVER, THINGSPEAK_PORT, false, tsUpload.reused,
+                                        TS_BATCH_SIZE * WX_CURRENT_INTERVAL * 60000UL); // one batch per TS_BATCH_SIZE observations
+    if (tsUpload.client == nullptr)
+    {
+      DEBUG_PRINTLN("ThingSpeak connection failed.");
+      netTimingEndFor(NET_THINGSPEAK, false);
+      policyFailure(tsHealth);
+      PT_EXIT(pt);
+    }
     DEBUG_PRINT("ThingSpeak Server connected to channel: ");
     DEBUG_PRINTLN(TS_CHANNEL);
 
-    String dataStr = "&field1=" + String(wx.obsTemp);
-    dataStr += "&field2=" + String(wx.obsHumidity);
-    dataStr += "&field3=" + String(wx.obsPressure);
-    dataStr += "&field4=" + String(wx.obsWindSpeed);
-    dataStr += "&field5=" + String(wx.obsWindDir);
-    dataStr += "&field6=" + String(wx.obsSolarRadiation);
-    dataStr += "&field7=" + String(wx.obsPrecipTotal);
-    dataStr += "&field8=" + String(wx.obsPrecipRate);
-    dataStr += (unitStatus.isEmpty()) ? "" : ("&status=" + unitStatus);
-
-    DEBUG_PRINTLN(dataStr); // show ThingSpeak payload on serial monitor
-
-    // post the data to ThingSpeak
-    client.println("POST /update HTTP/1.1");
-    client.print("Host: ");
-    client.println(THINGSPEAK_SERVER);
-    client.println("Connection: close");
-    client.print("X-THINGSPEAKAPIKEY: ");
-    client.println(TS_WRITE_KEY);
-    client.println("Content-Type: application/x-www-form-urlencoded");
-    client.println("Content-Length: " + String(dataStr.length()));
-    client.println("");
-    client.print(dataStr);
-
-    DEBUG_PRINTLN("ThingSpeak data sent.");
+    tsUpload.rows = tsUsed; // rows buffered from now on wait for the next batch
+    sendBatch(*tsUpload.client, tsUpload.rows);
+    beginHttpResponse(tsUpload.response, tsUpload.client, NET_THINGSPEAK, POOL_MAX_BODY, TS_TIMEOUT);
+    PT_AWAIT_THREAD(pt, readHttpResponse(tsUpload.response));
+    releaseConnection(tsUpload.client, tsUpload.response.keepAlive);
+
+    {
+      int httpCode = tsUpload.response.status;
+      bool accepted = (httpCode == 200 || httpCode == 202) &&
+                      tsBulkAccepted(tsUpload.response.body.c_str(), tsUpload.response.body.length());
+      netTimingEndFor(NET_THINGSPEAK, accepted);
+      if (httpCode == 0 && tsUpload.reused)
+      {
+        continue; // stale keep-alive socket
+      }
+      if (accepted)
+      {
+        DEBUG_PRINT("ThingSpeak rows sent: ");
+        DEBUG_PRINTLN(tsUpload.rows);
+        tsHead = (tsHead + tsUpload.rows) % TS_SLOTS;
+        tsUsed -= tsUpload.rows;
+        policySuccess(tsHealth);
+        PT_EXIT(pt);
+      }
+      DEBUG_PRINT("ThingSpeak rejected batch: ");
+      DEBUG_PRINT(httpCode);
+      DEBUG_PRINT(" ");
+      DEBUG_PRINTLN(tsUpload.response.body);
+      if (TS_REFUSED(httpCode))
+      {
+        // the same rows would be refused again: drop them, the server itself is fine
+        tsHead = (tsHead + tsUpload.rows) % TS_SLOTS;
+        tsUsed -= tsUpload.rows;
+        tsDropped += tsUpload.rows;
+        DEBUG_PRINT("ThingSpeak rows dropped: ");
+        DEBUG_PRINTLN(tsDropped);
+        policySuccess(tsHealth);
+        PT_EXIT(pt);
+      }
+    }
+    break;
+  }
+  policyFailure(tsHealth); // rows stay buffered for the retry
+  PT_END(pt);
+} // uploadBatch()
+
+coroutine tsCoroutine = COROUTINE("thingspeak", uploadBatch);
+
+void uploadThingspeakBatch()
+{
+  if (tsUsed > 0)
+  {
+    coStart(tsCoroutine); // false if an upload is already under way
+  }
+} // uploadThingspeakBatch()
+
+bool finishThingspeakUpload()
+{
+  uploadThingspeakBatch();
+  finishCoroutine(tsCoroutine);
+  return tsUsed == 0;
+} // finishThingspeakUpload()
+
+void retryThingspeakUpload()
+{
+  if (tsUsed > 0 && !coActive(tsCoroutine) && policyRetryDue(tsHealth))
+  {
+    uploadThingspeakBatch();
+  }
+} // retryThingspeakUpload()
+
+/*
+******************************************************
+*************** Buffer current weather ***************
+******************************************************
+*/
+void postWXtoThingspeak()
+{
+  uint32_t epoch = (wx.obsEpoch != 0) ? wx.obsEpoch : UTC.now();
+  if (tsUsed > 0 && tsBuffer[(tsHead + tsUsed - 1) % TS_SLOTS].epoch == epoch)
+  {
+    DEBUG_PRINTLN("ThingSpeak: observation already buffered");
+  }
+  else
+  {
+    if (tsUsed == TS_SLOTS)
+    {
+      tsHead = (tsHead + 1) % TS_SLOTS; // drop the oldest row
+      tsUsed--;
+      if (coActive(tsCoroutine) && tsUpload.rows > 0)
+      {
+        tsUpload.rows--; // it was part of the upload under way
+      }
+    }
+    tsSample &row = tsBuffer[(tsHead + tsUsed) % TS_SLOTS];
+    row.epoch = epoch;
+    tsFields(currentObservation(), row.field); // channel layout shared with the gateway
+    tsUsed++;
+  }
+
+  DEBUG_PRINT("ThingSpeak rows buffered: ");
+  DEBUG_PRINTLN(tsUsed);
+
+  if (tsUsed >= (int)min(TS_BATCH_SIZE, (unsigned int)TS_SLOTS))
+  {
+    uploadThingspeakBatch();
   }
-  client.stop();
-} // postToThingSpeak()
\ No newline at end of file
+} // postWXtoThingspeak()
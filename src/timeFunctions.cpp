@@ -18,8 +18,10 @@
 
 #include <Arduino.h>	 // Arduino functions
 #include <ezTime.h>		 // ezTime library for timezone handling
+#include <tzRules.h>	 // built-in POSIX rules from lib/wxcore
 #include "aprsService.h" // for APRSsendBulletin
 #include "credentials.h" // for MY_TIMEZONE
+#include "wug_debug.h"	 // debug print macro
 
 Timezone myTZ;
 
@@ -27,18 +29,25 @@ Timezone myTZ;
  * @brief Sets the local timezone configuration.
  *
  * This function synchronizes the system time and ensures that the timezone is set correctly.
- * If the timezone has not been cached in EEPROM or if the user requests a new timezone,
- * it updates the timezone using the specified location. Finally, it sets the local timezone as default.
+ * A zone in the built-in table (tzRules.h) is set from its POSIX rule without any network
+ * request. Other zones are looked up on the ezTime timezone server, unless the rule cached
+ * in EEPROM is already for that zone. Finally, it sets the local timezone as default.
  *
  * Dependencies:
- * - Requires `myTZ` object with methods: setCache(), getOlson(), setLocation(), setDefault().
+ * - Requires `myTZ` object with methods: setPosix(), setCache(), getOlson(), setLocation(), setDefault().
  * - Uses `MY_TIMEZONE` constant for the desired timezone.
  * - Calls `waitForSync()` to ensure time synchronization before setting the timezone.
  */
 void setTimeZone()
 {
 	waitForSync();
-	if (!myTZ.setCache(0) || myTZ.getOlson() != MY_TIMEZONE)
+	char posix[TZ_POSIX_SIZE];
+	if (tzPosixRule(MY_TIMEZONE.c_str(), posix, sizeof(posix)))
+	{
+		myTZ.setPosix(posix);
+		DEBUG_PRINTLN("Timezone from built-in rules: " + String(posix));
+	}
+	else if (!myTZ.setCache(0) || myTZ.getOlson() != MY_TIMEZONE)
 	{
 		myTZ.setLocation(MY_TIMEZONE);
 	}
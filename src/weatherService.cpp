@@ -10,11 +10,19 @@
 #include "weatherService.h"
 
 #include <Arduino.h>           // Arduino functions
+#include "connectionPool.h"    // shared keep-alive sockets
+#include <coroutine.h>         // protothreads from lib/wxcore
 #include "credentials.h"       // Wi-Fi and weather station credentials
+#include "endpointPolicy.h"    // retry and circuit breaker
+#include "localIngest.h"       // uploads from the station on the LAN
+#include "netTiming.h"         // phase timing
+#include "taskControl.h"       // finishCoroutine()
 #include <ESP8266HTTPClient.h> // [builtin] for http and https
-#include <WiFiClientSecure.h>  // [builtin] for https
 #include <ArduinoJson.h>       // [manager] v7.2 Benoit Blanchon https://arduinojson.org/
 #include "thingSpeakService.h" // ThingSpeak service header
+#include "wxEvents.h"          // update events
+#include "wxHistory.h"         // observation history
+#include "wxShare.h"           // snapshots from a leader display
 #include "wug_debug.h"         // debug print
 
 weather wx; // global weather object
@@ -23,36 +31,56 @@ weather wx; // global weather object
 // !!! DO NOT CHANGE !!!
 // documentation: https://docs.google.com/document/d/1eKCnKXI9xnoMGRRzOL1xPCBihNV2rOet08qpE_gArAY/edit?tab=t.0
 // WX_KEY is in credentials.h
+const char *WX_SERVER = "api.weather.com";               ///< Weather Underground API server
+const uint16_t WX_PORT = 443;                            ///< HTTPS port
 const String WX_HOST = "https://api.weather.com";        ///< Weather Underground API host
 const String WX_CURRENT = "v2/pws/observations/current"; ///< Current weather observations endpoint
+const String WX_HISTORY = "v2/pws/observations/all/1day"; ///< Last 24 hours of 5 minute observations
 const String WX_FORECAST = "v3/wx/forecast/daily/5day";  ///< Forecast weather endpoint
 const String WX_LANGUAGE = "en-US";                      ///< Language for the API response
 const String WX_UNITS = "m";                             ///< MUST USE METRIC!!!
 const String WX_FORMAT = "json";                         ///< Format of the API response
 const String WX_PRECISION = "decimal";                   ///< Precision of the API response
 
+#define WX_NEXT_USE (WX_CURRENT_INTERVAL * 60000UL) ///< the current fetch uses the socket most often
+
+//! back off 30 s doubling to 15 min, open the circuit for 10 min after 3 failures
+const retryPolicy WX_POLICY = {30000UL, 900000UL, 3, 600000UL};
+endpointHealth wxHealth = ENDPOINT_HEALTH("weather", WX_POLICY);
+
 /*
 ******************************************************
 ************* fetch Data and Parse *******************
 ******************************************************
 */
 
-void fetchDataAndParse(String getQuery, JsonDocument &filter, JsonDocument &doc)
+bool fetchDataAndParse(String getQuery, JsonDocument &filter, JsonDocument &doc)
 {
   // HTTP request and parsing logic
   // by Copilot 12/15/2024
-  WiFiClientSecure client;
-  client.setInsecure();
+  // The TLS socket comes from the connection pool and stays open between requests
+  bool reused;
+  WiFiClient *client = acquireConnection(WX_SERVER, WX_PORT, true, reused, WX_NEXT_USE);
+  if (client == nullptr)
+  {
+    DEBUG_PRINTLN("https: can't connect");
+    return false;
+  }
   HTTPClient https;
+  https.setReuse(true); // ask for keep-alive
+  bool parsed = false;
 
-  if (https.begin(client, getQuery))
+  if (https.begin(*client, getQuery))
   {
     int httpCode = https.GET();
+    netTimingMark(NET_PHASE_FIRST_BYTE);
     if (httpCode > 0)
     {
       if (httpCode == HTTP_CODE_OK)
       {
-        DeserializationError error = deserializeJson(doc, client, DeserializationOption::Filter(filter));
+        DeserializationError error = deserializeJson(doc, *client, DeserializationOption::Filter(filter));
+        netTimingMark(NET_PHASE_BODY);
+        parsed = !error;
         if (error)
         {
           DEBUG_PRINT("deserialization failed: ");
@@ -65,13 +93,14 @@ void fetchDataAndParse(String getQuery, JsonDocument &filter, JsonDocument &doc)
       DEBUG_PRINT("GET error: ");
       DEBUG_PRINTLN(https.errorToString(httpCode).c_str());
     }
-    https.end();   // Ensure connection is closed after each request
-    client.stop(); // Explicitly close the client connection
+    https.end(); // leaves the socket open when the server allows reuse
   }
   else
   {
     DEBUG_PRINTLN("https: can't connect");
   }
+  releaseConnection(client, client->connected());
+  return parsed;
 } // fetchDataAndParse()
 
 /*
@@ -79,20 +108,23 @@ void fetchDataAndParse(String getQuery, JsonDocument &filter, JsonDocument &doc)
 ************** Get Current Weather *******************
 ******************************************************
 */
-void getWXcurrent()
-{
-  // Documentation:
-  // https://api.weather.com/v2/pws/observations/current?stationId=yourStationID&format=json&units=m&numericPrecision=decimal&apiKey=yourApiKey
-  // Uses API stream
+#define WX_CURRENT_TIMEOUT 5000L  // milliseconds allowed for each part of the response
+#define WX_CURRENT_MAX_BODY 2048 // one observation is about 1 KB
 
-  String getQuery = WX_HOST + "/" + WX_CURRENT +
-                    "?stationId=" + WX_STATION_ID +
-                    "&format=" + WX_FORMAT +
-                    "&units=" + WX_UNITS +
-                    "&numericPrecision=" + WX_PRECISION +
-                    "&apiKey=" + WX_KEY;
+// one current-conditions request; only this state survives the waits of fetchCurrent()
+struct wxCurrentFetch
+{
+  WiFiClient *client;    // pooled TLS socket
+  bool reused;           // socket came warm from the pool
+  httpResponse response; // server reply
+};
+wxCurrentFetch wxFetch;
 
+// copy the observation into wx, false if the reply held none
+static bool applyCurrent(const String &body)
+{
   JsonDocument filter; // filter to reduce size of JsonDocument
+  filter["observations"][0]["epoch"] = true;
   filter["observations"][0]["lat"] = true;
   filter["observations"][0]["lon"] = true;
   filter["observations"][0]["neighborhood"] = true;
@@ -103,37 +135,303 @@ void getWXcurrent()
   filter["observations"][0]["metric"] = true; // extends to all items under "metric"
   // includes temp, heatIndex, dewpt, windChill, windSpeed, windGust, pressure, precip rates
 
-  JsonDocument doc; // holds filtered json stream
-
-  fetchDataAndParse(getQuery, filter, doc);
+  JsonDocument doc; // holds filtered json
+  DeserializationError error = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+  if (error)
+  {
+    DEBUG_PRINT("deserialization failed: ");
+    DEBUG_PRINTLN(error.c_str());
+    return false;
+  }
 
   JsonObject observations_0 = doc["observations"][0];
-  if (observations_0["lat"] != 0)
-  {
-    wx.obsLat = observations_0["lat"];                           // decimal latitude
-    wx.obsLon = observations_0["lon"];                           // decimal longitude
-    wx.obsNeighborhood = (String)observations_0["neighborhood"]; // WU area
-    wx.obsSolarRadiation = observations_0["solarRadiation"];     // W/m^2
-    wx.obsUV = observations_0["uv"];                             // UV index
-    wx.obsWindDir = observations_0["winddir"];                   // degrees clockwise from North
-    wx.obsHumidity = observations_0["humidity"];                 // relative humidity 0 - 100%
-    JsonObject observations_0_metric = observations_0["metric"]; //! Program expects all metric values
-    wx.obsTemp = observations_0_metric["temp"];                  // Celsius
-    wx.obsHeatIndex = observations_0_metric["heatIndex"];        // Celsius valid when temp >+ 18C
-    wx.obsDewPt = observations_0_metric["dewpt"];                // Celsius
-    wx.obsWindChill = observations_0_metric["windChill"];        // Celsius valid when temp < 18C
-    wx.obsWindSpeed = observations_0_metric["windSpeed"];        // km/h
-    wx.obsWindGust = observations_0_metric["windGust"];          // km/h
-    wx.obsPressure = observations_0_metric["pressure"];          // millibars of mercury
-    wx.obsPrecipRate = observations_0_metric["precipRate"];      // mm for rain, cm for snow
-    wx.obsPrecipTotal = observations_0_metric["precipTotal"];    // mm/h for rain, {cm/h for snow???} from midnight
+  if (observations_0["lat"] == 0)
+  {
+    return false;
   }
-  else
+  wx.obsEpoch = observations_0["epoch"];                       // unix time UTC
+  wx.obsLat = observations_0["lat"];                           // decimal latitude
+  wx.obsLon = observations_0["lon"];                           // decimal longitude
+  wx.obsNeighborhood = (String)observations_0["neighborhood"]; // WU area
+  wx.obsSolarRadiation = observations_0["solarRadiation"];     // W/m^2
+  wx.obsUV = observations_0["uv"];                             // UV index
+  wx.obsWindDir = observations_0["winddir"];                   // degrees clockwise from North
+  wx.obsHumidity = observations_0["humidity"];                 // relative humidity 0 - 100%
+  JsonObject observations_0_metric = observations_0["metric"]; //! Program expects all metric values
+  wx.obsTemp = observations_0_metric["temp"];                  // Celsius
+  wx.obsHeatIndex = observations_0_metric["heatIndex"];        // Celsius valid when temp >+ 18C
+  wx.obsDewPt = observations_0_metric["dewpt"];                // Celsius
+  wx.obsWindChill = observations_0_metric["windChill"];        // Celsius valid when temp < 18C
+  wx.obsWindSpeed = observations_0_metric["windSpeed"];        // km/h
+  wx.obsWindGust = observations_0_metric["windGust"];          // km/h
+  wx.obsPressure = observations_0_metric["pressure"];          // millibars of mercury
+  wx.obsPrecipRate = observations_0_metric["precipRate"];      // mm for rain, cm for snow
+  wx.obsPrecipTotal = observations_0_metric["precipTotal"];    // mm/h for rain, {cm/h for snow???} from midnight
+  return true;
+} // applyCurrent()
+
+// the request as a protothread: the display runs while WU answers
+static ptState fetchCurrent(protothread *pt)
+{
+  PT_BEGIN(pt);
+  if (localDataFresh())
+  {
+    DEBUG_PRINTLN("WU: local upload is current, skipping poll");
+    PT_EXIT(pt);
+  }
+  if (shareFeedsWX())
+  {
+    DEBUG_PRINTLN("WU: following leader, skipping poll");
+    PT_EXIT(pt);
+  }
+  if (!policyAllow(wxHealth))
+  {
+    DEBUG_PRINTLN("WU: backing off");
+    PT_EXIT(pt);
+  }
+
+  // Documentation:
+  // https://api.weather.com/v2/pws/observations/current?stationId=yourStationID&format=json&units=m&numericPrecision=decimal&apiKey=yourApiKey
+  // The TLS socket comes from the connection pool and stays open between requests
+  netTimingBegin(NET_WX_CURRENT);
+  wxFetch.client = acquireConnection(WX_SERVER, WX_PORT, true, wxFetch.reused, WX_NEXT_USE);
+  if (wxFetch.client == nullptr)
+  {
+    DEBUG_PRINTLN("https: can't connect");
+    netTimingEndFor(NET_WX_CURRENT, false);
+    policyFailure(wxHealth);
+    PT_EXIT(pt);
+  }
+  wxFetch.client->print("GET /" + WX_CURRENT +
+                        "?stationId=" + WX_STATION_ID +
+                        "&format=" + WX_FORMAT +
+                        "&units=" + WX_UNITS +
+                        "&numericPrecision=" + WX_PRECISION +
+                        "&apiKey=" + WX_KEY + " HTTP/1.1\r\n" +
+                        "Host: " + WX_SERVER + "\r\n" +
+                        "Accept-Encoding: identity\r\n" +
+                        "Connection: keep-alive\r\n\r\n");
+  beginHttpResponse(wxFetch.response, wxFetch.client, NET_WX_CURRENT, WX_CURRENT_MAX_BODY, WX_CURRENT_TIMEOUT);
+  PT_AWAIT_THREAD(pt, readHttpResponse(wxFetch.response));
+  releaseConnection(wxFetch.client, wxFetch.response.keepAlive);
+
   {
-    DEBUG_PRINTLN("No data from WU");
+    bool valid = wxFetch.response.status == 200 && applyCurrent(wxFetch.response.body);
+    wxFetch.response.body = ""; // give the heap back
+    if (valid)
+    {
+      historyRecordWX(); // extend the rolling history
+      publishWXupdate(); // uplinks and display
+    }
+    else
+    {
+      DEBUG_PRINT("No data from WU, HTTP ");
+      DEBUG_PRINTLN(wxFetch.response.status);
+    }
+    netTimingMarkFor(NET_WX_CURRENT, NET_PHASE_PARSE);
+    netTimingEndFor(NET_WX_CURRENT, valid);
+    valid ? policySuccess(wxHealth) : policyFailure(wxHealth);
+  }
+  PT_END(pt);
+} // fetchCurrent()
+
+coroutine wxCurrentCoroutine = COROUTINE("wx current", fetchCurrent);
+
+void getWXcurrent()
+{
+  if (coStart(wxCurrentCoroutine)) // false if a fetch is already under way
+  {
+    coResume(wxCurrentCoroutine); // send the request now, the reply is read as it comes
   }
 } // getWXcurrent()
 
+void finishWXcurrent()
+{
+  getWXcurrent();
+  finishCoroutine(wxCurrentCoroutine);
+} // finishWXcurrent()
+
+// the pool has one api.weather.com socket; a blocking request waits for a current fetch to let go of it
+static void waitForWXconnection()
+{
+  if (coActive(wxCurrentCoroutine))
+  {
+    DEBUG_PRINTLN("WU: waiting for the current fetch");
+    finishCoroutine(wxCurrentCoroutine);
+  }
+} // waitForWXconnection()
+
+/*
+******************************************************
+************** Current Observation *******************
+******************************************************
+*/
+wxObservation currentObservation()
+{
+  wxObservation obs;
+  obs.epoch = wx.obsEpoch;
+  obs.lat = wx.obsLat;
+  obs.lon = wx.obsLon;
+  obs.solarRadiation = wx.obsSolarRadiation;
+  obs.uv = wx.obsUV;
+  obs.humidity = wx.obsHumidity;
+  obs.dewPt = wx.obsDewPt;
+  obs.temp = wx.obsTemp;
+  obs.heatIndex = wx.obsHeatIndex;
+  obs.windChill = wx.obsWindChill;
+  obs.windDir = wx.obsWindDir;
+  obs.windSpeed = wx.obsWindSpeed;
+  obs.windGust = wx.obsWindGust;
+  obs.pressure = wx.obsPressure;
+  obs.precipRate = wx.obsPrecipRate;
+  obs.precipTotal = wx.obsPrecipTotal;
+  return obs;
+} // currentObservation()
+
+/*
+******************************************************
+******************* Next Sunset **********************
+******************************************************
+*/
+uint32_t nextSunset(uint32_t after)
+{
+  if (wx.forSunSet == 0)
+  {
+    return 0; // no forecast yet, the calendar asks again
+  }
+  // until the next forecast brings tomorrow's time, the same time of day is
+  // close enough: sunset moves by a few minutes a day at most
+  uint32_t sunset = wx.forSunSet;
+  if (sunset <= after)
+  {
+    sunset += ((after - sunset) / 86400 + 1) * 86400;
+  }
+  return sunset;
+} // nextSunset()
+
+/*
+******************************************************
+************** Get Weather History *******************
+******************************************************
+*/
+void getWXhistory()
+{
+  if (shareFeedsWX())
+  {
+    DEBUG_PRINTLN("WU: following leader, skipping request");
+    return;
+  }
+  if (!policyAllow(wxHealth))
+  {
+    DEBUG_PRINTLN("WU: backing off");
+    return;
+  }
+
+  // Documentation:
+  // https://api.weather.com/v2/pws/observations/all/1day?stationId=yourStationID&format=json&units=m&numericPrecision=decimal&apiKey=yourApiKey
+  // The response holds up to 288 five minute summaries, far too large for a JsonDocument.
+  // Each element of the "observations" array is deserialized on its own straight
+  // from the stream so only one observation is held in RAM at a time.
+
+  String getQuery = WX_HOST + "/" + WX_HISTORY +
+                    "?stationId=" + WX_STATION_ID +
+                    "&format=" + WX_FORMAT +
+                    "&units=" + WX_UNITS +
+                    "&numericPrecision=" + WX_PRECISION +
+                    "&apiKey=" + WX_KEY;
+
+  JsonDocument filter; // filter applied to each observation
+  filter["epoch"] = true;
+  filter["humidityAvg"] = true;
+  filter["metric"]["tempHigh"] = true;
+  filter["metric"]["tempLow"] = true;
+  filter["metric"]["windspeedAvg"] = true;
+  filter["metric"]["windgustHigh"] = true;
+  filter["metric"]["pressureMax"] = true;
+  filter["metric"]["pressureMin"] = true;
+  filter["metric"]["precipTotal"] = true;
+  filter["solarRadiationHigh"] = true;
+
+  waitForWXconnection();
+  netTimingBegin(NET_WX_HISTORY);
+  bool reused;
+  WiFiClient *client = acquireConnection(WX_SERVER, WX_PORT, true, reused, WX_NEXT_USE);
+  if (client == nullptr)
+  {
+    DEBUG_PRINTLN("https: can't connect");
+    netTimingEnd(false);
+    policyFailure(wxHealth);
+    return;
+  }
+  HTTPClient https;
+  https.useHTTP10(true); // no chunked transfer encoding so the body can be streamed
+
+  if (!https.begin(*client, getQuery))
+  {
+    DEBUG_PRINTLN("https: can't connect");
+    releaseConnection(client, false);
+    netTimingEnd(false);
+    policyFailure(wxHealth);
+    return;
+  }
+
+  int count = 0;
+  int httpCode = https.GET();
+  netTimingMark(NET_PHASE_FIRST_BYTE);
+  if (httpCode == HTTP_CODE_OK)
+  {
+    if (client->find("\"observations\":["))
+    {
+      do
+      {
+        JsonDocument doc; // holds a single observation
+        DeserializationError error = deserializeJson(doc, *client, DeserializationOption::Filter(filter));
+        if (error)
+        {
+          DEBUG_PRINT("deserialization failed: ");
+          DEBUG_PRINTLN(error.c_str());
+          break;
+        }
+        JsonObject metric = doc["metric"];
+        wxSample sample;
+        sample.epoch = doc["epoch"];
+        sample.tempHigh = lround(10 * metric["tempHigh"].as<float>());
+        sample.tempLow = lround(10 * metric["tempLow"].as<float>());
+        sample.pressure = lround(5 * (metric["pressureMax"].as<float>() + metric["pressureMin"].as<float>()));
+        sample.windSpeed = lround(10 * metric["windspeedAvg"].as<float>());
+        sample.windGust = lround(10 * metric["windgustHigh"].as<float>());
+        sample.precipTotal = lround(10 * metric["precipTotal"].as<float>());
+        sample.humidity = lround(doc["humidityAvg"].as<float>());
+        sample.solar = lround(doc["solarRadiationHigh"].as<float>());
+        sample.indoorTemp = INDOOR_NONE; // no indoor readings before boot
+        if (sample.epoch != 0)
+        {
+          historyAppend(sample);
+          count++;
+        }
+      } while (client->findUntil(",", "]"));
+    }
+    netTimingMark(NET_PHASE_BODY); // streamed parse into the history
+  }
+  else
+  {
+    DEBUG_PRINT("GET error: ");
+    DEBUG_PRINTLN(https.errorToString(httpCode).c_str());
+  }
+  https.end();
+  releaseConnection(client, false); // HTTP/1.0 closes after the response
+  netTimingEnd(count > 0);
+  (count > 0) ? policySuccess(wxHealth) : policyFailure(wxHealth);
+
+  DEBUG_PRINT("History backfill: ");
+  DEBUG_PRINT(count);
+  DEBUG_PRINTLN(" observations");
+  DEBUG_PRINT("\tRain 24h:\t");
+  DEBUG_PRINTLN(historyRain24h());
+  DEBUG_PRINT("\tBP tendency:\t");
+  DEBUG_PRINTLN(historyPressureTendency());
+} // getWXhistory()
+
 /*
 ******************************************************
 ************** Get Forecast Weather ******************
@@ -141,6 +439,17 @@ void getWXcurrent()
 */
 void getWXforecast()
 {
+  if (shareFeedsWX())
+  {
+    DEBUG_PRINTLN("WU: following leader, skipping request");
+    return;
+  }
+  if (!policyAllow(wxHealth))
+  {
+    DEBUG_PRINTLN("WU: backing off");
+    return;
+  }
+
   // The PWS Google doc appears to be out of date. Use the IBM document for 5-day.
   // Obsolete Documentation: https://docs.google.com/document/d/1_Zte7-SdOjnzBttb1-Y9e0Wgl0_3tah9dSwXUyEA3-c/edit?tab=t.0
   // Use this Documentation: https://www.ibm.com/docs/en/environmental-intel-suite?topic=fa-daily-forecast-3-day-5-day-7-day-10-day
@@ -167,29 +476,36 @@ void getWXforecast()
 
   // parse the filtered JsonDocument
   JsonDocument doc;
-  fetchDataAndParse(getQuery, filter, doc);
-
-  JsonArray calendarDayTemperatureMax = doc["calendarDayTemperatureMax"];
-  wx.forTempMax = (calendarDayTemperatureMax[0]) ? calendarDayTemperatureMax[0] : calendarDayTemperatureMax[1];
+  waitForWXconnection();
+  netTimingBegin(NET_WX_FORECAST);
+  bool parsed = fetchDataAndParse(getQuery, filter, doc);
+  if (parsed) // keep the last forecast when this one failed
+  {
+    JsonArray calendarDayTemperatureMax = doc["calendarDayTemperatureMax"];
+    wx.forTempMax = (calendarDayTemperatureMax[0]) ? calendarDayTemperatureMax[0] : calendarDayTemperatureMax[1];
 
-  JsonArray calendarDayTemperatureMin = doc["calendarDayTemperatureMin"];
-  wx.forTempMin = (calendarDayTemperatureMin[0]) ? calendarDayTemperatureMin[0] : calendarDayTemperatureMin[1];
+    JsonArray calendarDayTemperatureMin = doc["calendarDayTemperatureMin"];
+    wx.forTempMin = (calendarDayTemperatureMin[0]) ? calendarDayTemperatureMin[0] : calendarDayTemperatureMin[1];
 
-  JsonArray sunriseTimeUtc = doc["sunriseTimeUtc"];
-  wx.forSunRise = (sunriseTimeUtc[0]) ? sunriseTimeUtc[0] : sunriseTimeUtc[1]; // 1731412186
+    JsonArray sunriseTimeUtc = doc["sunriseTimeUtc"];
+    wx.forSunRise = (sunriseTimeUtc[0]) ? sunriseTimeUtc[0] : sunriseTimeUtc[1]; // 1731412186
 
-  JsonArray sunsetTimeUtc = doc["sunsetTimeUtc"];
-  wx.forSunSet = (sunsetTimeUtc[0]) ? sunsetTimeUtc[0] : sunsetTimeUtc[1]; // 1731448679
+    JsonArray sunsetTimeUtc = doc["sunsetTimeUtc"];
+    wx.forSunSet = (sunsetTimeUtc[0]) ? sunsetTimeUtc[0] : sunsetTimeUtc[1]; // 1731448679
 
-  JsonObject daypart_0 = doc["daypart"][0];
-  JsonArray daypart_0_cloudCover = daypart_0["cloudCover"];
-  wx.forCloud = (daypart_0_cloudCover[0]) ? daypart_0_cloudCover[0] : daypart_0_cloudCover[1];
+    JsonObject daypart_0 = doc["daypart"][0];
+    JsonArray daypart_0_cloudCover = daypart_0["cloudCover"];
+    wx.forCloud = (daypart_0_cloudCover[0]) ? daypart_0_cloudCover[0] : daypart_0_cloudCover[1];
 
-  JsonArray daypart_0_wxPhraseLong = daypart_0["wxPhraseLong"];
-  wx.forPhraseLong = (daypart_0_wxPhraseLong[0]) ? (String)daypart_0_wxPhraseLong[0] : (String)daypart_0_wxPhraseLong[1];
+    JsonArray daypart_0_wxPhraseLong = daypart_0["wxPhraseLong"];
+    wx.forPhraseLong = (daypart_0_wxPhraseLong[0]) ? (String)daypart_0_wxPhraseLong[0] : (String)daypart_0_wxPhraseLong[1];
 
-  JsonArray daypart_0_wxPhraseShort = daypart_0["wxPhraseShort"];
-  wx.forPhraseShort = (daypart_0_wxPhraseShort[0]) ? (String)daypart_0_wxPhraseShort[0] : (String)daypart_0_wxPhraseShort[1];
+    JsonArray daypart_0_wxPhraseShort = daypart_0["wxPhraseShort"];
+    wx.forPhraseShort = (daypart_0_wxPhraseShort[0]) ? (String)daypart_0_wxPhraseShort[0] : (String)daypart_0_wxPhraseShort[1];
+  }
+  netTimingMark(NET_PHASE_PARSE);
+  netTimingEnd(parsed);
+  parsed ? policySuccess(wxHealth) : policyFailure(wxHealth);
 
   // prettified print
   DEBUG_PRINTLN("Forecast filtered:");
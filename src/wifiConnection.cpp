@@ -1,39 +1,491 @@
 /**
  * @file wifiConnection.cpp
  * @author Karl W. Berger
- * @date 2025-06-05
- * @brief Contains the function to connect to the Wi-Fi network.
- * @details The function logonToRouter() connects the ESP8266 to the specified Wi-Fi network.
- * Uses the WiFi library to connect and prints the IP address once connected.
+ * @date 2025-06-23
+ * @brief Wi-Fi supervisor: connects, watches the link and reconnects without blocking.
+ * @details checkWiFiConnection() runs a small state machine from loop():
+ *
+ *   OFFLINE --retry time--> FAST --no IP in 5 s--> SCAN --no IP in 20 s--> OFFLINE
+ *                            |                      |
+ *                            +------ got IP ------> ONLINE --link lost--> OFFLINE
+ *
+ * FAST associates directly with the cached access point, and reuses the cached lease
+ * while it is less than half its length old; SCAN is a normal scan and DHCP. A failed
+ * SCAN waits an exponential backoff with jitter before the next attempt, so the display,
+ * clock and local tasks keep running while the router is away.
+ * The SDK's disconnect event gives prompt loss detection; WiFi.status() is polled as
+ * well in case an event is missed.
+ *
+ * wifiSleep() and wifiWake() take the link down and up on purpose for the radio power
+ * manager. A planned sleep is not a link loss: it is not counted, and the restore
+ * callbacks do not run when the planned wake-up connects.
+ *
+ * The access point (BSSID and channel) and the DHCP lease of the last good connection are
+ * cached in RTC memory, which survives a reset, and in LittleFS, which survives power loss.
+ * A static reuse of the lease never renews it, so the cache keeps the lease length and the
+ * UTC time it was granted. Once half the lease has gone by, the time a DHCP client would
+ * renew, or when its age cannot be told because the clock is not set, FAST asks DHCP
+ * again on the cached access point and the new lease is cached. A lease granted before
+ * the clock was set is stamped as soon as it is.
  */
 
 #include "wifiConnection.h"
 
 #include <Arduino.h>	 // Arduino functions
 #include <ESP8266WiFi.h> // [manager] v2.0.0 Wi-Fi
+#include <LittleFS.h>	 // [builtin] cache that survives power loss
+#include <ezTime.h>		 // lease age
+#include <lwip/dhcp.h>	 // lease length
 #include "credentials.h" // Wi-Fi credentials
+#include "gatewayMode.h" // GATEWAY_RTC_BLOCK follows the cache
 #include "wug_debug.h"	 // debug print
 
-void logonToRouter()
+#define WIFI_CACHE_MAGIC 0x57494643 // "WIFC"
+#define WIFI_CACHE_FILE "/wifi.bin"
+#define WIFI_RTC_BLOCK 0			// RTC user memory offset in 4 byte blocks, 13 blocks used
+#define WIFI_LEASE_DEFAULT 3600UL	// seconds assumed when DHCP does not say
+#define WIFI_FAST_TIMEOUT 5000UL	// milliseconds allowed for the cached connection
+#define WIFI_SCAN_TIMEOUT 20000UL	// milliseconds allowed for scan and DHCP
+#define WIFI_BACKOFF_MIN 2000UL		// first wait after a failed attempt
+#define WIFI_BACKOFF_MAX 300000UL	// longest wait between attempts
+#define WIFI_BOOT_WAIT 30000UL		// waitForWiFi() gives up this long after beginWiFi() and continues offline
+#define WIFI_RSSI_PERIOD 10000UL	// milliseconds between signal samples
+#define WIFI_MAX_CALLBACKS 6		// onWiFiRestored() registrations
+
+struct wifiCache
+{
+	uint32_t magic;	  // WIFI_CACHE_MAGIC when valid
+	uint32_t ssidCrc; // cache belongs to this SSID
+	uint8_t bssid[6]; // access point
+	uint8_t spare[2];
+	int32_t channel;
+	uint32_t ip;
+	uint32_t gateway;
+	uint32_t mask;
+	uint32_t dns1;
+	uint32_t dns2;
+	uint32_t leaseSeconds; // lease length granted by DHCP
+	uint32_t leaseStart;   // UTC when it was granted, 0 if the clock was not set
+	uint32_t crc;		   // of everything above
+};
+static_assert(WIFI_RTC_BLOCK + (sizeof(wifiCache) + 3) / 4 <= GATEWAY_RTC_BLOCK,
+			  "Wi-Fi cache overlaps the gateway state in RTC memory");
+
+enum wifiState
+{
+	WIFI_OFFLINE, // waiting for the next attempt
+	WIFI_FAST,	  // cached access point and lease
+	WIFI_SCAN,	  // scan and DHCP
+	WIFI_ONLINE,  // have an IP address
+	WIFI_ASLEEP	  // radio off on purpose
+};
+const char *const STATE_NAMES[] = {"offline", "connecting (cached)", "connecting (scan)", "online", "asleep"};
+
+wifiState wifiStatus = WIFI_OFFLINE;
+unsigned long stateSince = 0;				// millis() of the last state change
+unsigned long attemptStart = 0;				// millis() when the current attempt began
+unsigned long bootStart = 0;				// millis() of beginWiFi(), for waitForWiFi()
+unsigned long retryAt = 0;					// millis() of the next attempt while offline
+unsigned long backoff = WIFI_BACKOFF_MIN;	// wait after the next failure
+unsigned long lastBlink = 0;				// LED toggle while connecting
+bool plannedWake = false;					// connecting after wifiWake()
+bool leaseReused = false;					// this attempt configured the cached lease statically
+bool leaseStamped = true;					// the cached lease has its UTC start
+unsigned long leaseMillis = 0;				// millis() when the current DHCP lease arrived
+volatile bool linkLost = false;				// set by the disconnect event
+volatile uint8_t lostReason = 0;			// SDK disconnect reason
+WiFiEventHandler disconnectedHandler;		// keeps the event registered
+wifiCallback restoredCallbacks[WIFI_MAX_CALLBACKS];
+
+// connection statistics
+unsigned long lastTimeToIP = 0; // milliseconds from attempt to IP of the last connection
+bool lastConnectFast = false;	// last connection used the cache
+uint32_t fastConnects = 0;		// connections made from the cache
+uint32_t scanConnects = 0;		// connections made by scan and DHCP
+uint32_t fastMisses = 0;		// cached attempts that fell back to a scan
+uint32_t failedAttempts = 0;	// scans that timed out
+uint32_t linkLosses = 0;		// drops while online
+unsigned long onlineMs = 0;		// time online before the current session
+
+// link quality
+float rssiAverage = 0;		   // exponential average, dBm
+int8_t rssiMin = 0;			   // weakest sample this session
+int8_t rssiMax = -127;		   // strongest sample this session
+unsigned long lastRssiSample = 0;
+
+/*
+******************************************************
+******************** Cache ***************************
+******************************************************
+*/
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	while (length--)
+	{
+		crc ^= *data++;
+		for (int bit = 0; bit < 8; bit++)
+		{
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+	}
+	return ~crc;
+} // crc32()
+
+static bool cacheValid(const wifiCache &cache)
+{
+	return cache.magic == WIFI_CACHE_MAGIC &&
+		   cache.ssidCrc == crc32((const uint8_t *)WIFI_SSID.c_str(), WIFI_SSID.length()) &&
+		   cache.crc == crc32((const uint8_t *)&cache, offsetof(wifiCache, crc));
+} // cacheValid()
+
+// RTC memory first, LittleFS after a power cycle
+static bool loadCache(wifiCache &cache)
+{
+	if (ESP.rtcUserMemoryRead(WIFI_RTC_BLOCK, (uint32_t *)&cache, sizeof(cache)) && cacheValid(cache))
+	{
+		return true;
+	}
+	if (LittleFS.begin())
+	{
+		File file = LittleFS.open(WIFI_CACHE_FILE, "r");
+		if (file)
+		{
+			bool read = file.read((uint8_t *)&cache, sizeof(cache)) == sizeof(cache);
+			file.close();
+			return read && cacheValid(cache);
+		}
+	}
+	return false;
+} // loadCache()
+
+// length of the lease DHCP just granted
+static uint32_t leaseLength()
+{
+	struct dhcp *dhcp = netif_default ? netif_dhcp_data(netif_default) : nullptr;
+	return (dhcp && dhcp->offered_t0_lease) ? dhcp->offered_t0_lease : WIFI_LEASE_DEFAULT;
+} // leaseLength()
+
+// a lease may be reused statically until T1, when a DHCP client would renew it
+static bool leaseFresh(const wifiCache &cache)
 {
-	pinMode(LED_BUILTIN, OUTPUT);		  // Built-in LED
-	WiFi.begin(WIFI_SSID, WIFI_PASSWORD); // Begin WiFi
-	WiFi.mode(WIFI_STA);				  // Explicitly set mode, ESP defaults to STA+AP
-	while (WiFi.status() != WL_CONNECTED) // Wait for Wi-Fi to connect
+	if (cache.leaseStart == 0 || timeStatus() == timeNotSet)
 	{
-		delay(500);
-		digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN)); // Toggle LED
-		DEBUG_PRINT('.');
+		return false; // age unknown
 	}
+	uint32_t age = UTC.now() - cache.leaseStart; // huge if the clock reads earlier
+	return age < cache.leaseSeconds / 2;
+} // leaseFresh()
+
+// cache the access point and the lease DHCP granted at leaseMillis
+static void saveCache()
+{
+	wifiCache cache = {};
+	cache.magic = WIFI_CACHE_MAGIC;
+	cache.ssidCrc = crc32((const uint8_t *)WIFI_SSID.c_str(), WIFI_SSID.length());
+	memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+	cache.channel = WiFi.channel();
+	cache.ip = WiFi.localIP();
+	cache.gateway = WiFi.gatewayIP();
+	cache.mask = WiFi.subnetMask();
+	cache.dns1 = WiFi.dnsIP(0);
+	cache.dns2 = WiFi.dnsIP(1);
+	cache.leaseSeconds = leaseLength();
+	leaseStamped = timeStatus() != timeNotSet;
+	cache.leaseStart = leaseStamped ? UTC.now() - (millis() - leaseMillis) / 1000 : 0;
+	cache.crc = crc32((const uint8_t *)&cache, offsetof(wifiCache, crc));
+
+	wifiCache old;
+	bool changed = !ESP.rtcUserMemoryRead(WIFI_RTC_BLOCK, (uint32_t *)&old, sizeof(old)) ||
+				   memcmp(&old, &cache, sizeof(cache)) != 0;
+	ESP.rtcUserMemoryWrite(WIFI_RTC_BLOCK, (uint32_t *)&cache, sizeof(cache));
+	if (changed && LittleFS.begin()) // spare the flash when nothing moved
+	{
+		File file = LittleFS.open(WIFI_CACHE_FILE, "w");
+		if (file)
+		{
+			file.write((const uint8_t *)&cache, sizeof(cache));
+			file.close();
+		}
+	}
+} // saveCache()
+
+static void forgetCache()
+{
+	wifiCache empty = {};
+	ESP.rtcUserMemoryWrite(WIFI_RTC_BLOCK, (uint32_t *)&empty, sizeof(empty));
+	if (LittleFS.begin())
+	{
+		LittleFS.remove(WIFI_CACHE_FILE);
+	}
+} // forgetCache()
+
+/*
+******************************************************
+***************** State machine **********************
+******************************************************
+*/
+static void setState(wifiState state)
+{
+	wifiStatus = state;
+	stateSince = millis();
+}
+
+static void startAttempt()
+{
+	attemptStart = millis();
+	linkLost = false;
+	wifiCache cache;
+	leaseReused = false;
+	if (loadCache(cache))
+	{
+		// direct association with the last access point, and its lease while that is fresh
+		leaseReused = leaseFresh(cache);
+		if (leaseReused)
+		{
+			WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway), IPAddress(cache.mask), IPAddress(cache.dns1),
+						IPAddress(cache.dns2));
+		}
+		else
+		{
+			WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u)); // renew through DHCP
+		}
+		WiFi.begin(WIFI_SSID, WIFI_PASSWORD, cache.channel, cache.bssid);
+		setState(WIFI_FAST);
+	}
+	else
+	{
+		WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u)); // DHCP
+		WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+		setState(WIFI_SCAN);
+	}
+} // startAttempt()
+
+static void connected()
+{
+	unsigned long now = millis();
+	lastTimeToIP = now - attemptStart;
+	lastConnectFast = (wifiStatus == WIFI_FAST);
+	lastConnectFast ? fastConnects++ : scanConnects++;
+	if (!leaseReused)
+	{
+		leaseMillis = now;
+		saveCache(); // a new lease, or a new access point
+	}
+	backoff = WIFI_BACKOFF_MIN;
+	linkLost = false;
+	rssiAverage = WiFi.RSSI();
+	rssiMin = rssiMax = rssiAverage;
+	lastRssiSample = now;
+	setState(WIFI_ONLINE);
 	digitalWrite(LED_BUILTIN, HIGH); // Turn off LED
+
 	DEBUG_PRINT("\nWi-Fi connected. IP address: ");
 	DEBUG_PRINTLN(WiFi.localIP()); // Send the IP address of the ESP8266 to the computer
-} // logonToRouter()
+	DEBUG_PRINT("Wi-Fi time to IP ms: ");
+	DEBUG_PRINT(lastTimeToIP);
+	DEBUG_PRINTLN(lastConnectFast ? " (cached)" : " (scan)");
+
+	if (plannedWake)
+	{
+		plannedWake = false; // nothing was lost
+		return;
+	}
+	for (int i = 0; i < WIFI_MAX_CALLBACKS && restoredCallbacks[i]; i++)
+	{
+		restoredCallbacks[i]();
+	}
+} // connected()
+
+static void goOffline(unsigned long wait)
+{
+	WiFi.disconnect();
+	retryAt = millis() + wait;
+	setState(WIFI_OFFLINE);
+} // goOffline()
 
 void checkWiFiConnection()
 {
-	if (WiFi.status() != WL_CONNECTED) // Check if Wi-Fi is connected
+	unsigned long now = millis();
+	switch (wifiStatus)
+	{
+	case WIFI_ONLINE:
+		if (linkLost || WiFi.status() != WL_CONNECTED)
+		{
+			DEBUG_PRINT("Wi-Fi lost, reason ");
+			DEBUG_PRINTLN(lostReason);
+			linkLosses++;
+			onlineMs += now - stateSince;
+			linkLost = false;
+			goOffline(0); // first attempt at once, the access point may just have roamed
+			break;
+		}
+		if (!leaseStamped && timeStatus() != timeNotSet)
+		{
+			saveCache(); // the lease arrived before NTP did
+		}
+		if (now - lastRssiSample >= WIFI_RSSI_PERIOD)
+		{
+			int8_t rssi = WiFi.RSSI();
+			rssiAverage += (rssi - rssiAverage) / 8; // about the last 80 s
+			rssiMin = min(rssiMin, rssi);
+			rssiMax = max(rssiMax, rssi);
+			lastRssiSample = now;
+		}
+		break;
+
+	case WIFI_FAST:
+	case WIFI_SCAN:
+		if (WiFi.status() == WL_CONNECTED)
+		{
+			connected();
+			break;
+		}
+		if (now - lastBlink >= 500)
+		{
+			digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN)); // Toggle LED
+			lastBlink = now;
+		}
+		if (wifiStatus == WIFI_FAST && now - stateSince > WIFI_FAST_TIMEOUT)
+		{
+			DEBUG_PRINTLN("Wi-Fi cached connection failed, scanning");
+			fastMisses++;
+			leaseReused = false;
+			forgetCache();
+			WiFi.disconnect();
+			WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u)); // back to DHCP
+			WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+			setState(WIFI_SCAN);
+		}
+		else if (wifiStatus == WIFI_SCAN && now - stateSince > WIFI_SCAN_TIMEOUT)
+		{
+			failedAttempts++;
+			unsigned long wait = backoff / 2 + random(backoff / 2 + 1); // equal jitter
+			backoff = min(backoff * 2, WIFI_BACKOFF_MAX);
+			DEBUG_PRINT("Wi-Fi not found, retry in ms ");
+			DEBUG_PRINTLN(wait);
+			digitalWrite(LED_BUILTIN, HIGH); // Turn off LED
+			plannedWake = false;			 // this is an outage now
+			goOffline(wait);
+		}
+		break;
+
+	case WIFI_OFFLINE:
+		if ((long)(now - retryAt) >= 0)
+		{
+			startAttempt();
+		}
+		break;
+
+	case WIFI_ASLEEP:
+		break; // wifiWake() ends it
+	}
+} // checkWiFiConnection()
+
+/*
+******************************************************
+********************* Public *************************
+******************************************************
+*/
+void beginWiFi()
+{
+	pinMode(LED_BUILTIN, OUTPUT);  // Built-in LED
+	WiFi.mode(WIFI_STA);		   // Explicitly set mode, ESP defaults to STA+AP
+	WiFi.persistent(false);		   // the SDK's own flash copy is not needed
+	WiFi.setAutoReconnect(false); // the supervisor decides when to retry
+	disconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected &event) {
+		lostReason = event.reason;
+		linkLost = true;
+	});
+	startAttempt();
+	bootStart = millis();
+} // beginWiFi()
+
+void waitForWiFi()
+{
+	// setup() wants the network for the first weather fetch, but not forever
+	while (wifiStatus != WIFI_ONLINE && millis() - bootStart < WIFI_BOOT_WAIT)
+	{
+		checkWiFiConnection();
+		delay(50);
+	}
+	if (wifiStatus != WIFI_ONLINE)
+	{
+		DEBUG_PRINTLN("Wi-Fi unavailable, continuing offline");
+	}
+} // waitForWiFi()
+
+void logonToRouter()
+{
+	beginWiFi();
+	waitForWiFi();
+} // logonToRouter()
+
+bool wifiOnline()
+{
+	return wifiStatus == WIFI_ONLINE;
+}
+
+void wifiSleep()
+{
+	if (wifiStatus != WIFI_ONLINE)
+	{
+		return; // an outage is the supervisor's business
+	}
+	onlineMs += millis() - stateSince;
+	WiFi.disconnect();
+	WiFi.forceSleepBegin();
+	delay(1); // the SDK needs a yield to power down
+	setState(WIFI_ASLEEP);
+} // wifiSleep()
+
+void wifiWake()
+{
+	if (wifiStatus != WIFI_ASLEEP)
+	{
+		return;
+	}
+	WiFi.forceSleepWake();
+	delay(1);
+	WiFi.mode(WIFI_STA);
+	plannedWake = true;
+	startAttempt(); // cached access point, usually about a second
+} // wifiWake()
+
+bool wifiAsleep()
+{
+	return wifiStatus == WIFI_ASLEEP;
+}
+
+bool onWiFiRestored(wifiCallback callback)
+{
+	for (int i = 0; i < WIFI_MAX_CALLBACKS; i++)
+	{
+		if (restoredCallbacks[i] == nullptr)
+		{
+			restoredCallbacks[i] = callback;
+			return true;
+		}
+	}
+	return false;
+} // onWiFiRestored()
+
+void printWiFiStats()
+{
+	unsigned long now = millis();
+	Serial.printf("Wi-Fi %s for %lu s", STATE_NAMES[wifiStatus], (now - stateSince) / 1000);
+	if (wifiStatus == WIFI_ONLINE)
+	{
+		Serial.printf(", %s, channel %d\n", WiFi.localIP().toString().c_str(), WiFi.channel());
+		Serial.printf("\tRSSI %d dBm, average %.0f, min %d, max %d\n", WiFi.RSSI(), rssiAverage, rssiMin, rssiMax);
+	}
+	else
 	{
-		logonToRouter(); // Reconnect to Wi-Fi
+		Serial.println();
 	}
-} // checkWiFiConnection()	
\ No newline at end of file
+	unsigned long online = onlineMs + (wifiStatus == WIFI_ONLINE ? now - stateSince : 0);
+	Serial.printf("\tonline %.1f%% of uptime, %u link losses, %u failed attempts\n", 100.0 * online / max(now, 1UL),
+				  linkLosses, failedAttempts);
+	Serial.printf("\tlast time to IP %lu ms (%s)\n", lastTimeToIP, lastConnectFast ? "cached" : "scan");
+	Serial.printf("\tconnects: %u cached, %u scan, %u cache misses\n", fastConnects, scanConnects, fastMisses);
+} // printWiFiStats()
@@ -0,0 +1,108 @@
+/**
+ * @file wxEvents.cpp
+ * @author Karl Berger
+ * @date 2025-06-27
+ * @brief Weather update events for the uplinks and the display.
+ * @details Delivery runs as a one-shot scheduler task rather than inside
+ *          publishWXupdate(), so a fetch task finishes before the posts it
+ *          triggers begin. When a subscriber is still inside its interval the
+ *          task is rescheduled for the moment the interval ends.
+ */
+
+#include "wxEvents.h"
+
+#include <Arduino.h>	   // Arduino functions
+#include <taskScheduler.h> // deadline scheduler from lib/wxcore
+#include "wug_debug.h"	   // debug print
+
+wxSubscription *subscribers[WX_MAX_SUBSCRIBERS];
+uint32_t updateVersion = 0; // raised by every publishWXupdate()
+
+static void deliverUpdates();
+scheduledTask taskDeliverWX = SCHEDULED_TASK("wx events", deliverUpdates, 0);
+
+static void deliverUpdates()
+{
+	unsigned long now = millis();
+	unsigned long next = ULONG_MAX;
+	for (int i = 0; i < WX_MAX_SUBSCRIBERS && subscribers[i]; i++)
+	{
+		wxSubscription &sub = *subscribers[i];
+		if (sub.version == updateVersion)
+		{
+			continue; // already has it
+		}
+		unsigned long elapsed = now - sub.deliveredAt;
+		if (sub.delivered > 0 && elapsed < sub.minInterval)
+		{
+			next = min(next, sub.minInterval - elapsed); // hold the newest update
+			continue;
+		}
+		sub.version = updateVersion;
+		sub.deliveredAt = now;
+		sub.delivered++;
+		sub.deliver();
+	}
+	if (next != ULONG_MAX)
+	{
+		taskSchedule(taskDeliverWX, next);
+	}
+} // deliverUpdates()
+
+bool subscribeWX(wxSubscription &subscription)
+{
+	for (int i = 0; i < WX_MAX_SUBSCRIBERS; i++)
+	{
+		if (subscribers[i] == nullptr || subscribers[i] == &subscription)
+		{
+			subscribers[i] = &subscription;
+			return true;
+		}
+	}
+	return false;
+} // subscribeWX()
+
+void publishWXupdate()
+{
+	for (int i = 0; i < WX_MAX_SUBSCRIBERS && subscribers[i]; i++)
+	{
+		if (subscribers[i]->version != updateVersion)
+		{
+			subscribers[i]->coalesced++; // the held update will never be sent
+		}
+	}
+	updateVersion++;
+	DEBUG_PRINT("WX update ");
+	DEBUG_PRINTLN(updateVersion);
+	taskSchedule(taskDeliverWX, 0);
+} // publishWXupdate()
+
+uint32_t wxUpdateVersion()
+{
+	return updateVersion;
+}
+
+unsigned long wxDeliveryDueIn()
+{
+	uint32_t wait = taskDueIn(taskDeliverWX);
+	return (wait == TASK_NEVER) ? ULONG_MAX : wait;
+}
+
+void printWXevents()
+{
+	unsigned long now = millis();
+	Serial.printf("WX update version %u\n", updateVersion);
+	Serial.println("\tsubscriber  interval-s  delivered  coalesced  waiting");
+	for (int i = 0; i < WX_MAX_SUBSCRIBERS && subscribers[i]; i++)
+	{
+		wxSubscription &sub = *subscribers[i];
+		bool waiting = sub.version != updateVersion;
+		unsigned long elapsed = now - sub.deliveredAt;
+		unsigned long waitMs = (waiting && elapsed < sub.minInterval) ? sub.minInterval - elapsed : 0;
+		Serial.printf("\t%-11s %10lu %10u %10u  %s", sub.name, sub.minInterval / 1000, sub.delivered, sub.coalesced,
+					  waiting ? "yes" : "no");
+		Serial.printf(waiting ? ", %lu s\n" : "\n", waitMs / 1000);
+	}
+} // printWXevents()
+
+// End of file
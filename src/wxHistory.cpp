@@ -0,0 +1,263 @@
+/**
+ * @file wxHistory.cpp
+ * @author Karl Berger
+ * @date 2025-06-12
+ * @brief Compact in-RAM history of weather observations.
+ * @details Samples are held in a statically allocated packed store of HISTORY_BYTES.
+ *          When the store is full the oldest block of samples is dropped. Samples must
+ *          arrive in time order; a sample that is not newer than the last one is ignored
+ *          so the boot backfill and the regular current observations can overlap safely.
+ *          The low temperature is stored as its distance below the high, which is zero
+ *          for a current observation, and wind to the whole km/h the APRS report uses.
+ *          Each sample accepted is also appended to the observation log (obsLog.h),
+ *          which historyRestore() replays at boot.
+ */
+
+#include "wxHistory.h"
+
+#include <Arduino.h>		// Arduino functions
+#include "indoorSensor.h"	// indoor temperature
+#include "obsLog.h"			// samples kept across a restart
+#include "weatherService.h" // weather data
+#include "wug_debug.h"		// debug print
+
+const uint32_t DAY_SECONDS = 86400UL;	 // rolling window for rain and hi/lo
+const uint32_t TENDENCY_SECONDS = 10800UL; // 3 hour pressure tendency (WMO)
+const uint32_t RAIN_START_SLACK = 3600UL;  // latest first sample that still makes a 24 hour rain total
+
+enum historyChannel // packed record values
+{
+	CH_TEMP_HIGH,
+	CH_TEMP_SPREAD, // high minus low
+	CH_HUMIDITY,
+	CH_PRESSURE,
+	CH_WIND,		// km/h
+	CH_GUST,		// km/h
+	CH_PRECIP,
+	CH_SOLAR,
+	CH_INDOOR
+};
+
+packedStore history; // packed samples, empty as zero-initialized
+
+// scale a float to a clamped integer with the given multiplier
+static long scaleValue(float value, float multiplier, long lo, long hi)
+{
+	long scaled = lround(value * multiplier);
+	return constrain(scaled, lo, hi);
+}
+
+static void toRecord(const wxSample &sample, packedRecord &record)
+{
+	record.epoch = sample.epoch;
+	record.value[CH_TEMP_HIGH] = sample.tempHigh;
+	record.value[CH_TEMP_SPREAD] = sample.tempHigh - sample.tempLow;
+	record.value[CH_HUMIDITY] = sample.humidity;
+	record.value[CH_PRESSURE] = sample.pressure;
+	record.value[CH_WIND] = (sample.windSpeed + 5) / 10;
+	record.value[CH_GUST] = (sample.windGust + 5) / 10;
+	record.value[CH_PRECIP] = sample.precipTotal;
+	record.value[CH_SOLAR] = sample.solar;
+	record.value[CH_INDOOR] = sample.indoorTemp;
+} // toRecord()
+
+static void fromRecord(const packedRecord &record, wxSample &sample)
+{
+	sample.epoch = record.epoch;
+	sample.tempHigh = record.value[CH_TEMP_HIGH];
+	sample.tempLow = record.value[CH_TEMP_HIGH] - record.value[CH_TEMP_SPREAD];
+	sample.humidity = record.value[CH_HUMIDITY];
+	sample.pressure = record.value[CH_PRESSURE];
+	sample.windSpeed = record.value[CH_WIND] * 10;
+	sample.windGust = record.value[CH_GUST] * 10;
+	sample.precipTotal = record.value[CH_PRECIP];
+	sample.solar = record.value[CH_SOLAR];
+	sample.indoorTemp = record.value[CH_INDOOR];
+} // fromRecord()
+
+void historyAppend(const wxSample &sample)
+{
+	packedRecord record;
+	toRecord(sample, record);
+	if (packedAppend(history, record)) // false for a duplicate or out of order
+	{
+		logAppend(sample);
+	}
+} // historyAppend()
+
+// a sample from the log goes into the history only
+static void restoreSample(const wxSample &sample)
+{
+	packedRecord record;
+	toRecord(sample, record);
+	packedAppend(history, record);
+} // restoreSample()
+
+bool historyRestore()
+{
+	return beginObsLog(restoreSample);
+}
+
+void historyRecordWX()
+{
+	if (wx.obsEpoch == 0)
+	{
+		return; // no observation yet
+	}
+	wxSample sample;
+	sample.epoch = wx.obsEpoch;
+	sample.tempHigh = scaleValue(wx.obsTemp, 10, INT16_MIN, INT16_MAX);
+	sample.tempLow = sample.tempHigh;
+	sample.pressure = scaleValue(wx.obsPressure, 10, 0, UINT16_MAX);
+	sample.windSpeed = scaleValue(wx.obsWindSpeed, 10, 0, UINT16_MAX);
+	sample.windGust = scaleValue(wx.obsWindGust, 10, 0, UINT16_MAX);
+	sample.precipTotal = scaleValue(wx.obsPrecipTotal, 10, 0, UINT16_MAX);
+	sample.solar = scaleValue(wx.obsSolarRadiation, 1, 0, UINT16_MAX);
+	sample.indoorTemp = (indoorSensor && indoorReady()) ? scaleValue(indoor.tempC, 10, INT16_MIN + 1, INT16_MAX) : INDOOR_NONE;
+	sample.humidity = scaleValue(wx.obsHumidity, 1, 0, 100);
+	historyAppend(sample);
+} // historyRecordWX()
+
+int historyCount()
+{
+	return history.count;
+}
+
+bool historyNewest(wxSample &sample)
+{
+	packedRecord record;
+	if (!packedNewest(history, record))
+	{
+		return false;
+	}
+	fromRecord(record, sample);
+	return true;
+} // historyNewest()
+
+void historyWindow(historyCursor &cursor, uint32_t from)
+{
+	packedBegin(history, cursor, from);
+}
+
+bool historyNext(historyCursor &cursor, wxSample &sample)
+{
+	packedRecord record;
+	if (!packedNext(cursor, record))
+	{
+		return false;
+	}
+	fromRecord(record, sample);
+	return true;
+} // historyNext()
+
+/*
+******************************************************
+***************** Rolling values *********************
+******************************************************
+*/
+float historyRain24h()
+{
+	// precipTotal restarts at local midnight, so sum the increases
+	wxSample newest, sample;
+	if (!historyNewest(newest))
+	{
+		return NAN;
+	}
+	historyCursor cursor;
+	historyWindow(cursor, newest.epoch - DAY_SECONDS);
+	if (!historyNext(cursor, sample) || sample.epoch - (newest.epoch - DAY_SECONDS) > RAIN_START_SLACK)
+	{
+		return NAN; // history too short for a 24 hour total, e.g. after a boot without backfill
+	}
+
+	long rain = 0; // 0.1 mm
+	uint16_t previous = sample.precipTotal;
+	while (historyNext(cursor, sample))
+	{
+		rain += (sample.precipTotal >= previous) ? sample.precipTotal - previous : sample.precipTotal;
+		previous = sample.precipTotal;
+	}
+	return rain / 10.0;
+} // historyRain24h()
+
+float historyPressureTendency()
+{
+	// compare the newest pressure with the newest sample at least 3 hours older,
+	// looked for within twice that so a long gap gives no tendency
+	wxSample newest, sample;
+	if (!historyNewest(newest))
+	{
+		return NAN;
+	}
+	historyCursor cursor;
+	historyWindow(cursor, newest.epoch - 2 * TENDENCY_SECONDS);
+	bool found = false;
+	uint16_t pressure = 0;
+	while (historyNext(cursor, sample) && newest.epoch - sample.epoch >= TENDENCY_SECONDS)
+	{
+		pressure = sample.pressure;
+		found = true;
+	}
+	return found ? (newest.pressure - (long)pressure) / 10.0 : NAN; // NAN if not enough history yet
+} // historyPressureTendency()
+
+bool historyTempHiLo(float &hi, float &lo)
+{
+	wxSample newest, sample;
+	if (!historyNewest(newest))
+	{
+		return false;
+	}
+	historyCursor cursor;
+	historyWindow(cursor, newest.epoch - DAY_SECONDS);
+
+	int16_t high = INT16_MIN;
+	int16_t low = INT16_MAX;
+	while (historyNext(cursor, sample))
+	{
+		high = max(high, sample.tempHigh);
+		low = min(low, sample.tempLow);
+	}
+	hi = high / 10.0;
+	lo = low / 10.0;
+	return true;
+} // historyTempHiLo()
+
+void printHistoryStats()
+{
+	wxSample oldest, newest;
+	historyCursor cursor;
+	historyWindow(cursor, 0);
+	if (!historyNext(cursor, oldest) || !historyNewest(newest))
+	{
+		Serial.println("History: empty");
+		return;
+	}
+	uint32_t bits = packedBits(history);
+	Serial.printf("History %d samples over %.2f days, %u of %u bytes, %.1f bits/sample, %u dropped\n", historyCount(),
+				  (newest.epoch - oldest.epoch) / 86400.0, (bits + 7) / 8, HISTORY_BYTES, (float)bits / historyCount(),
+				  history.dropped);
+
+	// decode cost: the whole store, then the 24 hour window the rolling values read
+	wxSample sample;
+	unsigned long start = micros();
+	int count = 0;
+	historyWindow(cursor, 0);
+	while (historyNext(cursor, sample))
+	{
+		count++;
+	}
+	unsigned long fullUs = micros() - start;
+	start = micros();
+	int dayCount = 0;
+	historyWindow(cursor, newest.epoch - DAY_SECONDS);
+	while (historyNext(cursor, sample))
+	{
+		dayCount++;
+	}
+	unsigned long dayUs = micros() - start;
+	Serial.printf("\tscan all %d in %lu us (%.1f us each), last 24 h %d in %lu us\n", count, fullUs,
+				  (float)fullUs / max(count, 1), dayCount, dayUs);
+} // printHistoryStats()
+
+// End of file
@@ -0,0 +1,273 @@
+/**
+ * @file wxShare.cpp
+ * @author Karl Berger
+ * @date 2025-06-20
+ * @brief Share weather data between displays on the same LAN.
+ * @details The wire format is wxSnapshot.h in lib/wxcore. The leader sends only
+ *          when the content differs from the last snapshot or the heartbeat is
+ *          due, so a quiet LAN sees one packet a minute.
+ */
+
+#include "wxShare.h"
+
+#include <Arduino.h>		// Arduino functions
+#include <ESP8266WiFi.h>	// [builtin] local IP
+#include <WiFiUdp.h>		// [builtin] multicast
+#include "credentials.h"	// SHARE_MODE
+#include "weatherService.h" // weather data
+#include "wxEvents.h"		// update events
+#include "wxHistory.h"		// observation history
+#include <wxSnapshot.h>		// snapshot wire format from lib/wxcore
+#include "wug_debug.h"		// debug print
+
+const IPAddress SHARE_GROUP(239, 255, 87, 71); ///< administratively scoped multicast group
+const uint32_t QUERY = QUERY_MAGIC;			   ///< sent as it is
+
+WiFiUDP shareUdp;
+bool shareStarted = false;
+uint32_t shareSequence = 0;		  // leader: last sequence sent
+wxSnapshot lastSent;			  // leader: content of the last snapshot
+unsigned long lastSentAt = 0;	  // leader: millis() of the last snapshot
+unsigned long lastReceivedAt = 0; // follower: millis() of the last valid snapshot
+wxSnapshot lastReceived;		  // follower: the last valid snapshot, to tell what is new
+uint32_t sharedSent = 0;		  // snapshots sent
+uint32_t sharedReceived = 0;	  // valid snapshots received
+uint32_t sharedApplied = 0;		  // snapshots that changed wx
+uint32_t sharedRejected = 0;	  // bad magic, version, length or CRC
+
+static void copyText(char *to, size_t size, const String &from)
+{
+	memset(to, 0, size);
+	strncpy(to, from.c_str(), size - 1);
+}
+
+/*
+******************************************************
+********************** Leader ************************
+******************************************************
+*/
+static void buildSnapshot(wxSnapshot &snap)
+{
+	memset(&snap, 0, sizeof(snap));
+	snap.obsEpoch = wx.obsEpoch;
+	snap.lat = lround(wx.obsLat * 100000);
+	snap.lon = lround(wx.obsLon * 100000);
+	snap.temp = lround(wx.obsTemp * 10);
+	snap.dewPt = lround(wx.obsDewPt * 10);
+	snap.heatIndex = lround(wx.obsHeatIndex * 10);
+	snap.windChill = lround(wx.obsWindChill * 10);
+	snap.humidity = lround(wx.obsHumidity * 10);
+	snap.pressure = lround(wx.obsPressure * 10);
+	snap.windDir = lround(wx.obsWindDir);
+	snap.windSpeed = lround(wx.obsWindSpeed * 10);
+	snap.windGust = lround(wx.obsWindGust * 10);
+	snap.precipRate = lround(wx.obsPrecipRate * 10);
+	snap.precipTotal = lround(wx.obsPrecipTotal * 10);
+	snap.solar = lround(wx.obsSolarRadiation * 10);
+	snap.uv = lround(wx.obsUV * 10);
+	copyText(snap.neighborhood, sizeof(snap.neighborhood), wx.obsNeighborhood);
+	if (wx.forSunRise != 0)
+	{
+		snap.flags |= SNAPSHOT_FORECAST;
+		snap.tempMax = wx.forTempMax;
+		snap.tempMin = wx.forTempMin;
+		snap.cloud = wx.forCloud;
+		snap.sunRise = wx.forSunRise;
+		snap.sunSet = wx.forSunSet;
+		copyText(snap.phraseShort, sizeof(snap.phraseShort), wx.forPhraseShort);
+		copyText(snap.phraseLong, sizeof(snap.phraseLong), wx.forPhraseLong);
+	}
+} // buildSnapshot()
+
+static void sendSnapshot(bool force)
+{
+	wxSnapshot snap;
+	buildSnapshot(snap);
+	bool changed = memcmp(&snap, &lastSent, sizeof(snap)) != 0;
+	if (!force && !changed && millis() - lastSentAt < SHARE_HEARTBEAT)
+	{
+		return;
+	}
+	if (wx.obsEpoch == 0)
+	{
+		return; // nothing fetched yet
+	}
+	lastSent = snap; // compared without sequence and crc
+	snapshotSeal(snap, ++shareSequence);
+	shareUdp.beginPacketMulticast(SHARE_GROUP, SHARE_PORT, WiFi.localIP());
+	shareUdp.write((const uint8_t *)&snap, sizeof(snap));
+	shareUdp.endPacket();
+	lastSentAt = millis();
+	sharedSent++;
+} // sendSnapshot()
+
+/*
+******************************************************
+********************* Follower ***********************
+******************************************************
+*/
+// the forecast fields of a snapshot
+static void applyForecast(const wxSnapshot &snap)
+{
+	if (snap.flags & SNAPSHOT_FORECAST)
+	{
+		wx.forTempMax = snap.tempMax;
+		wx.forTempMin = snap.tempMin;
+		wx.forCloud = snap.cloud;
+		wx.forSunRise = snap.sunRise;
+		wx.forSunSet = snap.sunSet;
+		wx.forPhraseShort = String(snap.phraseShort);
+		wx.forPhraseLong = String(snap.phraseLong);
+	}
+} // applyForecast()
+
+static void applySnapshot(const wxSnapshot &snap)
+{
+	wx.obsEpoch = snap.obsEpoch;
+	wx.obsLat = snap.lat / 100000.0;
+	wx.obsLon = snap.lon / 100000.0;
+	wx.obsTemp = snap.temp / 10.0;
+	wx.obsDewPt = snap.dewPt / 10.0;
+	wx.obsHeatIndex = snap.heatIndex / 10.0;
+	wx.obsWindChill = snap.windChill / 10.0;
+	wx.obsHumidity = snap.humidity / 10.0;
+	wx.obsPressure = snap.pressure / 10.0;
+	wx.obsWindDir = snap.windDir;
+	wx.obsWindSpeed = snap.windSpeed / 10.0;
+	wx.obsWindGust = snap.windGust / 10.0;
+	wx.obsPrecipRate = snap.precipRate / 10.0;
+	wx.obsPrecipTotal = snap.precipTotal / 10.0;
+	wx.obsSolarRadiation = snap.solar / 10.0;
+	wx.obsUV = snap.uv / 10.0;
+	wx.obsNeighborhood = String(snap.neighborhood);
+	applyForecast(snap);
+	historyRecordWX();
+	publishWXupdate(); // uplinks and display
+} // applySnapshot()
+
+static void receiveSnapshot(int size)
+{
+	uint8_t packet[256];
+	int length = shareUdp.read(packet, min(size, (int)sizeof(packet)));
+	switch (snapshotReceive(packet, max(length, 0), lastReceived))
+	{
+	case SNAPSHOT_REJECTED:
+		sharedRejected++;
+		return;
+	case SNAPSHOT_OBSERVATION:
+		applySnapshot(lastReceived);
+		sharedApplied++;
+		break;
+	case SNAPSHOT_FORECAST_UPDATE:
+		applyForecast(lastReceived); // the observation was published already
+		sharedApplied++;
+		break;
+	case SNAPSHOT_HEARTBEAT:
+		break; // the leader is alive, nothing to redraw or post
+	}
+	lastReceivedAt = millis();
+	sharedReceived++;
+} // receiveSnapshot()
+
+// join the group; a follower asks the leader for a snapshot
+static bool joinGroup()
+{
+	shareStarted = shareUdp.beginMulticast(WiFi.localIP(), SHARE_GROUP, SHARE_PORT);
+	if (!shareStarted)
+	{
+		DEBUG_PRINTLN("Share: multicast failed");
+		return false;
+	}
+	if (SHARE_MODE == SHARE_FOLLOWER)
+	{
+		shareUdp.beginPacketMulticast(SHARE_GROUP, SHARE_PORT, WiFi.localIP());
+		shareUdp.write((const uint8_t *)&QUERY, sizeof(QUERY));
+		shareUdp.endPacket();
+	}
+	return true;
+} // joinGroup()
+
+/*
+******************************************************
+********************* Public *************************
+******************************************************
+*/
+void beginShare()
+{
+	if (SHARE_MODE == SHARE_OFF || shareStarted || !joinGroup())
+	{
+		return;
+	}
+	if (SHARE_MODE == SHARE_FOLLOWER)
+	{
+		unsigned long start = millis();
+		while (lastReceivedAt == 0 && millis() - start < SHARE_BOOT_WAIT)
+		{
+			shareLoop();
+			delay(10);
+		}
+		DEBUG_PRINTLN(lastReceivedAt ? "Share: following leader" : "Share: no leader yet");
+	}
+} // beginShare()
+
+void restartShare()
+{
+	if (SHARE_MODE == SHARE_OFF)
+	{
+		return;
+	}
+	if (shareStarted)
+	{
+		shareUdp.stop(); // group membership belongs to the old link
+	}
+	joinGroup();
+} // restartShare()
+
+void shareLoop()
+{
+	if (!shareStarted)
+	{
+		return;
+	}
+	int size;
+	while ((size = shareUdp.parsePacket()) > 0)
+	{
+		if (size == sizeof(QUERY))
+		{
+			uint32_t magic = 0;
+			shareUdp.read((uint8_t *)&magic, sizeof(magic));
+			if (magic == QUERY && SHARE_MODE == SHARE_LEADER)
+			{
+				sendSnapshot(true);
+			}
+		}
+		else if (SHARE_MODE == SHARE_FOLLOWER)
+		{
+			receiveSnapshot(size);
+		}
+		shareUdp.flush();
+	}
+	if (SHARE_MODE == SHARE_LEADER)
+	{
+		sendSnapshot(false);
+	}
+} // shareLoop()
+
+bool shareFeedsWX()
+{
+	return SHARE_MODE == SHARE_FOLLOWER && lastReceivedAt != 0 && millis() - lastReceivedAt < SHARE_SILENT;
+}
+
+void printShareStats()
+{
+	const char *const MODE_NAMES[] = {"off", "leader", "follower"};
+	Serial.printf("Share %s: %u sent, %u received, %u applied, %u rejected", MODE_NAMES[SHARE_MODE % 3], sharedSent,
+				  sharedReceived, sharedApplied, sharedRejected);
+	if (SHARE_MODE == SHARE_FOLLOWER)
+	{
+		Serial.print(shareFeedsWX() ? ", leader active" : ", fetching locally");
+	}
+	Serial.println();
+} // printShareStats()
+
+// End of file
@@ -0,0 +1,60 @@
+"""Send sample station uploads to a display's local ingest listener.
+
+    python tools/ingest_sample.py HOST [--port 8080] [--station KVACENTR126] [--passkey KEY]
+
+Sends one Weather Underground GET and one Ecowitt POST, as a station pointed at
+the display would, and prints each reply. The display should answer
+"200 success" and show the values below; "401" means the passkey does not match
+INGEST_PASSKEY and "400" that the upload was rejected (wrong station id, no
+temperature).
+"""
+import argparse
+import urllib.error
+import urllib.parse
+import urllib.request
+from datetime import datetime, timezone
+
+
+def send(url, body=None):
+    """Print the status and body of one request."""
+    data = body.encode() if body is not None else None
+    try:
+        with urllib.request.urlopen(url, data=data, timeout=5) as response:
+            print(response.status, response.read().decode().strip())
+    except urllib.error.HTTPError as error:
+        print(error.code, error.read().decode().strip())
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Send sample WU and Ecowitt uploads")
+    parser.add_argument("host", help="display IP address or host name")
+    parser.add_argument("--port", type=int, default=8080, help="INGEST_PORT")
+    parser.add_argument("--station", default="KVACENTR126", help="WX_STATION_ID")
+    parser.add_argument("--passkey", default="", help="INGEST_PASSKEY")
+    args = parser.parse_args()
+    base = f"http://{args.host}:{args.port}"
+    now = datetime.now(timezone.utc).strftime("%Y-%m-%d %H:%M:%S")
+
+    # Weather Underground protocol: 70.7 F, 29.92 inHg, 5.6 mph from 225
+    wu = {
+        "ID": args.station, "PASSWORD": args.passkey, "action": "updateraw", "dateutc": now,
+        "tempf": "70.7", "humidity": "64", "dewptf": "58.0", "winddir": "225",
+        "windspeedmph": "5.6", "windgustmph": "9.2", "baromin": "29.92", "rainin": "0.00",
+        "dailyrainin": "0.12", "solarradiation": "412.5", "UV": "4",
+    }
+    print("WU GET:      ", end="")
+    send(f"{base}/weatherstation/updateweatherstation.php?" + urllib.parse.urlencode(wu))
+
+    # Ecowitt protocol: form encoded body, a little warmer
+    ecowitt = {
+        "PASSKEY": args.passkey, "stationtype": "GW1100A_V2.3.1", "dateutc": now,
+        "tempf": "71.2", "humidity": "63", "winddir": "230", "windspeedmph": "4.9",
+        "windgustmph": "8.1", "baromrelin": "29.91", "rainratein": "0.000",
+        "dailyrainin": "0.118", "solarradiation": "420.11", "uv": "4", "model": "GW1100A",
+    }
+    print("Ecowitt POST: ", end="")
+    send(f"{base}/data/report/", urllib.parse.urlencode(ecowitt))
+
+
+if __name__ == "__main__":
+    main()